@@ -34,17 +34,39 @@ namespace UB
             IMPL( int argc, const char * argv[] );
             IMPL( const IMPL & o );
             
-            bool                    _showHelp;
-            bool                    _breakOnInterrupt;
-            bool                    _breakOnInterruptReturn;
-            bool                    _trap;
-            bool                    _debugVideo;
-            bool                    _singleStep;
-            bool                    _noUI;
-            bool                    _noColors;
-            size_t                  _memory;
-            std::string             _bootImage;
-            std::vector< uint64_t > _breakpoints;
+            bool                       _showHelp;
+            bool                       _breakOnInterrupt;
+            bool                       _breakOnInterruptReturn;
+            bool                       _trap;
+            bool                       _debugVideo;
+            bool                       _singleStep;
+            bool                       _noUI;
+            bool                       _noColors;
+            size_t                     _memory;
+            std::string                _bootImage;
+            std::vector< uint64_t >    _breakpoints;
+            std::string                _compressImage;
+            std::string                _bootSector;
+            std::vector< std::string > _load;
+            std::string                _entry;
+            std::vector< std::string > _drives;
+            std::string                _serial;
+            std::string                _serialInput;
+            bool                       _realtime;
+            std::string                _time;
+            std::string                _keys;
+            std::string                _dumpScreen;
+            std::string                _dumpFramebuffer;
+            std::string                _dumpInterval;
+            std::string                _saveState;
+            std::string                _loadState;
+            std::string                _warmStart;
+            std::string                _warmStartCache;
+            std::vector< std::string > _diffState;
+            std::string                _batch;
+            size_t                     _jobs;
+            std::string                _budget;
+            std::string                _timeout;
     };
     
     Arguments::Arguments( int argc, const char * argv[] ):
@@ -124,6 +146,116 @@ namespace UB
         return this->impl->_breakpoints;
     }
     
+    std::string Arguments::compressImage( void ) const
+    {
+        return this->impl->_compressImage;
+    }
+    
+    std::string Arguments::bootSector( void ) const
+    {
+        return this->impl->_bootSector;
+    }
+    
+    std::vector< std::string > Arguments::load( void ) const
+    {
+        return this->impl->_load;
+    }
+    
+    std::string Arguments::entry( void ) const
+    {
+        return this->impl->_entry;
+    }
+    
+    std::vector< std::string > Arguments::drives( void ) const
+    {
+        return this->impl->_drives;
+    }
+    
+    std::string Arguments::serial( void ) const
+    {
+        return this->impl->_serial;
+    }
+    
+    std::string Arguments::serialInput( void ) const
+    {
+        return this->impl->_serialInput;
+    }
+    
+    bool Arguments::realtime( void ) const
+    {
+        return this->impl->_realtime;
+    }
+    
+    std::string Arguments::time( void ) const
+    {
+        return this->impl->_time;
+    }
+    
+    std::string Arguments::keys( void ) const
+    {
+        return this->impl->_keys;
+    }
+    
+    std::string Arguments::dumpScreen( void ) const
+    {
+        return this->impl->_dumpScreen;
+    }
+    
+    std::string Arguments::dumpFramebuffer( void ) const
+    {
+        return this->impl->_dumpFramebuffer;
+    }
+    
+    std::string Arguments::dumpInterval( void ) const
+    {
+        return this->impl->_dumpInterval;
+    }
+    
+    std::string Arguments::saveState( void ) const
+    {
+        return this->impl->_saveState;
+    }
+    
+    std::string Arguments::loadState( void ) const
+    {
+        return this->impl->_loadState;
+    }
+    
+    std::string Arguments::warmStart( void ) const
+    {
+        return this->impl->_warmStart;
+    }
+    
+    std::string Arguments::warmStartCache( void ) const
+    {
+        return this->impl->_warmStartCache;
+    }
+    
+    std::vector< std::string > Arguments::diffState( void ) const
+    {
+        return this->impl->_diffState;
+    }
+    
+    std::string Arguments::batch( void ) const
+    {
+        return this->impl->_batch;
+    }
+    
+    size_t Arguments::jobs( void ) const
+    {
+        return this->impl->_jobs;
+    }
+    
+    std::string Arguments::budget( void ) const
+    {
+        return this->impl->_budget;
+    }
+    
+    std::string Arguments::timeout( void ) const
+    {
+        return this->impl->_timeout;
+    }
+    
     void swap( Arguments & o1, Arguments & o2 )
     {
         using std::swap;
@@ -140,7 +272,9 @@ namespace UB
         _singleStep(             false ),
         _noUI(                   false ),
         _noColors(               false ),
-        _memory(                 0 )
+        _memory(                 0 ),
+        _realtime(               false ),
+        _jobs(                   0 )
     {
         if( argc < 1 )
         {
@@ -183,6 +317,10 @@ namespace UB
             {
                 this->_noColors = true;
             }
+            else if( arg == "--realtime" )
+            {
+                this->_realtime = true;
+            }
             else if( arg == "--memory" || arg == "-m" )
             {
                 if( ++i < argc )
@@ -207,6 +345,158 @@ namespace UB
                     {}
                 }
             }
+            else if( arg == "--compress-image" )
+            {
+                if( ++i < argc )
+                {
+                    this->_compressImage = argv[ i ];
+                }
+            }
+            else if( arg == "--boot-sector" )
+            {
+                if( ++i < argc )
+                {
+                    this->_bootSector = argv[ i ];
+                }
+            }
+            else if( arg == "--load" )
+            {
+                if( ++i < argc )
+                {
+                    this->_load.push_back( argv[ i ] );
+                }
+            }
+            else if( arg == "--entry" )
+            {
+                if( ++i < argc )
+                {
+                    this->_entry = argv[ i ];
+                }
+            }
+            else if( arg == "--drive" )
+            {
+                if( ++i < argc )
+                {
+                    this->_drives.push_back( argv[ i ] );
+                }
+            }
+            else if( arg == "--serial" )
+            {
+                if( ++i < argc )
+                {
+                    this->_serial = argv[ i ];
+                }
+            }
+            else if( arg == "--serial-input" )
+            {
+                if( ++i < argc )
+                {
+                    this->_serialInput = argv[ i ];
+                }
+            }
+            else if( arg == "--time" )
+            {
+                if( ++i < argc )
+                {
+                    this->_time = argv[ i ];
+                }
+            }
+            else if( arg == "--keys" )
+            {
+                if( ++i < argc )
+                {
+                    this->_keys = argv[ i ];
+                }
+            }
+            else if( arg == "--dump-screen" )
+            {
+                if( ++i < argc )
+                {
+                    this->_dumpScreen = argv[ i ];
+                }
+            }
+            else if( arg == "--dump-framebuffer" )
+            {
+                if( ++i < argc )
+                {
+                    this->_dumpFramebuffer = argv[ i ];
+                }
+            }
+            else if( arg == "--dump-interval" )
+            {
+                if( ++i < argc )
+                {
+                    this->_dumpInterval = argv[ i ];
+                }
+            }
+            else if( arg == "--save-state" )
+            {
+                if( ++i < argc )
+                {
+                    this->_saveState = argv[ i ];
+                }
+            }
+            else if( arg == "--load-state" )
+            {
+                if( ++i < argc )
+                {
+                    this->_loadState = argv[ i ];
+                }
+            }
+            else if( arg == "--warm-start" )
+            {
+                if( ++i < argc )
+                {
+                    this->_warmStart = argv[ i ];
+                }
+            }
+            else if( arg == "--warm-start-cache" )
+            {
+                if( ++i < argc )
+                {
+                    this->_warmStartCache = argv[ i ];
+                }
+            }
+            else if( arg == "--diff-state" )
+            {
+                if( ++i < argc )
+                {
+                    this->_diffState.push_back( argv[ i ] );
+                }
+            }
+            else if( arg == "--batch" )
+            {
+                if( ++i < argc )
+                {
+                    this->_batch = argv[ i ];
+                }
+            }
+            else if( arg == "--jobs" || arg == "-j" )
+            {
+                if( ++i < argc )
+                {
+                    try
+                    {
+                        this->_jobs = static_cast< size_t >( std::atoll( argv[ i ] ) );
+                    }
+                    catch( ... )
+                    {}
+                }
+            }
+            else if( arg == "--budget" )
+            {
+                if( ++i < argc )
+                {
+                    this->_budget = argv[ i ];
+                }
+            }
+            else if( arg == "--timeout" )
+            {
+                if( ++i < argc )
+                {
+                    this->_timeout = argv[ i ];
+                }
+            }
             else if( this->_bootImage.length() == 0 )
             {
                 this->_bootImage = arg;
@@ -225,6 +515,28 @@ namespace UB
         _noColors(                o._noColors ),
         _memory(                  o._memory ),
         _bootImage(               o._bootImage ),
-        _breakpoints(             o._breakpoints )
+        _breakpoints(             o._breakpoints ),
+        _compressImage(           o._compressImage ),
+        _bootSector(              o._bootSector ),
+        _load(                    o._load ),
+        _entry(                   o._entry ),
+        _drives(                  o._drives ),
+        _serial(                  o._serial ),
+        _serialInput(             o._serialInput ),
+        _realtime(                o._realtime ),
+        _time(                    o._time ),
+        _keys(                    o._keys ),
+        _dumpScreen(              o._dumpScreen ),
+        _dumpFramebuffer(         o._dumpFramebuffer ),
+        _dumpInterval(            o._dumpInterval ),
+        _saveState(               o._saveState ),
+        _loadState(               o._loadState ),
+        _warmStart(               o._warmStart ),
+        _warmStartCache(          o._warmStartCache ),
+        _diffState(               o._diffState ),
+        _batch(                   o._batch ),
+        _jobs(                    o._jobs ),
+        _budget(                  o._budget ),
+        _timeout(                 o._timeout )
     {}
 }
@@ -43,17 +43,39 @@ namespace UB
             
             Arguments & operator =( Arguments o );
             
-            bool                    showHelp( void )               const;
-            bool                    breakOnInterrupt( void )       const;
-            bool                    breakOnInterruptReturn( void ) const;
-            bool                    trap( void )                   const;
-            bool                    debugVideo( void )             const;
-            bool                    singleStep( void )             const;
-            bool                    noUI( void )                   const;
-            bool                    noColors( void )               const;
-            size_t                  memory( void )                 const;
-            std::string             bootImage( void )              const;
-            std::vector< uint64_t > breakpoints( void )            const;
+            bool                       showHelp( void )               const;
+            bool                       breakOnInterrupt( void )       const;
+            bool                       breakOnInterruptReturn( void ) const;
+            bool                       trap( void )                   const;
+            bool                       debugVideo( void )             const;
+            bool                       singleStep( void )             const;
+            bool                       noUI( void )                   const;
+            bool                       noColors( void )               const;
+            size_t                     memory( void )                 const;
+            std::string                bootImage( void )              const;
+            std::vector< uint64_t >    breakpoints( void )            const;
+            std::string                compressImage( void )          const;
+            std::string                bootSector( void )             const;
+            std::vector< std::string > load( void )                   const;
+            std::string                entry( void )                  const;
+            std::vector< std::string > drives( void )                 const;
+            std::string                serial( void )                 const;
+            std::string                serialInput( void )            const;
+            bool                       realtime( void )               const;
+            std::string                time( void )                   const;
+            std::string                keys( void )                   const;
+            std::string                dumpScreen( void )             const;
+            std::string                dumpFramebuffer( void )        const;
+            std::string                dumpInterval( void )           const;
+            std::string                saveState( void )              const;
+            std::string                loadState( void )              const;
+            std::string                warmStart( void )              const;
+            std::string                warmStartCache( void )         const;
+            std::vector< std::string > diffState( void )              const;
+            std::string                batch( void )                  const;
+            size_t                     jobs( void )                   const;
+            std::string                budget( void )                 const;
+            std::string                timeout( void )                const;
             
             friend void swap( Arguments & o1, Arguments & o2 );
             
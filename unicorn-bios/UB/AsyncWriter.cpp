@@ -0,0 +1,308 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/AsyncWriter.hpp"
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace UB
+{
+    class AsyncWriter::IMPL
+    {
+        public:
+            
+            IMPL( const std::string & path, size_t capacity );
+            ~IMPL( void );
+            
+            void _run( void );
+            bool _open( void );
+            bool _write( const std::vector< uint8_t > & data );
+            
+            std::string               _path;
+            size_t                    _capacity;
+            int                       _fd;
+            bool                      _opened;
+            bool                      _failed;
+            bool                      _stop;
+            size_t                    _pending;
+            uint64_t                  _written;
+            uint64_t                  _dropped;
+            std::vector< uint8_t >    _buffer;
+            mutable std::mutex        _mtx;
+            std::condition_variable   _cv;
+            std::condition_variable   _flushed;
+            std::thread               _thread;
+    };
+    
+    AsyncWriter::AsyncWriter( const std::string & path, size_t capacity ):
+        impl( std::make_unique< IMPL >( path, capacity ) )
+    {
+        this->impl->_thread = std::thread( [ this ] { this->impl->_run(); } );
+    }
+    
+    AsyncWriter::~AsyncWriter( void )
+    {
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_stop = true;
+        }
+        
+        this->impl->_cv.notify_all();
+        this->impl->_thread.join();
+    }
+    
+    std::string AsyncWriter::path( void ) const
+    {
+        return this->impl->_path;
+    }
+    
+    uint64_t AsyncWriter::written( void ) const
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        
+        return this->impl->_written;
+    }
+    
+    uint64_t AsyncWriter::dropped( void ) const
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        
+        return this->impl->_dropped;
+    }
+    
+    void AsyncWriter::write( uint8_t c )
+    {
+        this->write( &c, 1 );
+    }
+    
+    void AsyncWriter::write( const uint8_t * data, size_t size )
+    {
+        bool wake;
+        
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( this->impl->_failed || this->impl->_pending + size > this->impl->_capacity )
+            {
+                this->impl->_dropped += size;
+                
+                return;
+            }
+            
+            wake = this->impl->_buffer.empty();
+            
+            this->impl->_buffer.insert( this->impl->_buffer.end(), data, data + size );
+            
+            this->impl->_pending += size;
+        }
+        
+        if( wake )
+        {
+            this->impl->_cv.notify_one();
+        }
+    }
+    
+    void AsyncWriter::flush( void )
+    {
+        std::unique_lock< std::mutex > l( this->impl->_mtx );
+        
+        this->impl->_flushed.wait
+        (
+            l,
+            [ this ]
+            {
+                return this->impl->_pending == 0 || this->impl->_failed || this->impl->_opened == false;
+            }
+        );
+    }
+    
+    AsyncWriter::IMPL::IMPL( const std::string & path, size_t capacity ):
+        _path(     path ),
+        _capacity( capacity ),
+        _fd(       -1 ),
+        _opened(   false ),
+        _failed(   false ),
+        _stop(     false ),
+        _pending(  0 ),
+        _written(  0 ),
+        _dropped(  0 )
+    {
+        if( this->_path == "-" )
+        {
+            this->_fd     = STDOUT_FILENO;
+            this->_opened = true;
+        }
+        else
+        {
+            this->_opened = this->_open();
+        }
+    }
+    
+    AsyncWriter::IMPL::~IMPL( void )
+    {
+        if( this->_fd >= 0 && this->_fd != STDOUT_FILENO )
+        {
+            close( this->_fd );
+        }
+    }
+    
+    bool AsyncWriter::IMPL::_open( void )
+    {
+        int fd( open( this->_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, 0644 ) );
+        
+        if( fd < 0 )
+        {
+            if( errno != ENXIO )
+            {
+                throw std::runtime_error( "Cannot open file for writing: " + this->_path );
+            }
+            
+            return false;
+        }
+        
+        fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) & ~O_NONBLOCK );
+        
+        this->_fd = fd;
+        
+        return true;
+    }
+    
+    void AsyncWriter::IMPL::_run( void )
+    {
+        std::vector< uint8_t > data;
+        
+        while( true )
+        {
+            {
+                std::unique_lock< std::mutex > l( this->_mtx );
+                
+                if( this->_opened == false )
+                {
+                    this->_cv.wait_for( l, std::chrono::milliseconds( 100 ), [ this ] { return this->_stop; } );
+                    
+                    if( this->_stop )
+                    {
+                        this->_dropped += this->_pending;
+                        this->_pending  = 0;
+                        
+                        this->_buffer.clear();
+                        this->_flushed.notify_all();
+                        
+                        return;
+                    }
+                    
+                    l.unlock();
+                    
+                    try
+                    {
+                        bool opened( this->_open() );
+                        
+                        std::lock_guard< std::mutex > ll( this->_mtx );
+                        
+                        this->_opened = opened;
+                    }
+                    catch( ... )
+                    {
+                        std::lock_guard< std::mutex > ll( this->_mtx );
+                        
+                        this->_failed   = true;
+                        this->_dropped += this->_pending;
+                        this->_pending  = 0;
+                        
+                        this->_buffer.clear();
+                        this->_flushed.notify_all();
+                        
+                        return;
+                    }
+                    
+                    continue;
+                }
+                
+                this->_cv.wait( l, [ this ] { return this->_stop || this->_buffer.empty() == false; } );
+                
+                if( this->_buffer.empty() )
+                {
+                    return;
+                }
+                
+                data.clear();
+                std::swap( data, this->_buffer );
+            }
+            
+            {
+                bool success( this->_write( data ) );
+                
+                std::lock_guard< std::mutex > l( this->_mtx );
+                
+                this->_pending -= data.size();
+                
+                if( success )
+                {
+                    this->_written += data.size();
+                }
+                else
+                {
+                    this->_failed   = true;
+                    this->_dropped += data.size() + this->_pending;
+                    this->_pending  = 0;
+                    
+                    this->_buffer.clear();
+                }
+                
+                this->_flushed.notify_all();
+            }
+        }
+    }
+    
+    bool AsyncWriter::IMPL::_write( const std::vector< uint8_t > & data )
+    {
+        size_t offset( 0 );
+        
+        while( offset < data.size() )
+        {
+            ssize_t n( ::write( this->_fd, data.data() + offset, data.size() - offset ) );
+            
+            if( n < 0 )
+            {
+                if( errno == EINTR )
+                {
+                    continue;
+                }
+                
+                return false;
+            }
+            
+            offset += static_cast< size_t >( n );
+        }
+        
+        return true;
+    }
+}
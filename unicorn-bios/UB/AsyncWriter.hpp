@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_ASYNC_WRITER_HPP
+#define UB_ASYNC_WRITER_HPP
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+
+namespace UB
+{
+    class AsyncWriter
+    {
+        public:
+            
+            AsyncWriter( const std::string & path, size_t capacity = 64 * 1024 * 1024 );
+            ~AsyncWriter( void );
+            
+            AsyncWriter( const AsyncWriter & o )              = delete;
+            AsyncWriter( AsyncWriter && o )                   = delete;
+            AsyncWriter & operator =( const AsyncWriter & o ) = delete;
+            AsyncWriter & operator =( AsyncWriter && o )      = delete;
+            
+            std::string path( void )    const;
+            uint64_t    written( void ) const;
+            uint64_t    dropped( void ) const;
+            
+            void write( uint8_t c );
+            void write( const uint8_t * data, size_t size );
+            void flush( void );
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_ASYNC_WRITER_HPP */
@@ -37,33 +37,54 @@ namespace UB
     {
         namespace Disk
         {
-            bool reset( const Machine & machine, Engine & engine )
+            static uint64_t bytesPerSector( const FAT::Image & image )
             {
-                machine.ui().debug() << "Resetting drive " << String::toHex( engine.dl() ) << std::endl;
+                FAT::MBR mbr( image.mbr() );
                 
-                engine.cf( false );
-                engine.ah( 0 );
+                return ( mbr.isValid() && image.partitions().size() == 0 ) ? mbr.bytesPerSector() : 512;
+            }
+            
+            bool reset( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )engine;
+                
+                machine.ui().debug() << "Resetting drive " << String::toHex( frame.dl() ) << std::endl;
+                
+                if( machine.hasDrive( frame.dl() ) == false )
+                {
+                    frame.cf( true );
+                    frame.ah( 1 );
+                    
+                    return true;
+                }
+                
+                frame.cf( false );
+                frame.ah( 0 );
                 
                 return true;
             }
             
-            bool readSectors( const Machine & machine, Engine & engine )
+            bool readSectors( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                uint8_t    driveNumber( engine.dl() );
-                uint8_t    sectors(     engine.al() );
-                uint8_t    cylinder(    engine.ch() );
-                uint8_t    sector(      engine.cl() );
-                uint8_t    head(        engine.dh() );
-                uint64_t   destination( Engine::getAddress( engine.es(), engine.bx() ) );
-                FAT::Image image(       machine.bootImage() );
-                
-                if( driveNumber != 0x00 )
+                uint8_t            driveNumber( frame.dl() );
+                uint8_t            sectors(     frame.al() );
+                uint16_t           cylinder(    static_cast< uint16_t >( frame.ch() | ( ( frame.cl() & 0xC0 ) << 2 ) ) );
+                uint8_t            sector(      frame.cl() & 0x3F );
+                uint8_t            head(        frame.dh() );
+                uint64_t           destination( Engine::getAddress( frame.es(), frame.bx() ) );
+                const FAT::Image * image(       nullptr );
+                uint64_t           lba(         0 );
+                
+                if( machine.hasDrive( driveNumber ) == false )
                 {
-                    machine.ui().debug() << "[ ERROR ]> Reading from drive " << String::toHex( driveNumber ) << " is not supported" << std::endl;
+                    machine.ui().debug() << "[ ERROR ]> No such drive: " << String::toHex( driveNumber ) << std::endl;
                     
                     goto error;
                 }
                 
+                image = &( machine.drive( driveNumber ) );
+                lba   = FAT::chsToLBA( image->heads(), image->sectorsPerTrack(), cylinder, sector, head );
+                
                 machine.ui().debug() << "Reading " << static_cast< unsigned int >( sectors ) << " sector" << ( ( sectors > 1 ) ? "s" : "" ) << " from drive " << String::toHex( driveNumber )
                                      << std::endl
                                      << "    - Cylinder:    " << String::toHex( cylinder )
@@ -72,13 +93,20 @@ namespace UB
                                      << std::endl
                                      << "    - Sector:      " << String::toHex( sector )
                                      << std::endl
-                                     << "    - LBA:         " << String::toHex( FAT::chsToLBA( image.mbr(), cylinder, sector, head ) )
+                                     << "    - LBA:         " << String::toHex( lba )
                                      << std::endl
-                                     << "    - Destination: " << String::toHex( destination ) << " (" << String::toHex( engine.es() ) << ":" << String::toHex( engine.bx() ) << ")"
+                                     << "    - Destination: " << String::toHex( destination ) << " (" << String::toHex( frame.es() ) << ":" << String::toHex( frame.bx() ) << ")"
                                      << std::endl;
                 
+                if( sector == 0 || ( lba + sectors ) * bytesPerSector( *( image ) ) > image->size() )
                 {
-                    std::vector< uint8_t > bytes( image.read( cylinder, head, sector, sectors ) );
+                    machine.ui().debug() << "[ ERROR ]> Sector out of range" << std::endl;
+                    
+                    goto error;
+                }
+                
+                {
+                    std::vector< uint8_t > bytes( image->read( cylinder, head, sector, sectors ) );
                     
                     if( bytes.size() == 0 )
                     {
@@ -97,58 +125,166 @@ namespace UB
                                          << String::toHex( destination + bytes.size() )
                                          << std::endl;
                     
-                    engine.cf( false );
-                    engine.ah( 0 );
-                    engine.al( sectors );
+                    frame.cf( false );
+                    frame.ah( 0 );
+                    frame.al( sectors );
                     
                     return true;
                 }
                 
                 error:
                     
-                    engine.cf( true );
-                    engine.ah( 1 );
-                    engine.al( 0 );
+                    frame.cf( true );
+                    frame.ah( 1 );
+                    frame.al( 0 );
+                    
+                    return true;
+            }
+            
+            bool getDriveParameters( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )engine;
+                
+                uint8_t driveNumber( frame.dl() );
+                
+                machine.ui().debug() << "Getting parameters for drive " << String::toHex( driveNumber ) << std::endl;
+                
+                if( machine.hasDrive( driveNumber ) == false )
+                {
+                    machine.ui().debug() << "[ ERROR ]> No such drive: " << String::toHex( driveNumber ) << std::endl;
+                    
+                    frame.cf( true );
+                    frame.ah( 1 );
                     
                     return true;
+                }
+                
+                {
+                    const FAT::Image & image( machine.drive( driveNumber ) );
+                    uint16_t           cylinders( static_cast< uint16_t >( std::max< uint16_t >( image.cylinders(), 1 ) - 1 ) );
+                    uint8_t            count( 0 );
+                    
+                    for( uint8_t drive: machine.drives() )
+                    {
+                        if( ( drive & 0x80 ) == ( driveNumber & 0x80 ) )
+                        {
+                            count++;
+                        }
+                    }
+                    
+                    machine.ui().debug() << "    - Cylinders:         " << image.cylinders()
+                                         << std::endl
+                                         << "    - Heads:             " << image.heads()
+                                         << std::endl
+                                         << "    - Sectors per track: " << image.sectorsPerTrack()
+                                         << std::endl;
+                    
+                    if( driveNumber < 0x80 )
+                    {
+                        switch( image.size() )
+                        {
+                            case  368640: frame.bl( 0x01 ); break;
+                            case 1228800: frame.bl( 0x02 ); break;
+                            case  737280: frame.bl( 0x03 ); break;
+                            case 2949120: frame.bl( 0x05 ); break;
+                            default:      frame.bl( 0x04 ); break;
+                        }
+                        
+                        frame.es( 0 );
+                        frame.di( 0 );
+                    }
+                    
+                    frame.ch( static_cast< uint8_t >( cylinders & 0xFF ) );
+                    frame.cl( static_cast< uint8_t >( ( image.sectorsPerTrack() & 0x3F ) | ( ( cylinders >> 2 ) & 0xC0 ) ) );
+                    frame.dh( static_cast< uint8_t >( image.heads() - 1 ) );
+                    frame.dl( count );
+                    frame.cf( false );
+                    frame.ax( 0 );
+                }
+                
+                return true;
             }
             
-            bool checkExtensions( const Machine & machine, Engine & engine )
+            bool getDiskType( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
+                ( void )engine;
+                
+                uint8_t driveNumber( frame.dl() );
+                
+                machine.ui().debug() << "Getting type of drive " << String::toHex( driveNumber ) << std::endl;
+                
+                frame.cf( false );
+                
+                if( machine.hasDrive( driveNumber ) == false )
+                {
+                    frame.ah( 0 );
+                }
+                else if( driveNumber < 0x80 )
+                {
+                    frame.ah( 1 );
+                }
+                else
+                {
+                    uint64_t sectors( machine.drive( driveNumber ).size() / 512 );
+                    
+                    sectors = std::min< uint64_t >( sectors, 0xFFFFFFFF );
+                    
+                    frame.ah( 3 );
+                    frame.cx( static_cast< uint16_t >( sectors >> 16 ) );
+                    frame.dx( static_cast< uint16_t >( sectors & 0xFFFF ) );
+                }
+                
+                return true;
+            }
+            
+            bool checkExtensions( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )engine;
+                
                 machine.ui().debug() << "Checking if INT13h extensions are supported" << std::endl;
                 
-                engine.bx( 0xAA55 );
-                engine.cf( false );
-                engine.ah( 0 );
-                engine.cx( 7 );
+                if( machine.hasDrive( frame.dl() ) == false || frame.bx() != 0x55AA )
+                {
+                    frame.cf( true );
+                    frame.ah( 1 );
+                    
+                    return true;
+                }
+                
+                frame.bx( 0xAA55 );
+                frame.cf( false );
+                frame.ah( 0 );
+                frame.cx( 7 );
                 
                 return true;
             }
             
-            bool extendedReadSectors( const Machine & machine, Engine & engine )
+            bool extendedReadSectors( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                uint8_t          driveNumber     = engine.dl();
-                uint64_t         dapAddress      = Engine::getAddress( engine.ds(), engine.si() );
-                FAT::Image       image           = machine.bootImage();
-                FAT::MBR         mbr             = image.mbr();
-                BinaryDataStream dapData         = engine.read( dapAddress, FAT::DAP::DataSize() );
-                FAT::DAP         dap             = dapData;
-                uint64_t         destination     = Engine::getAddress( dap.destinationSegment(), dap.destinationOffset() );
-                uint64_t         numberOfSectors = numeric_cast< uint64_t >( dap.numberOfSectors() );
-                uint64_t         bytesPerSector  = ( mbr.isValid() ) ? mbr.bytesPerSector() : 512;
-                uint64_t         offset          = dap.logicalBlockAddress() * bytesPerSector;
-                uint64_t         size            = numberOfSectors * bytesPerSector;
-                
-                if( driveNumber != 0x00 )
+                uint8_t            driveNumber     = frame.dl();
+                uint64_t           dapAddress      = Engine::getAddress( frame.ds(), frame.si() );
+                BinaryDataStream   dapData         = engine.read( dapAddress, FAT::DAP::DataSize() );
+                FAT::DAP           dap             = dapData;
+                uint64_t           destination     = Engine::getAddress( dap.destinationSegment(), dap.destinationOffset() );
+                uint64_t           numberOfSectors = numeric_cast< uint64_t >( dap.numberOfSectors() );
+                const FAT::Image * image           = nullptr;
+                uint64_t           offset          = 0;
+                uint64_t           size            = 0;
+                
+                if( machine.hasDrive( driveNumber ) == false )
                 {
-                    machine.ui().debug() << "[ ERROR ]> Reading from drive " << String::toHex( driveNumber ) << " is not supported" << std::endl;
+                    machine.ui().debug() << "[ ERROR ]> No such drive: " << String::toHex( driveNumber ) << std::endl;
                     
                     goto error;
                 }
                 
+                image  = &( machine.drive( driveNumber ) );
+                offset = dap.logicalBlockAddress() * bytesPerSector( *( image ) );
+                size   = numberOfSectors * bytesPerSector( *( image ) );
+                
                 machine.ui().debug() << "Reading DAP at " << String::toHex( dapAddress ) << " from drive " << String::toHex( driveNumber )
                                      << std::endl
-                                     << "    - DAP Address: " << String::toHex( dapAddress )  << " (" << String::toHex( engine.ds() ) << ":" << String::toHex( engine.si() ) << ")"
+                                     << "    - DAP Address: " << String::toHex( dapAddress )  << " (" << String::toHex( frame.ds() ) << ":" << String::toHex( frame.si() ) << ")"
                                      << std::endl
                                      << "    - LBA:         " << String::toHex( dap.logicalBlockAddress() )
                                      << std::endl
@@ -159,8 +295,15 @@ namespace UB
                                      << "    - Destination: " << String::toHex( destination ) << " (" << String::toHex( dap.destinationSegment() ) << ":" << String::toHex( dap.destinationOffset() ) << ")"
                                      << std::endl;
                 
+                if( offset > image->size() || size > image->size() - offset )
+                {
+                    machine.ui().debug() << "[ ERROR ]> Sector out of range" << std::endl;
+                    
+                    goto error;
+                }
+                
                 {
-                    std::vector< uint8_t > bytes( image.read( offset, size ) );
+                    std::vector< uint8_t > bytes( image->read( offset, size ) );
                     
                     if( bytes.size() == 0 )
                     {
@@ -179,19 +322,80 @@ namespace UB
                                          << String::toHex( destination + bytes.size() )
                                          << std::endl;
                     
-                    engine.cf( false );
-                    engine.ah( 0 );
+                    frame.cf( false );
+                    frame.ah( 0 );
                     
                     return true;
                 }
                 
                 error:
                     
-                    engine.cf( true );
-                    engine.ah( 1 );
+                    frame.cf( true );
+                    frame.ah( 1 );
                     
                     return true;
             }
+            
+            bool extendedGetDriveParameters( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint8_t  driveNumber( frame.dl() );
+                uint64_t address( Engine::getAddress( frame.ds(), frame.si() ) );
+                
+                machine.ui().debug() << "Getting extended parameters for drive " << String::toHex( driveNumber ) << std::endl;
+                
+                if( machine.hasDrive( driveNumber ) == false )
+                {
+                    machine.ui().debug() << "[ ERROR ]> No such drive: " << String::toHex( driveNumber ) << std::endl;
+                    
+                    frame.cf( true );
+                    frame.ah( 1 );
+                    
+                    return true;
+                }
+                
+                {
+                    const FAT::Image     & image( machine.drive( driveNumber ) );
+                    std::vector< uint8_t > buffer( engine.read( address, 2 ) );
+                    uint16_t               length( static_cast< uint16_t >( buffer[ 0 ] | ( buffer[ 1 ] << 8 ) ) );
+                    uint64_t               bps( bytesPerSector( image ) );
+                    std::vector< uint8_t > data;
+                    
+                    auto write = [ & ]( uint64_t value, size_t bytes )
+                    {
+                        for( size_t i = 0; i < bytes; i++ )
+                        {
+                            data.push_back( static_cast< uint8_t >( ( value >> ( i * 8 ) ) & 0xFF ) );
+                        }
+                    };
+                    
+                    if( length < 0x1A )
+                    {
+                        frame.cf( true );
+                        frame.ah( 1 );
+                        
+                        return true;
+                    }
+                    
+                    write( ( length >= 0x1E ) ? 0x1E : 0x1A,         2 );
+                    write( ( driveNumber < 0x80 ) ? 0x0006 : 0x0002, 2 );
+                    write( image.cylinders(),                        4 );
+                    write( image.heads(),                            4 );
+                    write( image.sectorsPerTrack(),                  4 );
+                    write( image.size() / bps,                       8 );
+                    write( bps,                                      2 );
+                    
+                    if( length >= 0x1E )
+                    {
+                        write( 0xFFFFFFFF, 4 );
+                    }
+                    
+                    engine.write( address, data );
+                    frame.cf( false );
+                    frame.ah( 0 );
+                }
+                
+                return true;
+            }
         }
     }
 }
@@ -29,15 +29,19 @@ namespace UB
 {
     class Machine;
     class Engine;
+    class RegisterFrame;
     
     namespace BIOS
     {
         namespace Disk
         {
-            bool reset( const Machine & machine, Engine & engine );
-            bool readSectors( const Machine & machine, Engine & engine );
-            bool checkExtensions( const Machine & machine, Engine & engine );
-            bool extendedReadSectors( const Machine & machine, Engine & engine );
+            bool reset( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool readSectors( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getDriveParameters( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getDiskType( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool checkExtensions( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool extendedReadSectors( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool extendedGetDriveParameters( const Machine & machine, Engine & engine, RegisterFrame & frame );
         }
     }
 }
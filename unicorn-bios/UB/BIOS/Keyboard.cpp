@@ -25,6 +25,8 @@
 #include "UB/BIOS/Keyboard.hpp"
 #include "UB/Machine.hpp"
 #include "UB/Engine.hpp"
+#include <map>
+#include <cctype>
 
 namespace UB
 {
@@ -32,13 +34,306 @@ namespace UB
     {
         namespace Keyboard
         {
-            bool readKey( const Machine & machine, Engine & engine )
+            static bool     read(  const Machine & machine, Engine & engine, RegisterFrame & frame, bool extended );
+            static bool     check( Engine & engine, RegisterFrame & frame, bool extended );
+            static bool     wait(  const Machine & machine, Engine & engine, RegisterFrame & frame );
+            static bool     retry( Engine & engine, RegisterFrame & frame );
+            static bool     pop(   Engine & engine, uint16_t & key, bool remove );
+            static uint16_t word(  Engine & engine, size_t address );
+            static void     word(  Engine & engine, size_t address, uint16_t value );
+            
+            bool readKey( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                return read( machine, engine, frame, false );
+            }
+            
+            bool checkKey( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )machine;
+                
+                return check( engine, frame, false );
+            }
+            
+            bool getShiftFlags( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
                 ( void )machine;
-                ( void )engine;
+                
+                frame.al( engine.read( 0x417, 1 )[ 0 ] );
                 
                 return true;
             }
+            
+            bool readExtendedKey( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                return read( machine, engine, frame, true );
+            }
+            
+            bool checkExtendedKey( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )machine;
+                
+                return check( engine, frame, true );
+            }
+            
+            void initialize( Engine & engine )
+            {
+                word( engine, 0x41A, 0x001E );
+                word( engine, 0x41C, 0x001E );
+                word( engine, 0x480, 0x001E );
+                word( engine, 0x482, 0x003E );
+                
+                engine.write( 0x417, { 0x00, 0x00 } );
+            }
+            
+            bool push( Engine & engine, uint16_t key )
+            {
+                uint16_t start( word( engine, 0x480 ) );
+                uint16_t end(   word( engine, 0x482 ) );
+                uint16_t head(  word( engine, 0x41A ) );
+                uint16_t tail(  word( engine, 0x41C ) );
+                uint16_t next(  static_cast< uint16_t >( tail + 2 ) );
+                
+                if( next >= end )
+                {
+                    next = start;
+                }
+                
+                if( next == head )
+                {
+                    return false;
+                }
+                
+                word( engine, 0x400 + static_cast< size_t >( tail ), key );
+                word( engine, 0x41C, next );
+                
+                return true;
+            }
+            
+            uint16_t keyCode( int c )
+            {
+                static const char * const keys[]    = { "1234567890-=", "qwertyuiop[]", "asdfghjkl;'`", "\\zxcvbnm,./" };
+                static const char * const shifted[] = { "!@#$%^&*()_+", "QWERTYUIOP{}", "ASDFGHJKL:\"~", "|ZXCVBNM<>?" };
+                static const uint8_t      scans[]   = { 0x02, 0x10, 0x1E, 0x2B };
+                
+                switch( c )
+                {
+                    case 0x08: case 0x7F: return 0x0E08;
+                    case 0x09:            return 0x0F09;
+                    case 0x0A: case 0x0D: return 0x1C0D;
+                    case 0x1B:            return 0x011B;
+                    case 0x20:            return 0x3920;
+                    default:              break;
+                }
+                
+                if( c > 0x00 && c < 0x1B )
+                {
+                    return static_cast< uint16_t >( ( keyCode( c + 0x60 ) & 0xFF00 ) | c );
+                }
+                
+                for( size_t i = 0; i < sizeof( scans ); i++ )
+                {
+                    for( size_t j = 0; keys[ i ][ j ] != 0; j++ )
+                    {
+                        if( keys[ i ][ j ] == c || shifted[ i ][ j ] == c )
+                        {
+                            return static_cast< uint16_t >( ( ( scans[ i ] + j ) << 8 ) | static_cast< uint8_t >( c ) );
+                        }
+                    }
+                }
+                
+                return 0;
+            }
+            
+            uint16_t keyCode( const std::string & name )
+            {
+                static const std::map< std::string, uint16_t > keys =
+                {
+                    { "enter",     0x1C0D },
+                    { "esc",       0x011B },
+                    { "tab",       0x0F09 },
+                    { "backspace", 0x0E08 },
+                    { "space",     0x3920 },
+                    { "up",        0x4800 },
+                    { "down",      0x5000 },
+                    { "left",      0x4B00 },
+                    { "right",     0x4D00 },
+                    { "home",      0x4700 },
+                    { "end",       0x4F00 },
+                    { "pgup",      0x4900 },
+                    { "pgdn",      0x5100 },
+                    { "ins",       0x5200 },
+                    { "del",       0x5300 },
+                    { "f1",        0x3B00 },
+                    { "f2",        0x3C00 },
+                    { "f3",        0x3D00 },
+                    { "f4",        0x3E00 },
+                    { "f5",        0x3F00 },
+                    { "f6",        0x4000 },
+                    { "f7",        0x4100 },
+                    { "f8",        0x4200 },
+                    { "f9",        0x4300 },
+                    { "f10",       0x4400 },
+                    { "f11",       0x8500 },
+                    { "f12",       0x8600 }
+                };
+                
+                std::string lower( name );
+                
+                std::transform( lower.begin(), lower.end(), lower.begin(), []( char c ) { return static_cast< char >( ::tolower( c ) ); } );
+                
+                {
+                    auto it( keys.find( lower ) );
+                    
+                    if( it != keys.end() )
+                    {
+                        return it->second;
+                    }
+                }
+                
+                if( name.length() == 1 )
+                {
+                    return keyCode( static_cast< uint8_t >( name[ 0 ] ) );
+                }
+                
+                if( lower.length() == 6 && lower.substr( 0, 5 ) == "ctrl-" && ::islower( lower[ 5 ] ) )
+                {
+                    return keyCode( lower[ 5 ] - 0x60 );
+                }
+                
+                return 0;
+            }
+            
+            static bool read( const Machine & machine, Engine & engine, RegisterFrame & frame, bool extended )
+            {
+                uint16_t key( 0 );
+                
+                while( true )
+                {
+                    if( pop( engine, key, true ) == false )
+                    {
+                        if( wait( machine, engine, frame ) == false )
+                        {
+                            return true;
+                        }
+                    }
+                    else if( extended || ( key >> 8 ) < 0x85 )
+                    {
+                        break;
+                    }
+                }
+                
+                frame.ax( key );
+                
+                return true;
+            }
+            
+            static bool check( Engine & engine, RegisterFrame & frame, bool extended )
+            {
+                uint16_t key( 0 );
+                
+                while( pop( engine, key, false ) )
+                {
+                    if( extended || ( key >> 8 ) < 0x85 )
+                    {
+                        frame.ax( key );
+                        frame.zf( false );
+                        
+                        return true;
+                    }
+                    
+                    pop( engine, key, true );
+                }
+                
+                frame.zf( true );
+                
+                return true;
+            }
+            
+            static bool wait( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint16_t key( 0 );
+                
+                machine.waitForKey();
+                
+                if( pop( engine, key, false ) )
+                {
+                    return true;
+                }
+                
+                if( retry( engine, frame ) == false )
+                {
+                    frame.ax( 0 );
+                }
+                
+                return false;
+            }
+            
+            static bool retry( Engine & engine, RegisterFrame & frame )
+            {
+                std::vector< uint8_t > instruction( engine.read( Engine::getAddress( frame.cs(), frame.ip() ), 2 ) );
+                
+                if( instruction[ 0 ] == 0xCD && instruction[ 1 ] == 0x16 )
+                {
+                    frame.eflags( frame.eflags() | 0x0200 );
+                    engine.jump( Engine::getAddress( frame.cs(), frame.ip() ) );
+                    
+                    return true;
+                }
+                
+                {
+                    uint64_t               stack( Engine::getAddress( frame.ss(), frame.sp() ) );
+                    std::vector< uint8_t > data( engine.read( stack, 6 ) );
+                    uint16_t               ip( static_cast< uint16_t >( ( data[ 0 ] | ( data[ 1 ] << 8 ) ) - 2 ) );
+                    uint16_t               cs( static_cast< uint16_t >( data[ 2 ] | ( data[ 3 ] << 8 ) ) );
+                    
+                    instruction = engine.read( Engine::getAddress( cs, ip ), 2 );
+                    
+                    if( instruction[ 0 ] != 0xCD || instruction[ 1 ] != 0x16 )
+                    {
+                        return false;
+                    }
+                    
+                    word( engine, stack, ip );
+                    engine.write( stack + 5, { static_cast< uint8_t >( data[ 5 ] | 0x02 ) } );
+                }
+                
+                return true;
+            }
+            
+            static bool pop( Engine & engine, uint16_t & key, bool remove )
+            {
+                uint16_t start( word( engine, 0x480 ) );
+                uint16_t end(   word( engine, 0x482 ) );
+                uint16_t head(  word( engine, 0x41A ) );
+                uint16_t tail(  word( engine, 0x41C ) );
+                uint16_t next(  static_cast< uint16_t >( head + 2 ) );
+                
+                if( head == tail )
+                {
+                    return false;
+                }
+                
+                key = word( engine, 0x400 + static_cast< size_t >( head ) );
+                
+                if( remove )
+                {
+                    word( engine, 0x41A, ( next >= end ) ? start : next );
+                }
+                
+                return true;
+            }
+            
+            static uint16_t word( Engine & engine, size_t address )
+            {
+                std::vector< uint8_t > data( engine.read( address, 2 ) );
+                
+                return static_cast< uint16_t >( data[ 0 ] | ( data[ 1 ] << 8 ) );
+            }
+            
+            static void word( Engine & engine, size_t address, uint16_t value )
+            {
+                engine.write( address, { static_cast< uint8_t >( value & 0xFF ), static_cast< uint8_t >( value >> 8 ) } );
+            }
         }
     }
 }
@@ -25,16 +25,29 @@
 #ifndef UB_BIOS_KEYBOARD_HPP
 #define UB_BIOS_KEYBOARD_HPP
 
+#include <cstdint>
+#include <string>
+
 namespace UB
 {
     class Machine;
     class Engine;
+    class RegisterFrame;
     
     namespace BIOS
     {
         namespace Keyboard
         {
-            bool readKey( const Machine & machine, Engine & engine );
+            bool readKey(          const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool checkKey(         const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getShiftFlags(    const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool readExtendedKey(  const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool checkExtendedKey( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            
+            void     initialize( Engine & engine );
+            bool     push( Engine & engine, uint16_t key );
+            uint16_t keyCode( int c );
+            uint16_t keyCode( const std::string & name );
         }
     }
 }
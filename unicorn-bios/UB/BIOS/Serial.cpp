@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/BIOS/Serial.hpp"
+#include "UB/Machine.hpp"
+#include "UB/Engine.hpp"
+#include "UB/String.hpp"
+#include "UB/Devices/Bus.hpp"
+
+namespace UB
+{
+    namespace BIOS
+    {
+        namespace Serial
+        {
+            static bool    base( Engine & engine, RegisterFrame & frame, uint16_t & port );
+            static uint8_t in(   const Machine & machine, uint16_t port );
+            static void    out(  const Machine & machine, uint16_t port, uint8_t value );
+            
+            bool initialize( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                static const uint16_t divisors[] = { 0x0417, 0x0300, 0x0180, 0x00C0, 0x0060, 0x0030, 0x0018, 0x000C };
+                
+                uint16_t port( 0 );
+                uint16_t divisor( divisors[ frame.al() >> 5 ] );
+                
+                if( base( engine, frame, port ) == false )
+                {
+                    return true;
+                }
+                
+                machine.ui().debug() << "Initializing serial port " << String::toHex( port )
+                                     << std::endl
+                                     << "    - Baud rate:   " << 115200 / divisor
+                                     << std::endl
+                                     << "    - Line config: " << String::toHex( static_cast< uint8_t >( frame.al() & 0x1F ) )
+                                     << std::endl;
+                
+                out( machine, static_cast< uint16_t >( port + 3 ), 0x80 );
+                out( machine, static_cast< uint16_t >( port + 0 ), static_cast< uint8_t >( divisor & 0xFF ) );
+                out( machine, static_cast< uint16_t >( port + 1 ), static_cast< uint8_t >( divisor >> 8 ) );
+                out( machine, static_cast< uint16_t >( port + 3 ), static_cast< uint8_t >( frame.al() & 0x1F ) );
+                out( machine, static_cast< uint16_t >( port + 1 ), 0x00 );
+                
+                frame.ah( in( machine, static_cast< uint16_t >( port + 5 ) ) );
+                frame.al( in( machine, static_cast< uint16_t >( port + 6 ) ) );
+                
+                return true;
+            }
+            
+            bool send( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint16_t port( 0 );
+                uint8_t  lsr( 0 );
+                
+                if( base( engine, frame, port ) == false )
+                {
+                    return true;
+                }
+                
+                lsr = in( machine, static_cast< uint16_t >( port + 5 ) );
+                
+                if( ( lsr & 0x20 ) == 0 )
+                {
+                    frame.ah( static_cast< uint8_t >( lsr | 0x80 ) );
+                    
+                    return true;
+                }
+                
+                out( machine, port, frame.al() );
+                frame.ah( in( machine, static_cast< uint16_t >( port + 5 ) ) );
+                
+                return true;
+            }
+            
+            bool receive( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint16_t port( 0 );
+                uint8_t  lsr( 0 );
+                
+                if( base( engine, frame, port ) == false )
+                {
+                    return true;
+                }
+                
+                lsr = in( machine, static_cast< uint16_t >( port + 5 ) );
+                
+                if( ( lsr & 0x01 ) == 0 )
+                {
+                    frame.ah( static_cast< uint8_t >( lsr | 0x80 ) );
+                    
+                    return true;
+                }
+                
+                frame.al( in( machine, port ) );
+                frame.ah( static_cast< uint8_t >( lsr & 0x1E ) );
+                
+                return true;
+            }
+            
+            bool status( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint16_t port( 0 );
+                
+                if( base( engine, frame, port ) == false )
+                {
+                    return true;
+                }
+                
+                frame.ah( in( machine, static_cast< uint16_t >( port + 5 ) ) );
+                frame.al( in( machine, static_cast< uint16_t >( port + 6 ) ) );
+                
+                return true;
+            }
+            
+            static bool base( Engine & engine, RegisterFrame & frame, uint16_t & port )
+            {
+                std::vector< uint8_t > data;
+                
+                if( frame.dx() > 3 )
+                {
+                    frame.ah( 0x80 );
+                    
+                    return false;
+                }
+                
+                data = engine.read( 0x400 + static_cast< size_t >( frame.dx() ) * 2, 2 );
+                port = static_cast< uint16_t >( data[ 0 ] | ( data[ 1 ] << 8 ) );
+                
+                if( port == 0 )
+                {
+                    frame.ah( 0x80 );
+                    
+                    return false;
+                }
+                
+                return true;
+            }
+            
+            static uint8_t in( const Machine & machine, uint16_t port )
+            {
+                uint32_t value( 0xFF );
+                
+                machine.bus().read( port, 1, value );
+                
+                return static_cast< uint8_t >( value );
+            }
+            
+            static void out( const Machine & machine, uint16_t port, uint8_t value )
+            {
+                machine.bus().write( port, 1, value );
+            }
+        }
+    }
+}
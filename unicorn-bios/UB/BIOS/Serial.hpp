@@ -22,30 +22,25 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
-#include "UB/CPU/Functions.hpp"
+#ifndef UB_BIOS_SERIAL_HPP
+#define UB_BIOS_SERIAL_HPP
 
 namespace UB
 {
-    namespace CPU
+    class Machine;
+    class Engine;
+    class RegisterFrame;
+    
+    namespace BIOS
     {
-        void cpuid( Engine & engine, const Registers & registers )
+        namespace Serial
         {
-            uint32_t eax( registers.eax() );
-            
-            if( eax == 0 )
-            {
-                engine.ebx( 0x43494E55 );
-                engine.edx( 0x2D4E524F );
-                engine.ecx( 0x534F4942 );
-            }
-            else if( eax == 0x80000000 )
-            {
-                engine.eax( 0x80000001 );
-            }
-            else if( eax == 0x80000001 )
-            {
-                engine.edx( engine.edx() & 0xDFFFFFFF );
-            }
+            bool initialize( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool send(       const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool receive(    const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool status(     const Machine & machine, Engine & engine, RegisterFrame & frame );
         }
     }
 }
+
+#endif /* UB_BIOS_SERIAL_HPP */
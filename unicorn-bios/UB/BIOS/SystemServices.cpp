@@ -33,12 +33,12 @@ namespace UB
     {
         namespace SystemServices
         {
-            bool getMemoryMap( const Machine & machine, Engine & engine )
+            bool getMemoryMap( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                uint64_t                        destination( Engine::getAddress( engine.es(), engine.di() ) );
-                uint32_t                        index( engine.ebx() );
-                uint32_t                        size( engine.ecx() );
-                uint32_t                        signature( engine.edx() );
+                uint64_t                        destination( Engine::getAddress( frame.es(), frame.di() ) );
+                uint32_t                        index( frame.ebx() );
+                uint32_t                        size( frame.ecx() );
+                uint32_t                        signature( frame.edx() );
                 const MemoryMap               & map( machine.memoryMap() );
                 std::vector< MemoryMap::Entry > entries( map.entries() );
                 
@@ -46,7 +46,7 @@ namespace UB
                                      << std::endl
                                      << "    - Continuation: " << String::toHex( index )
                                      << std::endl
-                                     << "    - Destination:  " << String::toHex( destination ) << " (" << String::toHex( engine.es() ) << ":" << String::toHex( engine.di() ) << ")"
+                                     << "    - Destination:  " << String::toHex( destination ) << " (" << String::toHex( frame.es() ) << ":" << String::toHex( frame.di() ) << ")"
                                      << std::endl
                                      << "    - Buffer size:  " << String::toHex( size )
                                      << std::endl
@@ -110,17 +110,17 @@ namespace UB
                         engine.write( destination, reinterpret_cast< const uint8_t * >( data.data() ), data.size() );
                     }
                     
-                    engine.cf( false );
-                    engine.eax( 0x534D4150 );
-                    engine.ecx( 0x00000014 );
+                    frame.cf( false );
+                    frame.eax( 0x534D4150 );
+                    frame.ecx( 0x00000014 );
                     
                     if( index == entries.size() - 1 )
                     {
-                        engine.ebx( 0 );
+                        frame.ebx( 0 );
                     }
                     else
                     {
-                        engine.ebx( index + 1 );
+                        frame.ebx( index + 1 );
                     }
                     
                     machine.ui().debug() << "[ SUCCESS ]> Wrote 20 bytes at "
@@ -134,17 +134,19 @@ namespace UB
                 
                 error:
                     
-                    engine.cf( true );
-                    engine.eax( 0x534D4150 );
-                    engine.ebx( 0x00000000 );
-                    engine.ecx( 0x00000014 );
+                    frame.cf( true );
+                    frame.eax( 0x534D4150 );
+                    frame.ebx( 0x00000000 );
+                    frame.ecx( 0x00000014 );
                     
                     return false;
             }
 
-            bool enterLongMode( const Machine & machine, Engine & engine )
+            bool enterLongMode( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                uint8_t mode( engine.bl() );
+                ( void )engine;
+                
+                uint8_t mode( frame.bl() );
 
                 switch ( mode )
                 {
@@ -165,12 +167,12 @@ namespace UB
                         goto error;
                 }
 
-                engine.cf( false );
+                frame.cf( false );
                 return true;
 
                 error:
 
-                    engine.cf( true );
+                    frame.cf( true );
                     return false;
             }
         }
@@ -29,13 +29,14 @@ namespace UB
 {
     class Machine;
     class Engine;
+    class RegisterFrame;
     
     namespace BIOS
     {
         namespace SystemServices
         {
-            bool getMemoryMap(  const Machine & machine, Engine & engine );
-            bool enterLongMode( const Machine & machine, Engine & engine );
+            bool getMemoryMap(  const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool enterLongMode( const Machine & machine, Engine & engine, RegisterFrame & frame );
         }
     }
 }
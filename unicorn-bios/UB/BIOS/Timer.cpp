@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/BIOS/Timer.hpp"
+#include "UB/Machine.hpp"
+#include "UB/Engine.hpp"
+#include "UB/Devices/Bus.hpp"
+#include "UB/Devices/CMOS.hpp"
+
+namespace UB
+{
+    namespace BIOS
+    {
+        namespace Timer
+        {
+            static uint32_t ticks( Engine & engine );
+            static void     ticks( Engine & engine, uint32_t value );
+            static uint8_t  cmos( const Machine & machine, uint8_t index );
+            
+            bool tick( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint32_t value( ticks( engine ) + 1 );
+                
+                ( void )frame;
+                
+                if( value >= 0x1800B0 )
+                {
+                    value = 0;
+                    
+                    engine.write( 0x470, { 0x01 } );
+                }
+                
+                ticks( engine, value );
+                machine.bus().write( 0x20, 1, 0x20 );
+                
+                return true;
+            }
+            
+            bool getSystemTime( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint32_t value( ticks( engine ) );
+                
+                ( void )machine;
+                
+                frame.al( engine.read( 0x470, 1 )[ 0 ] );
+                frame.cx( static_cast< uint16_t >( value >> 16 ) );
+                frame.dx( static_cast< uint16_t >( value & 0xFFFF ) );
+                
+                engine.write( 0x470, { 0x00 } );
+                
+                return true;
+            }
+            
+            bool setSystemTime( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )machine;
+                
+                ticks( engine, static_cast< uint32_t >( ( frame.cx() << 16 ) | frame.dx() ) );
+                engine.write( 0x470, { 0x00 } );
+                
+                return true;
+            }
+            
+            bool getRTCTime( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )engine;
+                
+                frame.ch( cmos( machine, 0x04 ) );
+                frame.cl( cmos( machine, 0x02 ) );
+                frame.dh( cmos( machine, 0x00 ) );
+                frame.dl( static_cast< uint8_t >( cmos( machine, 0x0B ) & 0x01 ) );
+                frame.cf( false );
+                
+                return true;
+            }
+            
+            bool getRTCDate( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )engine;
+                
+                frame.ch( cmos( machine, 0x32 ) );
+                frame.cl( cmos( machine, 0x09 ) );
+                frame.dh( cmos( machine, 0x08 ) );
+                frame.dl( cmos( machine, 0x07 ) );
+                frame.cf( false );
+                
+                return true;
+            }
+            
+            static uint32_t ticks( Engine & engine )
+            {
+                std::vector< uint8_t > data( engine.read( 0x46C, 4 ) );
+                
+                return static_cast< uint32_t >( data[ 0 ] | ( data[ 1 ] << 8 ) | ( data[ 2 ] << 16 ) | ( data[ 3 ] << 24 ) );
+            }
+            
+            static void ticks( Engine & engine, uint32_t value )
+            {
+                engine.write
+                (
+                    0x46C,
+                    {
+                        static_cast< uint8_t >( value & 0xFF ),
+                        static_cast< uint8_t >( ( value >> 8 ) & 0xFF ),
+                        static_cast< uint8_t >( ( value >> 16 ) & 0xFF ),
+                        static_cast< uint8_t >( ( value >> 24 ) & 0xFF )
+                    }
+                );
+            }
+            
+            static uint8_t cmos( const Machine & machine, uint8_t index )
+            {
+                return machine.cmos().clock( machine.bus(), index );
+            }
+        }
+    }
+}
@@ -32,16 +32,23 @@ namespace UB
         {
             public:
                 
-                IMPL( void );
+                IMPL( uint16_t segment, uint16_t offset, const std::vector< uint16_t > & modes, size_t memory );
                 IMPL( const IMPL & o );
                 ~IMPL( void );
                 
+                void _pointer( std::vector< uint8_t > & data, size_t position, size_t offset ) const;
+                void _string( std::vector< uint8_t > & data, size_t offset, const std::string & s ) const;
+                
                 std::array< uint8_t, 4 > _signature;
                 uint16_t                 _version;
+                uint16_t                 _segment;
+                uint16_t                 _offset;
+                std::vector< uint16_t >  _modes;
+                size_t                   _memory;
         };
 
-        VESAInfo::VESAInfo( void ):
-            impl( std::make_unique< IMPL >() )
+        VESAInfo::VESAInfo( uint16_t segment, uint16_t offset, const std::vector< uint16_t > & modes, size_t memory ):
+            impl( std::make_unique< IMPL >( segment, offset, modes, memory ) )
         {}
 
         VESAInfo::VESAInfo( const VESAInfo & o ):
@@ -64,7 +71,42 @@ namespace UB
         
         std::vector< uint8_t > VESAInfo::data( void ) const
         {
-            return {};
+            std::vector< uint8_t > data( 512, 0 );
+            size_t                 memory( std::min< size_t >( this->impl->_memory / 0x10000, 0xFFFF ) );
+            size_t                 i( 0x22 );
+            
+            std::copy( this->impl->_signature.begin(), this->impl->_signature.end(), data.begin() );
+            
+            data[ 0x04 ] = static_cast< uint8_t >( this->impl->_version & 0xFF );
+            data[ 0x05 ] = static_cast< uint8_t >( this->impl->_version >> 8 );
+            data[ 0x12 ] = static_cast< uint8_t >( memory & 0xFF );
+            data[ 0x13 ] = static_cast< uint8_t >( memory >> 8 );
+            
+            for( uint16_t mode: this->impl->_modes )
+            {
+                if( i + 4 > 0x60 )
+                {
+                    break;
+                }
+                
+                data[ i++ ] = static_cast< uint8_t >( mode & 0xFF );
+                data[ i++ ] = static_cast< uint8_t >( mode >> 8 );
+            }
+            
+            data[ i++ ] = 0xFF;
+            data[ i++ ] = 0xFF;
+            
+            this->impl->_pointer( data, 0x0E, 0x22 );
+            this->impl->_pointer( data, 0x06, 0x60 );
+            this->impl->_pointer( data, 0x16, 0x70 );
+            this->impl->_pointer( data, 0x1A, 0x80 );
+            this->impl->_pointer( data, 0x1E, 0x98 );
+            this->impl->_string(  data, 0x60, "unicorn-bios" );
+            this->impl->_string(  data, 0x70, "XS-Labs" );
+            this->impl->_string(  data, 0x80, "unicorn-bios VBE" );
+            this->impl->_string(  data, 0x98, "1.0" );
+            
+            return data;
         }
         
         std::array< uint8_t, 4 > VESAInfo::signature( void ) const
@@ -77,6 +119,16 @@ namespace UB
             return this->impl->_version;
         }
         
+        std::vector< uint16_t > VESAInfo::modes( void ) const
+        {
+            return this->impl->_modes;
+        }
+        
+        size_t VESAInfo::memory( void ) const
+        {
+            return this->impl->_memory;
+        }
+        
         void swap( VESAInfo & o1, VESAInfo & o2 )
         {
             using std::swap;
@@ -84,17 +136,40 @@ namespace UB
             swap( o1.impl, o2.impl );
         }
 
-        VESAInfo::IMPL::IMPL( void ):
+        VESAInfo::IMPL::IMPL( uint16_t segment, uint16_t offset, const std::vector< uint16_t > & modes, size_t memory ):
             _signature( { 'V', 'E', 'S', 'A' } ),
-            _version(   0x0200 )
+            _version(   0x0300 ),
+            _segment(   segment ),
+            _offset(    offset ),
+            _modes(     modes ),
+            _memory(    memory )
         {}
 
         VESAInfo::IMPL::IMPL( const IMPL & o ):
             _signature( o._signature ),
-            _version( o._version )
+            _version(   o._version ),
+            _segment(   o._segment ),
+            _offset(    o._offset ),
+            _modes(     o._modes ),
+            _memory(    o._memory )
         {}
 
         VESAInfo::IMPL::~IMPL( void )
         {}
+        
+        void VESAInfo::IMPL::_pointer( std::vector< uint8_t > & data, size_t position, size_t offset ) const
+        {
+            uint16_t address( static_cast< uint16_t >( this->_offset + offset ) );
+            
+            data[ position ]     = static_cast< uint8_t >( address & 0xFF );
+            data[ position + 1 ] = static_cast< uint8_t >( address >> 8 );
+            data[ position + 2 ] = static_cast< uint8_t >( this->_segment & 0xFF );
+            data[ position + 3 ] = static_cast< uint8_t >( this->_segment >> 8 );
+        }
+        
+        void VESAInfo::IMPL::_string( std::vector< uint8_t > & data, size_t offset, const std::string & s ) const
+        {
+            std::copy( s.begin(), s.end(), data.begin() + static_cast< std::ptrdiff_t >( offset ) );
+        }
     }
 }
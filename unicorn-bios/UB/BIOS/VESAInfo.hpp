@@ -30,6 +30,7 @@
 #include <vector>
 #include <cstdint>
 #include <array>
+#include <string>
 
 namespace UB
 {
@@ -39,7 +40,7 @@ namespace UB
         {
             public:
                 
-                VESAInfo( void );
+                VESAInfo( uint16_t segment, uint16_t offset, const std::vector< uint16_t > & modes, size_t memory );
                 VESAInfo( const VESAInfo & o );
                 VESAInfo( VESAInfo && o ) noexcept;
                 ~VESAInfo( void );
@@ -50,6 +51,8 @@ namespace UB
                 
                 std::array< uint8_t, 4 > signature( void ) const;
                 uint16_t                 version( void )   const;
+                std::vector< uint16_t >  modes( void )     const;
+                size_t                   memory( void )    const;
                 
                 friend void swap( VESAInfo & o1, VESAInfo & o2 );
                 
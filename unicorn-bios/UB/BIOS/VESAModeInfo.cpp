@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/BIOS/VESAModeInfo.hpp"
+
+namespace UB
+{
+    namespace BIOS
+    {
+        class VESAModeInfo::IMPL
+        {
+            public:
+                
+                IMPL( uint16_t width, uint16_t height, uint8_t bitsPerPixel, uint32_t base, size_t memory );
+                IMPL( const IMPL & o );
+                ~IMPL( void );
+                
+                uint16_t _width;
+                uint16_t _height;
+                uint8_t  _bitsPerPixel;
+                uint32_t _base;
+                size_t   _memory;
+        };
+        
+        VESAModeInfo::VESAModeInfo( uint16_t width, uint16_t height, uint8_t bitsPerPixel, uint32_t base, size_t memory ):
+            impl( std::make_unique< IMPL >( width, height, bitsPerPixel, base, memory ) )
+        {}
+        
+        VESAModeInfo::VESAModeInfo( const VESAModeInfo & o ):
+            impl( std::make_unique< IMPL >( *( o.impl ) ) )
+        {}
+        
+        VESAModeInfo::VESAModeInfo( VESAModeInfo && o ) noexcept:
+            impl( std::move( o.impl ) )
+        {}
+        
+        VESAModeInfo::~VESAModeInfo( void )
+        {}
+        
+        VESAModeInfo & VESAModeInfo::operator =( VESAModeInfo o )
+        {
+            swap( *( this ), o );
+            
+            return *( this );
+        }
+        
+        std::vector< uint8_t > VESAModeInfo::data( void ) const
+        {
+            std::vector< uint8_t > data( 256, 0 );
+            uint16_t               pitch( this->pitch() );
+            size_t                 pages( this->impl->_memory / std::max< size_t >( static_cast< size_t >( pitch ) * this->impl->_height, 1 ) );
+            uint8_t                bpp( this->impl->_bitsPerPixel );
+            std::vector< uint8_t > masks;
+            
+            if( bpp == 16 )
+            {
+                masks = { 5, 11, 6, 5, 5, 0, 0, 0 };
+            }
+            else
+            {
+                masks = { 8, 16, 8, 8, 8, 0, static_cast< uint8_t >( ( bpp == 32 ) ? 8 : 0 ), static_cast< uint8_t >( ( bpp == 32 ) ? 24 : 0 ) };
+            }
+            
+            pages = std::min< size_t >( std::max< size_t >( pages, 1 ) - 1, 0xFF );
+            
+            data[ 0x00 ] = 0x9B;
+            data[ 0x10 ] = static_cast< uint8_t >( pitch & 0xFF );
+            data[ 0x11 ] = static_cast< uint8_t >( pitch >> 8 );
+            data[ 0x12 ] = static_cast< uint8_t >( this->impl->_width & 0xFF );
+            data[ 0x13 ] = static_cast< uint8_t >( this->impl->_width >> 8 );
+            data[ 0x14 ] = static_cast< uint8_t >( this->impl->_height & 0xFF );
+            data[ 0x15 ] = static_cast< uint8_t >( this->impl->_height >> 8 );
+            data[ 0x16 ] = 8;
+            data[ 0x17 ] = 16;
+            data[ 0x18 ] = 1;
+            data[ 0x19 ] = bpp;
+            data[ 0x1A ] = 1;
+            data[ 0x1B ] = 0x06;
+            data[ 0x1D ] = static_cast< uint8_t >( pages );
+            data[ 0x1E ] = 1;
+            data[ 0x28 ] = static_cast< uint8_t >( this->impl->_base );
+            data[ 0x29 ] = static_cast< uint8_t >( this->impl->_base >> 8 );
+            data[ 0x2A ] = static_cast< uint8_t >( this->impl->_base >> 16 );
+            data[ 0x2B ] = static_cast< uint8_t >( this->impl->_base >> 24 );
+            data[ 0x32 ] = data[ 0x10 ];
+            data[ 0x33 ] = data[ 0x11 ];
+            data[ 0x34 ] = static_cast< uint8_t >( pages );
+            data[ 0x35 ] = static_cast< uint8_t >( pages );
+            
+            std::copy( masks.begin(), masks.end(), data.begin() + 0x1F );
+            std::copy( masks.begin(), masks.end(), data.begin() + 0x36 );
+            
+            return data;
+        }
+        
+        uint16_t VESAModeInfo::width( void ) const
+        {
+            return this->impl->_width;
+        }
+        
+        uint16_t VESAModeInfo::height( void ) const
+        {
+            return this->impl->_height;
+        }
+        
+        uint8_t VESAModeInfo::bitsPerPixel( void ) const
+        {
+            return this->impl->_bitsPerPixel;
+        }
+        
+        uint16_t VESAModeInfo::pitch( void ) const
+        {
+            return static_cast< uint16_t >( this->impl->_width * ( this->impl->_bitsPerPixel / 8 ) );
+        }
+        
+        uint32_t VESAModeInfo::base( void ) const
+        {
+            return this->impl->_base;
+        }
+        
+        void swap( VESAModeInfo & o1, VESAModeInfo & o2 )
+        {
+            using std::swap;
+            
+            swap( o1.impl, o2.impl );
+        }
+        
+        VESAModeInfo::IMPL::IMPL( uint16_t width, uint16_t height, uint8_t bitsPerPixel, uint32_t base, size_t memory ):
+            _width(        width ),
+            _height(       height ),
+            _bitsPerPixel( bitsPerPixel ),
+            _base(         base ),
+            _memory(       memory )
+        {}
+        
+        VESAModeInfo::IMPL::IMPL( const IMPL & o ):
+            _width(        o._width ),
+            _height(       o._height ),
+            _bitsPerPixel( o._bitsPerPixel ),
+            _base(         o._base ),
+            _memory(       o._memory )
+        {}
+        
+        VESAModeInfo::IMPL::~IMPL( void )
+        {}
+    }
+}
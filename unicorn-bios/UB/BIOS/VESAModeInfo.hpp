@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_BIOS_VESA_MODE_INFO_HPP
+#define UB_BIOS_VESA_MODE_INFO_HPP
+
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+namespace UB
+{
+    namespace BIOS
+    {
+        class VESAModeInfo
+        {
+            public:
+                
+                VESAModeInfo( uint16_t width, uint16_t height, uint8_t bitsPerPixel, uint32_t base, size_t memory );
+                VESAModeInfo( const VESAModeInfo & o );
+                VESAModeInfo( VESAModeInfo && o ) noexcept;
+                ~VESAModeInfo( void );
+                
+                VESAModeInfo & operator =( VESAModeInfo o );
+                
+                std::vector< uint8_t > data( void ) const;
+                
+                uint16_t width( void )        const;
+                uint16_t height( void )       const;
+                uint8_t  bitsPerPixel( void ) const;
+                uint16_t pitch( void )        const;
+                uint32_t base( void )         const;
+                
+                friend void swap( VESAModeInfo & o1, VESAModeInfo & o2 );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_BIOS_VESA_MODE_INFO_HPP */
@@ -24,9 +24,12 @@
 
 #include "UB/BIOS/Video.hpp"
 #include "UB/BIOS/VESAInfo.hpp"
+#include "UB/BIOS/VESAModeInfo.hpp"
 #include "UB/Machine.hpp"
 #include "UB/Engine.hpp"
 #include "UB/String.hpp"
+#include "UB/Devices/VGA.hpp"
+#include "UB/Devices/VBE.hpp"
 #include <cctype>
 
 namespace UB
@@ -35,9 +38,25 @@ namespace UB
     {
         namespace Video
         {
-            bool setVideoMode( const Machine & machine, Engine & engine )
+            static uint16_t word(    Engine & engine, size_t address );
+            static void     word(    Engine & engine, size_t address, uint16_t value );
+            static size_t   columns( Engine & engine );
+            static size_t   rows(    Engine & engine );
+            static uint8_t  page(    Engine & engine );
+            static size_t   address( Engine & engine, uint8_t page, size_t row, size_t column );
+            static void     cursor(  Devices::VGA & vga, Engine & engine, uint8_t page, size_t row, size_t column );
+            static void     fill(    Devices::VGA & vga, Engine & engine, size_t address, size_t count, uint8_t c, uint8_t attribute, bool setAttribute );
+            static void     scroll(  Devices::VGA & vga, Engine & engine, uint8_t page, size_t lines, bool up, size_t top, size_t left, size_t bottom, size_t right, uint8_t attribute );
+            static void     text(    Devices::VGA & vga, Engine & engine, uint8_t mode, size_t columns, size_t rows, bool clear );
+            
+            void initialize( Devices::VGA & vga, Engine & engine )
+            {
+                text( vga, engine, 0x03, 80, 25, true );
+            }
+            
+            bool setVideoMode( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                uint8_t mode( engine.al() );
+                uint8_t mode( frame.al() );
                 uint8_t maskedMode( mode & 0x7f );
                 
                 if( machine.debugVideo() )
@@ -75,46 +94,116 @@ namespace UB
                     machine.ui().debug() << "    - " << description << std::endl;
                 }
                 
+                machine.vbe().disable();
+                
+                if( maskedMode <= 1 )
+                {
+                    text( machine.vga(), engine, maskedMode, 40, 25, ( mode & 0x80 ) == 0 );
+                }
+                else if( maskedMode <= 3 || maskedMode == 7 )
+                {
+                    text( machine.vga(), engine, maskedMode, 80, 25, ( mode & 0x80 ) == 0 );
+                }
+                else
+                {
+                    engine.write( 0x449, { maskedMode } );
+                }
+                
                 if( maskedMode > 7 )
                 {
-                    engine.al( 0x20 );
+                    frame.al( 0x20 );
                 }
                 else if( maskedMode == 6 )
                 {
-                    engine.al( 0x3F );
+                    frame.al( 0x3F );
                 }
                 else
                 {
-                    engine.al( 0x30 );
+                    frame.al( 0x30 );
                 }
                 
                 return true;
             }
             
-            bool setCursorPosition( const Machine & machine, Engine & engine )
+            bool setCursorShape( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )machine;
+                
+                word( engine, 0x460, frame.cx() );
+                
+                return true;
+            }
+            
+            bool setCursorPosition( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
                 if( machine.debugVideo() )
                 {
                     machine.ui().debug() << "Setting cursor position:"
                                          << std::endl
-                                         << "    - Page:   " << std::to_string( static_cast< unsigned int >( engine.bh() ) )
+                                         << "    - Page:   " << std::to_string( static_cast< unsigned int >( frame.bh() ) )
                                          << std::endl
-                                         << "    - Row:    " << std::to_string( static_cast< unsigned int >( engine.dh() ) )
+                                         << "    - Row:    " << std::to_string( static_cast< unsigned int >( frame.dh() ) )
                                          << std::endl
-                                         << "    - Column: " << std::to_string( static_cast< unsigned int >( engine.dl() ) )
+                                         << "    - Column: " << std::to_string( static_cast< unsigned int >( frame.dl() ) )
                                          << std::endl;
                 }
                 
+                cursor( machine.vga(), engine, frame.bh(), frame.dh(), frame.dl() );
+                
                 return true;
             }
             
-            bool ttyOutput( const Machine & machine, Engine & engine )
+            bool getCursorPosition( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                char c( static_cast< char >( engine.al() ) );
+                ( void )machine;
+                
+                uint16_t position( word( engine, 0x450 + static_cast< size_t >( frame.bh() & 7 ) * 2 ) );
+                
+                frame.dh( static_cast< uint8_t >( position >> 8 ) );
+                frame.dl( static_cast< uint8_t >( position & 0xFF ) );
+                frame.cx( word( engine, 0x460 ) );
+                
+                return true;
+            }
+            
+            bool scrollUp( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                scroll( machine.vga(), engine, page( engine ), frame.al(), true, frame.ch(), frame.cl(), frame.dh(), frame.dl(), frame.bh() );
+                
+                return true;
+            }
+            
+            bool scrollDown( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                scroll( machine.vga(), engine, page( engine ), frame.al(), false, frame.ch(), frame.cl(), frame.dh(), frame.dl(), frame.bh() );
+                
+                return true;
+            }
+            
+            bool readCharacterAndAttributeAtCursor( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                ( void )machine;
+                
+                uint16_t               position( word( engine, 0x450 + static_cast< size_t >( frame.bh() & 7 ) * 2 ) );
+                std::vector< uint8_t > cell( engine.read( address( engine, frame.bh(), position >> 8, position & 0xFF ), 2 ) );
+                
+                frame.al( cell[ 0 ] );
+                frame.ah( cell[ 1 ] );
+                
+                return true;
+            }
+            
+            bool ttyOutput( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                char     c( static_cast< char >( frame.al() ) );
+                uint8_t  active( page( engine ) );
+                uint16_t position( word( engine, 0x450 + static_cast< size_t >( active ) * 2 ) );
+                size_t   row( position >> 8 );
+                size_t   column( position & 0xFF );
                 
                 if( machine.debugVideo() )
                 {
-                    machine.ui().debug() << "TTY output: " << String::toHex( engine.al() ) << std::endl;
+                    machine.ui().debug() << "TTY output: " << String::toHex( frame.al() ) << std::endl;
                 }
                 
                 if( std::isprint( c ) || std::isspace( c ) )
@@ -126,22 +215,55 @@ namespace UB
                     machine.ui().output() << ".";
                 }
                 
+                switch( frame.al() )
+                {
+                    case 0x07:                                    break;
+                    case 0x08: column -= ( column > 0 ) ? 1 : 0; break;
+                    case 0x0A: row++;                             break;
+                    case 0x0D: column = 0;                        break;
+                    
+                    default:
+                        
+                        fill( machine.vga(), engine, address( engine, active, row, column ), 1, frame.al(), 0, false );
+                        
+                        column++;
+                        
+                        break;
+                }
+                
+                if( column >= columns( engine ) )
+                {
+                    column = 0;
+                    row++;
+                }
+                
+                if( row >= rows( engine ) )
+                {
+                    row = rows( engine ) - 1;
+                    
+                    scroll( machine.vga(), engine, active, 1, true, 0, 0, row, columns( engine ) - 1, engine.read( address( engine, active, row, column ) + 1, 1 )[ 0 ] );
+                }
+                
+                cursor( machine.vga(), engine, active, row, column );
+                
                 return true;
             }
             
-            bool palette( const Machine & machine, Engine & engine )
+            bool palette( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                if( engine.al() == 0x10 )
+                ( void )engine;
+                
+                if( frame.al() == 0x10 )
                 {
                     if( machine.debugVideo() )
                     {
-                        machine.ui().debug() << "Setting DAC color: " << String::toHex( engine.bx() )
+                        machine.ui().debug() << "Setting DAC color: " << String::toHex( frame.bx() )
                                              << std::endl
-                                             << "    - R: " << String::toHex( engine.dh() )
+                                             << "    - R: " << String::toHex( frame.dh() )
                                              << std::endl
-                                             << "    - G: " << String::toHex( engine.ch() )
+                                             << "    - G: " << String::toHex( frame.ch() )
                                              << std::endl
-                                             << "    - B: " << String::toHex( engine.cl() )
+                                             << "    - B: " << String::toHex( frame.cl() )
                                              << std::endl;
                     }
                     
@@ -151,53 +273,314 @@ namespace UB
                 return false;
             }
             
-            bool writeCharacterAndAttributeAtCursor( const Machine & machine, Engine & engine )
+            bool writeCharacterAndAttributeAtCursor( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
+                uint16_t position( word( engine, 0x450 + static_cast< size_t >( frame.bh() & 7 ) * 2 ) );
+                
                 if( machine.debugVideo() )
                 {
-                    machine.ui().debug() << "Writing character: " << String::toHex( engine.al() )
+                    machine.ui().debug() << "Writing character: " << String::toHex( frame.al() )
                                          << std::endl
-                                         << "    - Page:  " << std::to_string( static_cast< unsigned int >( engine.bh() ) )
+                                         << "    - Page:  " << std::to_string( static_cast< unsigned int >( frame.bh() ) )
                                          << std::endl
-                                         << "    - Color: " << String::toHex( engine.bl() )
+                                         << "    - Color: " << String::toHex( frame.bl() )
                                          << std::endl
-                                         << "    - Times: "<< std::to_string( static_cast< unsigned int >( engine.cx() ) )
+                                         << "    - Times: "<< std::to_string( static_cast< unsigned int >( frame.cx() ) )
                                          << std::endl;
                 }
                 
+                fill( machine.vga(), engine, address( engine, frame.bh(), position >> 8, position & 0xFF ), frame.cx(), frame.al(), frame.bl(), true );
+                
                 return true;
             }
             
-            bool writeCharacterOnlyAtCursor( const Machine & machine, Engine & engine )
+            bool writeCharacterOnlyAtCursor( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
+                uint16_t position( word( engine, 0x450 + static_cast< size_t >( frame.bh() & 7 ) * 2 ) );
+                
                 if( machine.debugVideo() )
                 {
-                    machine.ui().debug() << "Writing character: " << String::toHex( engine.al() )
+                    machine.ui().debug() << "Writing character: " << String::toHex( frame.al() )
                                          << std::endl
-                                         << "    - Page:  " << std::to_string( static_cast< unsigned int >( engine.bh() ) )
+                                         << "    - Page:  " << std::to_string( static_cast< unsigned int >( frame.bh() ) )
                                          << std::endl
-                                         << "    - Times: "<< std::to_string( static_cast< unsigned int >( engine.cx() ) )
+                                         << "    - Times: "<< std::to_string( static_cast< unsigned int >( frame.cx() ) )
                                          << std::endl;
                 }
                 
+                fill( machine.vga(), engine, address( engine, frame.bh(), position >> 8, position & 0xFF ), frame.cx(), frame.al(), 0, false );
+                
                 return true;
             }
             
-            bool getVBEControllerInfo( const Machine & machine, Engine & engine )
+            bool getVideoMode( const Machine & machine, Engine & engine, RegisterFrame & frame )
             {
-                uint64_t               destination( Engine::getAddress( engine.es(), engine.di() ) );
-                VESAInfo               vesa;
-                std::vector< uint8_t > data( vesa.data() );
+                ( void )machine;
                 
-                machine.ui().debug() << "Getting VBE controller info: "
-                                     << std::endl
-                                     << "    - Destination: " << String::toHex( destination ) << " (" << String::toHex( engine.es() ) << ":" << String::toHex( engine.di() ) << ")"
-                                     << std::endl;
+                frame.al( engine.read( 0x449, 1 )[ 0 ] );
+                frame.ah( static_cast< uint8_t >( columns( engine ) ) );
+                frame.bh( page( engine ) );
                 
-                engine.write( destination, data );
+                return true;
+            }
+            
+            bool getVBEControllerInfo( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint64_t                destination( Engine::getAddress( frame.es(), frame.di() ) );
+                std::vector< uint8_t >  signature( engine.read( destination, 4 ) );
+                std::vector< uint16_t > modes;
+                
+                for( const auto & mode: Devices::VBE::modes() )
+                {
+                    modes.push_back( mode.number );
+                }
+                
+                {
+                    VESAInfo               vesa( frame.es(), frame.di(), modes, Devices::VBE::lfbSize );
+                    std::vector< uint8_t > data( vesa.data() );
+                    
+                    machine.ui().debug() << "Getting VBE controller info: "
+                                         << std::endl
+                                         << "    - Destination: " << String::toHex( destination ) << " (" << String::toHex( frame.es() ) << ":" << String::toHex( frame.di() ) << ")"
+                                         << std::endl;
+                    
+                    if( std::string( signature.begin(), signature.end() ) != "VBE2" )
+                    {
+                        data.resize( 256 );
+                    }
+                    
+                    engine.write( destination, data );
+                }
+                
+                frame.ax( 0x004F );
                 
                 return true;
             }
+            
+            bool getVBEModeInfo( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint64_t destination( Engine::getAddress( frame.es(), frame.di() ) );
+                
+                if( machine.debugVideo() )
+                {
+                    machine.ui().debug() << "Getting VBE mode info: " << String::toHex( frame.cx() ) << std::endl;
+                }
+                
+                for( const auto & mode: Devices::VBE::modes() )
+                {
+                    if( mode.number == ( frame.cx() & 0x1FF ) )
+                    {
+                        VESAModeInfo info( mode.width, mode.height, mode.bitsPerPixel, static_cast< uint32_t >( Devices::VBE::lfbBase ), Devices::VBE::lfbSize );
+                        
+                        engine.write( destination, info.data() );
+                        frame.ax( 0x004F );
+                        
+                        return true;
+                    }
+                }
+                
+                frame.ax( 0x014F );
+                
+                return true;
+            }
+            
+            bool setVBEMode( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                uint16_t number( frame.bx() & 0x1FF );
+                
+                if( machine.debugVideo() )
+                {
+                    machine.ui().debug() << "Setting VBE mode: " << String::toHex( frame.bx() ) << std::endl;
+                }
+                
+                if( number < 0x100 )
+                {
+                    frame.al( static_cast< uint8_t >( number | ( ( frame.bx() & 0x8000 ) ? 0x80 : 0x00 ) ) );
+                    setVideoMode( machine, engine, frame );
+                    frame.ax( 0x004F );
+                }
+                else if( ( frame.bx() & 0x4000 ) == 0 || machine.vbe().mode( number ) == false )
+                {
+                    frame.ax( 0x014F );
+                }
+                else
+                {
+                    if( ( frame.bx() & 0x8000 ) == 0 )
+                    {
+                        std::vector< uint8_t > zero( machine.vbe().pitch() * machine.vbe().mode().height, 0 );
+                        
+                        engine.write( Devices::VBE::lfbBase, zero );
+                    }
+                    
+                    machine.vbe().invalidate();
+                    frame.ax( 0x004F );
+                }
+                
+                return true;
+            }
+            
+            bool getVBEMode( const Machine & machine, Engine & engine, RegisterFrame & frame )
+            {
+                if( machine.vbe().enabled() )
+                {
+                    frame.bx( static_cast< uint16_t >( machine.vbe().mode().number | 0x4000 ) );
+                }
+                else
+                {
+                    frame.bx( engine.read( 0x449, 1 )[ 0 ] );
+                }
+                
+                frame.ax( 0x004F );
+                
+                return true;
+            }
+            
+            static uint16_t word( Engine & engine, size_t address )
+            {
+                std::vector< uint8_t > data( engine.read( address, 2 ) );
+                
+                return static_cast< uint16_t >( data[ 0 ] | ( data[ 1 ] << 8 ) );
+            }
+            
+            static void word( Engine & engine, size_t address, uint16_t value )
+            {
+                engine.write( address, { static_cast< uint8_t >( value & 0xFF ), static_cast< uint8_t >( value >> 8 ) } );
+            }
+            
+            static size_t columns( Engine & engine )
+            {
+                return std::max< size_t >( word( engine, 0x44A ), 1 );
+            }
+            
+            static size_t rows( Engine & engine )
+            {
+                return static_cast< size_t >( engine.read( 0x484, 1 )[ 0 ] ) + 1;
+            }
+            
+            static uint8_t page( Engine & engine )
+            {
+                return engine.read( 0x462, 1 )[ 0 ] & 7;
+            }
+            
+            static size_t address( Engine & engine, uint8_t page, size_t row, size_t column )
+            {
+                size_t offset( ( static_cast< size_t >( page & 7 ) * word( engine, 0x44C ) ) + ( ( row * columns( engine ) ) + column ) * 2 );
+                
+                return Devices::VGA::textBase + std::min( offset, Devices::VGA::textSize - 2 );
+            }
+            
+            static void cursor( Devices::VGA & vga, Engine & engine, uint8_t page, size_t row, size_t column )
+            {
+                page &= 7;
+                
+                word( engine, 0x450 + static_cast< size_t >( page ) * 2, static_cast< uint16_t >( ( ( row & 0xFF ) << 8 ) | ( column & 0xFF ) ) );
+                
+                if( page == Video::page( engine ) )
+                {
+                    vga.cursor( static_cast< uint16_t >( ( address( engine, page, row, column ) - Devices::VGA::textBase ) / 2 ) );
+                }
+            }
+            
+            static void fill( Devices::VGA & vga, Engine & engine, size_t address, size_t count, uint8_t c, uint8_t attribute, bool setAttribute )
+            {
+                std::vector< uint8_t > data;
+                
+                count = std::min( count, ( Devices::VGA::textBase + Devices::VGA::textSize - address ) / 2 );
+                
+                if( count == 0 )
+                {
+                    return;
+                }
+                
+                if( setAttribute )
+                {
+                    data.resize( count * 2, attribute );
+                }
+                else
+                {
+                    data = engine.read( address, count * 2 );
+                }
+                
+                for( size_t i = 0; i < data.size(); i += 2 )
+                {
+                    data[ i ] = c;
+                }
+                
+                engine.write( address, data );
+                vga.invalidate( address - Devices::VGA::textBase, data.size() );
+            }
+            
+            static void scroll( Devices::VGA & vga, Engine & engine, uint8_t page, size_t lines, bool up, size_t top, size_t left, size_t bottom, size_t right, uint8_t attribute )
+            {
+                size_t                 width( columns( engine ) );
+                size_t                 start( address( engine, page, 0, 0 ) );
+                std::vector< uint8_t > data;
+                size_t                 height;
+                
+                bottom = std::min( bottom, rows( engine ) - 1 );
+                right  = std::min( right,  width - 1 );
+                
+                if( top > bottom || left > right )
+                {
+                    return;
+                }
+                
+                height = bottom - top + 1;
+                lines  = ( lines == 0 || lines > height ) ? height : lines;
+                start += top * width * 2;
+                data   = engine.read( start, std::min( height * width * 2, Devices::VGA::textBase + Devices::VGA::textSize - start ) );
+                
+                if( data.size() < height * width * 2 )
+                {
+                    return;
+                }
+                
+                for( size_t i = 0; i < height; i++ )
+                {
+                    size_t    y( ( up ) ? i : height - i - 1 );
+                    size_t    from( ( up ) ? y + lines : y - std::min( y, lines ) );
+                    uint8_t * row( data.data() + ( y * width + left ) * 2 );
+                    
+                    if( i < height - lines )
+                    {
+                        std::copy_n( data.data() + ( from * width + left ) * 2, ( right - left + 1 ) * 2, row );
+                    }
+                    else
+                    {
+                        for( size_t x = 0; x <= right - left; x++ )
+                        {
+                            row[ x * 2 ]     = 0x20;
+                            row[ x * 2 + 1 ] = attribute;
+                        }
+                    }
+                }
+                
+                engine.write( start, data );
+                vga.invalidate( start - Devices::VGA::textBase, data.size() );
+            }
+            
+            static void text( Devices::VGA & vga, Engine & engine, uint8_t mode, size_t columns, size_t rows, bool clear )
+            {
+                std::vector< uint8_t > cursors( 16, 0 );
+                
+                engine.write( 0x449, { mode } );
+                word( engine, 0x44A, static_cast< uint16_t >( columns ) );
+                word( engine, 0x44C, ( columns > 40 ) ? 0x1000 : 0x0800 );
+                word( engine, 0x44E, 0 );
+                engine.write( 0x450, cursors );
+                word( engine, 0x460, 0x0607 );
+                engine.write( 0x462, { 0x00 } );
+                word( engine, 0x463, 0x03D4 );
+                engine.write( 0x484, { static_cast< uint8_t >( rows - 1 ) } );
+                word( engine, 0x485, 16 );
+                
+                vga.textMode( columns, rows );
+                
+                if( clear )
+                {
+                    fill( vga, engine, Devices::VGA::textBase, Devices::VGA::textSize / 2, 0x20, 0x07, true );
+                }
+            }
         }
     }
 }
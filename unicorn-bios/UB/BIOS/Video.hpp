@@ -29,18 +29,35 @@ namespace UB
 {
     class Machine;
     class Engine;
+    class RegisterFrame;
+    
+    namespace Devices
+    {
+        class VGA;
+    }
     
     namespace BIOS
     {
         namespace Video
         {
-            bool setVideoMode( const Machine & machine, Engine & engine );
-            bool setCursorPosition( const Machine & machine, Engine & engine );
-            bool ttyOutput( const Machine & machine, Engine & engine );
-            bool palette( const Machine & machine, Engine & engine );
-            bool writeCharacterAndAttributeAtCursor( const Machine & machine, Engine & engine );
-            bool writeCharacterOnlyAtCursor( const Machine & machine, Engine & engine );
-            bool getVBEControllerInfo( const Machine & machine, Engine & engine );
+            bool setVideoMode( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool setCursorShape( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool setCursorPosition( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getCursorPosition( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool scrollUp( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool scrollDown( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool readCharacterAndAttributeAtCursor( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool ttyOutput( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool palette( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool writeCharacterAndAttributeAtCursor( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool writeCharacterOnlyAtCursor( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getVideoMode( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getVBEControllerInfo( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getVBEModeInfo( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool setVBEMode( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            bool getVBEMode( const Machine & machine, Engine & engine, RegisterFrame & frame );
+            
+            void initialize( Devices::VGA & vga, Engine & engine );
         }
     }
 }
@@ -0,0 +1,503 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/Batch.hpp"
+#include "UB/Signal.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cctype>
+#include <cstdlib>
+#include <csignal>
+#include <stdexcept>
+
+static std::atomic< bool > interrupted( false );
+
+namespace UB
+{
+    class Batch::IMPL
+    {
+        public:
+            
+            struct Job
+            {
+                Job( const std::string & text, const Arguments & args, double seconds );
+                
+                std::string line;
+                Arguments   arguments;
+                double      timeout;
+                std::string reason;
+                std::string output;
+                std::string debug;
+                uint64_t    instructions;
+                uint64_t    time;
+                double      setup;
+                double      run;
+            };
+            
+            static std::vector< std::string > _split( const std::string & line );
+            static double                     _seconds( std::chrono::steady_clock::time_point start );
+            
+            void _run( Job & job, const std::function< std::unique_ptr< Machine >( const Arguments & ) > & create, const std::function< void( const Arguments &, Machine & ) > & finish );
+            
+            std::vector< Job > _jobs;
+            size_t             _threads;
+            double             _time;
+    };
+    
+    Batch::Batch( const std::string & manifest ):
+        impl( std::make_unique< IMPL >() )
+    {
+        std::ifstream stream( manifest );
+        std::string   line;
+        size_t        n( 0 );
+        
+        if( stream.is_open() == false )
+        {
+            throw std::runtime_error( "Cannot read batch manifest: " + manifest );
+        }
+        
+        this->impl->_threads = 0;
+        this->impl->_time    = 0;
+        
+        while( std::getline( stream, line ) )
+        {
+            std::vector< std::string >  tokens( IMPL::_split( line ) );
+            std::vector< const char * > argv( { "unicorn-bios" } );
+            double                      timeout( 0 );
+            
+            n++;
+            
+            if( tokens.size() == 0 || tokens[ 0 ][ 0 ] == '#' )
+            {
+                continue;
+            }
+            
+            for( const auto & token: tokens )
+            {
+                argv.push_back( token.c_str() );
+            }
+            
+            {
+                Arguments args( static_cast< int >( argv.size() ), argv.data() );
+                
+                if( args.bootImage().length() == 0 || args.batch().length() > 0 || args.compressImage().length() > 0 || args.diffState().size() > 0 )
+                {
+                    throw std::runtime_error( "Invalid batch job at line " + std::to_string( n ) + ": " + line );
+                }
+                
+                if( args.timeout().length() > 0 )
+                {
+                    char * end( nullptr );
+                    
+                    timeout = std::strtod( args.timeout().c_str(), &end );
+                    
+                    if( *( end ) != 0 || timeout <= 0 )
+                    {
+                        throw std::runtime_error( "Invalid --timeout argument at line " + std::to_string( n ) + ": " + args.timeout() );
+                    }
+                }
+                
+                this->impl->_jobs.emplace_back( line.substr( line.find_first_not_of( " \t" ) ), args, timeout );
+            }
+        }
+    }
+    
+    Batch::~Batch( void )
+    {}
+    
+    size_t Batch::jobs( void ) const
+    {
+        return this->impl->_jobs.size();
+    }
+    
+    bool Batch::succeeded( void ) const
+    {
+        for( const auto & job: this->impl->_jobs )
+        {
+            if( job.reason == "exception" || job.reason == "error" || job.reason == "timeout" || job.reason == "interrupted" || job.reason == "skipped" )
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    std::string Batch::report( void ) const
+    {
+        std::stringstream               ss;
+        std::map< std::string, size_t > reasons;
+        
+        ss << std::left
+           << std::setw( 6 )  << "Job"
+           << std::setw( 13 ) << "Result"
+           << std::setw( 15 ) << "Instructions"
+           << std::setw( 11 ) << "Emulated"
+           << std::setw( 9 )  << "Setup"
+           << std::setw( 9 )  << "Run"
+           << "Command"
+           << std::endl;
+        
+        for( size_t i = 0; i < this->impl->_jobs.size(); i++ )
+        {
+            const IMPL::Job & job( this->impl->_jobs[ i ] );
+            
+            reasons[ job.reason ]++;
+            
+            ss << std::left
+               << std::setw( 6 )  << i + 1
+               << std::setw( 13 ) << job.reason
+               << std::setw( 15 ) << job.instructions
+               << std::fixed
+               << std::setprecision( 3 )
+               << std::setw( 11 ) << static_cast< double >( job.time ) / 1000000000.0
+               << std::setw( 9 )  << job.setup
+               << std::setw( 9 )  << job.run
+               << job.line
+               << std::endl;
+        }
+        
+        ss << std::endl
+           << this->impl->_jobs.size()
+           << " jobs on "
+           << this->impl->_threads
+           << " threads in "
+           << this->impl->_time
+           << "s:";
+        
+        for( const auto & p: reasons )
+        {
+            ss << " " << p.second << " " << p.first;
+        }
+        
+        ss << std::endl;
+        
+        for( size_t i = 0; i < this->impl->_jobs.size(); i++ )
+        {
+            const IMPL::Job & job( this->impl->_jobs[ i ] );
+            
+            if( job.output.length() == 0 && job.debug.length() == 0 )
+            {
+                continue;
+            }
+            
+            ss << std::endl
+               << "==> Job "
+               << i + 1
+               << ": "
+               << job.line
+               << " ("
+               << job.reason
+               << ") <=="
+               << std::endl
+               << job.output;
+            
+            if( job.output.length() > 0 && job.output.back() != '\n' )
+            {
+                ss << std::endl;
+            }
+            
+            ss << job.debug;
+            
+            if( job.debug.length() > 0 && job.debug.back() != '\n' )
+            {
+                ss << std::endl;
+            }
+        }
+        
+        return ss.str();
+    }
+    
+    void Batch::run( size_t threads, const std::function< std::unique_ptr< Machine >( const Arguments & ) > & create, const std::function< void( const Arguments &, Machine & ) > & finish )
+    {
+        static std::once_flag               once;
+        auto                                start( std::chrono::steady_clock::now() );
+        size_t                              count;
+        std::vector< std::deque< size_t > > queues;
+        std::vector< std::mutex >           mutexes;
+        std::vector< std::thread >          workers;
+        
+        std::call_once
+        (
+            once,
+            []
+            {
+                Signal::handle
+                (
+                    SIGINT,
+                    []( int sig )
+                    {
+                        ( void )sig;
+                        
+                        interrupted = true;
+                    }
+                );
+            }
+        );
+        
+        if( threads == 0 )
+        {
+            threads = std::thread::hardware_concurrency();
+        }
+        
+        count = std::max< size_t >( 1, std::min( threads, this->impl->_jobs.size() ) );
+        
+        queues  = std::vector< std::deque< size_t > >( count );
+        mutexes = std::vector< std::mutex >( count );
+        
+        for( size_t i = 0; i < this->impl->_jobs.size(); i++ )
+        {
+            queues[ i % count ].push_back( i );
+        }
+        
+        auto next = [ & ]( size_t worker, size_t & job ) -> bool
+        {
+            {
+                std::lock_guard< std::mutex > l( mutexes[ worker ] );
+                
+                if( queues[ worker ].size() > 0 )
+                {
+                    job = queues[ worker ].front();
+                    
+                    queues[ worker ].pop_front();
+                    
+                    return true;
+                }
+            }
+            
+            for( size_t i = 1; i < count; i++ )
+            {
+                size_t                        victim( ( worker + i ) % count );
+                std::lock_guard< std::mutex > l( mutexes[ victim ] );
+                
+                if( queues[ victim ].size() > 0 )
+                {
+                    job = queues[ victim ].back();
+                    
+                    queues[ victim ].pop_back();
+                    
+                    return true;
+                }
+            }
+            
+            return false;
+        };
+        
+        for( size_t t = 0; t < count; t++ )
+        {
+            workers.emplace_back
+            (
+                [ &, t ]
+                {
+                    size_t job;
+                    
+                    while( next( t, job ) )
+                    {
+                        if( interrupted )
+                        {
+                            continue;
+                        }
+                        
+                        this->impl->_run( this->impl->_jobs[ job ], create, finish );
+                    }
+                }
+            );
+        }
+        
+        for( auto & worker: workers )
+        {
+            worker.join();
+        }
+        
+        this->impl->_threads = count;
+        this->impl->_time    = IMPL::_seconds( start );
+    }
+    
+    Batch::IMPL::Job::Job( const std::string & text, const Arguments & args, double seconds ):
+        line(         text ),
+        arguments(    args ),
+        timeout(      seconds ),
+        reason(       "skipped" ),
+        instructions( 0 ),
+        time(         0 ),
+        setup(        0 ),
+        run(          0 )
+    {}
+    
+    std::vector< std::string > Batch::IMPL::_split( const std::string & line )
+    {
+        std::vector< std::string > tokens;
+        std::string                token;
+        bool                       quoted( false );
+        bool                       empty( true );
+        
+        for( char c: line )
+        {
+            if( c == '"' )
+            {
+                quoted = quoted == false;
+                empty  = false;
+            }
+            else if( quoted == false && std::isspace( static_cast< unsigned char >( c ) ) )
+            {
+                if( empty == false )
+                {
+                    tokens.push_back( token );
+                }
+                
+                token.clear();
+                
+                empty = true;
+            }
+            else
+            {
+                token += c;
+                empty  = false;
+            }
+        }
+        
+        if( quoted )
+        {
+            throw std::runtime_error( "Unterminated quote in batch manifest: " + line );
+        }
+        
+        if( empty == false )
+        {
+            tokens.push_back( token );
+        }
+        
+        return tokens;
+    }
+    
+    double Batch::IMPL::_seconds( std::chrono::steady_clock::time_point start )
+    {
+        return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    }
+    
+    void Batch::IMPL::_run( Job & job, const std::function< std::unique_ptr< Machine >( const Arguments & ) > & create, const std::function< void( const Arguments &, Machine & ) > & finish )
+    {
+        auto                       start( std::chrono::steady_clock::now() );
+        std::unique_ptr< Machine > machine;
+        std::string                error;
+        
+        try
+        {
+            machine   = create( job.arguments );
+            job.setup = _seconds( start );
+            start     = std::chrono::steady_clock::now();
+            
+            {
+                std::mutex              mtx;
+                std::condition_variable cv;
+                bool                    done( false );
+                
+                std::thread watchdog
+                (
+                    [ & ]
+                    {
+                        std::unique_lock< std::mutex > l( mtx );
+                        
+                        while( done == false )
+                        {
+                            if( interrupted )
+                            {
+                                machine->stop( "interrupted" );
+                            }
+                            else if( job.timeout > 0 && _seconds( start ) >= job.timeout )
+                            {
+                                machine->stop( "timeout" );
+                            }
+                            
+                            cv.wait_for( l, std::chrono::milliseconds( 100 ) );
+                        }
+                    }
+                );
+                
+                try
+                {
+                    machine->run();
+                }
+                catch( ... )
+                {
+                    {
+                        std::lock_guard< std::mutex > l( mtx );
+                        
+                        done = true;
+                    }
+                    
+                    cv.notify_all();
+                    watchdog.join();
+                    
+                    throw;
+                }
+                
+                {
+                    std::lock_guard< std::mutex > l( mtx );
+                    
+                    done = true;
+                }
+                
+                cv.notify_all();
+                watchdog.join();
+            }
+            
+            job.run    = _seconds( start );
+            job.reason = machine->stopReason();
+            
+            finish( job.arguments, *( machine ) );
+        }
+        catch( const std::exception & e )
+        {
+            job.reason = "error";
+            error      = e.what();
+        }
+        catch( ... )
+        {
+            job.reason = "error";
+            error      = "Unknown error";
+        }
+        
+        if( machine != nullptr )
+        {
+            job.instructions = machine->clock().instructions();
+            job.time         = machine->clock().time();
+            job.output       = machine->ui().output().string();
+            job.debug        = machine->ui().debug().string();
+        }
+        
+        if( error.length() > 0 )
+        {
+            job.debug += "[ ERROR ]> " + error + "\n";
+        }
+    }
+}
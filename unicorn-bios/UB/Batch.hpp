@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_BATCH_HPP
+#define UB_BATCH_HPP
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <functional>
+#include "UB/Arguments.hpp"
+#include "UB/Machine.hpp"
+
+namespace UB
+{
+    /*
+     * Runs the jobs of a batch manifest on concurrent headless machines.
+     *
+     * The manifest has one job per line, written as the command line
+     * arguments for a single run (BOOT_IMG followed by options, double
+     * quotes grouping words). Empty lines and lines starting with '#' are
+     * ignored. --budget and --timeout limit each job.
+     * Jobs are distributed round-robin on per-thread queues; idle threads
+     * steal from the back of other queues.
+     */
+    class Batch
+    {
+        public:
+            
+            Batch( const std::string & manifest );
+            ~Batch( void );
+            
+            Batch( const Batch & o )              = delete;
+            Batch( Batch && o )                   = delete;
+            Batch & operator =( const Batch & o ) = delete;
+            Batch & operator =( Batch && o )      = delete;
+            
+            size_t      jobs( void )      const;
+            bool        succeeded( void ) const;
+            std::string report( void )    const;
+            
+            void run( size_t threads, const std::function< std::unique_ptr< Machine >( const Arguments & ) > & create, const std::function< void( const Arguments &, Machine & ) > & finish );
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_BATCH_HPP */
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/CPU/CPUID.hpp"
+#include <map>
+#include <array>
+
+namespace UB
+{
+    namespace CPU
+    {
+        class CPUID::IMPL
+        {
+            public:
+                
+                IMPL( void );
+                IMPL( const IMPL & o );
+                ~IMPL( void );
+                
+                class Leaf
+                {
+                    public:
+                        
+                        Leaf( void );
+                        
+                        std::array< uint32_t, 4 > _values;
+                        std::array< uint32_t, 4 > _masks;
+                };
+                
+                std::map< uint32_t, Leaf > _leaves;
+        };
+        
+        CPUID::CPUID( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        CPUID::CPUID( const CPUID & o ):
+            impl( std::make_unique< IMPL >( *( o.impl ) ) )
+        {}
+        
+        CPUID::CPUID( CPUID && o ) noexcept:
+            impl( std::move( o.impl ) )
+        {}
+        
+        CPUID::~CPUID( void )
+        {}
+        
+        CPUID & CPUID::operator =( CPUID o )
+        {
+            swap( *( this ), o );
+            
+            return *( this );
+        }
+        
+        bool CPUID::contains( uint32_t leaf ) const
+        {
+            return this->impl->_leaves.find( leaf ) != this->impl->_leaves.end();
+        }
+        
+        void CPUID::set( uint32_t leaf, Register reg, uint32_t value, uint32_t mask )
+        {
+            IMPL::Leaf & entry( this->impl->_leaves[ leaf ] );
+            size_t       i( static_cast< size_t >( reg ) );
+            
+            entry._values[ i ] = ( entry._values[ i ] & ~mask ) | ( value & mask );
+            entry._masks[ i ] |= mask;
+        }
+        
+        void CPUID::remove( uint32_t leaf )
+        {
+            this->impl->_leaves.erase( leaf );
+        }
+        
+        void CPUID::vendor( const std::string & vendor )
+        {
+            std::string id( vendor.substr( 0, 12 ) );
+            
+            id.resize( 12, ' ' );
+            
+            for( size_t i = 0; i < 3; i++ )
+            {
+                static const Register regs[] = { Register::EBX, Register::EDX, Register::ECX };
+                
+                uint32_t value( 0 );
+                
+                for( size_t j = 0; j < 4; j++ )
+                {
+                    value |= static_cast< uint32_t >( static_cast< uint8_t >( id[ i * 4 + j ] ) ) << ( j * 8 );
+                }
+                
+                this->set( 0, regs[ i ], value );
+            }
+        }
+        
+        bool CPUID::apply( uint32_t leaf, uint32_t & eax, uint32_t & ebx, uint32_t & ecx, uint32_t & edx ) const
+        {
+            auto it( this->impl->_leaves.find( leaf ) );
+            
+            if( it == this->impl->_leaves.end() )
+            {
+                return false;
+            }
+            
+            {
+                const IMPL::Leaf & entry( it->second );
+                
+                eax = ( eax & ~entry._masks[ 0 ] ) | entry._values[ 0 ];
+                ebx = ( ebx & ~entry._masks[ 1 ] ) | entry._values[ 1 ];
+                ecx = ( ecx & ~entry._masks[ 2 ] ) | entry._values[ 2 ];
+                edx = ( edx & ~entry._masks[ 3 ] ) | entry._values[ 3 ];
+            }
+            
+            return true;
+        }
+        
+        void swap( CPUID & o1, CPUID & o2 )
+        {
+            using std::swap;
+            
+            swap( o1.impl, o2.impl );
+        }
+        
+        CPUID::IMPL::IMPL( void )
+        {}
+        
+        CPUID::IMPL::IMPL( const IMPL & o ):
+            _leaves( o._leaves )
+        {}
+        
+        CPUID::IMPL::~IMPL( void )
+        {}
+        
+        CPUID::IMPL::Leaf::Leaf( void ):
+            _values{ { 0, 0, 0, 0 } },
+            _masks{  { 0, 0, 0, 0 } }
+        {}
+    }
+}
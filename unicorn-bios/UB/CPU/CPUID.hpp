@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_CPU_CPUID_HPP
+#define UB_CPU_CPUID_HPP
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace UB
+{
+    namespace CPU
+    {
+        class CPUID
+        {
+            public:
+                
+                enum class Register
+                {
+                    EAX,
+                    EBX,
+                    ECX,
+                    EDX
+                };
+                
+                CPUID( void );
+                CPUID( const CPUID & o );
+                CPUID( CPUID && o ) noexcept;
+                ~CPUID( void );
+                
+                CPUID & operator =( CPUID o );
+                
+                bool contains( uint32_t leaf ) const;
+                void set( uint32_t leaf, Register reg, uint32_t value, uint32_t mask = 0xFFFFFFFF );
+                void remove( uint32_t leaf );
+                void vendor( const std::string & vendor );
+                bool apply( uint32_t leaf, uint32_t & eax, uint32_t & ebx, uint32_t & ecx, uint32_t & edx ) const;
+                
+                friend void swap( CPUID & o1, CPUID & o2 );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_CPU_CPUID_HPP */
@@ -129,5 +129,41 @@ namespace UB
             
             return v;
         }
+        
+        std::vector< std::pair< uint64_t, size_t > > decode( const std::vector< uint8_t > & data, uint64_t org, unsigned int bits )
+        {
+            csh       handle;
+            cs_insn * instruction;
+            size_t    count;
+            cs_mode   mode( ( bits == 64 ) ? CS_MODE_64 : ( ( bits == 32 ) ? CS_MODE_32 : CS_MODE_16 ) );
+            
+            std::vector< std::pair< uint64_t, size_t > > v;
+            
+            if( data.size() == 0 || cs_open( CS_ARCH_X86, mode, &handle ) != CS_ERR_OK )
+            {
+                return {};
+            }
+            
+            count = cs_disasm( handle, &( data[ 0 ] ), data.size(), org, 0, &instruction );
+            
+            if( count == 0 )
+            {
+                cs_close( &handle );
+                
+                return {};
+            }
+            
+            v.reserve( count );
+            
+            for( size_t i = 0; i < count; i++ )
+            {
+                v.push_back( { instruction[ i ].address, instruction[ i ].size } );
+            }
+            
+            cs_free( instruction, count );
+            cs_close( &handle );
+            
+            return v;
+        }
     }
 }
@@ -35,6 +35,7 @@ namespace UB
     {
         std::vector< std::pair< std::string, std::string > > disassemble(  const std::vector< uint8_t > & data, uint64_t org );
         std::vector< std::pair< std::string, std::string > > instructions( const std::vector< uint8_t > & data, uint64_t org );
+        std::vector< std::pair< uint64_t, size_t > >         decode(       const std::vector< uint8_t > & data, uint64_t org, unsigned int bits );
     }
 }
 
@@ -0,0 +1,214 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/Devices/APIC.hpp"
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class APIC::IMPL
+        {
+            public:
+                
+                IMPL( Type type );
+                ~IMPL( void );
+                
+                uint32_t _read( uint32_t reg );
+                void     _write( uint32_t reg, uint32_t value );
+                
+                Type                           _type;
+                uint32_t                       _select;
+                std::map< uint32_t, uint32_t > _registers;
+                mutable std::mutex             _mtx;
+        };
+        
+        APIC::APIC( Type type ):
+            impl( std::make_unique< IMPL >( type ) )
+        {}
+        
+        APIC::~APIC( void )
+        {}
+        
+        APIC::Type APIC::type( void ) const
+        {
+            return this->impl->_type;
+        }
+        
+        uint64_t APIC::base( void ) const
+        {
+            return ( this->impl->_type == Type::Local ) ? localBase : ioBase;
+        }
+        
+        uint64_t APIC::read( uint64_t offset, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            uint32_t                      value( 0 );
+            
+            if( this->impl->_type == Type::Local )
+            {
+                value = this->impl->_read( static_cast< uint32_t >( offset & ~0x0FULL ) );
+            }
+            else if( ( offset & ~0x03ULL ) == 0x00 )
+            {
+                value = this->impl->_select;
+            }
+            else if( ( offset & ~0x03ULL ) == 0x10 )
+            {
+                value = this->impl->_read( this->impl->_select );
+            }
+            
+            value >>= ( offset & 0x03 ) * 8;
+            
+            return ( size >= 4 ) ? value : value & ( ( 1U << ( size * 8 ) ) - 1 );
+        }
+        
+        void APIC::write( uint64_t offset, size_t size, uint64_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( size < 4 || ( offset & 0x03 ) != 0 )
+            {
+                return;
+            }
+            
+            if( this->impl->_type == Type::Local )
+            {
+                this->impl->_write( static_cast< uint32_t >( offset & ~0x0FULL ), static_cast< uint32_t >( value ) );
+            }
+            else if( offset == 0x00 )
+            {
+                this->impl->_select = static_cast< uint32_t >( value & 0xFF );
+            }
+            else if( offset == 0x10 )
+            {
+                this->impl->_write( this->impl->_select, static_cast< uint32_t >( value ) );
+            }
+        }
+        
+        std::vector< uint8_t > APIC::state( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint32_t >       values( { this->impl->_select } );
+            std::vector< uint8_t >        data;
+            
+            for( const auto & p: this->impl->_registers )
+            {
+                values.push_back( p.first );
+                values.push_back( p.second );
+            }
+            
+            for( uint32_t value: values )
+            {
+                for( size_t i = 0; i < 4; i++ )
+                {
+                    data.push_back( static_cast< uint8_t >( value >> ( i * 8 ) ) );
+                }
+            }
+            
+            return data;
+        }
+        
+        void APIC::state( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint32_t >       values;
+            
+            if( data.size() < 4 || ( data.size() - 4 ) % 8 != 0 )
+            {
+                throw std::runtime_error( "Invalid APIC state" );
+            }
+            
+            for( size_t i = 0; i < data.size(); i += 4 )
+            {
+                values.push_back( static_cast< uint32_t >( data[ i ] ) | static_cast< uint32_t >( data[ i + 1 ] << 8 ) | static_cast< uint32_t >( data[ i + 2 ] << 16 ) | static_cast< uint32_t >( data[ i + 3 ] << 24 ) );
+            }
+            
+            this->impl->_select = values[ 0 ];
+            
+            this->impl->_registers.clear();
+            
+            for( size_t i = 1; i < values.size(); i += 2 )
+            {
+                this->impl->_registers[ values[ i ] ] = values[ i + 1 ];
+            }
+        }
+        
+        APIC::IMPL::IMPL( Type type ):
+            _type( type ),
+            _select( 0 )
+        {
+            if( type == Type::Local )
+            {
+                this->_registers[ 0x030 ] = 0x00050014;
+                this->_registers[ 0x0E0 ] = 0xFFFFFFFF;
+                this->_registers[ 0x0F0 ] = 0x000000FF;
+                
+                for( uint32_t reg = 0x320; reg <= 0x370; reg += 0x10 )
+                {
+                    this->_registers[ reg ] = 0x00010000;
+                }
+            }
+            else
+            {
+                this->_registers[ 0x01 ] = 0x00170011;
+                
+                for( uint32_t reg = 0x10; reg < 0x40; reg += 2 )
+                {
+                    this->_registers[ reg ] = 0x00010000;
+                }
+            }
+        }
+        
+        APIC::IMPL::~IMPL( void )
+        {}
+        
+        uint32_t APIC::IMPL::_read( uint32_t reg )
+        {
+            auto it( this->_registers.find( reg ) );
+            
+            return ( it == this->_registers.end() ) ? 0 : it->second;
+        }
+        
+        void APIC::IMPL::_write( uint32_t reg, uint32_t value )
+        {
+            if( this->_type == Type::Local )
+            {
+                if( reg == 0x020 || reg == 0x030 || reg == 0x0B0 || ( reg >= 0x100 && reg < 0x280 ) || reg == 0x390 )
+                {
+                    return;
+                }
+            }
+            else if( reg == 0x01 || reg == 0x02 )
+            {
+                return;
+            }
+            
+            this->_registers[ reg ] = value;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_DEVICES_APIC_HPP
+#define UB_DEVICES_APIC_HPP
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class APIC
+        {
+            public:
+                
+                enum class Type
+                {
+                    Local,
+                    IO
+                };
+                
+                static const uint64_t localBase = 0xFEE00000;
+                static const uint64_t ioBase    = 0xFEC00000;
+                static const size_t   size      = 0x1000;
+                
+                APIC( Type type );
+                ~APIC( void );
+                
+                APIC( const APIC & o )              = delete;
+                APIC( APIC && o )                   = delete;
+                APIC & operator =( const APIC & o ) = delete;
+                APIC & operator =( APIC && o )      = delete;
+                
+                Type     type( void ) const;
+                uint64_t base( void ) const;
+                uint64_t read(  uint64_t offset, size_t size );
+                void     write( uint64_t offset, size_t size, uint64_t value );
+            
+                std::vector< uint8_t > state( void ) const;
+                void                   state( const std::vector< uint8_t > & data );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_DEVICES_APIC_HPP */
@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/Devices/Bus.hpp"
+#include "UB/String.hpp"
+#include "UB/VirtualClock.hpp"
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class Bus::IMPL
+        {
+            public:
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                std::vector< std::shared_ptr< Device > >        _ports;
+                std::vector< std::shared_ptr< Device > >        _devices;
+                std::atomic< const VirtualClock * >             _clock;
+                std::atomic< uint64_t >                         _next;
+                std::chrono::steady_clock::time_point           _start;
+                std::vector< std::function< void( void ) > >    _stopHandlers;
+                std::vector< std::function< void( uint8_t ) > > _raiseHandlers;
+                mutable std::recursive_mutex                    _rmtx;
+        };
+        
+        Bus::Bus( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        Bus::~Bus( void )
+        {}
+        
+        void Bus::attach( const std::shared_ptr< Device > & device, uint16_t first, uint16_t last )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            if( device == nullptr || last < first )
+            {
+                throw std::runtime_error( "Invalid device attachment" );
+            }
+            
+            for( uint32_t port = first; port <= last; port++ )
+            {
+                if( this->impl->_ports[ port ] != nullptr )
+                {
+                    throw std::runtime_error( "I/O port " + String::toHex( static_cast< uint16_t >( port ) ) + " is already used by " + this->impl->_ports[ port ]->name() );
+                }
+            }
+            
+            for( uint32_t port = first; port <= last; port++ )
+            {
+                this->impl->_ports[ port ] = device;
+            }
+            
+            if( std::find( this->impl->_devices.begin(), this->impl->_devices.end(), device ) == this->impl->_devices.end() )
+            {
+                this->impl->_devices.push_back( device );
+            }
+            
+            this->impl->_next = 0;
+        }
+        
+        void Bus::detach( uint16_t first, uint16_t last )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            for( uint32_t port = first; port <= last; port++ )
+            {
+                this->impl->_ports[ port ] = nullptr;
+            }
+            
+            this->impl->_devices.erase
+            (
+                std::remove_if
+                (
+                    this->impl->_devices.begin(),
+                    this->impl->_devices.end(),
+                    [ & ]( const std::shared_ptr< Device > & device ) -> bool
+                    {
+                        return std::find( this->impl->_ports.begin(), this->impl->_ports.end(), device ) == this->impl->_ports.end();
+                    }
+                ),
+                this->impl->_devices.end()
+            );
+        }
+        
+        std::shared_ptr< Device > Bus::device( uint16_t port ) const
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            return this->impl->_ports[ port ];
+        }
+        
+        bool Bus::read( uint16_t port, size_t size, uint32_t & value )
+        {
+            std::shared_ptr< Device > device( this->device( port ) );
+            
+            if( device == nullptr )
+            {
+                return false;
+            }
+            
+            value = device->read( *( this ), port, size );
+            
+            this->impl->_next = 0;
+            
+            return true;
+        }
+        
+        bool Bus::write( uint16_t port, size_t size, uint32_t value )
+        {
+            std::shared_ptr< Device > device( this->device( port ) );
+            
+            if( device == nullptr )
+            {
+                return false;
+            }
+            
+            device->write( *( this ), port, size, value );
+            
+            this->impl->_next = 0;
+            
+            return true;
+        }
+        
+        void Bus::update( void )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            uint64_t                                next( std::numeric_limits< uint64_t >::max() );
+            
+            for( const auto & device: this->impl->_devices )
+            {
+                device->update( *( this ) );
+            }
+            
+            for( const auto & device: this->impl->_devices )
+            {
+                next = std::min( next, device->deadline( *( this ) ) );
+            }
+            
+            this->impl->_next = next;
+        }
+        
+        uint64_t Bus::time( void ) const
+        {
+            const VirtualClock * clock( this->impl->_clock );
+            
+            if( clock != nullptr )
+            {
+                return clock->time();
+            }
+            
+            return static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - this->impl->_start ).count() );
+        }
+        
+        uint64_t Bus::next( void ) const
+        {
+            return this->impl->_next;
+        }
+        
+        void Bus::clock( const VirtualClock * clock )
+        {
+            this->impl->_clock = clock;
+            this->impl->_next  = 0;
+        }
+        
+        void Bus::stop( void )
+        {
+            std::vector< std::function< void( void ) > > handlers;
+            
+            {
+                std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                
+                handlers = this->impl->_stopHandlers;
+            }
+            
+            for( const auto & f: handlers )
+            {
+                f();
+            }
+        }
+        
+        void Bus::raise( uint8_t irq )
+        {
+            std::vector< std::function< void( uint8_t ) > > handlers;
+            
+            this->impl->_next = 0;
+            
+            {
+                std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                
+                handlers = this->impl->_raiseHandlers;
+            }
+            
+            for( const auto & f: handlers )
+            {
+                f( irq );
+            }
+        }
+        
+        void Bus::onStop( const std::function< void( void ) > & handler )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            this->impl->_stopHandlers.push_back( handler );
+        }
+        
+        void Bus::onRaise( const std::function< void( uint8_t ) > & handler )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            this->impl->_raiseHandlers.push_back( handler );
+        }
+        
+        Bus::IMPL::IMPL( void ):
+            _ports( 0x10000 ),
+            _clock( nullptr ),
+            _next( 0 ),
+            _start( std::chrono::steady_clock::now() )
+        {}
+        
+        Bus::IMPL::~IMPL( void )
+        {}
+    }
+}
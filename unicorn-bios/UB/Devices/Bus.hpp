@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#ifndef UB_DEVICES_BUS_HPP
+#define UB_DEVICES_BUS_HPP
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include "UB/Devices/Device.hpp"
+
+namespace UB
+{
+    class VirtualClock;
+    
+    namespace Devices
+    {
+        class Bus
+        {
+            public:
+                
+                Bus( void );
+                ~Bus( void );
+                
+                Bus( const Bus & o )              = delete;
+                Bus( Bus && o )                   = delete;
+                Bus & operator =( const Bus & o ) = delete;
+                Bus & operator =( Bus && o )      = delete;
+                
+                void                      attach( const std::shared_ptr< Device > & device, uint16_t first, uint16_t last );
+                void                      detach( uint16_t first, uint16_t last );
+                std::shared_ptr< Device > device( uint16_t port ) const;
+                
+                bool read(  uint16_t port, size_t size, uint32_t & value );
+                bool write( uint16_t port, size_t size, uint32_t value );
+                void update( void );
+                
+                uint64_t time( void ) const;
+                uint64_t next( void ) const;
+                void     clock( const VirtualClock * clock );
+                
+                void stop( void );
+                void raise( uint8_t irq );
+                
+                void onStop(  const std::function< void( void ) > & handler );
+                void onRaise( const std::function< void( uint8_t ) > & handler );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_DEVICES_BUS_HPP */
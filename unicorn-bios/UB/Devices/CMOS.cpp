@@ -0,0 +1,257 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/Devices/CMOS.hpp"
+#include "UB/Devices/Bus.hpp"
+#include <array>
+#include <mutex>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class CMOS::IMPL
+        {
+            public:
+                
+                IMPL( size_t memory, time_t time );
+                ~IMPL( void );
+                
+                uint8_t _encode( int value ) const;
+                uint8_t _clock( const Bus & bus, uint8_t index ) const;
+                void    _checksum( void );
+                
+                std::array< uint8_t, 128 > _ram;
+                uint8_t                    _index;
+                time_t                     _time;
+                mutable std::mutex         _mtx;
+        };
+        
+        CMOS::CMOS( size_t memory, time_t time ):
+            impl( std::make_unique< IMPL >( memory, time ) )
+        {}
+        
+        CMOS::~CMOS( void )
+        {}
+        
+        std::string CMOS::name( void ) const
+        {
+            return "CMOS RTC";
+        }
+        
+        uint32_t CMOS::read( Bus & bus, uint16_t port, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            uint8_t                       index( this->impl->_index );
+            
+            ( void )size;
+            
+            if( port == 0x70 )
+            {
+                return index;
+            }
+            
+            if( index <= 0x09 || index == 0x32 )
+            {
+                return this->impl->_clock( bus, index );
+            }
+            
+            if( index == 0x0C )
+            {
+                uint8_t value( this->impl->_ram[ 0x0C ] );
+                
+                this->impl->_ram[ 0x0C ] = 0;
+                
+                return value;
+            }
+            
+            return this->impl->_ram[ index ];
+        }
+        
+        void CMOS::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            ( void )bus;
+            ( void )size;
+            
+            if( port == 0x70 )
+            {
+                this->impl->_index = value & 0x7F;
+            }
+            else if( this->impl->_index > 0x09 && this->impl->_index != 0x0A && this->impl->_index != 0x0C && this->impl->_index != 0x0D )
+            {
+                this->impl->_ram[ this->impl->_index ] = static_cast< uint8_t >( value );
+            }
+        }
+        
+        uint8_t CMOS::value( uint8_t index ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_ram[ index & 0x7F ];
+        }
+        
+        void CMOS::value( uint8_t index, uint8_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_ram[ index & 0x7F ] = value;
+            
+            this->impl->_checksum();
+        }
+        
+        uint8_t CMOS::clock( const Bus & bus, uint8_t index ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_clock( bus, index & 0x7F );
+        }
+        
+        time_t CMOS::time( const Bus & bus ) const
+        {
+            return this->impl->_time + static_cast< time_t >( bus.time() / 1000000000 );
+        }
+        
+        void CMOS::time( time_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_time = value;
+        }
+        
+        std::vector< uint8_t > CMOS::state( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint8_t >        data( this->impl->_ram.begin(), this->impl->_ram.end() );
+            
+            data.push_back( this->impl->_index );
+            data.resize( data.size() + sizeof( time_t ) );
+            memcpy( data.data() + data.size() - sizeof( time_t ), &( this->impl->_time ), sizeof( time_t ) );
+            
+            return data;
+        }
+        
+        void CMOS::state( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( data.size() != this->impl->_ram.size() + 1 + sizeof( time_t ) )
+            {
+                throw std::runtime_error( "Invalid CMOS state" );
+            }
+            
+            std::copy( data.begin(), data.begin() + static_cast< ptrdiff_t >( this->impl->_ram.size() ), this->impl->_ram.begin() );
+            memcpy( &( this->impl->_time ), data.data() + this->impl->_ram.size() + 1, sizeof( time_t ) );
+            
+            this->impl->_index = data[ this->impl->_ram.size() ];
+        }
+        
+        CMOS::IMPL::IMPL( size_t memory, time_t time ):
+            _ram{},
+            _index( 0 ),
+            _time( time )
+        {
+            size_t extended( ( memory > 0x100000 ) ? ( memory - 0x100000 ) / 1024 : 0 );
+            size_t high( ( memory > 0x1000000 ) ? ( memory - 0x1000000 ) / 0x10000 : 0 );
+            
+            extended = std::min< size_t >( extended, 0xFFFF );
+            high     = std::min< size_t >( high,     0xFFFF );
+            
+            this->_ram[ 0x0A ] = 0x26;
+            this->_ram[ 0x0B ] = 0x02;
+            this->_ram[ 0x0D ] = 0x80;
+            this->_ram[ 0x15 ] = 0x80;
+            this->_ram[ 0x16 ] = 0x02;
+            this->_ram[ 0x17 ] = static_cast< uint8_t >( extended & 0xFF );
+            this->_ram[ 0x18 ] = static_cast< uint8_t >( extended >> 8 );
+            this->_ram[ 0x30 ] = static_cast< uint8_t >( extended & 0xFF );
+            this->_ram[ 0x31 ] = static_cast< uint8_t >( extended >> 8 );
+            this->_ram[ 0x34 ] = static_cast< uint8_t >( high & 0xFF );
+            this->_ram[ 0x35 ] = static_cast< uint8_t >( high >> 8 );
+            
+            this->_checksum();
+        }
+        
+        CMOS::IMPL::~IMPL( void )
+        {}
+        
+        uint8_t CMOS::IMPL::_encode( int value ) const
+        {
+            if( this->_ram[ 0x0B ] & 0x04 )
+            {
+                return static_cast< uint8_t >( value );
+            }
+            
+            return static_cast< uint8_t >( ( ( value / 10 ) << 4 ) | ( value % 10 ) );
+        }
+        
+        uint8_t CMOS::IMPL::_clock( const Bus & bus, uint8_t index ) const
+        {
+            time_t    t( this->_time + static_cast< time_t >( bus.time() / 1000000000 ) );
+            struct tm tm;
+            
+            gmtime_r( &t, &tm );
+            
+            switch( index )
+            {
+                case 0x00: return this->_encode( tm.tm_sec );
+                case 0x02: return this->_encode( tm.tm_min );
+                case 0x06: return this->_encode( tm.tm_wday + 1 );
+                case 0x07: return this->_encode( tm.tm_mday );
+                case 0x08: return this->_encode( tm.tm_mon + 1 );
+                case 0x09: return this->_encode( tm.tm_year % 100 );
+                case 0x32: return this->_encode( ( tm.tm_year + 1900 ) / 100 );
+                
+                case 0x04:
+                    
+                    if( this->_ram[ 0x0B ] & 0x02 )
+                    {
+                        return this->_encode( tm.tm_hour );
+                    }
+                    
+                    return static_cast< uint8_t >( this->_encode( ( tm.tm_hour % 12 == 0 ) ? 12 : tm.tm_hour % 12 ) | ( ( tm.tm_hour >= 12 ) ? 0x80 : 0x00 ) );
+                
+                default: break;
+            }
+            
+            return this->_ram[ index ];
+        }
+        
+        void CMOS::IMPL::_checksum( void )
+        {
+            uint16_t sum( 0 );
+            
+            for( size_t i = 0x10; i <= 0x2D; i++ )
+            {
+                sum = static_cast< uint16_t >( sum + this->_ram[ i ] );
+            }
+            
+            this->_ram[ 0x2E ] = static_cast< uint8_t >( sum >> 8 );
+            this->_ram[ 0x2F ] = static_cast< uint8_t >( sum & 0xFF );
+        }
+    }
+}
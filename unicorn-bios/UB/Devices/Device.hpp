@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#ifndef UB_DEVICES_DEVICE_HPP
+#define UB_DEVICES_DEVICE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <limits>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class Bus;
+        
+        class Device
+        {
+            public:
+                
+                virtual ~Device( void ) = default;
+                
+                virtual std::string name( void )                                                   const = 0;
+                virtual uint32_t    read(  Bus & bus, uint16_t port, size_t size )                       = 0;
+                virtual void        write( Bus & bus, uint16_t port, size_t size, uint32_t value )       = 0;
+                
+                virtual void update( Bus & bus )
+                {
+                    ( void )bus;
+                }
+                
+                virtual uint64_t deadline( const Bus & bus ) const
+                {
+                    ( void )bus;
+                    
+                    return std::numeric_limits< uint64_t >::max();
+                }
+                
+                virtual std::vector< uint8_t > state( void ) const
+                {
+                    return {};
+                }
+                
+                virtual void state( const std::vector< uint8_t > & data )
+                {
+                    ( void )data;
+                }
+        };
+    }
+}
+
+#endif /* UB_DEVICES_DEVICE_HPP */
@@ -0,0 +1,331 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/Devices/PIC.hpp"
+#include <mutex>
+#include <cstring>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class PIC::IMPL
+        {
+            public:
+                
+                struct Chip
+                {
+                    uint8_t irr;
+                    uint8_t isr;
+                    uint8_t imr;
+                    uint8_t base;
+                    uint8_t step;
+                    bool    single;
+                    bool    icw4;
+                    bool    autoEOI;
+                    bool    readISR;
+                };
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                static int  _highest( const Chip & chip, uint8_t requests );
+                static void _command( Chip & chip, uint8_t value );
+                static void _data( Chip & chip, uint8_t value );
+                
+                int _master( void ) const;
+                int _slave( void )  const;
+                
+                Chip               _chips[ 2 ];
+                mutable std::mutex _mtx;
+        };
+        
+        PIC::PIC( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        PIC::~PIC( void )
+        {}
+        
+        std::string PIC::name( void ) const
+        {
+            return "8259 PIC";
+        }
+        
+        uint32_t PIC::read( Bus & bus, uint16_t port, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            const IMPL::Chip            & chip( this->impl->_chips[ ( port >= 0xA0 ) ? 1 : 0 ] );
+            
+            ( void )bus;
+            ( void )size;
+            
+            if( ( port & 1 ) == 0 )
+            {
+                return ( chip.readISR ) ? chip.isr : chip.irr;
+            }
+            
+            return chip.imr;
+        }
+        
+        void PIC::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            IMPL::Chip                  & chip( this->impl->_chips[ ( port >= 0xA0 ) ? 1 : 0 ] );
+            
+            ( void )bus;
+            ( void )size;
+            
+            if( ( port & 1 ) == 0 )
+            {
+                IMPL::_command( chip, static_cast< uint8_t >( value ) );
+            }
+            else
+            {
+                IMPL::_data( chip, static_cast< uint8_t >( value ) );
+            }
+        }
+        
+        void PIC::raise( uint8_t irq )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_chips[ ( irq >> 3 ) & 1 ].irr |= static_cast< uint8_t >( 1 << ( irq & 7 ) );
+        }
+        
+        void PIC::lower( uint8_t irq )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_chips[ ( irq >> 3 ) & 1 ].irr &= static_cast< uint8_t >( ~( 1 << ( irq & 7 ) ) );
+        }
+        
+        bool PIC::pending( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_master() >= 0;
+        }
+        
+        uint8_t PIC::acknowledge( void )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            IMPL::Chip                  & master( this->impl->_chips[ 0 ] );
+            IMPL::Chip                  & slave( this->impl->_chips[ 1 ] );
+            int                           irq( this->impl->_master() );
+            
+            if( irq < 0 )
+            {
+                return 7;
+            }
+            
+            if( irq == 2 && this->impl->_slave() >= 0 )
+            {
+                int cascaded( this->impl->_slave() );
+                
+                slave.irr &= static_cast< uint8_t >( ~( 1 << cascaded ) );
+                
+                if( slave.autoEOI == false )
+                {
+                    slave.isr |= static_cast< uint8_t >( 1 << cascaded );
+                }
+                
+                if( master.autoEOI == false )
+                {
+                    master.isr |= 0x04;
+                }
+                
+                return static_cast< uint8_t >( 8 + cascaded );
+            }
+            
+            master.irr &= static_cast< uint8_t >( ~( 1 << irq ) );
+            
+            if( master.autoEOI == false )
+            {
+                master.isr |= static_cast< uint8_t >( 1 << irq );
+            }
+            
+            return static_cast< uint8_t >( irq );
+        }
+        
+        uint8_t PIC::vector( uint8_t irq ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return static_cast< uint8_t >( this->impl->_chips[ ( irq >> 3 ) & 1 ].base + ( irq & 7 ) );
+        }
+        
+        void PIC::endOfInterrupt( uint8_t irq )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( irq >= 8 )
+            {
+                this->impl->_chips[ 1 ].isr &= static_cast< uint8_t >( ~( 1 << ( irq & 7 ) ) );
+                
+                if( this->impl->_chips[ 1 ].isr == 0 )
+                {
+                    this->impl->_chips[ 0 ].isr &= static_cast< uint8_t >( ~0x04 );
+                }
+            }
+            else
+            {
+                this->impl->_chips[ 0 ].isr &= static_cast< uint8_t >( ~( 1 << irq ) );
+            }
+        }
+        
+        std::vector< uint8_t > PIC::state( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint8_t >        data( sizeof( this->impl->_chips ) );
+            
+            memcpy( data.data(), this->impl->_chips, data.size() );
+            
+            return data;
+        }
+        
+        void PIC::state( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( data.size() != sizeof( this->impl->_chips ) )
+            {
+                throw std::runtime_error( "Invalid PIC state" );
+            }
+            
+            memcpy( this->impl->_chips, data.data(), data.size() );
+        }
+        
+        PIC::IMPL::IMPL( void ):
+            _chips
+            {
+                { 0, 0, 0xB8, 0x08, 0, false, true, false, false },
+                { 0, 0, 0xFF, 0x70, 0, false, true, false, false }
+            }
+        {}
+        
+        PIC::IMPL::~IMPL( void )
+        {}
+        
+        int PIC::IMPL::_highest( const Chip & chip, uint8_t requests )
+        {
+            for( int i = 0; i < 8; i++ )
+            {
+                if( chip.isr & ( 1 << i ) )
+                {
+                    return -1;
+                }
+                
+                if( requests & ( 1 << i ) )
+                {
+                    return i;
+                }
+            }
+            
+            return -1;
+        }
+        
+        void PIC::IMPL::_command( Chip & chip, uint8_t value )
+        {
+            if( value & 0x10 )
+            {
+                chip.irr     = 0;
+                chip.isr     = 0;
+                chip.imr     = 0;
+                chip.step    = 2;
+                chip.single  = ( value & 0x02 ) != 0;
+                chip.icw4    = ( value & 0x01 ) != 0;
+                chip.autoEOI = false;
+                chip.readISR = false;
+            }
+            else if( value & 0x08 )
+            {
+                if( value & 0x02 )
+                {
+                    chip.readISR = ( value & 0x01 ) != 0;
+                }
+            }
+            else
+            {
+                uint8_t command( static_cast< uint8_t >( value >> 5 ) );
+                
+                if( command == 1 || command == 5 )
+                {
+                    for( int i = 0; i < 8; i++ )
+                    {
+                        if( chip.isr & ( 1 << i ) )
+                        {
+                            chip.isr &= static_cast< uint8_t >( ~( 1 << i ) );
+                            
+                            break;
+                        }
+                    }
+                }
+                else if( command == 3 || command == 7 )
+                {
+                    chip.isr &= static_cast< uint8_t >( ~( 1 << ( value & 7 ) ) );
+                }
+            }
+        }
+        
+        void PIC::IMPL::_data( Chip & chip, uint8_t value )
+        {
+            if( chip.step == 2 )
+            {
+                chip.base = value & 0xF8;
+                chip.step = ( chip.single ) ? ( ( chip.icw4 ) ? 4 : 0 ) : 3;
+            }
+            else if( chip.step == 3 )
+            {
+                chip.step = ( chip.icw4 ) ? 4 : 0;
+            }
+            else if( chip.step == 4 )
+            {
+                chip.autoEOI = ( value & 0x02 ) != 0;
+                chip.step    = 0;
+            }
+            else
+            {
+                chip.imr = value;
+            }
+        }
+        
+        int PIC::IMPL::_master( void ) const
+        {
+            uint8_t requests( this->_chips[ 0 ].irr );
+            
+            if( this->_slave() >= 0 )
+            {
+                requests |= 0x04;
+            }
+            
+            return _highest( this->_chips[ 0 ], requests & static_cast< uint8_t >( ~( this->_chips[ 0 ].imr ) ) );
+        }
+        
+        int PIC::IMPL::_slave( void ) const
+        {
+            return _highest( this->_chips[ 1 ], this->_chips[ 1 ].irr & static_cast< uint8_t >( ~( this->_chips[ 1 ].imr ) ) );
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#ifndef UB_DEVICES_PIC_HPP
+#define UB_DEVICES_PIC_HPP
+
+#include <memory>
+#include <algorithm>
+#include "UB/Devices/Device.hpp"
+
+namespace UB
+{
+    namespace Devices
+    {
+        class PIC: public Device
+        {
+            public:
+                
+                PIC( void );
+                
+                virtual ~PIC( void );
+                
+                PIC( const PIC & o )              = delete;
+                PIC( PIC && o )                   = delete;
+                PIC & operator =( const PIC & o ) = delete;
+                PIC & operator =( PIC && o )      = delete;
+                
+                std::string name( void )                                                   const override;
+                uint32_t    read(  Bus & bus, uint16_t port, size_t size )                       override;
+                void        write( Bus & bus, uint16_t port, size_t size, uint32_t value )       override;
+                
+                std::vector< uint8_t > state( void )                                const override;
+                void                   state( const std::vector< uint8_t > & data )       override;
+                
+                void    raise( uint8_t irq );
+                void    lower( uint8_t irq );
+                bool    pending( void )           const;
+                uint8_t acknowledge( void );
+                uint8_t vector( uint8_t irq )     const;
+                void    endOfInterrupt( uint8_t irq );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_DEVICES_PIC_HPP */
@@ -0,0 +1,387 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/Devices/PIT.hpp"
+#include "UB/Devices/Bus.hpp"
+#include <mutex>
+#include <limits>
+#include <cstring>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class PIT::IMPL
+        {
+            public:
+                
+                struct Counter
+                {
+                    uint8_t  mode;
+                    uint8_t  access;
+                    uint32_t reload;
+                    uint64_t start;
+                    bool     loaded;
+                    bool     latched;
+                    uint16_t latch;
+                    bool     readHigh;
+                    bool     writeHigh;
+                    uint8_t  low;
+                    uint64_t periods;
+                };
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                static uint64_t _ticks( const Bus & bus );
+                static uint16_t _count( const Counter & counter, uint64_t now );
+                static bool     _output( const Counter & counter, uint64_t now );
+                static void     _load( Counter & counter, uint16_t value, uint64_t now );
+                
+                Counter            _counters[ 3 ];
+                uint8_t            _control;
+                mutable std::mutex _mtx;
+        };
+        
+        PIT::PIT( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        PIT::~PIT( void )
+        {}
+        
+        std::string PIT::name( void ) const
+        {
+            return "8254 PIT";
+        }
+        
+        uint32_t PIT::read( Bus & bus, uint16_t port, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            uint64_t                      now( IMPL::_ticks( bus ) );
+            
+            ( void )size;
+            
+            if( port == 0x61 )
+            {
+                uint8_t value( this->impl->_control & 0x03 );
+                
+                if( ( now / 18 ) & 1 )
+                {
+                    value |= 0x10;
+                }
+                
+                if( IMPL::_output( this->impl->_counters[ 2 ], now ) )
+                {
+                    value |= 0x20;
+                }
+                
+                return value;
+            }
+            
+            if( port == 0x43 )
+            {
+                return 0xFF;
+            }
+            
+            {
+                IMPL::Counter & counter( this->impl->_counters[ port - 0x40 ] );
+                uint16_t        value( ( counter.latched ) ? counter.latch : IMPL::_count( counter, now ) );
+                uint8_t         byte;
+                
+                if( counter.access == 1 )
+                {
+                    byte            = static_cast< uint8_t >( value & 0xFF );
+                    counter.latched = false;
+                }
+                else if( counter.access == 2 )
+                {
+                    byte            = static_cast< uint8_t >( value >> 8 );
+                    counter.latched = false;
+                }
+                else if( counter.readHigh )
+                {
+                    byte             = static_cast< uint8_t >( value >> 8 );
+                    counter.readHigh = false;
+                    counter.latched  = false;
+                }
+                else
+                {
+                    byte             = static_cast< uint8_t >( value & 0xFF );
+                    counter.readHigh = true;
+                }
+                
+                return byte;
+            }
+        }
+        
+        void PIT::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            uint64_t                      now( IMPL::_ticks( bus ) );
+            uint8_t                       byte( static_cast< uint8_t >( value ) );
+            
+            ( void )size;
+            
+            if( port == 0x61 )
+            {
+                this->impl->_control = byte;
+            }
+            else if( port == 0x43 )
+            {
+                uint8_t select( static_cast< uint8_t >( byte >> 6 ) );
+                
+                if( select == 3 )
+                {
+                    for( unsigned int i = 0; i < 3; i++ )
+                    {
+                        if( ( byte & 0x20 ) == 0 && ( byte & ( 2 << i ) ) )
+                        {
+                            this->impl->_counters[ i ].latched  = true;
+                            this->impl->_counters[ i ].latch    = IMPL::_count( this->impl->_counters[ i ], now );
+                            this->impl->_counters[ i ].readHigh = false;
+                        }
+                    }
+                }
+                else
+                {
+                    IMPL::Counter & counter( this->impl->_counters[ select ] );
+                    uint8_t         access( ( byte >> 4 ) & 0x03 );
+                    
+                    if( access == 0 )
+                    {
+                        if( counter.latched == false )
+                        {
+                            counter.latched  = true;
+                            counter.latch    = IMPL::_count( counter, now );
+                            counter.readHigh = false;
+                        }
+                    }
+                    else
+                    {
+                        counter.access    = access;
+                        counter.mode      = ( byte >> 1 ) & 0x07;
+                        counter.mode      = ( counter.mode > 5 ) ? counter.mode & 0x03 : counter.mode;
+                        counter.loaded    = false;
+                        counter.latched   = false;
+                        counter.readHigh  = false;
+                        counter.writeHigh = false;
+                    }
+                }
+            }
+            else
+            {
+                IMPL::Counter & counter( this->impl->_counters[ port - 0x40 ] );
+                
+                if( counter.access == 1 )
+                {
+                    IMPL::_load( counter, byte, now );
+                }
+                else if( counter.access == 2 )
+                {
+                    IMPL::_load( counter, static_cast< uint16_t >( byte << 8 ), now );
+                }
+                else if( counter.writeHigh )
+                {
+                    counter.writeHigh = false;
+                    
+                    IMPL::_load( counter, static_cast< uint16_t >( counter.low | ( byte << 8 ) ), now );
+                }
+                else
+                {
+                    counter.low       = byte;
+                    counter.writeHigh = true;
+                }
+            }
+        }
+        
+        void PIT::update( Bus & bus )
+        {
+            bool raise( false );
+            
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                IMPL::Counter               & counter( this->impl->_counters[ 0 ] );
+                uint64_t                      now( IMPL::_ticks( bus ) );
+                
+                if( counter.loaded && now > counter.start )
+                {
+                    uint64_t periods( ( now - counter.start ) / counter.reload );
+                    
+                    if( counter.mode == 2 || counter.mode == 3 )
+                    {
+                        raise           = periods > counter.periods;
+                        counter.periods = periods;
+                    }
+                    else if( counter.mode == 0 && counter.periods == 0 && periods > 0 )
+                    {
+                        raise           = true;
+                        counter.periods = 1;
+                    }
+                }
+            }
+            
+            if( raise )
+            {
+                bus.raise( 0 );
+            }
+        }
+        
+        uint64_t PIT::deadline( const Bus & bus ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            const IMPL::Counter         & counter( this->impl->_counters[ 0 ] );
+            uint64_t                      ticks;
+            
+            ( void )bus;
+            
+            if( counter.loaded == false )
+            {
+                return std::numeric_limits< uint64_t >::max();
+            }
+            
+            if( counter.mode == 2 || counter.mode == 3 )
+            {
+                ticks = counter.start + ( counter.periods + 1 ) * counter.reload;
+            }
+            else if( counter.mode == 0 && counter.periods == 0 )
+            {
+                ticks = counter.start + counter.reload;
+            }
+            else
+            {
+                return std::numeric_limits< uint64_t >::max();
+            }
+            
+            return ( ticks / frequency ) * 1000000000 + ( ( ticks % frequency ) * 1000000000 + frequency - 1 ) / frequency;
+        }
+        
+        std::vector< uint8_t > PIT::state( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint8_t >        data( sizeof( this->impl->_counters ) + 1 );
+            
+            memcpy( data.data(), this->impl->_counters, sizeof( this->impl->_counters ) );
+            
+            data.back() = this->impl->_control;
+            
+            return data;
+        }
+        
+        void PIT::state( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( data.size() != sizeof( this->impl->_counters ) + 1 )
+            {
+                throw std::runtime_error( "Invalid PIT state" );
+            }
+            
+            memcpy( this->impl->_counters, data.data(), sizeof( this->impl->_counters ) );
+            
+            this->impl->_control = data.back();
+        }
+        
+        PIT::IMPL::IMPL( void ):
+            _counters
+            {
+                { 3, 3, 0x10000, 0, true,  false, 0, false, false, 0, 0 },
+                { 2, 3, 18,      0, true,  false, 0, false, false, 0, 0 },
+                { 3, 3, 0x10000, 0, false, false, 0, false, false, 0, 0 }
+            },
+            _control( 0 )
+        {}
+        
+        PIT::IMPL::~IMPL( void )
+        {}
+        
+        uint64_t PIT::IMPL::_ticks( const Bus & bus )
+        {
+            uint64_t ns( bus.time() );
+            
+            return ( ns / 1000000000 ) * frequency + ( ( ns % 1000000000 ) * frequency ) / 1000000000;
+        }
+        
+        uint16_t PIT::IMPL::_count( const Counter & counter, uint64_t now )
+        {
+            uint64_t elapsed;
+            
+            if( counter.loaded == false || now < counter.start )
+            {
+                return static_cast< uint16_t >( counter.reload );
+            }
+            
+            elapsed = now - counter.start;
+            
+            if( counter.mode == 2 )
+            {
+                return static_cast< uint16_t >( counter.reload - ( elapsed % counter.reload ) );
+            }
+            
+            if( counter.mode == 3 )
+            {
+                return static_cast< uint16_t >( ( counter.reload - ( ( elapsed * 2 ) % counter.reload ) ) & 0xFFFE );
+            }
+            
+            return static_cast< uint16_t >( ( counter.reload - elapsed ) & 0xFFFF );
+        }
+        
+        bool PIT::IMPL::_output( const Counter & counter, uint64_t now )
+        {
+            uint64_t elapsed;
+            
+            if( counter.loaded == false || now < counter.start )
+            {
+                return counter.mode != 0;
+            }
+            
+            elapsed = now - counter.start;
+            
+            if( counter.mode == 0 )
+            {
+                return elapsed >= counter.reload;
+            }
+            
+            if( counter.mode == 2 )
+            {
+                return ( elapsed % counter.reload ) != counter.reload - 1;
+            }
+            
+            if( counter.mode == 3 )
+            {
+                return ( elapsed % counter.reload ) < counter.reload / 2;
+            }
+            
+            return true;
+        }
+        
+        void PIT::IMPL::_load( Counter & counter, uint16_t value, uint64_t now )
+        {
+            counter.reload  = ( value == 0 ) ? 0x10000 : value;
+            counter.start   = now;
+            counter.loaded  = true;
+            counter.periods = 0;
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/Devices/POST.hpp"
+#include <vector>
+#include <mutex>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class POST::IMPL
+        {
+            public:
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                uint8_t                                         _code;
+                std::vector< std::function< void( uint8_t ) > > _handlers;
+                mutable std::mutex                              _mtx;
+        };
+        
+        POST::POST( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        POST::~POST( void )
+        {}
+        
+        std::string POST::name( void ) const
+        {
+            return "POST diagnostic port";
+        }
+        
+        uint32_t POST::read( Bus & bus, uint16_t port, size_t size )
+        {
+            ( void )bus;
+            ( void )port;
+            ( void )size;
+            
+            return this->code();
+        }
+        
+        void POST::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            std::vector< std::function< void( uint8_t ) > > handlers;
+            
+            ( void )bus;
+            ( void )port;
+            ( void )size;
+            
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                
+                if( this->impl->_code == static_cast< uint8_t >( value ) )
+                {
+                    return;
+                }
+                
+                this->impl->_code = static_cast< uint8_t >( value );
+                handlers          = this->impl->_handlers;
+            }
+            
+            for( const auto & f: handlers )
+            {
+                f( static_cast< uint8_t >( value ) );
+            }
+        }
+        
+        uint8_t POST::code( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_code;
+        }
+        
+        void POST::onCode( const std::function< void( uint8_t ) > & handler )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_handlers.push_back( handler );
+        }
+        
+        std::vector< uint8_t > POST::state( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return { this->impl->_code };
+        }
+        
+        void POST::state( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( data.size() != 1 )
+            {
+                throw std::runtime_error( "Invalid POST state" );
+            }
+            
+            this->impl->_code = data[ 0 ];
+        }
+        
+        POST::IMPL::IMPL( void ):
+            _code( 0 )
+        {}
+        
+        POST::IMPL::~IMPL( void )
+        {}
+    }
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+#include "UB/Devices/SystemControl.hpp"
+#include "UB/Devices/Bus.hpp"
+#include <atomic>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class SystemControl::IMPL
+        {
+            public:
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                std::atomic< uint8_t > _value;
+        };
+        
+        SystemControl::SystemControl( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        SystemControl::~SystemControl( void )
+        {}
+        
+        std::string SystemControl::name( void ) const
+        {
+            return "System control port A";
+        }
+        
+        uint32_t SystemControl::read( Bus & bus, uint16_t port, size_t size )
+        {
+            ( void )bus;
+            ( void )port;
+            ( void )size;
+            
+            return this->impl->_value;
+        }
+        
+        void SystemControl::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            ( void )port;
+            ( void )size;
+            
+            this->impl->_value = static_cast< uint8_t >( value & 0xFE );
+            
+            if( value & 0x01 )
+            {
+                bus.stop();
+            }
+        }
+        
+        bool SystemControl::a20( void ) const
+        {
+            return ( this->impl->_value & 0x02 ) != 0;
+        }
+        
+        std::vector< uint8_t > SystemControl::state( void ) const
+        {
+            return { this->impl->_value };
+        }
+        
+        void SystemControl::state( const std::vector< uint8_t > & data )
+        {
+            if( data.size() != 1 )
+            {
+                throw std::runtime_error( "Invalid system control state" );
+            }
+            
+            this->impl->_value = data[ 0 ];
+        }
+        
+        SystemControl::IMPL::IMPL( void ):
+            _value( 0x02 )
+        {}
+        
+        SystemControl::IMPL::~IMPL( void )
+        {}
+    }
+}
@@ -0,0 +1,363 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/Devices/UART.hpp"
+#include "UB/Devices/Bus.hpp"
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <limits>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class UART::IMPL
+        {
+            public:
+                
+                IMPL( uint16_t base, uint8_t irq );
+                ~IMPL( void );
+                
+                uint8_t _identification( void ) const;
+                uint8_t _lineStatus( void )     const;
+                uint8_t _modemStatus( void )    const;
+                
+                uint16_t                       _base;
+                uint8_t                        _irq;
+                uint16_t                       _divisor;
+                uint8_t                        _ier;
+                uint8_t                        _fcr;
+                uint8_t                        _lcr;
+                uint8_t                        _mcr;
+                uint8_t                        _scr;
+                bool                           _thre;
+                bool                           _line;
+                std::deque< uint8_t >          _rx;
+                std::shared_ptr< AsyncWriter > _writer;
+                mutable std::recursive_mutex   _mtx;
+        };
+        
+        UART::UART( uint16_t base, uint8_t irq ):
+            impl( std::make_unique< IMPL >( base, irq ) )
+        {}
+        
+        UART::~UART( void )
+        {}
+        
+        std::string UART::name( void ) const
+        {
+            return "16550 UART";
+        }
+        
+        uint32_t UART::read( Bus & bus, uint16_t port, size_t size )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            ( void )bus;
+            ( void )size;
+            
+            switch( port - this->impl->_base )
+            {
+                case 0:
+                    
+                    if( this->impl->_lcr & 0x80 )
+                    {
+                        return this->impl->_divisor & 0xFF;
+                    }
+                    
+                    if( this->impl->_rx.empty() == false )
+                    {
+                        uint8_t c( this->impl->_rx.front() );
+                        
+                        this->impl->_rx.pop_front();
+                        
+                        return c;
+                    }
+                    
+                    return 0;
+                
+                case 1:
+                    
+                    return ( this->impl->_lcr & 0x80 ) ? this->impl->_divisor >> 8 : this->impl->_ier;
+                
+                case 2:
+                {
+                    uint8_t iir( this->impl->_identification() );
+                    
+                    if( ( iir & 0x0F ) == 0x02 )
+                    {
+                        this->impl->_thre = false;
+                    }
+                    
+                    return iir;
+                }
+                
+                case 3: return this->impl->_lcr;
+                case 4: return this->impl->_mcr;
+                case 5: return this->impl->_lineStatus();
+                case 6: return this->impl->_modemStatus();
+                case 7: return this->impl->_scr;
+                
+                default: break;
+            }
+            
+            return 0xFF;
+        }
+        
+        void UART::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            uint8_t byte( static_cast< uint8_t >( value ) );
+            
+            ( void )size;
+            
+            switch( port - this->impl->_base )
+            {
+                case 0:
+                    
+                    if( this->impl->_lcr & 0x80 )
+                    {
+                        this->impl->_divisor = static_cast< uint16_t >( ( this->impl->_divisor & 0xFF00 ) | byte );
+                    }
+                    else if( this->impl->_mcr & 0x10 )
+                    {
+                        this->impl->_rx.push_back( byte );
+                        
+                        this->impl->_thre = true;
+                    }
+                    else
+                    {
+                        if( this->impl->_writer != nullptr )
+                        {
+                            this->impl->_writer->write( byte );
+                        }
+                        
+                        this->impl->_thre = true;
+                    }
+                    
+                    break;
+                
+                case 1:
+                    
+                    if( this->impl->_lcr & 0x80 )
+                    {
+                        this->impl->_divisor = static_cast< uint16_t >( ( this->impl->_divisor & 0x00FF ) | ( byte << 8 ) );
+                    }
+                    else
+                    {
+                        if( ( byte & 0x02 ) && ( this->impl->_ier & 0x02 ) == 0 )
+                        {
+                            this->impl->_thre = true;
+                        }
+                        
+                        this->impl->_ier = byte & 0x0F;
+                    }
+                    
+                    break;
+                
+                case 2:
+                    
+                    if( byte & 0x02 )
+                    {
+                        this->impl->_rx.clear();
+                    }
+                    
+                    this->impl->_fcr = byte & 0xC9;
+                    
+                    break;
+                
+                case 3: this->impl->_lcr = byte;        break;
+                case 4: this->impl->_mcr = byte & 0x1F; break;
+                case 7: this->impl->_scr = byte;        break;
+                
+                default: break;
+            }
+            
+            this->update( bus );
+        }
+        
+        void UART::update( Bus & bus )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            bool line( ( this->impl->_identification() & 0x01 ) == 0 && ( this->impl->_mcr & 0x08 ) != 0 );
+            
+            if( line && this->impl->_line == false )
+            {
+                bus.raise( this->impl->_irq );
+            }
+            
+            this->impl->_line = line;
+        }
+        
+        uint64_t UART::deadline( const Bus & bus ) const
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            bool line( ( this->impl->_identification() & 0x01 ) == 0 && ( this->impl->_mcr & 0x08 ) != 0 );
+            
+            ( void )bus;
+            
+            return ( line && this->impl->_line == false ) ? 0 : std::numeric_limits< uint64_t >::max();
+        }
+        
+        uint16_t UART::base( void ) const
+        {
+            return this->impl->_base;
+        }
+        
+        uint8_t UART::irq( void ) const
+        {
+            return this->impl->_irq;
+        }
+        
+        void UART::output( const std::shared_ptr< AsyncWriter > & writer )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            this->impl->_writer = writer;
+        }
+        
+        void UART::input( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            this->impl->_rx.insert( this->impl->_rx.end(), data.begin(), data.end() );
+        }
+        
+        void UART::flush( void )
+        {
+            std::shared_ptr< AsyncWriter > writer;
+            
+            {
+                std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+                
+                writer = this->impl->_writer;
+            }
+            
+            if( writer != nullptr )
+            {
+                writer->flush();
+            }
+        }
+        
+        std::vector< uint8_t > UART::state( void ) const
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            std::vector< uint8_t >                  data
+            {
+                static_cast< uint8_t >( this->impl->_divisor & 0xFF ),
+                static_cast< uint8_t >( this->impl->_divisor >> 8 ),
+                this->impl->_ier,
+                this->impl->_fcr,
+                this->impl->_lcr,
+                this->impl->_mcr,
+                this->impl->_scr,
+                static_cast< uint8_t >( this->impl->_thre ),
+                static_cast< uint8_t >( this->impl->_line )
+            };
+            
+            data.insert( data.end(), this->impl->_rx.begin(), this->impl->_rx.end() );
+            
+            return data;
+        }
+        
+        void UART::state( const std::vector< uint8_t > & data )
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_mtx );
+            
+            if( data.size() < 9 )
+            {
+                throw std::runtime_error( "Invalid UART state" );
+            }
+            
+            this->impl->_divisor = static_cast< uint16_t >( data[ 0 ] | ( data[ 1 ] << 8 ) );
+            this->impl->_ier     = data[ 2 ];
+            this->impl->_fcr     = data[ 3 ];
+            this->impl->_lcr     = data[ 4 ];
+            this->impl->_mcr     = data[ 5 ];
+            this->impl->_scr     = data[ 6 ];
+            this->impl->_thre    = data[ 7 ] != 0;
+            this->impl->_line    = data[ 8 ] != 0;
+            
+            this->impl->_rx.assign( data.begin() + 9, data.end() );
+        }
+        
+        UART::IMPL::IMPL( uint16_t base, uint8_t irq ):
+            _base(    base ),
+            _irq(     irq ),
+            _divisor( 0x0C ),
+            _ier(     0 ),
+            _fcr(     0 ),
+            _lcr(     0x03 ),
+            _mcr(     0 ),
+            _scr(     0 ),
+            _thre(    false ),
+            _line(    false )
+        {}
+        
+        UART::IMPL::~IMPL( void )
+        {}
+        
+        uint8_t UART::IMPL::_identification( void ) const
+        {
+            uint8_t fifo( ( this->_fcr & 0x01 ) ? 0xC0 : 0x00 );
+            
+            if( ( this->_ier & 0x01 ) && this->_rx.empty() == false )
+            {
+                return static_cast< uint8_t >( fifo | 0x04 );
+            }
+            
+            if( ( this->_ier & 0x02 ) && this->_thre )
+            {
+                return static_cast< uint8_t >( fifo | 0x02 );
+            }
+            
+            return static_cast< uint8_t >( fifo | 0x01 );
+        }
+        
+        uint8_t UART::IMPL::_lineStatus( void ) const
+        {
+            return ( this->_rx.empty() ) ? 0x60 : 0x61;
+        }
+        
+        uint8_t UART::IMPL::_modemStatus( void ) const
+        {
+            if( this->_mcr & 0x10 )
+            {
+                return static_cast< uint8_t >
+                (
+                      ( ( this->_mcr & 0x01 ) << 5 )
+                    | ( ( this->_mcr & 0x02 ) << 3 )
+                    | ( ( this->_mcr & 0x04 ) << 4 )
+                    | ( ( this->_mcr & 0x08 ) << 4 )
+                );
+            }
+            
+            return 0xB0;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_DEVICES_UART_HPP
+#define UB_DEVICES_UART_HPP
+
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include "UB/Devices/Device.hpp"
+#include "UB/AsyncWriter.hpp"
+
+namespace UB
+{
+    namespace Devices
+    {
+        class UART: public Device
+        {
+            public:
+                
+                UART( uint16_t base, uint8_t irq );
+                
+                virtual ~UART( void );
+                
+                UART( const UART & o )              = delete;
+                UART( UART && o )                   = delete;
+                UART & operator =( const UART & o ) = delete;
+                UART & operator =( UART && o )      = delete;
+                
+                std::string name( void )                                                   const override;
+                uint32_t    read(  Bus & bus, uint16_t port, size_t size )                       override;
+                void        write( Bus & bus, uint16_t port, size_t size, uint32_t value )       override;
+                void        update( Bus & bus )                                                  override;
+                uint64_t    deadline( const Bus & bus )                                    const override;
+                
+                std::vector< uint8_t > state( void )                                const override;
+                void                   state( const std::vector< uint8_t > & data )       override;
+                
+                uint16_t base( void ) const;
+                uint8_t  irq( void )  const;
+                
+                void output( const std::shared_ptr< AsyncWriter > & writer );
+                void input( const std::vector< uint8_t > & data );
+                void flush( void );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_DEVICES_UART_HPP */
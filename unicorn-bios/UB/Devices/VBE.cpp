@@ -0,0 +1,315 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/Devices/VBE.hpp"
+#include "UB/Casts.hpp"
+#include <zlib.h>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class VBE::IMPL
+        {
+            public:
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                static void _append( std::vector< uint8_t > & data, uint32_t value );
+                static void _chunk( std::vector< uint8_t > & png, const char * type, const std::vector< uint8_t > & data );
+                
+                bool                   _enabled;
+                Mode                   _mode;
+                size_t                 _tilesX;
+                size_t                 _tilesY;
+                std::vector< bool >    _dirty;
+                std::vector< uint8_t > _image;
+                mutable std::mutex     _mtx;
+        };
+        
+        VBE::VBE( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        VBE::~VBE( void )
+        {}
+        
+        std::vector< VBE::Mode > VBE::modes( void )
+        {
+            return
+            {
+                { 0x111,  640, 480, 16 },
+                { 0x112,  640, 480, 24 },
+                { 0x114,  800, 600, 16 },
+                { 0x115,  800, 600, 24 },
+                { 0x117, 1024, 768, 16 },
+                { 0x118, 1024, 768, 24 },
+                { 0x140,  640, 480, 32 },
+                { 0x141,  800, 600, 32 },
+                { 0x142, 1024, 768, 32 }
+            };
+        }
+        
+        bool VBE::enabled( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_enabled;
+        }
+        
+        VBE::Mode VBE::mode( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_mode;
+        }
+        
+        size_t VBE::pitch( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return static_cast< size_t >( this->impl->_mode.width ) * ( this->impl->_mode.bitsPerPixel / 8 );
+        }
+        
+        bool VBE::mode( uint16_t number )
+        {
+            for( const auto & mode: modes() )
+            {
+                if( mode.number == number )
+                {
+                    std::lock_guard< std::mutex > l( this->impl->_mtx );
+                    
+                    this->impl->_enabled = true;
+                    this->impl->_mode    = mode;
+                    this->impl->_tilesX  = ( mode.width  + tileSize - 1 ) / tileSize;
+                    this->impl->_tilesY  = ( mode.height + tileSize - 1 ) / tileSize;
+                    
+                    this->impl->_dirty.assign( this->impl->_tilesX * this->impl->_tilesY, true );
+                    this->impl->_image.assign( static_cast< size_t >( mode.width ) * mode.height * 3, 0 );
+                    
+                    return true;
+                }
+            }
+            
+            return false;
+        }
+        
+        void VBE::disable( void )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_enabled = false;
+        }
+        
+        void VBE::invalidate( void )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_dirty.assign( this->impl->_dirty.size(), true );
+        }
+        
+        void VBE::invalidate( uint64_t offset, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            size_t                        bytes( this->impl->_mode.bitsPerPixel / 8 );
+            size_t                        pitch( this->impl->_mode.width * bytes );
+            
+            if( this->impl->_enabled == false )
+            {
+                return;
+            }
+            
+            for( uint64_t o: { offset, offset + std::max< size_t >( size, 1 ) - 1 } )
+            {
+                size_t y( static_cast< size_t >( o / pitch ) );
+                size_t x( static_cast< size_t >( o % pitch ) / bytes );
+                
+                if( y < this->impl->_mode.height )
+                {
+                    this->impl->_dirty[ ( y / tileSize ) * this->impl->_tilesX + ( x / tileSize ) ] = true;
+                }
+            }
+        }
+        
+        size_t VBE::update( const std::function< std::vector< uint8_t >( uint64_t, size_t ) > & read )
+        {
+            std::vector< size_t > tiles;
+            Mode                  mode;
+            size_t                tilesX;
+            
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                
+                if( this->impl->_enabled == false )
+                {
+                    return 0;
+                }
+                
+                for( size_t i = 0; i < this->impl->_dirty.size(); i++ )
+                {
+                    if( this->impl->_dirty[ i ] )
+                    {
+                        tiles.push_back( i );
+                    }
+                }
+                
+                this->impl->_dirty.assign( this->impl->_dirty.size(), false );
+                
+                mode   = this->impl->_mode;
+                tilesX = this->impl->_tilesX;
+            }
+            
+            for( size_t tile: tiles )
+            {
+                size_t bytes( mode.bitsPerPixel / 8 );
+                size_t x( ( tile % tilesX ) * tileSize );
+                size_t y( ( tile / tilesX ) * tileSize );
+                size_t width( mode.width - x );
+                size_t height( mode.height - y );
+                
+                width  = ( width  > tileSize ) ? tileSize : width;
+                height = ( height > tileSize ) ? tileSize : height;
+                
+                for( size_t row = y; row < y + height; row++ )
+                {
+                    std::vector< uint8_t >        pixels( read( ( row * mode.width + x ) * bytes, width * bytes ) );
+                    std::lock_guard< std::mutex > l( this->impl->_mtx );
+                    uint8_t                     * rgb( this->impl->_image.data() + ( row * mode.width + x ) * 3 );
+                    
+                    if( this->impl->_image.size() != static_cast< size_t >( mode.width ) * mode.height * 3 || pixels.size() < width * bytes )
+                    {
+                        break;
+                    }
+                    
+                    for( size_t i = 0; i < width; i++ )
+                    {
+                        const uint8_t * p( pixels.data() + i * bytes );
+                        
+                        if( bytes == 2 )
+                        {
+                            uint16_t c( static_cast< uint16_t >( p[ 0 ] | ( p[ 1 ] << 8 ) ) );
+                            
+                            rgb[ i * 3 ]     = static_cast< uint8_t >( ( ( c >> 11 ) & 0x1F ) << 3 );
+                            rgb[ i * 3 + 1 ] = static_cast< uint8_t >( ( ( c >> 5 )  & 0x3F ) << 2 );
+                            rgb[ i * 3 + 2 ] = static_cast< uint8_t >( (   c          & 0x1F ) << 3 );
+                        }
+                        else
+                        {
+                            rgb[ i * 3 ]     = p[ 2 ];
+                            rgb[ i * 3 + 1 ] = p[ 1 ];
+                            rgb[ i * 3 + 2 ] = p[ 0 ];
+                        }
+                    }
+                }
+            }
+            
+            return tiles.size();
+        }
+        
+        std::vector< uint8_t > VBE::ppm( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::string                   header( "P6\n" + std::to_string( this->impl->_mode.width ) + " " + std::to_string( this->impl->_mode.height ) + "\n255\n" );
+            std::vector< uint8_t >        data( header.begin(), header.end() );
+            
+            data.insert( data.end(), this->impl->_image.begin(), this->impl->_image.end() );
+            
+            return data;
+        }
+        
+        std::vector< uint8_t > VBE::png( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint8_t >        png( { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' } );
+            std::vector< uint8_t >        header;
+            std::vector< uint8_t >        raw;
+            std::vector< uint8_t >        zlib;
+            uLongf                        length;
+            size_t                        stride( static_cast< size_t >( this->impl->_mode.width ) * 3 );
+            
+            IMPL::_append( header, this->impl->_mode.width );
+            IMPL::_append( header, this->impl->_mode.height );
+            header.insert( header.end(), { 8, 2, 0, 0, 0 } );
+            
+            for( size_t i = 0; i + stride <= this->impl->_image.size(); i += stride )
+            {
+                raw.push_back( 0 );
+                raw.insert( raw.end(), this->impl->_image.begin() + static_cast< std::ptrdiff_t >( i ), this->impl->_image.begin() + static_cast< std::ptrdiff_t >( i + stride ) );
+            }
+            
+            zlib.resize( compressBound( numeric_cast< uLong >( raw.size() ) ) );
+            
+            length = numeric_cast< uLongf >( zlib.size() );
+            
+            if( compress2( zlib.data(), &length, raw.data(), numeric_cast< uLong >( raw.size() ), Z_BEST_SPEED ) != Z_OK )
+            {
+                throw std::runtime_error( "Cannot compress framebuffer image" );
+            }
+            
+            zlib.resize( length );
+            
+            IMPL::_chunk( png, "IHDR", header );
+            IMPL::_chunk( png, "IDAT", zlib );
+            IMPL::_chunk( png, "IEND", {} );
+            
+            return png;
+        }
+        
+        VBE::IMPL::IMPL( void ):
+            _enabled( false ),
+            _mode(    { 0, 0, 0, 0 } ),
+            _tilesX(  0 ),
+            _tilesY(  0 )
+        {}
+        
+        VBE::IMPL::~IMPL( void )
+        {}
+        
+        void VBE::IMPL::_append( std::vector< uint8_t > & data, uint32_t value )
+        {
+            data.push_back( static_cast< uint8_t >( value >> 24 ) );
+            data.push_back( static_cast< uint8_t >( value >> 16 ) );
+            data.push_back( static_cast< uint8_t >( value >> 8 ) );
+            data.push_back( static_cast< uint8_t >( value ) );
+        }
+        
+        void VBE::IMPL::_chunk( std::vector< uint8_t > & png, const char * type, const std::vector< uint8_t > & data )
+        {
+            size_t start;
+            
+            _append( png, static_cast< uint32_t >( data.size() ) );
+            
+            start = png.size();
+            
+            png.insert( png.end(), type, type + 4 );
+            png.insert( png.end(), data.begin(), data.end() );
+            
+            _append( png, static_cast< uint32_t >( crc32( 0, png.data() + start, numeric_cast< uInt >( png.size() - start ) ) ) );
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_DEVICES_VBE_HPP
+#define UB_DEVICES_VBE_HPP
+
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class VBE
+        {
+            public:
+                
+                struct Mode
+                {
+                    uint16_t number;
+                    uint16_t width;
+                    uint16_t height;
+                    uint8_t  bitsPerPixel;
+                };
+                
+                static const uint64_t lfbBase  = 0xE0000000;
+                static const size_t   lfbSize  = 0x400000;
+                static const size_t   tileSize = 64;
+                
+                VBE( void );
+                ~VBE( void );
+                
+                VBE( const VBE & o )              = delete;
+                VBE( VBE && o )                   = delete;
+                VBE & operator =( const VBE & o ) = delete;
+                VBE & operator =( VBE && o )      = delete;
+                
+                static std::vector< Mode > modes( void );
+                
+                bool   enabled( void ) const;
+                Mode   mode( void )    const;
+                size_t pitch( void )   const;
+                
+                bool mode( uint16_t number );
+                void disable( void );
+                void invalidate( void );
+                void invalidate( uint64_t offset, size_t size );
+                
+                size_t                 update( const std::function< std::vector< uint8_t >( uint64_t, size_t ) > & read );
+                std::vector< uint8_t > ppm( void ) const;
+                std::vector< uint8_t > png( void ) const;
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_DEVICES_VBE_HPP */
@@ -0,0 +1,345 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/Devices/VGA.hpp"
+#include "UB/Devices/Bus.hpp"
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace Devices
+    {
+        class VGA::IMPL
+        {
+            public:
+                
+                IMPL( void );
+                ~IMPL( void );
+                
+                size_t                                                   _columns;
+                size_t                                                   _rows;
+                uint8_t                                                  _index;
+                std::array< uint8_t, 0x19 >                              _crtc;
+                bool                                                     _retrace;
+                std::array< std::atomic< uint64_t >, textSize / 2 / 64 > _dirty;
+                mutable std::mutex                                       _mtx;
+        };
+        
+        VGA::VGA( void ):
+            impl( std::make_unique< IMPL >() )
+        {}
+        
+        VGA::~VGA( void )
+        {}
+        
+        std::string VGA::name( void ) const
+        {
+            return "VGA";
+        }
+        
+        uint32_t VGA::read( Bus & bus, uint16_t port, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            ( void )bus;
+            ( void )size;
+            
+            if( port == 0x3D4 )
+            {
+                return this->impl->_index;
+            }
+            else if( port == 0x3D5 )
+            {
+                return ( this->impl->_index < this->impl->_crtc.size() ) ? this->impl->_crtc[ this->impl->_index ] : 0xFF;
+            }
+            else if( port == 0x3DA )
+            {
+                this->impl->_retrace = this->impl->_retrace == false;
+                
+                return ( this->impl->_retrace ) ? 0x09 : 0x00;
+            }
+            
+            return 0xFF;
+        }
+        
+        void VGA::write( Bus & bus, uint16_t port, size_t size, uint32_t value )
+        {
+            uint16_t start( this->start() );
+            
+            ( void )bus;
+            
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                
+                if( port == 0x3D4 )
+                {
+                    this->impl->_index = static_cast< uint8_t >( value & 0xFF );
+                    
+                    if( size > 1 )
+                    {
+                        port    = 0x3D5;
+                        value >>= 8;
+                    }
+                }
+                
+                if( port == 0x3D5 && this->impl->_index < this->impl->_crtc.size() )
+                {
+                    this->impl->_crtc[ this->impl->_index ] = static_cast< uint8_t >( value & 0xFF );
+                }
+            }
+            
+            if( this->start() != start )
+            {
+                this->invalidate();
+            }
+        }
+        
+        size_t VGA::columns( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_columns;
+        }
+        
+        size_t VGA::rows( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_rows;
+        }
+        
+        uint16_t VGA::start( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return static_cast< uint16_t >( ( this->impl->_crtc[ 0x0C ] << 8 ) | this->impl->_crtc[ 0x0D ] );
+        }
+        
+        uint16_t VGA::cursor( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return static_cast< uint16_t >( ( this->impl->_crtc[ 0x0E ] << 8 ) | this->impl->_crtc[ 0x0F ] );
+        }
+        
+        void VGA::textMode( size_t columns, size_t rows )
+        {
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                
+                this->impl->_columns = columns;
+                this->impl->_rows    = rows;
+            }
+            
+            this->start( 0 );
+            this->cursor( 0 );
+            this->invalidate();
+        }
+        
+        void VGA::start( uint16_t value )
+        {
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                
+                this->impl->_crtc[ 0x0C ] = static_cast< uint8_t >( value >> 8 );
+                this->impl->_crtc[ 0x0D ] = static_cast< uint8_t >( value & 0xFF );
+            }
+            
+            this->invalidate();
+        }
+        
+        void VGA::cursor( uint16_t value )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            this->impl->_crtc[ 0x0E ] = static_cast< uint8_t >( value >> 8 );
+            this->impl->_crtc[ 0x0F ] = static_cast< uint8_t >( value & 0xFF );
+        }
+        
+        void VGA::invalidate( void )
+        {
+            for( auto & word: this->impl->_dirty )
+            {
+                word = std::numeric_limits< uint64_t >::max();
+            }
+        }
+        
+        void VGA::invalidate( uint64_t offset, size_t size )
+        {
+            size_t first( static_cast< size_t >( offset / 2 ) );
+            size_t last(  static_cast< size_t >( ( offset + std::max< size_t >( size, 1 ) - 1 ) / 2 ) );
+            
+            for( size_t i = first; i <= last && i < textSize / 2; i++ )
+            {
+                this->impl->_dirty[ i / 64 ].fetch_or( static_cast< uint64_t >( 1 ) << ( i % 64 ), std::memory_order_relaxed );
+            }
+        }
+        
+        std::vector< size_t > VGA::dirty( void )
+        {
+            std::vector< size_t > cells;
+            size_t                first( this->start() );
+            size_t                count( this->columns() * this->rows() );
+            
+            for( size_t i = first; i < first + count && i < textSize / 2; )
+            {
+                size_t   bit(  i % 64 );
+                size_t   n(    std::min< size_t >( 64 - bit, first + count - i ) );
+                uint64_t mask( ( ( n == 64 ) ? std::numeric_limits< uint64_t >::max() : ( static_cast< uint64_t >( 1 ) << n ) - 1 ) << bit );
+                uint64_t bits( this->impl->_dirty[ i / 64 ].fetch_and( ~mask, std::memory_order_relaxed ) & mask );
+                
+                while( bits != 0 )
+                {
+                    size_t j( 0 );
+                    
+                    while( ( bits & ( static_cast< uint64_t >( 1 ) << j ) ) == 0 )
+                    {
+                        j++;
+                    }
+                    
+                    bits &= ~( static_cast< uint64_t >( 1 ) << j );
+                    
+                    cells.push_back( ( i - bit ) + j - first );
+                }
+                
+                i += n;
+            }
+            
+            return cells;
+        }
+        
+        std::string VGA::text( const std::vector< uint8_t > & memory ) const
+        {
+            std::string s;
+            size_t      columns( this->columns() );
+            size_t      rows( this->rows() );
+            
+            for( size_t y = 0; y < rows; y++ )
+            {
+                std::string line;
+                
+                for( size_t x = 0; x < columns && ( ( y * columns ) + x ) * 2 < memory.size(); x++ )
+                {
+                    line += character( memory[ ( ( y * columns ) + x ) * 2 ] );
+                }
+                
+                line.erase( line.find_last_not_of( ' ' ) + 1 );
+                
+                s += line + "\n";
+            }
+            
+            return s;
+        }
+        
+        char VGA::character( uint8_t c )
+        {
+            if( c >= 0x20 && c < 0x7F )
+            {
+                return static_cast< char >( c );
+            }
+            else if( c == 0x00 || c == 0xFF )
+            {
+                return ' ';
+            }
+            else if( c == 0xB3 || c == 0xBA )
+            {
+                return '|';
+            }
+            else if( c == 0xC4 || c == 0xCD )
+            {
+                return '-';
+            }
+            else if( c >= 0xB4 && c <= 0xDA )
+            {
+                return '+';
+            }
+            else if( ( c >= 0xB0 && c <= 0xB2 ) || ( c >= 0xDB && c <= 0xDF ) )
+            {
+                return '#';
+            }
+            
+            return '.';
+        }
+        
+        std::vector< uint8_t > VGA::state( void ) const
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            std::vector< uint8_t >        data
+            {
+                static_cast< uint8_t >( this->impl->_columns ),
+                static_cast< uint8_t >( this->impl->_rows ),
+                this->impl->_index,
+                static_cast< uint8_t >( this->impl->_retrace )
+            };
+            
+            data.insert( data.end(), this->impl->_crtc.begin(), this->impl->_crtc.end() );
+            
+            return data;
+        }
+        
+        void VGA::state( const std::vector< uint8_t > & data )
+        {
+            {
+                std::lock_guard< std::mutex > l( this->impl->_mtx );
+                
+                if( data.size() != 4 + this->impl->_crtc.size() )
+                {
+                    throw std::runtime_error( "Invalid VGA state" );
+                }
+                
+                this->impl->_columns = data[ 0 ];
+                this->impl->_rows    = data[ 1 ];
+                this->impl->_index   = data[ 2 ];
+                this->impl->_retrace = data[ 3 ] != 0;
+                
+                std::copy( data.begin() + 4, data.end(), this->impl->_crtc.begin() );
+            }
+            
+            this->invalidate();
+        }
+        
+        VGA::IMPL::IMPL( void ):
+            _columns( 80 ),
+            _rows(    25 ),
+            _index(   0 ),
+            _crtc(    {} ),
+            _retrace( false )
+        {
+            this->_crtc[ 0x0A ] = 0x0D;
+            this->_crtc[ 0x0B ] = 0x0E;
+            
+            for( auto & word: this->_dirty )
+            {
+                word = std::numeric_limits< uint64_t >::max();
+            }
+        }
+        
+        VGA::IMPL::~IMPL( void )
+        {}
+    }
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_DEVICES_VGA_HPP
+#define UB_DEVICES_VGA_HPP
+
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include "UB/Devices/Device.hpp"
+
+namespace UB
+{
+    namespace Devices
+    {
+        class VGA: public Device
+        {
+            public:
+                
+                static const uint64_t textBase = 0xB8000;
+                static const size_t   textSize = 0x8000;
+                
+                VGA( void );
+                
+                virtual ~VGA( void );
+                
+                VGA( const VGA & o )              = delete;
+                VGA( VGA && o )                   = delete;
+                VGA & operator =( const VGA & o ) = delete;
+                VGA & operator =( VGA && o )      = delete;
+                
+                std::string name( void )                                                   const override;
+                uint32_t    read(  Bus & bus, uint16_t port, size_t size )                       override;
+                void        write( Bus & bus, uint16_t port, size_t size, uint32_t value )       override;
+                
+                std::vector< uint8_t > state( void )                                const override;
+                void                   state( const std::vector< uint8_t > & data )       override;
+                
+                size_t   columns( void ) const;
+                size_t   rows( void )    const;
+                uint16_t start( void )   const;
+                uint16_t cursor( void )  const;
+                
+                void textMode( size_t columns, size_t rows );
+                void start( uint16_t value );
+                void cursor( uint16_t value );
+                
+                void                  invalidate( void );
+                void                  invalidate( uint64_t offset, size_t size );
+                std::vector< size_t > dirty( void );
+                std::string           text( const std::vector< uint8_t > & memory ) const;
+                
+                static char character( uint8_t c );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_DEVICES_VGA_HPP */
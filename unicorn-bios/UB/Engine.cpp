@@ -30,12 +30,24 @@
 #include "UB/Engine.hpp"
 #include "UB/String.hpp"
 #include "UB/Casts.hpp"
+#include "UB/BinaryDataStream.hpp"
+#include "UB/Capstone.hpp"
 #include <unicorn/unicorn.h>
 #include <map>
+#include <set>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
 #include <limits>
+#include <array>
+#include <bitset>
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 namespace UB
 {
@@ -43,6 +55,41 @@ namespace UB
     {
         public:
             
+            struct Device
+            {
+                uint64_t                                            base;
+                size_t                                              size;
+                std::function< uint64_t( uint64_t, size_t ) >       read;
+                std::function< void( uint64_t, size_t, uint64_t ) > write;
+            };
+            
+            struct Execute
+            {
+                uint64_t                          begin;
+                uint64_t                          end;
+                std::function< void( uint64_t ) > handler;
+            };
+            
+            struct Region
+            {
+                uint64_t                base;
+                std::vector< uint8_t >  data;
+                std::vector< uint64_t > dirty;
+            };
+            
+            struct Block
+            {
+                size_t size;
+                size_t instructions;
+            };
+            
+            struct Checkpoint
+            {
+                Mode                                                 mode;
+                std::unique_ptr< uc_context, uc_err( * )( void * ) > context;
+                std::vector< Region >                                regions;
+            };
+            
             IMPL( size_t memory );
             ~IMPL( void );
             
@@ -50,18 +97,88 @@ namespace UB
             static void _handleInstruction( uc_engine * uc, uint64_t address, uint32_t size, void * data );
             static bool _handleInvalidMemoryAccess( uc_engine * uc, uc_mem_type type, uint64_t address, int size, int64_t value, void * data );
             static void _handleValidMemoryAccess( uc_engine * uc, uc_mem_type type, uint64_t address, int size, int64_t value, void * data );
+            static void _handleExecute( uc_engine * uc, uint64_t address, uint32_t size, void * data );
+            static void _handleBlock( uc_engine * uc, uint64_t address, uint32_t size, void * data );
+            static void _handleSystemSite( uc_engine * uc, uint64_t address, uint32_t size, void * data );
+            static uint32_t _handlePortRead( uc_engine * uc, uint32_t port, int size, void * data );
+            static void _handlePortWrite( uc_engine * uc, uint32_t port, int size, uint32_t value, void * data );
+            static void _handleSystemInstruction( Engine & engine, uint8_t opcode, uint32_t eax, uint32_t ecx, uint32_t edx );
+            static void _handleDeviceRead( uc_engine * uc, uc_mem_type type, uint64_t address, int size, int64_t value, void * data );
+            static void _handleDeviceWrite( uc_engine * uc, uc_mem_type type, uint64_t address, int size, int64_t value, void * data );
+            
+            static bool _isSystemOpcode( uint8_t opcode );
+            
+            static const size_t idleThreshold = 64;
+            static const size_t poolLimit     = 16;
+            
+            static const std::vector< int > controlRegisters;
+            static const std::vector< int > tableRegisters;
+            static const std::vector< int > longModeRegisters;
+            static const std::vector< int > x87Registers;
+            static const std::vector< int > sseRegisters;
+            static const std::vector< int > longModeSSERegisters;
+            
+            static int _createMemory( size_t size );
+            
+            static std::unique_ptr< IMPL > _acquire( size_t memory );
+            static void                    _release( std::unique_ptr< IMPL > impl );
+            
+            static std::mutex                                                                  _poolMutex;
+            static std::map< std::pair< Mode, size_t >, std::vector< std::unique_ptr< IMPL > > > _pool;
+            
+            bool _isIdle( uint64_t address );
+            bool _scanBlock( uc_engine * uc, uint64_t address, uint32_t size, size_t & instructions );
+            void _addSystemHook( uc_engine * uc, uint64_t address );
+            void _completeSystemInstruction( void );
+            void _invalidateBlocks( uint64_t address, size_t size );
+            void _clearBlocks( void );
             
             std::vector< uint8_t > _read( size_t address, size_t size );
             void                   _write( size_t address, const uint8_t * bytes, size_t size );
             void                   _switchMode( Mode mode );
+            void                   _mapMemory( int fd, bool shared );
+            void                   _clearMemory( void );
+            void                   _reset( void );
+            void                   _addHooks( uc_engine * uc );
+            void                   _mapDevice( uc_engine * uc, const Device * device );
+            bool                   _isMapped( size_t address, size_t size ) const;
+            void                   _markDirty( uint64_t address, size_t size );
+            int                    _registerID( RegisterFrame::Register reg ) const;
             
+            Engine                     * _engine;
             size_t                       _memory;
+            uint8_t                    * _ram;
+            int                          _ramFD;
+            bool                         _frozen;
+            bool                         _modified;
             Mode                         _mode;
             Registers                    _registers;
+            Registers                    _previousRegisters;
+            std::atomic< bool >          _traceRequested;
+            bool                         _tracing;
             uint64_t                     _lastInstructionAddress;
             std::vector< uint8_t >       _lastInstruction;
+            std::vector< uint8_t >       _previousInstruction;
+            uint8_t                      _systemOpcode;
+            uint64_t                     _systemNext;
+            uint32_t                     _systemEAX;
+            uint32_t                     _systemECX;
+            uint32_t                     _systemEDX;
+            std::map< uint64_t, Block >  _blocks;
+            size_t                       _blockLimit;
+            std::vector< uint64_t >      _code;
+            std::set< uint64_t >         _systemSites;
             uc_engine                  * _uc;
             bool                         _running;
+            bool                         _jump;
+            size_t                       _jumpAddress;
+            bool                         _stopRequested;
+            bool                         _restart;
+            uint64_t                     _idleBlock;
+            size_t                       _idleRepeats;
+            bool                         _idleWrite;
+            std::vector< uint64_t >      _written;
+            std::vector< uc_hook >       _hooks;
             mutable std::recursive_mutex _rmtx;
             std::condition_variable_any  _cv;
             
@@ -73,6 +190,20 @@ namespace UB
             std::vector< std::function< void( uint64_t, size_t ) > >                                            _validMemoryHandlers;
             std::vector< std::function< void( uint64_t, const std::vector< uint8_t > & ) > >                    _beforeInstructionHandlers;
             std::vector< std::function< void( uint64_t, const Registers &, const std::vector< uint8_t > & ) > > _afterInstructionHandlers;
+            std::vector< std::unique_ptr< Execute > >                                                           _executeHandlers;
+            std::vector< std::function< void( uint64_t, size_t, size_t ) > >                                    _blockHandlers;
+            std::vector< std::function< bool( uint16_t, size_t, uint32_t & ) > >                                _portReadHandlers;
+            std::vector< std::function< bool( uint16_t, size_t, uint32_t ) > >                                  _portWriteHandlers;
+            std::vector< std::function< void( uint32_t, uint32_t, RegisterFrame & ) > >                         _cpuidHandlers;
+            std::vector< std::function< bool( uint64_t & ) > >                                                  _rdtscHandlers;
+            std::vector< std::function< bool( uint32_t, uint64_t & ) > >                                        _rdmsrHandlers;
+            std::vector< std::function< void( uint32_t, uint64_t ) > >                                          _wrmsrHandlers;
+            std::vector< std::function< void( void ) > >                                                        _idleHandlers;
+            std::vector< std::function< bool( void ) > >                                                        _haltHandlers;
+            std::array< uint64_t, RegisterFrame::count >                                                        _idleRegisters;
+            std::vector< std::unique_ptr< Device > >                                                            _devices;
+            std::unique_ptr< Checkpoint >                                                                       _checkpoint;
+            std::unique_ptr< uc_context, uc_err( * )( void * ) >                                                _context;
             
             template< typename _T_ >
             _T_ _readRegister( int reg ) const
@@ -102,6 +233,16 @@ namespace UB
             }
     };
     
+    const std::vector< int > Engine::IMPL::controlRegisters     = { UC_X86_REG_CR0, UC_X86_REG_CR2, UC_X86_REG_CR3, UC_X86_REG_CR4 };
+    const std::vector< int > Engine::IMPL::tableRegisters       = { UC_X86_REG_GDTR, UC_X86_REG_IDTR, UC_X86_REG_LDTR, UC_X86_REG_TR };
+    const std::vector< int > Engine::IMPL::longModeRegisters    = { UC_X86_REG_R8, UC_X86_REG_R9, UC_X86_REG_R10, UC_X86_REG_R11, UC_X86_REG_R12, UC_X86_REG_R13, UC_X86_REG_R14, UC_X86_REG_R15 };
+    const std::vector< int > Engine::IMPL::x87Registers         = { UC_X86_REG_ST0, UC_X86_REG_ST1, UC_X86_REG_ST2, UC_X86_REG_ST3, UC_X86_REG_ST4, UC_X86_REG_ST5, UC_X86_REG_ST6, UC_X86_REG_ST7 };
+    const std::vector< int > Engine::IMPL::sseRegisters         = { UC_X86_REG_XMM0, UC_X86_REG_XMM1, UC_X86_REG_XMM2, UC_X86_REG_XMM3, UC_X86_REG_XMM4, UC_X86_REG_XMM5, UC_X86_REG_XMM6, UC_X86_REG_XMM7 };
+    const std::vector< int > Engine::IMPL::longModeSSERegisters = { UC_X86_REG_XMM8, UC_X86_REG_XMM9, UC_X86_REG_XMM10, UC_X86_REG_XMM11, UC_X86_REG_XMM12, UC_X86_REG_XMM13, UC_X86_REG_XMM14, UC_X86_REG_XMM15 };
+    
+    std::mutex                                                                                  Engine::IMPL::_poolMutex;
+    std::map< std::pair< Engine::Mode, size_t >, std::vector< std::unique_ptr< Engine::IMPL > > > Engine::IMPL::_pool;
+    
     uint64_t Engine::getAddress( uint16_t segment, uint16_t offset )
     {
         uint64_t address( segment );
@@ -113,37 +254,15 @@ namespace UB
     }
     
     Engine::Engine( size_t memory ):
-        impl( std::make_unique< IMPL >( memory ) )
+        impl( IMPL::_acquire( memory ) )
     {
-        uc_hook h1;
-        uc_hook h2;
-        uc_hook h3;
-        uc_hook h4;
-        uc_err  e;
-        
-        if( ( e = uc_hook_add( this->impl->_uc, &h1, UC_HOOK_INTR, reinterpret_cast< void * >( &IMPL::_handleInterrupt ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
-        {
-            throw std::runtime_error( uc_strerror( e ) );
-        }
-        
-        if( ( e = uc_hook_add( this->impl->_uc, &h2, UC_HOOK_CODE, reinterpret_cast< void * >( &IMPL::_handleInstruction ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
-        {
-            throw std::runtime_error( uc_strerror( e ) );
-        }
-        
-        if( ( e = uc_hook_add( this->impl->_uc, &h3, UC_HOOK_MEM_INVALID, reinterpret_cast< void * >( &IMPL::_handleInvalidMemoryAccess ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
-        {
-            throw std::runtime_error( uc_strerror( e ) );
-        }
-        
-        if( ( e = uc_hook_add( this->impl->_uc, &h4, UC_HOOK_MEM_WRITE + UC_HOOK_MEM_FETCH, reinterpret_cast< void * >( &IMPL::_handleValidMemoryAccess ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
-        {
-            throw std::runtime_error( uc_strerror( e ) );
-        }
+        this->impl->_engine = this;
     }
     
     Engine::~Engine( void )
-    {}
+    {
+        IMPL::_release( std::move( this->impl ) );
+    }
     
     size_t Engine::memory( void ) const
     {
@@ -971,6 +1090,89 @@ namespace UB
         return this->impl->_registers;
     }
     
+    void Engine::trace( bool value )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_traceRequested = value;
+        
+        if( this->impl->_running == false && this->impl->_tracing != value )
+        {
+            this->impl->_tracing = value;
+            
+            this->impl->_switchMode( this->impl->_mode );
+        }
+    }
+    
+    RegisterFrame Engine::frame( void ) const
+    {
+        RegisterFrame                                frame;
+        std::array< int, RegisterFrame::count >      regs;
+        std::array< uint64_t, RegisterFrame::count > values{};
+        std::array< void *, RegisterFrame::count >   pointers;
+        uc_err                                       e;
+        std::lock_guard< std::recursive_mutex >      l( this->impl->_rmtx );
+        
+        for( size_t i = 0; i < RegisterFrame::count; i++ )
+        {
+            regs[ i ]     = this->impl->_registerID( static_cast< RegisterFrame::Register >( i ) );
+            pointers[ i ] = &( values[ i ] );
+        }
+        
+        if( ( e = uc_reg_read_batch( this->impl->_uc, regs.data(), pointers.data(), static_cast< int >( regs.size() ) ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        for( size_t i = 0; i < RegisterFrame::count; i++ )
+        {
+            frame.value( static_cast< RegisterFrame::Register >( i ), values[ i ] );
+        }
+        
+        frame.clean();
+        
+        return frame;
+    }
+    
+    void Engine::frame( const RegisterFrame & frame )
+    {
+        std::array< int, RegisterFrame::count >      regs;
+        std::array< uint64_t, RegisterFrame::count > values;
+        std::array< void *, RegisterFrame::count >   pointers;
+        int                                          count( 0 );
+        uc_err                                       e;
+        
+        if( frame.isDirty() == false )
+        {
+            return;
+        }
+        
+        for( size_t i = 0; i < RegisterFrame::count; i++ )
+        {
+            RegisterFrame::Register reg( static_cast< RegisterFrame::Register >( i ) );
+            
+            if( frame.isDirty( reg ) == false )
+            {
+                continue;
+            }
+            
+            regs[ static_cast< size_t >( count ) ]     = this->impl->_registerID( reg );
+            values[ static_cast< size_t >( count ) ]   = frame.value( reg );
+            pointers[ static_cast< size_t >( count ) ] = &( values[ static_cast< size_t >( count ) ] );
+            
+            count++;
+        }
+        
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            if( ( e = uc_reg_write_batch( this->impl->_uc, regs.data(), pointers.data(), count ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+    }
+    
     bool Engine::running( void ) const
     {
         std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
@@ -1024,6 +1226,11 @@ namespace UB
     {
         std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
         
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot add a before-instruction handler while the engine is running" );
+        }
+        
         this->impl->_beforeInstructionHandlers.push_back( handler );
     }
     
@@ -1031,226 +1238,1209 @@ namespace UB
     {
         std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
         
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot add an after-instruction handler while the engine is running" );
+        }
+        
         this->impl->_afterInstructionHandlers.push_back( handler );
     }
     
-    std::vector< uint8_t > Engine::read( size_t address, size_t size )
+    void Engine::onBlock( const std::function< void( uint64_t, size_t, size_t ) > handler )
     {
-        return this->impl->_read( address, size );
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot add a block handler while the engine is running" );
+        }
+        
+        this->impl->_blockHandlers.push_back( handler );
     }
     
-    void Engine::write( size_t address, const std::vector< uint8_t > & bytes )
+    void Engine::onPortRead( const std::function< bool( uint16_t, size_t, uint32_t & ) > handler )
     {
-        this->impl->_write( address, &( bytes[ 0 ] ), bytes.size() );
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_portReadHandlers.push_back( handler );
     }
     
-    void Engine::write( size_t address, const uint8_t * bytes, size_t size )
+    void Engine::onPortWrite( const std::function< bool( uint16_t, size_t, uint32_t ) > handler )
     {
-        this->impl->_write( address, bytes, size );
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_portWriteHandlers.push_back( handler );
     }
     
-    bool Engine::start( size_t address )
+    void Engine::onCPUID( const std::function< void( uint32_t, uint32_t, RegisterFrame & ) > handler )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_cpuidHandlers.push_back( handler );
+    }
+    
+    void Engine::onRDTSC( const std::function< bool( uint64_t & ) > handler )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_rdtscHandlers.push_back( handler );
+    }
+    
+    void Engine::onRDMSR( const std::function< bool( uint32_t, uint64_t & ) > handler )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_rdmsrHandlers.push_back( handler );
+    }
+    
+    void Engine::onWRMSR( const std::function< void( uint32_t, uint64_t ) > handler )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_wrmsrHandlers.push_back( handler );
+    }
+    
+    void Engine::onIdle( const std::function< void( void ) > handler )
     {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        if( this->impl->_running )
         {
-            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
-            
-            if( this->impl->_running )
-            {
-                return false;
-            }
-            
-            this->impl->_running = true;
-            
-            this->impl->_cv.notify_all();
-            
-            for( const auto & f: this->impl->_onStart )
-            {
-                f();
-            }
+            throw std::runtime_error( "Cannot add an idle handler while the engine is running" );
         }
         
-        std::thread
-        (
-            [ = ]
-            {
-                try
-                {
-                    uc_err e;
-                    
-                    if( ( e = uc_emu_start( this->impl->_uc, address, std::numeric_limits< uint64_t >::max(), 0, 0 ) ) != UC_ERR_OK )
-                    {
-                        throw std::runtime_error( uc_strerror( e ) );
-                    }
-                }
-                catch( const std::exception & e )
-                {
-                    std::vector< std::function< bool( const std::exception & ) > > handlers;
-                    bool                                                           handled( false );
-                    
-                    {
-                        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
-                        
-                        handlers = this->impl->_exceptionHandlers;
-                    }
-                    
-                    for( const auto & f: handlers )
-                    {
-                        if( f( e ) )
-                        {
-                            handled = true;
-                        }
-                    }
-                    
-                    if( handled == false )
-                    {
-                        throw e;
-                    }
-                }
-                
-                {
-                    std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
-                    
-                    this->impl->_running = false;
-                    
-                    this->impl->_cv.notify_all();
-                    
-                    for( const auto & f: this->impl->_onStop )
-                    {
-                        f();
-                    }
-                }
-            }
-        )
-        .detach();
+        this->impl->_idleHandlers.push_back( handler );
+    }
+    
+    void Engine::onHalt( const std::function< bool( void ) > handler )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
         
-        return true;
+        this->impl->_haltHandlers.push_back( handler );
     }
     
-    void Engine::stop( void )
+    void Engine::onExecute( uint64_t begin, uint64_t end, const std::function< void( uint64_t ) > handler )
     {
         std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        uc_hook                                 h;
+        uc_err                                  e;
         
-        if( this->impl->_running == false )
+        this->impl->_executeHandlers.push_back( std::make_unique< IMPL::Execute >( IMPL::Execute { begin, end, handler } ) );
+        
+        if( ( e = uc_hook_add( this->impl->_uc, &h, UC_HOOK_CODE, reinterpret_cast< void * >( &IMPL::_handleExecute ), this->impl->_executeHandlers.back().get(), begin, end ) ) != UC_ERR_OK )
         {
-            return;
+            this->impl->_executeHandlers.pop_back();
+            
+            throw std::runtime_error( uc_strerror( e ) );
         }
         
-        uc_emu_stop( this->impl->_uc );
+        this->impl->_hooks.push_back( h );
     }
     
-    void Engine::waitUntilFinished( void ) const
+    std::vector< uint8_t > Engine::read( size_t address, size_t size )
     {
-        std::unique_lock< std::recursive_mutex > l( this->impl->_rmtx );
-        
-        this->impl->_cv.wait
-        (
-            l,
-            [ & ]( void ) -> bool
-            {
-                return this->impl->_running == false;
-            }
-        );
+        return this->impl->_read( address, size );
     }
     
-    Engine::IMPL::IMPL( size_t memory ):
-        _memory( memory ),
-        _mode( Mode::Real ),
-        _uc( nullptr ),
-        _running( false )
+    void Engine::write( size_t address, const std::vector< uint8_t > & bytes )
     {
-        this->_switchMode( Mode::Real );
+        this->impl->_write( address, &( bytes[ 0 ] ), bytes.size() );
     }
     
-    Engine::IMPL::~IMPL( void )
+    void Engine::write( size_t address, const uint8_t * bytes, size_t size )
     {
-        if( this->_uc != nullptr )
-        {
-            uc_close( this->_uc );
-        }
+        this->impl->_write( address, bytes, size );
     }
     
-    void Engine::IMPL::_handleInterrupt( uc_engine * uc, uint32_t i, void * data )
+    void Engine::mapDevice( uint64_t base, size_t size, const std::function< uint64_t( uint64_t, size_t ) > read, const std::function< void( uint64_t, size_t, uint64_t ) > write )
     {
-        Engine                                         * engine;
-        std::vector< std::function< bool( uint32_t ) > > handlers;
-        
-        ( void )uc;
-        
-        engine = static_cast< Engine * >( data );
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
         
-        if( engine == nullptr )
+        if( size == 0 || ( base < this->impl->_memory && base + size > this->impl->_memory ) )
         {
-            throw std::runtime_error( "Fatal internal error: unknown engine" );
+            throw std::runtime_error( "Invalid device range: " + String::toHex( base ) );
         }
         
+        if( base >= this->impl->_memory && ( ( base & 0xFFF ) != 0 || ( size & 0xFFF ) != 0 ) )
         {
-            std::lock_guard< std::recursive_mutex > l( engine->impl->_rmtx );
-            
-            handlers = engine->impl->_interruptHandlers;
+            throw std::runtime_error( "Device range outside of memory must be page aligned: " + String::toHex( base ) );
         }
         
-        for( const auto & f: handlers )
+        for( const auto & device: this->impl->_devices )
         {
-            if( f( i ) )
+            if( base < device->base + device->size && device->base < base + size )
             {
-                return;
+                throw std::runtime_error( "Device range already in use: " + String::toHex( base ) );
             }
         }
         
-        throw std::runtime_error( "Unhandled interrupt: " + String::toHex( i ) );
-    }
-    
+        this->impl->_devices.push_back( std::make_unique< IMPL::Device >( IMPL::Device { base, size, read, write } ) );
+        
+        try
+        {
+            this->impl->_mapDevice( this->impl->_uc, this->impl->_devices.back().get() );
+        }
+        catch( ... )
+        {
+            this->impl->_devices.pop_back();
+            
+            throw;
+        }
+    }
+    
+    void Engine::map( size_t address, size_t size, int fd, uint64_t offset )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot map memory while the engine is running" );
+        }
+        
+        if( address > this->impl->_memory || size > this->impl->_memory - address )
+        {
+            throw std::runtime_error( "Cannot map memory at address " + String::toHex( address ) + " - Not enough memory allocated" );
+        }
+        
+        if( size == 0 )
+        {
+            return;
+        }
+        
+        if( mmap( this->impl->_ram + address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, static_cast< off_t >( offset ) ) == MAP_FAILED )
+        {
+            throw std::runtime_error( "Cannot map memory at address " + String::toHex( address ) + " - " + strerror( errno ) );
+        }
+        
+        this->impl->_markDirty( address, size );
+        
+        this->impl->_frozen = true;
+    }
+    
+    void Engine::clearMemory( void )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot clear memory while the engine is running" );
+        }
+        
+        this->impl->_clearMemory();
+    }
+    
+    std::vector< uint8_t > Engine::state( void ) const
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        std::vector< uint8_t >                  data( { static_cast< uint8_t >( this->impl->_mode ) } );
+        std::vector< uint32_t >                 msrs;
+        uc_err                                  e;
+        
+        auto append = [ & ]( uint64_t value, size_t bytes )
+        {
+            for( size_t i = 0; i < bytes; i++ )
+            {
+                data.push_back( static_cast< uint8_t >( ( value >> ( i * 8 ) ) & 0xFF ) );
+            }
+        };
+        
+        for( int reg: IMPL::controlRegisters )
+        {
+            append( this->impl->_readRegister< uint64_t >( reg ), 8 );
+        }
+        
+        for( int reg: IMPL::tableRegisters )
+        {
+            uc_x86_mmr mmr {};
+            
+            if( ( e = uc_reg_read( this->impl->_uc, reg, &mmr ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            append( mmr.selector, 2 );
+            append( mmr.base,     8 );
+            append( mmr.limit,    4 );
+            append( mmr.flags,    4 );
+        }
+        
+        if( this->impl->_mode == Mode::Long )
+        {
+            msrs = { 0xC0000080, 0xC0000100, 0xC0000101, 0xC0000102 };
+        }
+        
+        append( msrs.size(), 1 );
+        
+        for( uint32_t id: msrs )
+        {
+            uc_x86_msr msr { id, 0 };
+            
+            if( ( e = uc_reg_read( this->impl->_uc, UC_X86_REG_MSR, &msr ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            append( msr.rid,   4 );
+            append( msr.value, 8 );
+        }
+        
+        for( size_t i = 0; i < RegisterFrame::count; i++ )
+        {
+            append( this->impl->_readRegister< uint64_t >( this->impl->_registerID( static_cast< RegisterFrame::Register >( i ) ) ), 8 );
+        }
+        
+        if( this->impl->_mode == Mode::Long )
+        {
+            for( int reg: IMPL::longModeRegisters )
+            {
+                append( this->impl->_readRegister< uint64_t >( reg ), 8 );
+            }
+        }
+        
+        append( this->impl->_readRegister< uint16_t >( UC_X86_REG_FPCW ),  2 );
+        append( this->impl->_readRegister< uint16_t >( UC_X86_REG_FPSW ),  2 );
+        append( this->impl->_readRegister< uint16_t >( UC_X86_REG_FPTAG ), 2 );
+        
+        for( int reg: IMPL::x87Registers )
+        {
+            std::array< uint64_t, 2 > value {};
+            
+            if( ( e = uc_reg_read( this->impl->_uc, reg, value.data() ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            append( value[ 0 ], 8 );
+            append( value[ 1 ], 2 );
+        }
+        
+        append( this->impl->_readRegister< uint32_t >( UC_X86_REG_MXCSR ), 4 );
+        
+        for( int reg: IMPL::sseRegisters )
+        {
+            std::array< uint64_t, 2 > value {};
+            
+            if( ( e = uc_reg_read( this->impl->_uc, reg, value.data() ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            append( value[ 0 ], 8 );
+            append( value[ 1 ], 8 );
+        }
+        
+        if( this->impl->_mode == Mode::Long )
+        {
+            for( int reg: IMPL::longModeSSERegisters )
+            {
+                std::array< uint64_t, 2 > value {};
+                
+                if( ( e = uc_reg_read( this->impl->_uc, reg, value.data() ) ) != UC_ERR_OK )
+                {
+                    throw std::runtime_error( uc_strerror( e ) );
+                }
+                
+                append( value[ 0 ], 8 );
+                append( value[ 1 ], 8 );
+            }
+        }
+        
+        return data;
+    }
+    
+    void Engine::state( const std::vector< uint8_t > & data )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        BinaryDataStream                        stream( data );
+        uint8_t                                 mode( stream.readUInt8() );
+        uint8_t                                 msrs;
+        uc_err                                  e;
+        
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot restore the CPU state while the engine is running" );
+        }
+        
+        if( mode > static_cast< uint8_t >( Mode::Long ) )
+        {
+            throw std::runtime_error( "Invalid CPU state" );
+        }
+        
+        if( this->impl->_mode != static_cast< Mode >( mode ) )
+        {
+            this->impl->_switchMode( static_cast< Mode >( mode ) );
+        }
+        
+        for( int reg: IMPL::controlRegisters )
+        {
+            this->impl->_writeRegister< uint64_t >( reg, stream.readLittleEndianUInt64() );
+        }
+        
+        for( int reg: IMPL::tableRegisters )
+        {
+            uc_x86_mmr mmr {};
+            
+            mmr.selector = stream.readLittleEndianUInt16();
+            mmr.base     = stream.readLittleEndianUInt64();
+            mmr.limit    = stream.readLittleEndianUInt32();
+            mmr.flags    = stream.readLittleEndianUInt32();
+            
+            if( ( e = uc_reg_write( this->impl->_uc, reg, &mmr ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        msrs = stream.readUInt8();
+        
+        for( uint8_t i = 0; i < msrs; i++ )
+        {
+            uc_x86_msr msr { 0, 0 };
+            
+            msr.rid   = stream.readLittleEndianUInt32();
+            msr.value = stream.readLittleEndianUInt64();
+            
+            if( ( e = uc_reg_write( this->impl->_uc, UC_X86_REG_MSR, &msr ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        for( size_t i = 0; i < RegisterFrame::count; i++ )
+        {
+            this->impl->_writeRegister< uint64_t >( this->impl->_registerID( static_cast< RegisterFrame::Register >( i ) ), stream.readLittleEndianUInt64() );
+        }
+        
+        if( this->impl->_mode == Mode::Long )
+        {
+            for( int reg: IMPL::longModeRegisters )
+            {
+                this->impl->_writeRegister< uint64_t >( reg, stream.readLittleEndianUInt64() );
+            }
+        }
+        
+        this->impl->_writeRegister< uint16_t >( UC_X86_REG_FPCW,  stream.readLittleEndianUInt16() );
+        this->impl->_writeRegister< uint16_t >( UC_X86_REG_FPSW,  stream.readLittleEndianUInt16() );
+        this->impl->_writeRegister< uint16_t >( UC_X86_REG_FPTAG, stream.readLittleEndianUInt16() );
+        
+        for( int reg: IMPL::x87Registers )
+        {
+            std::array< uint64_t, 2 > value {};
+            
+            value[ 0 ] = stream.readLittleEndianUInt64();
+            value[ 1 ] = stream.readLittleEndianUInt16();
+            
+            if( ( e = uc_reg_write( this->impl->_uc, reg, value.data() ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        this->impl->_writeRegister< uint32_t >( UC_X86_REG_MXCSR, stream.readLittleEndianUInt32() );
+        
+        for( int reg: IMPL::sseRegisters )
+        {
+            std::array< uint64_t, 2 > value {};
+            
+            value[ 0 ] = stream.readLittleEndianUInt64();
+            value[ 1 ] = stream.readLittleEndianUInt64();
+            
+            if( ( e = uc_reg_write( this->impl->_uc, reg, value.data() ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        if( this->impl->_mode == Mode::Long )
+        {
+            for( int reg: IMPL::longModeSSERegisters )
+            {
+                std::array< uint64_t, 2 > value {};
+                
+                value[ 0 ] = stream.readLittleEndianUInt64();
+                value[ 1 ] = stream.readLittleEndianUInt64();
+                
+                if( ( e = uc_reg_write( this->impl->_uc, reg, value.data() ) ) != UC_ERR_OK )
+                {
+                    throw std::runtime_error( uc_strerror( e ) );
+                }
+            }
+        }
+        
+        this->impl->_jump          = false;
+        this->impl->_stopRequested = false;
+        this->impl->_idleBlock     = 0;
+        this->impl->_idleRepeats   = 0;
+    }
+    
+    std::vector< std::pair< std::string, uint64_t > > Engine::stateRegisters( const std::vector< uint8_t > & state )
+    {
+        BinaryDataStream                                  stream( state );
+        std::vector< std::pair< std::string, uint64_t > > registers;
+        uint8_t                                           mode( stream.readUInt8() );
+        uint8_t                                           msrs;
+        bool                                              longMode( mode == static_cast< uint8_t >( Mode::Long ) );
+        
+        if( mode > static_cast< uint8_t >( Mode::Long ) )
+        {
+            throw std::runtime_error( "Invalid CPU state" );
+        }
+        
+        registers.push_back( { "MODE", mode } );
+        
+        for( std::string name: { "CR0", "CR2", "CR3", "CR4" } )
+        {
+            registers.push_back( { name, stream.readLittleEndianUInt64() } );
+        }
+        
+        for( std::string name: { "GDTR", "IDTR", "LDTR", "TR" } )
+        {
+            registers.push_back( { name + ".SELECTOR", stream.readLittleEndianUInt16() } );
+            registers.push_back( { name + ".BASE",     stream.readLittleEndianUInt64() } );
+            registers.push_back( { name + ".LIMIT",    stream.readLittleEndianUInt32() } );
+            registers.push_back( { name + ".FLAGS",    stream.readLittleEndianUInt32() } );
+        }
+        
+        msrs = stream.readUInt8();
+        
+        for( uint8_t i = 0; i < msrs; i++ )
+        {
+            uint32_t id( stream.readLittleEndianUInt32() );
+            
+            registers.push_back( { "MSR." + String::toHex( id ), stream.readLittleEndianUInt64() } );
+        }
+        
+        {
+            std::vector< std::string > names;
+            
+            if( longMode )
+            {
+                names = { "RAX", "RBX", "RCX", "RDX", "RSI", "RDI", "RBP", "RSP", "RIP", "EFLAGS", "CS", "DS", "ES", "FS", "GS", "SS", "R8", "R9", "R10", "R11", "R12", "R13", "R14", "R15" };
+            }
+            else
+            {
+                names = { "EAX", "EBX", "ECX", "EDX", "ESI", "EDI", "EBP", "ESP", "EIP", "EFLAGS", "CS", "DS", "ES", "FS", "GS", "SS" };
+            }
+            
+            for( const std::string & name: names )
+            {
+                registers.push_back( { name, stream.readLittleEndianUInt64() } );
+            }
+        }
+        
+        for( std::string name: { "FPCW", "FPSW", "FPTAG" } )
+        {
+            registers.push_back( { name, stream.readLittleEndianUInt16() } );
+        }
+        
+        for( size_t i = 0; i < 8; i++ )
+        {
+            registers.push_back( { "ST" + std::to_string( i ) + ".MANTISSA", stream.readLittleEndianUInt64() } );
+            registers.push_back( { "ST" + std::to_string( i ) + ".EXPONENT", stream.readLittleEndianUInt16() } );
+        }
+        
+        registers.push_back( { "MXCSR", stream.readLittleEndianUInt32() } );
+        
+        for( size_t i = 0; i < ( ( longMode ) ? 16 : 8 ); i++ )
+        {
+            registers.push_back( { "XMM" + std::to_string( i ) + ".LOW",  stream.readLittleEndianUInt64() } );
+            registers.push_back( { "XMM" + std::to_string( i ) + ".HIGH", stream.readLittleEndianUInt64() } );
+        }
+        
+        return registers;
+    }
+    
+    void Engine::checkpoint( void )
+    {
+        std::lock_guard< std::recursive_mutex >        l( this->impl->_rmtx );
+        std::vector< std::pair< uint64_t, size_t > >   ranges( { { 0, this->impl->_memory } } );
+        uc_context                                   * context;
+        uc_err                                         e;
+        
+        if( ( e = uc_context_alloc( this->impl->_uc, &context ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        {
+            std::unique_ptr< IMPL::Checkpoint > checkpoint( std::make_unique< IMPL::Checkpoint >( IMPL::Checkpoint { this->impl->_mode, { context, uc_free }, {} } ) );
+            
+            if( ( e = uc_context_save( this->impl->_uc, context ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            for( const auto & device: this->impl->_devices )
+            {
+                if( device->base >= this->impl->_memory )
+                {
+                    ranges.push_back( { device->base, device->size } );
+                }
+            }
+            
+            for( const auto & range: ranges )
+            {
+                checkpoint->regions.push_back( { range.first, this->impl->_read( range.first, range.second ), std::vector< uint64_t >( ( ( range.second + pageSize - 1 ) / pageSize + 63 ) / 64, 0 ) } );
+            }
+            
+            this->impl->_checkpoint = std::move( checkpoint );
+        }
+    }
+    
+    bool Engine::restore( void )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        uc_err                                  e;
+        
+        if( this->impl->_checkpoint == nullptr )
+        {
+            return false;
+        }
+        
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot restore a checkpoint while the engine is running" );
+        }
+        
+        if( this->impl->_mode != this->impl->_checkpoint->mode )
+        {
+            this->impl->_switchMode( this->impl->_checkpoint->mode );
+        }
+        
+        for( auto & region: this->impl->_checkpoint->regions )
+        {
+            for( size_t i = 0; i < region.dirty.size(); i++ )
+            {
+                for( size_t bit = 0; bit < 64 && region.dirty[ i ] != 0; bit++ )
+                {
+                    size_t page( i * 64 + bit );
+                    size_t size( region.data.size() - page * pageSize );
+                    
+                    if( ( region.dirty[ i ] & ( static_cast< uint64_t >( 1 ) << bit ) ) == 0 )
+                    {
+                        continue;
+                    }
+                    
+                    region.dirty[ i ] &= ~( static_cast< uint64_t >( 1 ) << bit );
+                    
+                    if( ( e = uc_mem_write( this->impl->_uc, region.base + page * pageSize, region.data.data() + page * pageSize, ( size > pageSize ) ? pageSize : size ) ) != UC_ERR_OK )
+                    {
+                        throw std::runtime_error( uc_strerror( e ) );
+                    }
+                }
+            }
+        }
+        
+        if( ( e = uc_context_restore( this->impl->_uc, this->impl->_checkpoint->context.get() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        this->impl->_clearBlocks();
+        
+        this->impl->_jump          = false;
+        this->impl->_stopRequested = false;
+        this->impl->_idleBlock     = 0;
+        this->impl->_idleRepeats   = 0;
+        
+        return true;
+    }
+    
+    void Engine::fork( Engine & engine )
+    {
+        std::lock_guard< std::recursive_mutex >                l1( this->impl->_rmtx );
+        std::lock_guard< std::recursive_mutex >                l2( engine.impl->_rmtx );
+        std::unique_ptr< uc_context, uc_err( * )( void * ) > context( nullptr, uc_free );
+        uc_context                                           * ctx;
+        uc_err                                                 e;
+        
+        if( &engine == this || engine.impl->_memory != this->impl->_memory )
+        {
+            throw std::runtime_error( "Cannot fork into an engine with a different memory size" );
+        }
+        
+        if( this->impl->_running )
+        {
+            throw std::runtime_error( "Cannot fork a running engine" );
+        }
+        
+        if( engine.impl->_running )
+        {
+            throw std::runtime_error( "Cannot fork into a running engine" );
+        }
+        
+        if( this->impl->_memory > 0 )
+        {
+            if( this->impl->_frozen == false || this->impl->_modified )
+            {
+                if( this->impl->_frozen )
+                {
+                    int    fd( IMPL::_createMemory( this->impl->_memory ) );
+                    void * ram( mmap( nullptr, this->impl->_memory, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) );
+                    
+                    if( ram == MAP_FAILED )
+                    {
+                        close( fd );
+                        
+                        throw std::runtime_error( "Cannot map memory: " + std::string( strerror( errno ) ) );
+                    }
+                    
+                    memcpy( ram, this->impl->_ram, this->impl->_memory );
+                    munmap( ram, this->impl->_memory );
+                    close( this->impl->_ramFD );
+                    
+                    this->impl->_ramFD = fd;
+                }
+                
+                this->impl->_mapMemory( this->impl->_ramFD, false );
+                
+                this->impl->_frozen   = true;
+                this->impl->_modified = false;
+            }
+            
+            {
+                int fd( dup( this->impl->_ramFD ) );
+                
+                if( fd < 0 )
+                {
+                    throw std::runtime_error( "Cannot share memory: " + std::string( strerror( errno ) ) );
+                }
+                
+                close( engine.impl->_ramFD );
+                
+                engine.impl->_ramFD = fd;
+                
+                engine.impl->_mapMemory( engine.impl->_ramFD, false );
+                
+                engine.impl->_frozen = true;
+            }
+        }
+        
+        engine.impl->_switchMode( this->impl->_mode );
+        
+        for( const auto & device: this->impl->_devices )
+        {
+            if( device->base >= this->impl->_memory && engine.impl->_isMapped( device->base, device->size ) )
+            {
+                std::vector< uint8_t > memory( this->impl->_read( device->base, device->size ) );
+                
+                engine.impl->_write( device->base, memory.data(), memory.size() );
+            }
+        }
+        
+        if( ( e = uc_context_alloc( this->impl->_uc, &ctx ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        context.reset( ctx );
+        
+        if( ( e = uc_context_save( this->impl->_uc, ctx ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( ( e = uc_context_restore( engine.impl->_uc, ctx ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        engine.impl->_checkpoint.reset();
+        engine.impl->_clearBlocks();
+        
+        engine.impl->_modified      = false;
+        engine.impl->_jump          = false;
+        engine.impl->_stopRequested = false;
+        engine.impl->_idleBlock     = 0;
+        engine.impl->_idleRepeats   = 0;
+    }
+    
+    size_t Engine::dirtyPages( void ) const
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        size_t                                  n( 0 );
+        
+        if( this->impl->_checkpoint != nullptr )
+        {
+            for( const auto & region: this->impl->_checkpoint->regions )
+            {
+                for( uint64_t bits: region.dirty )
+                {
+                    n += static_cast< size_t >( std::bitset< 64 >( bits ).count() );
+                }
+            }
+        }
+        
+        return n;
+    }
+    
+    uint64_t Engine::pc( void ) const
+    {
+        if( this->impl->_mode == Mode::Real )
+        {
+            return getAddress( this->cs(), this->ip() );
+        }
+        
+        return ( this->impl->_mode == Mode::Long ) ? this->rip() : this->eip();
+    }
+    
+    bool Engine::start( size_t address )
+    {
+        {
+            std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+            
+            if( this->impl->_running )
+            {
+                return false;
+            }
+            
+            this->impl->_running       = true;
+            this->impl->_stopRequested = false;
+            this->impl->_restart       = false;
+            this->impl->_idleRepeats   = 0;
+            
+            this->impl->_cv.notify_all();
+            
+            for( const auto & f: this->impl->_onStart )
+            {
+                f();
+            }
+        }
+        
+        std::thread
+        (
+            [ = ]
+            {
+                try
+                {
+                    uc_err e;
+                    size_t begin( address );
+                    
+                    while( true )
+                    {
+                        if( ( e = uc_emu_start( this->impl->_uc, begin, std::numeric_limits< uint64_t >::max(), 0, 0 ) ) != UC_ERR_OK )
+                        {
+                            throw std::runtime_error( uc_strerror( e ) );
+                        }
+                        
+                        {
+                            std::vector< std::function< bool( void ) > > handlers;
+                            bool                                         resume( false );
+                            
+                            {
+                                std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                                uint64_t                                pc( this->pc() );
+                                uint8_t                                 opcode( 0 );
+                                
+                                if( this->impl->_systemOpcode != 0 && pc == this->impl->_systemNext )
+                                {
+                                    this->impl->_completeSystemInstruction();
+                                }
+                                
+                                this->impl->_systemOpcode = 0;
+                                
+                                if( this->impl->_jump )
+                                {
+                                    this->impl->_jump = false;
+                                    begin             = this->impl->_jumpAddress;
+                                    
+                                    continue;
+                                }
+                                
+                                if( this->impl->_restart && this->impl->_stopRequested == false )
+                                {
+                                    this->impl->_restart = false;
+                                    begin                = pc;
+                                    
+                                    if( this->impl->_tracing != this->impl->_traceRequested )
+                                    {
+                                        this->impl->_tracing = this->impl->_traceRequested;
+                                        
+                                        this->impl->_switchMode( this->impl->_mode );
+                                    }
+                                    
+                                    continue;
+                                }
+                                
+                                if( this->impl->_stopRequested || pc == 0 || uc_mem_read( this->impl->_uc, pc - 1, &opcode, 1 ) != UC_ERR_OK || opcode != 0xF4 )
+                                {
+                                    break;
+                                }
+                                
+                                handlers = this->impl->_haltHandlers;
+                            }
+                            
+                            for( const auto & f: handlers )
+                            {
+                                if( f() )
+                                {
+                                    resume = true;
+                                }
+                            }
+                            
+                            {
+                                std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                                
+                                if( resume == false || this->impl->_stopRequested )
+                                {
+                                    break;
+                                }
+                                
+                                if( this->impl->_jump )
+                                {
+                                    this->impl->_jump = false;
+                                    begin             = this->impl->_jumpAddress;
+                                }
+                                else if( this->impl->_mode == Mode::Real )
+                                {
+                                    begin = getAddress( this->cs(), this->ip() );
+                                }
+                                else
+                                {
+                                    begin = this->rip();
+                                }
+                            }
+                        }
+                    }
+                }
+                catch( const std::exception & e )
+                {
+                    std::vector< std::function< bool( const std::exception & ) > > handlers;
+                    bool                                                           handled( false );
+                    
+                    {
+                        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                        
+                        handlers = this->impl->_exceptionHandlers;
+                    }
+                    
+                    for( const auto & f: handlers )
+                    {
+                        if( f( e ) )
+                        {
+                            handled = true;
+                        }
+                    }
+                    
+                    if( handled == false )
+                    {
+                        throw e;
+                    }
+                }
+                
+                {
+                    std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                    
+                    this->impl->_running = false;
+                    
+                    this->impl->_cv.notify_all();
+                    
+                    for( const auto & f: this->impl->_onStop )
+                    {
+                        f();
+                    }
+                }
+            }
+        )
+        .detach();
+        
+        return true;
+    }
+    
+    void Engine::stop( void )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        if( this->impl->_running == false )
+        {
+            return;
+        }
+        
+        this->impl->_jump          = false;
+        this->impl->_restart       = false;
+        this->impl->_stopRequested = true;
+        
+        uc_emu_stop( this->impl->_uc );
+    }
+    
+    void Engine::jump( size_t address )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        if( this->impl->_running == false || this->impl->_stopRequested )
+        {
+            return;
+        }
+        
+        this->impl->_jump        = true;
+        this->impl->_jumpAddress = address;
+        
+        uc_emu_stop( this->impl->_uc );
+    }
+    
+    void Engine::waitUntilFinished( void ) const
+    {
+        std::unique_lock< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_cv.wait
+        (
+            l,
+            [ & ]( void ) -> bool
+            {
+                return this->impl->_running == false;
+            }
+        );
+    }
+    
+    Engine::IMPL::IMPL( size_t memory ):
+        _engine( nullptr ),
+        _memory( memory ),
+        _ram( nullptr ),
+        _ramFD( -1 ),
+        _frozen( false ),
+        _modified( false ),
+        _mode( Mode::Real ),
+        _traceRequested( false ),
+        _tracing( false ),
+        _lastInstructionAddress( 0 ),
+        _systemOpcode( 0 ),
+        _systemNext( 0 ),
+        _systemEAX( 0 ),
+        _systemECX( 0 ),
+        _systemEDX( 0 ),
+        _blockLimit( 0 ),
+        _code( ( ( memory + pageSize - 1 ) / pageSize + 63 ) / 64, 0 ),
+        _uc( nullptr ),
+        _running( false ),
+        _jump( false ),
+        _jumpAddress( 0 ),
+        _stopRequested( false ),
+        _restart( false ),
+        _idleBlock( 0 ),
+        _idleRepeats( 0 ),
+        _idleWrite( false ),
+        _written( ( ( memory + pageSize - 1 ) / pageSize + 63 ) / 64, 0 ),
+        _idleRegisters(),
+        _context( nullptr, uc_free )
+    {
+        if( this->_memory > 0 )
+        {
+            this->_ramFD = _createMemory( this->_memory );
+            
+            try
+            {
+                this->_mapMemory( this->_ramFD, true );
+            }
+            catch( ... )
+            {
+                close( this->_ramFD );
+                
+                throw;
+            }
+        }
+        
+        this->_switchMode( Mode::Real );
+    }
+    
+    Engine::IMPL::~IMPL( void )
+    {
+        if( this->_uc != nullptr )
+        {
+            uc_close( this->_uc );
+        }
+        
+        if( this->_ram != nullptr )
+        {
+            munmap( this->_ram, this->_memory );
+        }
+        
+        if( this->_ramFD >= 0 )
+        {
+            close( this->_ramFD );
+        }
+    }
+    
+    int Engine::IMPL::_createMemory( size_t size )
+    {
+        int fd;
+
+#ifdef __linux__
+        fd = memfd_create( "unicorn-bios", MFD_CLOEXEC );
+#else
+        {
+            static std::atomic< unsigned int > count( 0 );
+            std::string                        name( "/unicorn-bios-" + std::to_string( getpid() ) + "-" + std::to_string( count++ ) );
+            
+            fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 );
+            
+            if( fd >= 0 )
+            {
+                shm_unlink( name.c_str() );
+            }
+        }
+#endif
+
+        if( fd < 0 )
+        {
+            throw std::runtime_error( "Cannot allocate memory: " + std::string( strerror( errno ) ) );
+        }
+        
+        if( ftruncate( fd, static_cast< off_t >( size ) ) != 0 )
+        {
+            int error( errno );
+            
+            close( fd );
+            
+            throw std::runtime_error( "Cannot allocate memory: " + std::string( strerror( error ) ) );
+        }
+        
+        return fd;
+    }
+    
+    std::unique_ptr< Engine::IMPL > Engine::IMPL::_acquire( size_t memory )
+    {
+        std::unique_ptr< IMPL > impl;
+        
+        {
+            std::lock_guard< std::mutex > l( _poolMutex );
+            auto                          it( _pool.find( { Mode::Real, memory } ) );
+            
+            if( it != _pool.end() && it->second.empty() == false )
+            {
+                impl = std::move( it->second.back() );
+                
+                it->second.pop_back();
+            }
+        }
+        
+        if( impl == nullptr )
+        {
+            return std::make_unique< IMPL >( memory );
+        }
+        
+        return impl;
+    }
+    
+    void Engine::IMPL::_release( std::unique_ptr< IMPL > impl )
+    {
+        if( impl == nullptr )
+        {
+            return;
+        }
+        
+        try
+        {
+            uc_err e;
+            
+            impl->_reset();
+            
+            if( impl->_mode != Mode::Real || impl->_tracing )
+            {
+                impl->_tracing = false;
+                
+                impl->_switchMode( Mode::Real );
+                
+                if( ( e = uc_context_restore( impl->_uc, impl->_context.get() ) ) != UC_ERR_OK )
+                {
+                    throw std::runtime_error( uc_strerror( e ) );
+                }
+            }
+            
+            {
+                std::lock_guard< std::mutex > l( _poolMutex );
+                auto                        & engines( _pool[ { impl->_mode, impl->_memory } ] );
+                
+                if( engines.size() < poolLimit )
+                {
+                    engines.push_back( std::move( impl ) );
+                }
+            }
+        }
+        catch( ... )
+        {}
+    }
+    
+    void Engine::IMPL::_handleInterrupt( uc_engine * uc, uint32_t i, void * data )
+    {
+        Engine                                         * engine;
+        std::vector< std::function< bool( uint32_t ) > > handlers;
+        
+        ( void )uc;
+        
+        engine = ( data != nullptr ) ? static_cast< IMPL * >( data )->_engine : nullptr;
+        
+        if( engine == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown engine" );
+        }
+        
+        {
+            std::lock_guard< std::recursive_mutex > l( engine->impl->_rmtx );
+            
+            handlers = engine->impl->_interruptHandlers;
+        }
+        
+        for( const auto & f: handlers )
+        {
+            if( f( i ) )
+            {
+                return;
+            }
+        }
+        
+        throw std::runtime_error( "Unhandled interrupt: " + String::toHex( i ) );
+    }
+    
     void Engine::IMPL::_handleInstruction( uc_engine * uc, uint64_t address, uint32_t size, void * data )
     {
-        Engine               * engine;
-        std::vector< uint8_t > last;
-        uint64_t               lastAddress;
-        Registers              lastRegisters;
-        std::vector< uint8_t > current;
+        IMPL   * impl;
+        Engine * engine;
+        uint64_t lastAddress;
+        bool     after;
         
-        std::vector< std::function< void( uint64_t, const std::vector< uint8_t > & ) > > before;
-        std::vector< std::function< void( uint64_t, const Registers &, const std::vector< uint8_t > & ) > > after;
-        
-        ( void )uc;
-        
-        engine = static_cast< Engine * >( data );
+        impl   = static_cast< IMPL * >( data );
+        engine = ( impl != nullptr ) ? impl->_engine : nullptr;
         
         if( engine == nullptr )
         {
             throw std::runtime_error( "Fatal internal error: unknown engine" );
         }
         
+        std::swap( impl->_lastInstruction, impl->_previousInstruction );
+        impl->_lastInstruction.resize( size );
+        
+        if( size == 0 || size > 15 || uc_mem_read( uc, address, impl->_lastInstruction.data(), size ) != UC_ERR_OK )
         {
-            std::lock_guard< std::recursive_mutex > l( engine->impl->_rmtx );
-            
-            before        = engine->impl->_beforeInstructionHandlers;
-            after         = engine->impl->_afterInstructionHandlers;
-            last          = engine->impl->_lastInstruction;
-            lastAddress   = engine->impl->_lastInstructionAddress;
-            lastRegisters = engine->impl->_registers;
-            current       = engine->read( address, size );
+            throw std::runtime_error( "Fatal internal error: cannot read current instruction" );
+        }
+        
+        lastAddress                   = impl->_lastInstructionAddress;
+        impl->_lastInstructionAddress = address;
+        after                         = impl->_afterInstructionHandlers.size() > 0;
+        
+        {
+            Registers registers( *( engine ) );
             
-            if( current.size() == 0 )
             {
-                throw std::runtime_error( "Fatal internal error: cannot read current instruction" );
+                std::lock_guard< std::recursive_mutex > l( impl->_rmtx );
+                
+                std::swap( impl->_registers, impl->_previousRegisters );
+                
+                impl->_registers = std::move( registers );
             }
-            
-            engine->impl->_lastInstruction        = current;
-            engine->impl->_lastInstructionAddress = address;
-            engine->impl->_registers              = *( engine );
         }
         
-        if( last.size() > 0 )
+        if( after && impl->_previousInstruction.size() > 0 )
         {
-            for( const auto & f: after )
+            for( const auto & f: impl->_afterInstructionHandlers )
             {
-                f( lastAddress, lastRegisters, last );
+                f( lastAddress, impl->_previousRegisters, impl->_previousInstruction );
             }
         }
         
-        for( const auto & f: before )
+        for( const auto & f: impl->_beforeInstructionHandlers )
         {
-            f( address, current );
+            f( address, impl->_lastInstruction );
         }
     }
     
@@ -1263,7 +2453,7 @@ namespace UB
         ( void )type;
         ( void )value;
         
-        engine = static_cast< Engine * >( data );
+        engine = ( data != nullptr ) ? static_cast< IMPL * >( data )->_engine : nullptr;
         
         if( engine == nullptr )
         {
@@ -1290,10 +2480,405 @@ namespace UB
         std::vector< std::function< void( uint64_t, size_t ) > > handlers;
         
         ( void )uc;
+        ( void )value;
+        
+        engine = ( data != nullptr ) ? static_cast< IMPL * >( data )->_engine : nullptr;
+        
+        if( engine == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown engine" );
+        }
+        
+        {
+            std::lock_guard< std::recursive_mutex > l( engine->impl->_rmtx );
+            
+            handlers = engine->impl->_validMemoryHandlers;
+            
+            if( type == UC_MEM_WRITE )
+            {
+                engine->impl->_idleWrite = true;
+                
+                engine->impl->_markDirty( address, numeric_cast< size_t >( size ) );
+            }
+            
+            for( const auto & device: engine->impl->_devices )
+            {
+                if( address >= device->base && address < device->base + device->size )
+                {
+                    return;
+                }
+            }
+        }
+        
+        for( const auto & f: handlers )
+        {
+            f( address, numeric_cast< size_t >( size ) );
+        }
+    }
+    
+    void Engine::IMPL::_handleExecute( uc_engine * uc, uint64_t address, uint32_t size, void * data )
+    {
+        const Execute * execute;
+        
+        ( void )uc;
+        ( void )size;
+        
+        execute = static_cast< const Execute * >( data );
+        
+        if( execute == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown handler" );
+        }
+        
+        execute->handler( address );
+    }
+    
+    void Engine::IMPL::_handleDeviceRead( uc_engine * uc, uc_mem_type type, uint64_t address, int size, int64_t value, void * data )
+    {
+        const Device * device;
+        uint64_t       result;
+        
         ( void )type;
         ( void )value;
         
-        engine = static_cast< Engine * >( data );
+        device = static_cast< const Device * >( data );
+        
+        if( device == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown device" );
+        }
+        
+        result = device->read( address - device->base, numeric_cast< size_t >( size ) );
+        
+        uc_mem_write( uc, address, &result, std::min< size_t >( numeric_cast< size_t >( size ), sizeof( result ) ) );
+    }
+    
+    void Engine::IMPL::_handleDeviceWrite( uc_engine * uc, uc_mem_type type, uint64_t address, int size, int64_t value, void * data )
+    {
+        const Device * device;
+        uint64_t       mask( ( size >= 8 ) ? std::numeric_limits< uint64_t >::max() : ( static_cast< uint64_t >( 1 ) << ( size * 8 ) ) - 1 );
+        
+        ( void )uc;
+        ( void )type;
+        
+        device = static_cast< const Device * >( data );
+        
+        if( device == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown device" );
+        }
+        
+        device->write( address - device->base, numeric_cast< size_t >( size ), static_cast< uint64_t >( value ) & mask );
+    }
+    
+    void Engine::IMPL::_handleBlock( uc_engine * uc, uint64_t address, uint32_t size, void * data )
+    {
+        Engine * engine;
+        size_t   instructions( 1 );
+        
+        engine = ( data != nullptr ) ? static_cast< IMPL * >( data )->_engine : nullptr;
+        
+        if( engine == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown engine" );
+        }
+        
+        if( engine->impl->_systemOpcode != 0 )
+        {
+            if( address == engine->impl->_systemNext )
+            {
+                engine->impl->_completeSystemInstruction();
+            }
+            
+            engine->impl->_systemOpcode = 0;
+        }
+        
+        if( engine->impl->_traceRequested != engine->impl->_tracing || engine->impl->_scanBlock( uc, address, size, instructions ) )
+        {
+            engine->impl->_restart = true;
+            
+            uc_emu_stop( uc );
+            
+            return;
+        }
+        
+        if( engine->impl->_idleHandlers.size() > 0 && engine->impl->_isIdle( address ) )
+        {
+            for( const auto & f: engine->impl->_idleHandlers )
+            {
+                f();
+            }
+        }
+        
+        for( const auto & f: engine->impl->_blockHandlers )
+        {
+            f( address, size, instructions );
+        }
+    }
+    
+    void Engine::IMPL::_handleSystemSite( uc_engine * uc, uint64_t address, uint32_t size, void * data )
+    {
+        IMPL                     * impl;
+        std::array< uint8_t, 2 >   bytes;
+        
+        impl = static_cast< IMPL * >( data );
+        
+        if( impl == nullptr || impl->_engine == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown engine" );
+        }
+        
+        if( impl->_systemOpcode != 0 && address == impl->_systemNext )
+        {
+            impl->_completeSystemInstruction();
+        }
+        
+        if( size != 2 || uc_mem_read( uc, address, bytes.data(), bytes.size() ) != UC_ERR_OK || bytes[ 0 ] != 0x0F || _isSystemOpcode( bytes[ 1 ] ) == false )
+        {
+            return;
+        }
+        
+        impl->_systemOpcode = bytes[ 1 ];
+        impl->_systemNext   = address + 2;
+        impl->_systemEAX    = impl->_engine->eax();
+        impl->_systemECX    = impl->_engine->ecx();
+        impl->_systemEDX    = impl->_engine->edx();
+    }
+    
+    bool Engine::IMPL::_isSystemOpcode( uint8_t opcode )
+    {
+        return opcode == 0xA2 || opcode == 0x30 || opcode == 0x31 || opcode == 0x32;
+    }
+    
+    bool Engine::IMPL::_scanBlock( uc_engine * uc, uint64_t address, uint32_t size, size_t & instructions )
+    {
+        auto                                         it( this->_blocks.find( address ) );
+        std::vector< uint8_t >                       bytes;
+        std::vector< std::pair< uint64_t, size_t > > decoded;
+        unsigned int                                 bits( ( this->_mode == Mode::Long ) ? 64 : ( ( this->_mode == Mode::Protected ) ? 32 : 16 ) );
+        bool                                         hooked( false );
+        
+        if( it != this->_blocks.end() && it->second.size == size )
+        {
+            instructions = it->second.instructions;
+            
+            return false;
+        }
+        
+        bytes.resize( size );
+        
+        if( size == 0 || uc_mem_read( uc, address, bytes.data(), bytes.size() ) != UC_ERR_OK )
+        {
+            return false;
+        }
+        
+        decoded      = Capstone::decode( bytes, address, bits );
+        instructions = std::max< size_t >( decoded.size(), 1 );
+        
+        for( const auto & instruction: decoded )
+        {
+            uint64_t offset( instruction.first - address );
+            
+            if( instruction.second != 2 || bytes[ offset ] != 0x0F || _isSystemOpcode( bytes[ offset + 1 ] ) == false )
+            {
+                continue;
+            }
+            
+            if( this->_systemSites.insert( instruction.first ).second == false )
+            {
+                continue;
+            }
+            
+            this->_addSystemHook( uc, instruction.first );
+            
+            uc_mem_write( uc, instruction.first, bytes.data() + offset, 2 );
+            
+            hooked = true;
+        }
+        
+        this->_blocks[ address ] = { size, instructions };
+        this->_blockLimit        = std::max< size_t >( this->_blockLimit, size );
+        
+        if( address < this->_memory )
+        {
+            uint64_t first( address / pageSize );
+            uint64_t last(  ( std::min< uint64_t >( address + size, this->_memory ) - 1 ) / pageSize );
+            
+            for( uint64_t page = first; page <= last; page++ )
+            {
+                this->_code[ page / 64 ] |= static_cast< uint64_t >( 1 ) << ( page % 64 );
+            }
+        }
+        
+        return hooked;
+    }
+    
+    void Engine::IMPL::_addSystemHook( uc_engine * uc, uint64_t address )
+    {
+        uc_hook h;
+        uc_err  e;
+        
+        if( ( e = uc_hook_add( uc, &h, UC_HOOK_CODE, reinterpret_cast< void * >( &IMPL::_handleSystemSite ), this, address, address + 2 ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        this->_hooks.push_back( h );
+    }
+    
+    void Engine::IMPL::_completeSystemInstruction( void )
+    {
+        uint8_t opcode( this->_systemOpcode );
+        
+        this->_systemOpcode = 0;
+        
+        _handleSystemInstruction( *( this->_engine ), opcode, this->_systemEAX, this->_systemECX, this->_systemEDX );
+    }
+    
+    void Engine::IMPL::_invalidateBlocks( uint64_t address, size_t size )
+    {
+        bool code( address >= this->_memory );
+        
+        if( this->_blocks.empty() )
+        {
+            return;
+        }
+        
+        if( code == false )
+        {
+            uint64_t first( address / pageSize );
+            uint64_t last(  ( std::min< uint64_t >( address + size, this->_memory ) - 1 ) / pageSize );
+            
+            for( uint64_t page = first; page <= last && code == false; page++ )
+            {
+                code = ( this->_code[ page / 64 ] & ( static_cast< uint64_t >( 1 ) << ( page % 64 ) ) ) != 0;
+            }
+        }
+        
+        if( code == false )
+        {
+            return;
+        }
+        
+        {
+            auto it( this->_blocks.lower_bound( ( address > this->_blockLimit ) ? address - this->_blockLimit : 0 ) );
+            
+            while( it != this->_blocks.end() && it->first < address + size )
+            {
+                if( it->first + it->second.size > address )
+                {
+                    it = this->_blocks.erase( it );
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+    
+    void Engine::IMPL::_clearBlocks( void )
+    {
+        this->_blocks.clear();
+        
+        this->_blockLimit = 0;
+        
+        std::fill( this->_code.begin(), this->_code.end(), 0 );
+    }
+    
+    bool Engine::IMPL::_isIdle( uint64_t address )
+    {
+        bool write( this->_idleWrite );
+        
+        this->_idleWrite = false;
+        
+        if( address != this->_idleBlock || write )
+        {
+            this->_idleBlock   = address;
+            this->_idleRepeats = 0;
+            
+            return false;
+        }
+        
+        {
+            std::array< int, RegisterFrame::count >      regs;
+            std::array< uint64_t, RegisterFrame::count > registers{};
+            std::array< void *, RegisterFrame::count >   pointers;
+            uc_err                                       e;
+            std::lock_guard< std::recursive_mutex >      l( this->_rmtx );
+            
+            for( size_t i = 0; i < RegisterFrame::count; i++ )
+            {
+                regs[ i ]     = this->_registerID( static_cast< RegisterFrame::Register >( i ) );
+                pointers[ i ] = &( registers[ i ] );
+            }
+            
+            if( ( e = uc_reg_read_batch( this->_uc, regs.data(), pointers.data(), static_cast< int >( regs.size() ) ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            if( this->_idleRepeats == 0 || registers != this->_idleRegisters )
+            {
+                this->_idleRegisters = registers;
+                this->_idleRepeats   = 1;
+                
+                return false;
+            }
+            
+            if( ++this->_idleRepeats < idleThreshold )
+            {
+                return false;
+            }
+            
+            this->_idleRepeats = 0;
+            
+            return true;
+        }
+    }
+    
+    uint32_t Engine::IMPL::_handlePortRead( uc_engine * uc, uint32_t port, int size, void * data )
+    {
+        Engine                                                             * engine;
+        std::vector< std::function< bool( uint16_t, size_t, uint32_t & ) > > handlers;
+        uint32_t                                                             value;
+        
+        ( void )uc;
+        
+        engine = ( data != nullptr ) ? static_cast< IMPL * >( data )->_engine : nullptr;
+        
+        if( engine == nullptr )
+        {
+            throw std::runtime_error( "Fatal internal error: unknown engine" );
+        }
+        
+        {
+            std::lock_guard< std::recursive_mutex > l( engine->impl->_rmtx );
+            
+            handlers = engine->impl->_portReadHandlers;
+        }
+        
+        for( const auto & f: handlers )
+        {
+            value = 0;
+            
+            if( f( static_cast< uint16_t >( port ), numeric_cast< size_t >( size ), value ) )
+            {
+                return value;
+            }
+        }
+        
+        return ( size >= 4 ) ? 0xFFFFFFFF : ( 1U << ( size * 8 ) ) - 1;
+    }
+    
+    void Engine::IMPL::_handlePortWrite( uc_engine * uc, uint32_t port, int size, uint32_t value, void * data )
+    {
+        Engine                                                           * engine;
+        std::vector< std::function< bool( uint16_t, size_t, uint32_t ) > > handlers;
+        
+        ( void )uc;
+        
+        engine = ( data != nullptr ) ? static_cast< IMPL * >( data )->_engine : nullptr;
         
         if( engine == nullptr )
         {
@@ -1303,12 +2888,79 @@ namespace UB
         {
             std::lock_guard< std::recursive_mutex > l( engine->impl->_rmtx );
             
-            handlers = engine->impl->_validMemoryHandlers;
+            handlers = engine->impl->_portWriteHandlers;
         }
         
         for( const auto & f: handlers )
         {
-            f( address, numeric_cast< size_t >( size ) );
+            if( f( static_cast< uint16_t >( port ), numeric_cast< size_t >( size ), value ) )
+            {
+                return;
+            }
+        }
+    }
+    
+    void Engine::IMPL::_handleSystemInstruction( Engine & engine, uint8_t opcode, uint32_t eax, uint32_t ecx, uint32_t edx )
+    {
+        std::vector< std::function< void( uint32_t, uint32_t, RegisterFrame & ) > > cpuid;
+        std::vector< std::function< bool( uint64_t & ) > >                          rdtsc;
+        std::vector< std::function< bool( uint32_t, uint64_t & ) > >                rdmsr;
+        std::vector< std::function< void( uint32_t, uint64_t ) > >                  wrmsr;
+        uint64_t                                                                    value( 0 );
+        bool                                                                        handled( false );
+        
+        {
+            std::lock_guard< std::recursive_mutex > l( engine.impl->_rmtx );
+            
+            cpuid = engine.impl->_cpuidHandlers;
+            rdtsc = engine.impl->_rdtscHandlers;
+            rdmsr = engine.impl->_rdmsrHandlers;
+            wrmsr = engine.impl->_wrmsrHandlers;
+        }
+        
+        if( opcode == 0xA2 && cpuid.size() > 0 )
+        {
+            RegisterFrame frame( engine.frame() );
+            
+            for( const auto & f: cpuid )
+            {
+                f( eax, ecx, frame );
+            }
+            
+            engine.frame( frame );
+        }
+        else if( opcode == 0x30 )
+        {
+            for( const auto & f: wrmsr )
+            {
+                f( ecx, ( static_cast< uint64_t >( edx ) << 32 ) | eax );
+            }
+        }
+        else if( opcode == 0x31 )
+        {
+            for( const auto & f: rdtsc )
+            {
+                if( ( handled = f( value ) ) )
+                {
+                    break;
+                }
+            }
+        }
+        else if( opcode == 0x32 )
+        {
+            for( const auto & f: rdmsr )
+            {
+                if( ( handled = f( ecx, value ) ) )
+                {
+                    break;
+                }
+            }
+        }
+        
+        if( handled )
+        {
+            engine.eax( static_cast< uint32_t >( value & 0xFFFFFFFF ) );
+            engine.edx( static_cast< uint32_t >( value >> 32 ) );
         }
     }
     
@@ -1322,7 +2974,7 @@ namespace UB
             return {};
         }
         
-        if( address + size >= this->_memory )
+        if( this->_isMapped( address, size ) == false )
         {
             throw std::runtime_error( "Cannot read from address " + String::toHex( address ) + " - Not enough memory allocated" );
         }
@@ -1349,7 +3001,7 @@ namespace UB
             return;
         }
         
-        if( address >= this->_memory )
+        if( this->_isMapped( address, size ) == false )
         {
             throw std::runtime_error( "Cannot write to address " + String::toHex( address ) + " - Not enough memory allocated" );
         }
@@ -1358,6 +3010,8 @@ namespace UB
         {
             throw std::runtime_error( uc_strerror( e ) );
         }
+        
+        this->_markDirty( address, size );
     }
     
     void Engine::IMPL::_switchMode( Mode mode )
@@ -1391,7 +3045,25 @@ namespace UB
         
         if( this->_memory > 0 )
         {
-            if( ( e = uc_mem_map( uc, 0, this->_memory, UC_PROT_ALL ) ) != UC_ERR_OK )
+            if( ( e = uc_mem_map_ptr( uc, 0, this->_memory, UC_PROT_ALL, this->_ram ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        this->_addHooks( uc );
+        
+        {
+            uc_context * ctx;
+            
+            if( ( e = uc_context_alloc( uc, &ctx ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            this->_context.reset( ctx );
+            
+            if( ( e = uc_context_save( uc, ctx ) ) != UC_ERR_OK )
             {
                 throw std::runtime_error( uc_strerror( e ) );
             }
@@ -1399,11 +3071,14 @@ namespace UB
         
         if( this->_uc != nullptr )
         {
-            if( this->_memory > 0 )
+            for( const auto & device: this->_devices )
             {
-                std::vector< uint8_t > memory( this->_read( 0, this->_memory ) );
-                
-                uc_mem_write( uc, 0, &( memory[ 0 ] ), this->_memory );
+                if( device->base >= this->_memory )
+                {
+                    std::vector< uint8_t > memory( this->_read( device->base, device->size ) );
+                    
+                    uc_mem_write( uc, device->base, &( memory[ 0 ] ), device->size );
+                }
             }
             
             {
@@ -1423,11 +3098,366 @@ namespace UB
                 {
                     throw std::runtime_error( uc_strerror( e ) );
                 }
+                
+                uc_free( ctx );
             }
             
             uc_close( this->_uc );
         }
         
-        this->_uc = uc;
+        if( mode != this->_mode )
+        {
+            this->_clearBlocks();
+        }
+        
+        this->_uc   = uc;
+        this->_mode = mode;
+    }
+    
+    void Engine::IMPL::_mapMemory( int fd, bool shared )
+    {
+        void * ram( mmap( this->_ram, this->_memory, PROT_READ | PROT_WRITE, ( ( shared ) ? MAP_SHARED : MAP_PRIVATE ) | ( ( this->_ram != nullptr ) ? MAP_FIXED : 0 ), fd, 0 ) );
+        
+        if( ram == MAP_FAILED )
+        {
+            throw std::runtime_error( "Cannot map memory: " + std::string( strerror( errno ) ) );
+        }
+        
+        this->_ram = static_cast< uint8_t * >( ram );
+    }
+    
+    void Engine::IMPL::_clearMemory( void )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->_rmtx );
+        
+        if( this->_memory == 0 )
+        {
+            return;
+        }
+        
+        {
+            int fd( _createMemory( this->_memory ) );
+            
+            try
+            {
+                this->_mapMemory( fd, true );
+            }
+            catch( ... )
+            {
+                close( fd );
+                
+                throw;
+            }
+            
+            close( this->_ramFD );
+            
+            this->_ramFD = fd;
+        }
+        
+        this->_markDirty( 0, this->_memory );
+        this->_switchMode( this->_mode );
+        
+        std::fill( this->_written.begin(), this->_written.end(), 0 );
+        
+        this->_frozen   = false;
+        this->_modified = false;
+    }
+    
+    void Engine::IMPL::_reset( void )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->_rmtx );
+        uc_err                                  e;
+        
+        if( this->_running )
+        {
+            throw std::runtime_error( "Cannot reset the engine while it is running" );
+        }
+        
+        for( uc_hook h: this->_hooks )
+        {
+            if( ( e = uc_hook_del( this->_uc, h ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        for( const auto & device: this->_devices )
+        {
+            if( device->base >= this->_memory )
+            {
+                if( ( e = uc_mem_unmap( this->_uc, device->base, device->size ) ) != UC_ERR_OK )
+                {
+                    throw std::runtime_error( uc_strerror( e ) );
+                }
+            }
+        }
+        
+        this->_hooks.clear();
+        this->_devices.clear();
+        this->_executeHandlers.clear();
+        this->_onStart.clear();
+        this->_onStop.clear();
+        this->_interruptHandlers.clear();
+        this->_exceptionHandlers.clear();
+        this->_invalidMemoryHandlers.clear();
+        this->_validMemoryHandlers.clear();
+        this->_beforeInstructionHandlers.clear();
+        this->_afterInstructionHandlers.clear();
+        this->_blockHandlers.clear();
+        this->_portReadHandlers.clear();
+        this->_portWriteHandlers.clear();
+        this->_cpuidHandlers.clear();
+        this->_rdtscHandlers.clear();
+        this->_rdmsrHandlers.clear();
+        this->_wrmsrHandlers.clear();
+        this->_idleHandlers.clear();
+        this->_haltHandlers.clear();
+        this->_checkpoint.reset();
+        
+        if( this->_frozen )
+        {
+            this->_clearMemory();
+        }
+        else
+        {
+            static const std::array< uint8_t, pageSize > zero = {};
+            
+            for( size_t i = 0; i < this->_written.size(); i++ )
+            {
+                for( size_t bit = 0; bit < 64 && this->_written[ i ] != 0; bit++ )
+                {
+                    size_t page( i * 64 + bit );
+                    size_t size( this->_memory - page * pageSize );
+                    
+                    if( ( this->_written[ i ] & ( static_cast< uint64_t >( 1 ) << bit ) ) == 0 )
+                    {
+                        continue;
+                    }
+                    
+                    this->_written[ i ] &= ~( static_cast< uint64_t >( 1 ) << bit );
+                    
+                    if( ( e = uc_mem_write( this->_uc, page * pageSize, zero.data(), ( size > pageSize ) ? pageSize : size ) ) != UC_ERR_OK )
+                    {
+                        throw std::runtime_error( uc_strerror( e ) );
+                    }
+                }
+            }
+        }
+        
+        if( ( e = uc_context_restore( this->_uc, this->_context.get() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        this->_engine                 = nullptr;
+        this->_modified               = false;
+        this->_registers              = Registers();
+        this->_previousRegisters      = Registers();
+        this->_traceRequested         = false;
+        this->_lastInstructionAddress = 0;
+        this->_systemOpcode           = 0;
+        this->_jump                   = false;
+        this->_jumpAddress            = 0;
+        this->_stopRequested          = false;
+        this->_restart                = false;
+        this->_idleBlock              = 0;
+        this->_idleRepeats            = 0;
+        this->_idleWrite              = false;
+        
+        this->_lastInstruction.clear();
+        this->_previousInstruction.clear();
+        this->_systemSites.clear();
+        this->_clearBlocks();
+        this->_idleRegisters.fill( 0 );
+    }
+    
+    void Engine::IMPL::_addHooks( uc_engine * uc )
+    {
+        uc_hook h1;
+        uc_hook h2;
+        uc_hook h3;
+        uc_hook h4;
+        uc_hook h5;
+        uc_hook h6;
+        uc_hook h7;
+        uc_err  e;
+        
+        this->_hooks.clear();
+        
+        if( ( e = uc_hook_add( uc, &h1, UC_HOOK_INTR, reinterpret_cast< void * >( &IMPL::_handleInterrupt ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( this->_tracing && ( e = uc_hook_add( uc, &h2, UC_HOOK_CODE, reinterpret_cast< void * >( &IMPL::_handleInstruction ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( ( e = uc_hook_add( uc, &h3, UC_HOOK_MEM_INVALID, reinterpret_cast< void * >( &IMPL::_handleInvalidMemoryAccess ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( ( e = uc_hook_add( uc, &h4, UC_HOOK_MEM_WRITE + UC_HOOK_MEM_FETCH, reinterpret_cast< void * >( &IMPL::_handleValidMemoryAccess ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( ( e = uc_hook_add( uc, &h5, UC_HOOK_BLOCK, reinterpret_cast< void * >( &IMPL::_handleBlock ), this, 0, std::numeric_limits< uint64_t >::max() ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( ( e = uc_hook_add( uc, &h6, UC_HOOK_INSN, reinterpret_cast< void * >( &IMPL::_handlePortRead ), this, 0, std::numeric_limits< uint64_t >::max(), UC_X86_INS_IN ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        if( ( e = uc_hook_add( uc, &h7, UC_HOOK_INSN, reinterpret_cast< void * >( &IMPL::_handlePortWrite ), this, 0, std::numeric_limits< uint64_t >::max(), UC_X86_INS_OUT ) ) != UC_ERR_OK )
+        {
+            throw std::runtime_error( uc_strerror( e ) );
+        }
+        
+        for( const auto & handler: this->_executeHandlers )
+        {
+            if( ( e = uc_hook_add( uc, &h1, UC_HOOK_CODE, reinterpret_cast< void * >( &IMPL::_handleExecute ), handler.get(), handler->begin, handler->end ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            this->_hooks.push_back( h1 );
+        }
+        
+        for( uint64_t address: this->_systemSites )
+        {
+            this->_addSystemHook( uc, address );
+        }
+        
+        for( const auto & device: this->_devices )
+        {
+            this->_mapDevice( uc, device.get() );
+        }
+    }
+    
+    void Engine::IMPL::_mapDevice( uc_engine * uc, const Device * device )
+    {
+        uc_hook h;
+        uc_err  e;
+        
+        if( device->base >= this->_memory )
+        {
+            if( ( e = uc_mem_map( uc, device->base, device->size, UC_PROT_READ | UC_PROT_WRITE ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+        }
+        
+        if( device->read != nullptr )
+        {
+            if( ( e = uc_hook_add( uc, &h, UC_HOOK_MEM_READ, reinterpret_cast< void * >( &IMPL::_handleDeviceRead ), const_cast< Device * >( device ), device->base, device->base + device->size - 1 ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            this->_hooks.push_back( h );
+        }
+        
+        if( device->write != nullptr )
+        {
+            if( ( e = uc_hook_add( uc, &h, UC_HOOK_MEM_WRITE, reinterpret_cast< void * >( &IMPL::_handleDeviceWrite ), const_cast< Device * >( device ), device->base, device->base + device->size - 1 ) ) != UC_ERR_OK )
+            {
+                throw std::runtime_error( uc_strerror( e ) );
+            }
+            
+            this->_hooks.push_back( h );
+        }
+    }
+    
+    bool Engine::IMPL::_isMapped( size_t address, size_t size ) const
+    {
+        if( address + size <= this->_memory )
+        {
+            return true;
+        }
+        
+        for( const auto & device: this->_devices )
+        {
+            if( device->base >= this->_memory && address >= device->base && address + size <= device->base + device->size )
+            {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+    
+    void Engine::IMPL::_markDirty( uint64_t address, size_t size )
+    {
+        this->_modified = true;
+        
+        if( size == 0 )
+        {
+            return;
+        }
+        
+        this->_invalidateBlocks( address, size );
+        
+        if( address < this->_memory )
+        {
+            uint64_t first( address / pageSize );
+            uint64_t last(  ( std::min< uint64_t >( address + size, this->_memory ) - 1 ) / pageSize );
+            
+            for( uint64_t page = first; page <= last; page++ )
+            {
+                this->_written[ page / 64 ] |= static_cast< uint64_t >( 1 ) << ( page % 64 );
+            }
+        }
+        
+        if( this->_checkpoint == nullptr )
+        {
+            return;
+        }
+        
+        for( auto & region: this->_checkpoint->regions )
+        {
+            if( address < region.base + region.data.size() && region.base < address + size )
+            {
+                uint64_t first( ( std::max( address, region.base ) - region.base ) / pageSize );
+                uint64_t last(  ( std::min< uint64_t >( address + size, region.base + region.data.size() ) - 1 - region.base ) / pageSize );
+                
+                for( uint64_t page = first; page <= last; page++ )
+                {
+                    region.dirty[ page / 64 ] |= static_cast< uint64_t >( 1 ) << ( page % 64 );
+                }
+            }
+        }
+    }
+    
+    int Engine::IMPL::_registerID( RegisterFrame::Register reg ) const
+    {
+        bool longMode( this->_mode == Mode::Long );
+        
+        switch( reg )
+        {
+            case RegisterFrame::Register::RAX:    return ( longMode ) ? UC_X86_REG_RAX : UC_X86_REG_EAX;
+            case RegisterFrame::Register::RBX:    return ( longMode ) ? UC_X86_REG_RBX : UC_X86_REG_EBX;
+            case RegisterFrame::Register::RCX:    return ( longMode ) ? UC_X86_REG_RCX : UC_X86_REG_ECX;
+            case RegisterFrame::Register::RDX:    return ( longMode ) ? UC_X86_REG_RDX : UC_X86_REG_EDX;
+            case RegisterFrame::Register::RSI:    return ( longMode ) ? UC_X86_REG_RSI : UC_X86_REG_ESI;
+            case RegisterFrame::Register::RDI:    return ( longMode ) ? UC_X86_REG_RDI : UC_X86_REG_EDI;
+            case RegisterFrame::Register::RBP:    return ( longMode ) ? UC_X86_REG_RBP : UC_X86_REG_EBP;
+            case RegisterFrame::Register::RSP:    return ( longMode ) ? UC_X86_REG_RSP : UC_X86_REG_ESP;
+            case RegisterFrame::Register::RIP:    return ( longMode ) ? UC_X86_REG_RIP : UC_X86_REG_EIP;
+            case RegisterFrame::Register::EFLAGS: return UC_X86_REG_EFLAGS;
+            case RegisterFrame::Register::CS:     return UC_X86_REG_CS;
+            case RegisterFrame::Register::DS:     return UC_X86_REG_DS;
+            case RegisterFrame::Register::ES:     return UC_X86_REG_ES;
+            case RegisterFrame::Register::FS:     return UC_X86_REG_FS;
+            case RegisterFrame::Register::GS:     return UC_X86_REG_GS;
+            case RegisterFrame::Register::SS:     return UC_X86_REG_SS;
+        }
+        
+        throw std::runtime_error( "Unknown register" );
     }
 }
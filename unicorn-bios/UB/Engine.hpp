@@ -31,6 +31,7 @@
 #include <vector>
 #include <functional>
 #include "UB/Registers.hpp"
+#include "UB/RegisterFrame.hpp"
 
 namespace UB
 {
@@ -45,7 +46,10 @@ namespace UB
                 Long
             };
             
-            static uint64_t getAddress( uint16_t segment, uint16_t offset );
+            static const size_t pageSize = 0x1000;
+            
+            static uint64_t                                         getAddress( uint16_t segment, uint16_t offset );
+            static std::vector< std::pair< std::string, uint64_t > > stateRegisters( const std::vector< uint8_t > & state );
             
             Engine( size_t memory );
             ~Engine( void );
@@ -259,6 +263,10 @@ namespace UB
             void r15(  uint64_t value );
             
             Registers registers( void ) const;
+            void      trace( bool value );
+            
+            RegisterFrame frame( void ) const;
+            void          frame( const RegisterFrame & frame );
             
             bool running( void ) const;
             
@@ -270,13 +278,37 @@ namespace UB
             void onValidMemoryAccess(   const std::function< void( uint64_t, size_t ) > handler );
             void beforeInstruction(     const std::function< void( uint64_t, const std::vector< uint8_t > & ) > handler );
             void afterInstruction(      const std::function< void( uint64_t, const Registers &, const std::vector< uint8_t > & ) > handler );
+            void onExecute(             uint64_t begin, uint64_t end, const std::function< void( uint64_t ) > handler );
+            void onBlock(               const std::function< void( uint64_t, size_t, size_t ) > handler );
+            void onPortRead(            const std::function< bool( uint16_t, size_t, uint32_t & ) > handler );
+            void onPortWrite(           const std::function< bool( uint16_t, size_t, uint32_t ) > handler );
+            void onCPUID(               const std::function< void( uint32_t, uint32_t, RegisterFrame & ) > handler );
+            void onRDTSC(               const std::function< bool( uint64_t & ) > handler );
+            void onRDMSR(               const std::function< bool( uint32_t, uint64_t & ) > handler );
+            void onWRMSR(               const std::function< void( uint32_t, uint64_t ) > handler );
+            void onIdle(                const std::function< void( void ) > handler );
+            void onHalt(                const std::function< bool( void ) > handler );
             
             std::vector< uint8_t > read( size_t address, size_t size );
             void                   write( size_t address, const std::vector< uint8_t > & bytes );
             void                   write( size_t address, const uint8_t * bytes, size_t size );
             
+            void mapDevice( uint64_t base, size_t size, const std::function< uint64_t( uint64_t, size_t ) > read, const std::function< void( uint64_t, size_t, uint64_t ) > write );
+            void map( size_t address, size_t size, int fd, uint64_t offset );
+            void clearMemory( void );
+            
+            std::vector< uint8_t > state( void ) const;
+            void                   state( const std::vector< uint8_t > & data );
+            
+            void     checkpoint( void );
+            bool     restore( void );
+            void     fork( Engine & engine );
+            size_t   dirtyPages( void ) const;
+            uint64_t pc( void )         const;
+            
             bool start( size_t address );
             void stop( void );
+            void jump( size_t address );
             void waitUntilFinished( void ) const;
             
         private:
@@ -0,0 +1,398 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/FAT/CompressedImageReader.hpp"
+#include "UB/BinaryFileStream.hpp"
+#include "UB/Casts.hpp"
+#include <zlib.h>
+#include <fstream>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstring>
+#include <stdexcept>
+#include <limits>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class CompressedImageReader::IMPL
+        {
+            public:
+                
+                enum class Storage: uint32_t
+                {
+                    Zero     = 0,
+                    Deflated = 1,
+                    Stored   = 2
+                };
+                
+                struct Chunk
+                {
+                    uint64_t offset;
+                    uint32_t size;
+                    Storage  storage;
+                };
+                
+                static const std::string magic;
+                static const uint16_t    version;
+                
+                IMPL( const std::string & path, size_t cacheSize );
+                
+                const std::vector< uint8_t > & _chunk( uint64_t index );
+                size_t                         _chunkLength( uint64_t index ) const;
+                
+                BinaryFileStream      _stream;
+                uint32_t              _chunkSize;
+                uint64_t              _size;
+                std::vector< Chunk >  _chunks;
+                size_t                _cacheSize;
+                std::list< uint64_t > _lru;
+                std::mutex            _mtx;
+                
+                std::unordered_map< uint64_t, std::pair< std::vector< uint8_t >, std::list< uint64_t >::iterator > > _cache;
+        };
+        
+        const uint32_t    CompressedImageReader::defaultChunkSize = 64 * 1024;
+        const size_t      CompressedImageReader::defaultCacheSize = 16 * 1024 * 1024;
+        const std::string CompressedImageReader::IMPL::magic      = "UBCI";
+        const uint16_t    CompressedImageReader::IMPL::version    = 1;
+        
+        bool CompressedImageReader::isCompressedImage( const std::string & path )
+        {
+            std::ifstream stream( path, std::ios::binary | std::ios::in );
+            char          buf[ 4 ];
+            
+            if( stream.good() == false )
+            {
+                return false;
+            }
+            
+            if( stream.read( buf, sizeof( buf ) ).gcount() != sizeof( buf ) )
+            {
+                return false;
+            }
+            
+            return std::string( buf, sizeof( buf ) ) == IMPL::magic;
+        }
+        
+        void CompressedImageReader::compress( const std::string & input, const std::string & output, uint32_t chunkSize )
+        {
+            std::ifstream              in( input, std::ios::binary | std::ios::in );
+            std::ofstream              out( output, std::ios::binary | std::ios::out | std::ios::trunc );
+            std::vector< IMPL::Chunk > chunks;
+            uint64_t                   size;
+            uint64_t                   count;
+            uint64_t                   offset;
+            
+            auto write = [ & ]( uint64_t value, size_t bytes )
+            {
+                for( size_t i = 0; i < bytes; i++ )
+                {
+                    out.put( static_cast< char >( ( value >> ( i * 8 ) ) & 0xFF ) );
+                }
+            };
+            
+            if( chunkSize < 512 || chunkSize % 512 != 0 )
+            {
+                throw std::runtime_error( "Invalid chunk size: " + std::to_string( chunkSize ) );
+            }
+            
+            if( in.good() == false )
+            {
+                throw std::runtime_error( "Cannot open image: " + input );
+            }
+            
+            if( out.good() == false )
+            {
+                throw std::runtime_error( "Cannot create image: " + output );
+            }
+            
+            in.seekg( 0, std::ios_base::end );
+            
+            size  = numeric_cast< uint64_t >( static_cast< std::streamoff >( in.tellg() ) );
+            count = ( size + chunkSize - 1 ) / chunkSize;
+            
+            in.seekg( 0, std::ios_base::beg );
+            
+            out.write( IMPL::magic.data(), numeric_cast< std::streamsize >( IMPL::magic.size() ) );
+            write( IMPL::version, 2 );
+            write( 0,             2 );
+            write( chunkSize,     4 );
+            write( size,          8 );
+            write( count,         8 );
+            write( 0,             4 );
+            
+            offset = 32 + ( count * 16 );
+            
+            out.seekp( numeric_cast< std::streamoff >( offset ), std::ios_base::beg );
+            
+            {
+                std::vector< uint8_t > chunk( chunkSize, 0 );
+                std::vector< uint8_t > deflated( compressBound( chunkSize ), 0 );
+                
+                for( uint64_t i = 0; i < count; i++ )
+                {
+                    size_t length( numeric_cast< size_t >( std::min< uint64_t >( chunkSize, size - ( i * chunkSize ) ) ) );
+                    uLongf deflatedLength( numeric_cast< uLongf >( deflated.size() ) );
+                    
+                    in.read( reinterpret_cast< char * >( chunk.data() ), numeric_cast< std::streamsize >( length ) );
+                    
+                    if( in.good() == false || in.gcount() != numeric_cast< std::streamsize >( length ) )
+                    {
+                        throw std::runtime_error( "Cannot read image: " + input );
+                    }
+                    
+                    if( std::all_of( chunk.begin(), chunk.begin() + numeric_cast< ssize_t >( length ), []( uint8_t b ) { return b == 0; } ) )
+                    {
+                        chunks.push_back( { 0, 0, IMPL::Storage::Zero } );
+                        
+                        continue;
+                    }
+                    
+                    if( compress2( deflated.data(), &deflatedLength, chunk.data(), numeric_cast< uLong >( length ), Z_BEST_COMPRESSION ) == Z_OK && deflatedLength < length )
+                    {
+                        out.write( reinterpret_cast< const char * >( deflated.data() ), numeric_cast< std::streamsize >( deflatedLength ) );
+                        chunks.push_back( { offset, numeric_cast< uint32_t >( deflatedLength ), IMPL::Storage::Deflated } );
+                        
+                        offset += deflatedLength;
+                    }
+                    else
+                    {
+                        out.write( reinterpret_cast< const char * >( chunk.data() ), numeric_cast< std::streamsize >( length ) );
+                        chunks.push_back( { offset, numeric_cast< uint32_t >( length ), IMPL::Storage::Stored } );
+                        
+                        offset += length;
+                    }
+                }
+            }
+            
+            out.seekp( 32, std::ios_base::beg );
+            
+            for( const auto & chunk: chunks )
+            {
+                write( chunk.offset,                             8 );
+                write( chunk.size,                               4 );
+                write( static_cast< uint32_t >( chunk.storage ), 4 );
+            }
+            
+            if( out.good() == false )
+            {
+                throw std::runtime_error( "Cannot write image: " + output );
+            }
+        }
+        
+        CompressedImageReader::CompressedImageReader( const std::string & path, size_t cacheSize ):
+            impl( std::make_unique< IMPL >( path, cacheSize ) )
+        {}
+        
+        CompressedImageReader::~CompressedImageReader( void )
+        {}
+        
+        uint64_t CompressedImageReader::size( void ) const
+        {
+            return this->impl->_size;
+        }
+        
+        void CompressedImageReader::read( uint64_t offset, uint8_t * buf, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            if( offset > this->impl->_size || size > this->impl->_size - offset )
+            {
+                throw std::runtime_error( "Invalid read - Not enough data available" );
+            }
+            
+            while( size > 0 )
+            {
+                uint64_t index(  offset / this->impl->_chunkSize );
+                size_t   start(  numeric_cast< size_t >( offset % this->impl->_chunkSize ) );
+                size_t   length( std::min( size, this->impl->_chunkLength( index ) - start ) );
+                
+                if( this->impl->_chunks[ index ].storage == IMPL::Storage::Zero )
+                {
+                    memset( buf, 0, length );
+                }
+                else
+                {
+                    memcpy( buf, this->impl->_chunk( index ).data() + start, length );
+                }
+                
+                buf    += length;
+                offset += length;
+                size   -= length;
+            }
+        }
+        
+        uint32_t CompressedImageReader::chunkSize( void ) const
+        {
+            return this->impl->_chunkSize;
+        }
+        
+        uint64_t CompressedImageReader::chunkCount( void ) const
+        {
+            return this->impl->_chunks.size();
+        }
+        
+        CompressedImageReader::IMPL::IMPL( const std::string & path, size_t cacheSize ):
+            _stream( path ),
+            _chunkSize( 0 ),
+            _size( 0 ),
+            _cacheSize( 0 )
+        {
+            uint64_t count;
+            uint64_t fileSize;
+            uint64_t end;
+            
+            this->_stream.seek( 0, BinaryStream::SeekDirection::End );
+            
+            fileSize = this->_stream.tell();
+            
+            this->_stream.seek( 0, BinaryStream::SeekDirection::Begin );
+            
+            if( this->_stream.readString( magic.size() ) != magic )
+            {
+                throw std::runtime_error( "Invalid compressed image: " + path );
+            }
+            
+            if( this->_stream.readLittleEndianUInt16() != version )
+            {
+                throw std::runtime_error( "Unsupported compressed image version: " + path );
+            }
+            
+            this->_stream.readLittleEndianUInt16();
+            
+            this->_chunkSize = this->_stream.readLittleEndianUInt32();
+            this->_size      = this->_stream.readLittleEndianUInt64();
+            count            = this->_stream.readLittleEndianUInt64();
+            
+            this->_stream.readLittleEndianUInt32();
+            
+            if( this->_chunkSize == 0 || count != ( this->_size + this->_chunkSize - 1 ) / this->_chunkSize )
+            {
+                throw std::runtime_error( "Invalid compressed image: " + path );
+            }
+            
+            if( fileSize < 32 || count > ( fileSize - 32 ) / 16 )
+            {
+                throw std::runtime_error( "Invalid compressed image - Truncated chunk index: " + path );
+            }
+            
+            end = 32 + ( count * 16 );
+            
+            for( uint64_t i = 0; i < count; i++ )
+            {
+                Chunk chunk;
+                
+                chunk.offset  = this->_stream.readLittleEndianUInt64();
+                chunk.size    = this->_stream.readLittleEndianUInt32();
+                chunk.storage = static_cast< Storage >( this->_stream.readLittleEndianUInt32() );
+                
+                if( chunk.storage != Storage::Zero )
+                {
+                    if( chunk.storage != Storage::Deflated && chunk.storage != Storage::Stored )
+                    {
+                        throw std::runtime_error( "Invalid compressed image chunk: " + std::to_string( i ) );
+                    }
+                    
+                    if( chunk.size == 0 || chunk.offset < end || chunk.offset > fileSize || chunk.size > fileSize - chunk.offset )
+                    {
+                        throw std::runtime_error( "Invalid compressed image chunk - Out of bounds: " + std::to_string( i ) );
+                    }
+                    
+                    if( chunk.storage == Storage::Stored && chunk.size != std::min< uint64_t >( this->_chunkSize, this->_size - ( i * this->_chunkSize ) ) )
+                    {
+                        throw std::runtime_error( "Invalid compressed image chunk: " + std::to_string( i ) );
+                    }
+                    
+                    end = chunk.offset + chunk.size;
+                }
+                
+                this->_chunks.push_back( chunk );
+            }
+            
+            this->_cacheSize = std::max< size_t >( 1, cacheSize / this->_chunkSize );
+        }
+        
+        size_t CompressedImageReader::IMPL::_chunkLength( uint64_t index ) const
+        {
+            return numeric_cast< size_t >( std::min< uint64_t >( this->_chunkSize, this->_size - ( index * this->_chunkSize ) ) );
+        }
+        
+        const std::vector< uint8_t > & CompressedImageReader::IMPL::_chunk( uint64_t index )
+        {
+            auto it( this->_cache.find( index ) );
+            
+            if( it != this->_cache.end() )
+            {
+                this->_lru.splice( this->_lru.begin(), this->_lru, it->second.second );
+                
+                return it->second.first;
+            }
+            
+            {
+                const Chunk          & chunk( this->_chunks[ index ] );
+                std::vector< uint8_t > data( this->_chunkLength( index ), 0 );
+                
+                this->_stream.seek( numeric_cast< ssize_t >( chunk.offset ), BinaryStream::SeekDirection::Begin );
+                
+                if( chunk.storage == Storage::Stored )
+                {
+                    if( chunk.size != data.size() )
+                    {
+                        throw std::runtime_error( "Invalid compressed image chunk: " + std::to_string( index ) );
+                    }
+                    
+                    this->_stream.read( data.data(), data.size() );
+                }
+                else if( chunk.storage == Storage::Deflated )
+                {
+                    std::vector< uint8_t > deflated( this->_stream.read( chunk.size ) );
+                    uLongf                 length( numeric_cast< uLongf >( data.size() ) );
+                    
+                    if( uncompress( data.data(), &length, deflated.data(), numeric_cast< uLong >( deflated.size() ) ) != Z_OK || length != data.size() )
+                    {
+                        throw std::runtime_error( "Invalid compressed image chunk: " + std::to_string( index ) );
+                    }
+                }
+                else
+                {
+                    throw std::runtime_error( "Invalid compressed image chunk: " + std::to_string( index ) );
+                }
+                
+                if( this->_cache.size() >= this->_cacheSize )
+                {
+                    this->_cache.erase( this->_lru.back() );
+                    this->_lru.pop_back();
+                }
+                
+                this->_lru.push_front( index );
+                
+                return this->_cache.emplace( index, std::make_pair( std::move( data ), this->_lru.begin() ) ).first->second.first;
+            }
+        }
+    }
+}
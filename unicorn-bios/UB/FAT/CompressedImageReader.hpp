@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_FAT_COMPRESSED_IMAGE_READER_HPP
+#define UB_FAT_COMPRESSED_IMAGE_READER_HPP
+
+#include "UB/FAT/ImageReader.hpp"
+#include <memory>
+#include <algorithm>
+#include <string>
+
+namespace UB
+{
+    namespace FAT
+    {
+        /*
+         * Reads images stored in the chunked compressed container format.
+         *
+         * The file starts with a 32 bytes header ("UBCI" magic, version,
+         * chunk size, image size and chunk count), followed by one 16 bytes
+         * index entry per chunk (file offset, compressed size and storage
+         * type). Each chunk is deflated independently, and chunks only
+         * containing zeroes are not stored at all.
+         * Decompressed chunks are kept in a bounded LRU cache.
+         */
+        class CompressedImageReader: public ImageReader
+        {
+            public:
+                
+                static const uint32_t defaultChunkSize;
+                static const size_t   defaultCacheSize;
+                
+                static bool isCompressedImage( const std::string & path );
+                static void compress( const std::string & input, const std::string & output, uint32_t chunkSize = defaultChunkSize );
+                
+                CompressedImageReader( const std::string & path, size_t cacheSize = defaultCacheSize );
+                
+                virtual ~CompressedImageReader( void );
+                
+                CompressedImageReader( const CompressedImageReader & o )              = delete;
+                CompressedImageReader( CompressedImageReader && o )                   = delete;
+                CompressedImageReader & operator =( const CompressedImageReader & o ) = delete;
+                CompressedImageReader & operator =( CompressedImageReader && o )      = delete;
+                
+                uint64_t size( void )                                      const override;
+                void     read( uint64_t offset, uint8_t * buf, size_t size )       override;
+                
+                uint32_t chunkSize( void )  const;
+                uint64_t chunkCount( void ) const;
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_FAT_COMPRESSED_IMAGE_READER_HPP */
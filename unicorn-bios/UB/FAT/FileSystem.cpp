@@ -0,0 +1,603 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/FAT/FileSystem.hpp"
+#include "UB/FAT/MBR.hpp"
+#include "UB/String.hpp"
+#include "UB/Casts.hpp"
+#include <unordered_map>
+#include <mutex>
+#include <sstream>
+#include <cstring>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class FileSystem::IMPL
+        {
+            public:
+                
+                IMPL( const Image & image );
+                
+                static Image    volumeForImage( const Image & image );
+                static uint32_t read16( const std::vector< uint8_t > & data, size_t offset );
+                static uint32_t read32( const std::vector< uint8_t > & data, size_t offset );
+                
+                uint8_t                                  _fatByte( uint64_t offset );
+                uint32_t                                 _next( uint32_t cluster );
+                bool                                     _isEndOfChain( uint32_t cluster ) const;
+                const std::vector< uint32_t >          & _chain( uint32_t cluster );
+                std::vector< uint8_t >                   _readChain( uint32_t cluster, uint64_t size );
+                const std::vector< FileSystem::Entry > & _directory( const std::string & path );
+                std::vector< FileSystem::Entry >         _parseDirectory( const std::vector< uint8_t > & data ) const;
+                FileSystem::Entry                        _entry( const std::string & path );
+                
+                Image    _image;
+                Type     _type;
+                uint32_t _bytesPerSector;
+                uint32_t _sectorsPerCluster;
+                uint32_t _rootEntries;
+                uint32_t _rootCluster;
+                uint32_t _clusterCount;
+                uint64_t _fatOffset;
+                uint64_t _rootOffset;
+                uint64_t _dataOffset;
+                
+                std::unordered_map< uint64_t, std::vector< uint8_t > >              _fatSectors;
+                std::unordered_map< uint32_t, std::vector< uint32_t > >             _chains;
+                std::unordered_map< std::string, std::vector< FileSystem::Entry > > _directories;
+                std::mutex                                                          _mtx;
+        };
+        
+        class FileSystem::Entry::IMPL
+        {
+            public:
+                
+                IMPL( const std::string & name, const std::string & shortName, bool directory, uint32_t cluster, uint32_t size );
+                IMPL( const IMPL & o );
+                
+                std::string _name;
+                std::string _shortName;
+                bool        _directory;
+                uint32_t    _cluster;
+                uint32_t    _size;
+        };
+        
+        FileSystem::FileSystem( const Image & image ):
+            impl( std::make_unique< IMPL >( image ) )
+        {}
+        
+        FileSystem::~FileSystem( void )
+        {}
+        
+        FileSystem::Type FileSystem::type( void ) const
+        {
+            return this->impl->_type;
+        }
+        
+        std::vector< FileSystem::Entry > FileSystem::entries( const std::string & path )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_directory( path );
+        }
+        
+        FileSystem::Entry FileSystem::entry( const std::string & path )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            return this->impl->_entry( path );
+        }
+        
+        std::vector< uint8_t > FileSystem::read( const std::string & path )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            Entry entry( this->impl->_entry( path ) );
+            
+            if( entry.isDirectory() )
+            {
+                throw std::runtime_error( "Not a file: " + path );
+            }
+            
+            if( entry.size() == 0 )
+            {
+                return {};
+            }
+            
+            return this->impl->_readChain( entry.cluster(), entry.size() );
+        }
+        
+        FileSystem::Entry::Entry( const std::string & name, const std::string & shortName, bool directory, uint32_t cluster, uint32_t size ):
+            impl( std::make_unique< IMPL >( name, shortName, directory, cluster, size ) )
+        {}
+        
+        FileSystem::Entry::Entry( const Entry & o ):
+            impl( std::make_unique< IMPL >( *( o.impl ) ) )
+        {}
+        
+        FileSystem::Entry::Entry( Entry && o ) noexcept:
+            impl( std::move( o.impl ) )
+        {}
+        
+        FileSystem::Entry::~Entry( void )
+        {}
+        
+        FileSystem::Entry & FileSystem::Entry::operator =( Entry o )
+        {
+            swap( *( this ), o );
+            
+            return *( this );
+        }
+        
+        std::string FileSystem::Entry::name( void ) const
+        {
+            return this->impl->_name;
+        }
+        
+        std::string FileSystem::Entry::shortName( void ) const
+        {
+            return this->impl->_shortName;
+        }
+        
+        bool FileSystem::Entry::isDirectory( void ) const
+        {
+            return this->impl->_directory;
+        }
+        
+        uint32_t FileSystem::Entry::cluster( void ) const
+        {
+            return this->impl->_cluster;
+        }
+        
+        uint32_t FileSystem::Entry::size( void ) const
+        {
+            return this->impl->_size;
+        }
+        
+        void swap( FileSystem::Entry & o1, FileSystem::Entry & o2 )
+        {
+            using std::swap;
+            
+            swap( o1.impl, o2.impl );
+        }
+        
+        FileSystem::IMPL::IMPL( const Image & image ):
+            _image(             volumeForImage( image ) ),
+            _type(              Type::FAT12 ),
+            _bytesPerSector(    0 ),
+            _sectorsPerCluster( 0 ),
+            _rootEntries(       0 ),
+            _rootCluster(       0 ),
+            _clusterCount(      0 ),
+            _fatOffset(         0 ),
+            _rootOffset(        0 ),
+            _dataOffset(        0 )
+        {
+            MBR                    mbr( this->_image.mbr() );
+            std::vector< uint8_t > data( mbr.data() );
+            uint32_t               sectorsPerFAT;
+            uint32_t               totalSectors;
+            uint32_t               rootSectors;
+            uint32_t               overhead;
+            
+            if( mbr.isValid() == false || data.size() != 512 || mbr.numberOfFATs() == 0 )
+            {
+                throw std::runtime_error( "Invalid FAT volume: " + this->_image.path() );
+            }
+            
+            this->_bytesPerSector    = mbr.bytesPerSector();
+            this->_sectorsPerCluster = mbr.sectorsPerCluster();
+            this->_rootEntries       = mbr.maxRootDirEntries();
+            sectorsPerFAT            = ( mbr.sectorsPerFAT() != 0 ) ? mbr.sectorsPerFAT()  : read32( data, 36 );
+            totalSectors             = ( mbr.totalSectors()  != 0 ) ? mbr.totalSectors()   : mbr.lbaSectors();
+            rootSectors              = ( ( this->_rootEntries * 32 ) + this->_bytesPerSector - 1 ) / this->_bytesPerSector;
+            overhead                 = mbr.reservedSectors() + ( mbr.numberOfFATs() * sectorsPerFAT ) + rootSectors;
+            
+            if( sectorsPerFAT == 0 || totalSectors <= overhead )
+            {
+                throw std::runtime_error( "Invalid FAT volume: " + this->_image.path() );
+            }
+            
+            this->_clusterCount = ( totalSectors - overhead ) / this->_sectorsPerCluster;
+            this->_fatOffset    = static_cast< uint64_t >( mbr.reservedSectors() ) * this->_bytesPerSector;
+            this->_rootOffset   = this->_fatOffset  + ( static_cast< uint64_t >( mbr.numberOfFATs() ) * sectorsPerFAT * this->_bytesPerSector );
+            this->_dataOffset   = this->_rootOffset + ( static_cast< uint64_t >( rootSectors ) * this->_bytesPerSector );
+            
+            if( this->_clusterCount < 4085 )
+            {
+                this->_type = Type::FAT12;
+            }
+            else if( this->_clusterCount < 65525 )
+            {
+                this->_type = Type::FAT16;
+            }
+            else
+            {
+                this->_type        = Type::FAT32;
+                this->_rootCluster = read32( data, 44 ) & 0x0FFFFFFF;
+            }
+        }
+        
+        Image FileSystem::IMPL::volumeForImage( const Image & image )
+        {
+            std::vector< Partition > partitions( image.partitions() );
+            
+            if( partitions.size() == 0 )
+            {
+                return image;
+            }
+            
+            for( bool bootable: { true, false } )
+            {
+                for( size_t i = 0; i < partitions.size(); i++ )
+                {
+                    if( partitions[ i ].bootable() == bootable )
+                    {
+                        Image volume( image.partition( i ) );
+                        
+                        if( volume.mbr().isValid() )
+                        {
+                            return volume;
+                        }
+                    }
+                }
+            }
+            
+            throw std::runtime_error( "No FAT partition found: " + image.path() );
+        }
+        
+        uint32_t FileSystem::IMPL::read16( const std::vector< uint8_t > & data, size_t offset )
+        {
+            return static_cast< uint32_t >( data[ offset ] ) | ( static_cast< uint32_t >( data[ offset + 1 ] ) << 8 );
+        }
+        
+        uint32_t FileSystem::IMPL::read32( const std::vector< uint8_t > & data, size_t offset )
+        {
+            return read16( data, offset ) | ( read16( data, offset + 2 ) << 16 );
+        }
+        
+        uint8_t FileSystem::IMPL::_fatByte( uint64_t offset )
+        {
+            uint64_t sector( offset / this->_bytesPerSector );
+            auto     it( this->_fatSectors.find( sector ) );
+            
+            if( it == this->_fatSectors.end() )
+            {
+                it = this->_fatSectors.emplace( sector, this->_image.read( this->_fatOffset + ( sector * this->_bytesPerSector ), this->_bytesPerSector ) ).first;
+            }
+            
+            return it->second[ numeric_cast< size_t >( offset % this->_bytesPerSector ) ];
+        }
+        
+        uint32_t FileSystem::IMPL::_next( uint32_t cluster )
+        {
+            if( this->_type == Type::FAT12 )
+            {
+                uint64_t offset( cluster + ( cluster / 2 ) );
+                uint32_t value( static_cast< uint32_t >( this->_fatByte( offset ) ) | ( static_cast< uint32_t >( this->_fatByte( offset + 1 ) ) << 8 ) );
+                
+                return ( cluster & 1 ) ? value >> 4 : value & 0x0FFF;
+            }
+            
+            if( this->_type == Type::FAT16 )
+            {
+                uint64_t offset( static_cast< uint64_t >( cluster ) * 2 );
+                
+                return static_cast< uint32_t >( this->_fatByte( offset ) ) | ( static_cast< uint32_t >( this->_fatByte( offset + 1 ) ) << 8 );
+            }
+            
+            {
+                uint64_t offset( static_cast< uint64_t >( cluster ) * 4 );
+                uint32_t value( 0 );
+                
+                for( uint64_t i = 0; i < 4; i++ )
+                {
+                    value |= static_cast< uint32_t >( this->_fatByte( offset + i ) ) << ( i * 8 );
+                }
+                
+                return value & 0x0FFFFFFF;
+            }
+        }
+        
+        bool FileSystem::IMPL::_isEndOfChain( uint32_t cluster ) const
+        {
+            switch( this->_type )
+            {
+                case Type::FAT12: return cluster >= 0x0FF8;
+                case Type::FAT16: return cluster >= 0xFFF8;
+                case Type::FAT32: return cluster >= 0x0FFFFFF8;
+            }
+            
+            return true;
+        }
+        
+        const std::vector< uint32_t > & FileSystem::IMPL::_chain( uint32_t cluster )
+        {
+            auto it( this->_chains.find( cluster ) );
+            
+            if( it != this->_chains.end() )
+            {
+                return it->second;
+            }
+            
+            {
+                std::vector< uint32_t > chain;
+                uint32_t                first( cluster );
+                
+                while( this->_isEndOfChain( cluster ) == false )
+                {
+                    if( cluster < 2 || cluster >= this->_clusterCount + 2 || chain.size() > this->_clusterCount )
+                    {
+                        throw std::runtime_error( "Invalid cluster chain starting at cluster " + std::to_string( first ) );
+                    }
+                    
+                    chain.push_back( cluster );
+                    
+                    cluster = this->_next( cluster );
+                }
+                
+                return this->_chains.emplace( first, std::move( chain ) ).first->second;
+            }
+        }
+        
+        std::vector< uint8_t > FileSystem::IMPL::_readChain( uint32_t cluster, uint64_t size )
+        {
+            const std::vector< uint32_t > & chain( this->_chain( cluster ) );
+            uint64_t                        clusterSize( static_cast< uint64_t >( this->_sectorsPerCluster ) * this->_bytesPerSector );
+            std::vector< uint8_t >          data;
+            
+            if( size > chain.size() * clusterSize )
+            {
+                throw std::runtime_error( "Invalid cluster chain starting at cluster " + std::to_string( cluster ) );
+            }
+            
+            data.reserve( numeric_cast< size_t >( size ) );
+            
+            for( size_t i = 0; i < chain.size() && data.size() < size; )
+            {
+                size_t   run( 1 );
+                uint64_t length;
+                
+                while( i + run < chain.size() && chain[ i + run ] == chain[ i ] + run )
+                {
+                    run++;
+                }
+                
+                length = std::min< uint64_t >( run * clusterSize, size - data.size() );
+                
+                {
+                    std::vector< uint8_t > bytes( this->_image.read( this->_dataOffset + ( ( chain[ i ] - 2 ) * clusterSize ), length ) );
+                    
+                    data.insert( data.end(), bytes.begin(), bytes.end() );
+                }
+                
+                i += run;
+            }
+            
+            return data;
+        }
+        
+        const std::vector< FileSystem::Entry > & FileSystem::IMPL::_directory( const std::string & path )
+        {
+            std::vector< std::string > components;
+            std::string                key;
+            
+            {
+                std::stringstream ss( path );
+                std::string       component;
+                
+                while( std::getline( ss, component, '/' ) )
+                {
+                    if( component.length() > 0 )
+                    {
+                        components.push_back( component );
+                        
+                        key += "/" + String::toUpper( component );
+                    }
+                }
+            }
+            
+            {
+                auto it( this->_directories.find( key ) );
+                
+                if( it != this->_directories.end() )
+                {
+                    return it->second;
+                }
+            }
+            
+            if( components.size() == 0 )
+            {
+                std::vector< FileSystem::Entry > entries;
+                
+                if( this->_type == Type::FAT32 )
+                {
+                    entries = this->_parseDirectory( this->_readChain( this->_rootCluster, this->_chain( this->_rootCluster ).size() * this->_sectorsPerCluster * this->_bytesPerSector ) );
+                }
+                else
+                {
+                    entries = this->_parseDirectory( this->_image.read( this->_rootOffset, this->_rootEntries * 32 ) );
+                }
+                
+                return this->_directories.emplace( key, std::move( entries ) ).first->second;
+            }
+            
+            {
+                FileSystem::Entry entry( this->_entry( path ) );
+                uint64_t          size;
+                
+                if( entry.isDirectory() == false )
+                {
+                    throw std::runtime_error( "Not a directory: " + path );
+                }
+                
+                if( entry.cluster() == 0 )
+                {
+                    return this->_directory( "/" );
+                }
+                
+                size = this->_chain( entry.cluster() ).size() * this->_sectorsPerCluster * this->_bytesPerSector;
+                
+                return this->_directories.emplace( key, this->_parseDirectory( this->_readChain( entry.cluster(), size ) ) ).first->second;
+            }
+        }
+        
+        std::vector< FileSystem::Entry > FileSystem::IMPL::_parseDirectory( const std::vector< uint8_t > & data ) const
+        {
+            std::vector< FileSystem::Entry > entries;
+            std::string                      longName;
+            
+            for( size_t i = 0; i + 32 <= data.size(); i += 32 )
+            {
+                const uint8_t * entry( data.data() + i );
+                uint8_t         attributes( entry[ 11 ] );
+                
+                if( entry[ 0 ] == 0x00 )
+                {
+                    break;
+                }
+                
+                if( entry[ 0 ] == 0xE5 )
+                {
+                    longName = "";
+                    
+                    continue;
+                }
+                
+                if( ( attributes & 0x3F ) == 0x0F )
+                {
+                    std::string part;
+                    
+                    for( size_t offset: { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 } )
+                    {
+                        uint16_t c( static_cast< uint16_t >( entry[ offset ] | ( entry[ offset + 1 ] << 8 ) ) );
+                        
+                        if( c == 0x0000 || c == 0xFFFF )
+                        {
+                            break;
+                        }
+                        
+                        part += ( c < 0x80 ) ? static_cast< char >( c ) : '_';
+                    }
+                    
+                    longName = ( ( entry[ 0 ] & 0x40 ) ? "" : longName );
+                    longName = part + longName;
+                    
+                    continue;
+                }
+                
+                if( ( attributes & 0x08 ) || entry[ 0 ] == '.' )
+                {
+                    longName = "";
+                    
+                    continue;
+                }
+                
+                {
+                    std::string base( reinterpret_cast< const char * >( entry ),     8 );
+                    std::string ext(  reinterpret_cast< const char * >( entry + 8 ), 3 );
+                    std::string shortName;
+                    uint32_t    cluster( read16( data, i + 26 ) );
+                    
+                    if( this->_type == Type::FAT32 )
+                    {
+                        cluster |= read16( data, i + 20 ) << 16;
+                    }
+                    
+                    if( base[ 0 ] == 0x05 )
+                    {
+                        base[ 0 ] = static_cast< char >( 0xE5 );
+                    }
+                    
+                    base.erase( base.find_last_not_of( ' ' ) + 1 );
+                    ext.erase(  ext.find_last_not_of( ' ' )  + 1 );
+                    
+                    shortName = ( ext.length() > 0 ) ? base + "." + ext : base;
+                    
+                    entries.push_back
+                    (
+                        FileSystem::Entry
+                        (
+                            ( longName.length() > 0 ) ? longName : shortName,
+                            shortName,
+                            ( attributes & 0x10 ) != 0,
+                            cluster,
+                            read32( data, i + 28 )
+                        )
+                    );
+                    
+                    longName = "";
+                }
+            }
+            
+            return entries;
+        }
+        
+        FileSystem::Entry FileSystem::IMPL::_entry( const std::string & path )
+        {
+            size_t      pos( path.find_last_not_of( '/' ) );
+            std::string name;
+            std::string parent;
+            
+            if( pos == std::string::npos )
+            {
+                return FileSystem::Entry( "/", "/", true, 0, 0 );
+            }
+            
+            name   = path.substr( 0, pos + 1 );
+            pos    = name.rfind( '/' );
+            parent = ( pos == std::string::npos ) ? "/" : name.substr( 0, pos + 1 );
+            name   = String::toUpper( ( pos == std::string::npos ) ? name : name.substr( pos + 1 ) );
+            
+            for( const auto & entry: this->_directory( parent ) )
+            {
+                if( String::toUpper( entry.name() ) == name || String::toUpper( entry.shortName() ) == name )
+                {
+                    return entry;
+                }
+            }
+            
+            throw std::runtime_error( "No such file or directory: " + path );
+        }
+        
+        FileSystem::Entry::IMPL::IMPL( const std::string & name, const std::string & shortName, bool directory, uint32_t cluster, uint32_t size ):
+            _name(      name ),
+            _shortName( shortName ),
+            _directory( directory ),
+            _cluster(   cluster ),
+            _size(      size )
+        {}
+        
+        FileSystem::Entry::IMPL::IMPL( const IMPL & o ):
+            _name(      o._name ),
+            _shortName( o._shortName ),
+            _directory( o._directory ),
+            _cluster(   o._cluster ),
+            _size(      o._size )
+        {}
+    }
+}
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_FAT_FILE_SYSTEM_HPP
+#define UB_FAT_FILE_SYSTEM_HPP
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include "UB/FAT/Image.hpp"
+
+namespace UB
+{
+    namespace FAT
+    {
+        class FileSystem
+        {
+            public:
+                
+                enum class Type
+                {
+                    FAT12,
+                    FAT16,
+                    FAT32
+                };
+                
+                class Entry
+                {
+                    public:
+                        
+                        Entry( const std::string & name, const std::string & shortName, bool directory, uint32_t cluster, uint32_t size );
+                        Entry( const Entry & o );
+                        Entry( Entry && o ) noexcept;
+                        ~Entry( void );
+                        
+                        Entry & operator =( Entry o );
+                        
+                        std::string name( void )        const;
+                        std::string shortName( void )   const;
+                        bool        isDirectory( void ) const;
+                        uint32_t    cluster( void )     const;
+                        uint32_t    size( void )        const;
+                        
+                        friend void swap( Entry & o1, Entry & o2 );
+                    
+                    private:
+                        
+                        class IMPL;
+                        std::unique_ptr< IMPL > impl;
+                };
+                
+                FileSystem( const Image & image );
+                ~FileSystem( void );
+                
+                FileSystem( const FileSystem & o )              = delete;
+                FileSystem( FileSystem && o )                   = delete;
+                FileSystem & operator =( const FileSystem & o ) = delete;
+                FileSystem & operator =( FileSystem && o )      = delete;
+                
+                Type type( void ) const;
+                
+                std::vector< Entry >   entries( const std::string & path );
+                Entry                  entry( const std::string & path );
+                std::vector< uint8_t > read( const std::string & path );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_FAT_FILE_SYSTEM_HPP */
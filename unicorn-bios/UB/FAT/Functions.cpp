@@ -32,8 +32,13 @@ namespace UB
     {
         uint64_t chsToLBA( const MBR & mbr, uint8_t cylinder, uint8_t sector, uint8_t head )
         {
-            uint16_t hpc( mbr.headsPerCylinder() );
-            uint16_t spt( mbr.sectorsPerTrack() );
+            return chsToLBA( mbr.headsPerCylinder(), mbr.sectorsPerTrack(), cylinder, sector, head );
+        }
+        
+        uint64_t chsToLBA( uint16_t headsPerCylinder, uint16_t sectorsPerTrack, uint16_t cylinder, uint8_t sector, uint8_t head )
+        {
+            uint16_t hpc( headsPerCylinder );
+            uint16_t spt( sectorsPerTrack );
             
             return ( ( ( numeric_cast< uint64_t >( cylinder ) * numeric_cast< uint64_t >( hpc ) ) + numeric_cast< uint64_t >( head ) ) * numeric_cast< uint64_t >( spt ) ) + ( numeric_cast< uint64_t >( sector ) - 1 );
         }
@@ -34,6 +34,7 @@ namespace UB
         class MBR;
         
         uint64_t chsToLBA( const MBR & mbr, uint8_t cylinder, uint8_t sector, uint8_t head );
+        uint64_t chsToLBA( uint16_t headsPerCylinder, uint16_t sectorsPerTrack, uint16_t cylinder, uint8_t sector, uint8_t head );
     }
 }
 
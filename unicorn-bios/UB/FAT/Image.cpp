@@ -24,9 +24,13 @@
 
 #include "UB/FAT/Image.hpp"
 #include "UB/FAT/Functions.hpp"
-#include "UB/BinaryFileStream.hpp"
+#include "UB/FAT/RawImageReader.hpp"
+#include "UB/FAT/CompressedImageReader.hpp"
+#include "UB/FAT/VirtualImageReader.hpp"
+#include "UB/FAT/PartitionImageReader.hpp"
 #include "UB/BinaryDataStream.hpp"
 #include "UB/Casts.hpp"
+#include <zlib.h>
 
 namespace UB
 {
@@ -36,16 +40,36 @@ namespace UB
         {
             public:
                 
-                IMPL( const std::string & path );
+                IMPL( const std::string & path, const std::shared_ptr< ImageReader > & reader );
                 IMPL( const IMPL & o );
                 
-                std::string      _path;
-                BinaryDataStream _stream;
-                MBR              _mbr;
+                static std::shared_ptr< ImageReader > readerForPath( const std::string & path );
+                static uint64_t                       read32( const std::vector< uint8_t > & data, size_t offset );
+                static uint64_t                       read64( const std::vector< uint8_t > & data, size_t offset );
+                
+                std::vector< uint8_t > _sector( uint64_t lba );
+                void                   _probePartitions( const std::vector< uint8_t > & mbr );
+                bool                   _probeGPT( void );
+                void                   _probeExtended( uint64_t start, size_t number );
+                void                   _computeGeometry( const std::vector< uint8_t > & mbr );
+                
+                std::string                    _path;
+                std::shared_ptr< ImageReader > _reader;
+                MBR                            _mbr;
+                std::vector< Partition >       _partitions;
+                uint16_t                       _cylinders;
+                uint16_t                       _heads;
+                uint16_t                       _sectorsPerTrack;
         };
         
+        static const uint64_t sectorSize = 512;
+        
         Image::Image( const std::string & path ):
-            impl( std::make_unique< IMPL >( path ) )
+            impl( std::make_unique< IMPL >( path, IMPL::readerForPath( path ) ) )
+        {}
+        
+        Image::Image( const std::string & path, const std::shared_ptr< ImageReader > & reader ):
+            impl( std::make_unique< IMPL >( path, reader ) )
         {}
         
         Image::Image( const Image & o ):
@@ -76,18 +100,57 @@ namespace UB
             return this->impl->_mbr;
         }
         
-        std::vector< uint8_t > Image::read( uint8_t cylinder, uint8_t head, uint8_t sector, uint8_t sectors )
+        uint64_t Image::size( void ) const
+        {
+            return this->impl->_reader->size();
+        }
+        
+        uint16_t Image::cylinders( void ) const
+        {
+            return this->impl->_cylinders;
+        }
+        
+        uint16_t Image::heads( void ) const
+        {
+            return this->impl->_heads;
+        }
+        
+        uint16_t Image::sectorsPerTrack( void ) const
+        {
+            return this->impl->_sectorsPerTrack;
+        }
+        
+        std::vector< Partition > Image::partitions( void ) const
+        {
+            return this->impl->_partitions;
+        }
+        
+        Image Image::partition( size_t index ) const
         {
-            uint64_t lba( chsToLBA( this->impl->_mbr, cylinder, sector, head ) );
+            const Partition & partition( this->impl->_partitions.at( index ) );
             
-            return this->read( lba * this->impl->_mbr.bytesPerSector(), sectors * this->impl->_mbr.bytesPerSector() );
+            return Image
+            (
+                this->impl->_path + " (partition " + std::to_string( partition.number() ) + ")",
+                std::make_shared< PartitionImageReader >( this->impl->_reader, partition.start() * sectorSize, partition.sectors() * sectorSize )
+            );
         }
         
-        std::vector< uint8_t > Image::read( uint64_t offset, uint64_t size )
+        std::vector< uint8_t > Image::read( uint16_t cylinder, uint8_t head, uint8_t sector, uint8_t sectors ) const
         {
-            this->impl->_stream.seek( numeric_cast< ssize_t >( offset ), BinaryStream::SeekDirection::Begin );
+            uint64_t lba( chsToLBA( this->impl->_heads, this->impl->_sectorsPerTrack, cylinder, sector, head ) );
+            uint64_t bps( ( this->impl->_mbr.isValid() && this->impl->_partitions.size() == 0 ) ? this->impl->_mbr.bytesPerSector() : sectorSize );
             
-            return this->impl->_stream.read( size );
+            return this->read( lba * bps, sectors * bps );
+        }
+        
+        std::vector< uint8_t > Image::read( uint64_t offset, uint64_t size ) const
+        {
+            std::vector< uint8_t > data( numeric_cast< size_t >( size ), 0 );
+            
+            this->impl->_reader->read( offset, data.data(), data.size() );
+            
+            return data;
         }
         
         void swap( Image & o1, Image & o2 )
@@ -97,22 +160,324 @@ namespace UB
             swap( o1.impl, o2.impl );
         }
         
-        Image::IMPL::IMPL( const std::string & path ):
-            _path( path )
+        Image::IMPL::IMPL( const std::string & path, const std::shared_ptr< ImageReader > & reader ):
+            _path(            path ),
+            _reader(          reader ),
+            _cylinders(       0 ),
+            _heads(           0 ),
+            _sectorsPerTrack( 0 )
         {
-            BinaryFileStream stream( path );
+            std::vector< uint8_t > data( 512, 0 );
+            
+            if( this->_reader == nullptr )
+            {
+                throw std::runtime_error( "Invalid image reader" );
+            }
             
-            this->_stream = stream.readAll();
+            this->_reader->read( 0, data.data(), data.size() );
             
-            stream.seek( 0, BinaryStream::SeekDirection::Begin );
+            {
+                BinaryDataStream stream( data );
+                
+                this->_mbr = MBR( stream );
+            }
             
-            this->_mbr = MBR( stream );
+            this->_probePartitions( data );
+            this->_computeGeometry( data );
         }
         
         Image::IMPL::IMPL( const IMPL & o ):
-            _path(   o._path ),
-            _stream( o._stream ),
-            _mbr(    o._mbr )
+            _path(            o._path ),
+            _reader(          o._reader ),
+            _mbr(             o._mbr ),
+            _partitions(      o._partitions ),
+            _cylinders(       o._cylinders ),
+            _heads(           o._heads ),
+            _sectorsPerTrack( o._sectorsPerTrack )
         {}
+        
+        std::shared_ptr< ImageReader > Image::IMPL::readerForPath( const std::string & path )
+        {
+            if( VirtualImageReader::isDirectory( path ) )
+            {
+                return std::make_shared< VirtualImageReader >( path );
+            }
+            
+            if( CompressedImageReader::isCompressedImage( path ) )
+            {
+                return std::make_shared< CompressedImageReader >( path );
+            }
+            
+            return std::make_shared< RawImageReader >( path );
+        }
+        
+        uint64_t Image::IMPL::read32( const std::vector< uint8_t > & data, size_t offset )
+        {
+            uint64_t value( 0 );
+            
+            for( size_t i = 0; i < 4; i++ )
+            {
+                value |= static_cast< uint64_t >( data[ offset + i ] ) << ( i * 8 );
+            }
+            
+            return value;
+        }
+        
+        uint64_t Image::IMPL::read64( const std::vector< uint8_t > & data, size_t offset )
+        {
+            return read32( data, offset ) | ( read32( data, offset + 4 ) << 32 );
+        }
+        
+        std::vector< uint8_t > Image::IMPL::_sector( uint64_t lba )
+        {
+            std::vector< uint8_t > data( sectorSize, 0 );
+            
+            this->_reader->read( lba * sectorSize, data.data(), data.size() );
+            
+            return data;
+        }
+        
+        void Image::IMPL::_probePartitions( const std::vector< uint8_t > & mbr )
+        {
+            uint64_t                 sectors( this->_reader->size() / sectorSize );
+            std::vector< Partition > partitions;
+            bool                     gpt( false );
+            
+            if( mbr[ 510 ] != 0x55 || mbr[ 511 ] != 0xAA )
+            {
+                return;
+            }
+            
+            if( this->_mbr.isValid() && ( mbr[ 0 ] == 0xEB || mbr[ 0 ] == 0xE9 ) )
+            {
+                return;
+            }
+            
+            for( size_t i = 0; i < 4; i++ )
+            {
+                size_t   offset( 446 + ( i * 16 ) );
+                uint8_t  status( mbr[ offset ] );
+                uint8_t  type( mbr[ offset + 4 ] );
+                uint64_t start( read32( mbr, offset + 8 ) );
+                uint64_t count( read32( mbr, offset + 12 ) );
+                
+                if( status != 0x00 && status != 0x80 )
+                {
+                    return;
+                }
+                
+                if( type == 0 )
+                {
+                    continue;
+                }
+                
+                if( start == 0 || count == 0 || start + count > sectors )
+                {
+                    if( type != 0xEE )
+                    {
+                        return;
+                    }
+                }
+                
+                if( type == 0xEE )
+                {
+                    gpt = true;
+                }
+                
+                partitions.push_back( Partition( Partition::Scheme::MBR, i + 1, type, status == 0x80, start, count ) );
+            }
+            
+            if( gpt && this->_probeGPT() )
+            {
+                return;
+            }
+            
+            for( const auto & partition: partitions )
+            {
+                uint8_t type( partition.type() );
+                
+                if( type == 0x05 || type == 0x0F || type == 0x85 || type == 0xEE )
+                {
+                    continue;
+                }
+                
+                this->_partitions.push_back( partition );
+            }
+            
+            for( const auto & partition: partitions )
+            {
+                uint8_t type( partition.type() );
+                
+                if( type == 0x05 || type == 0x0F || type == 0x85 )
+                {
+                    this->_probeExtended( partition.start(), 5 );
+                    
+                    break;
+                }
+            }
+        }
+        
+        bool Image::IMPL::_probeGPT( void )
+        {
+            std::vector< uint8_t > header( this->_sector( 1 ) );
+            uint64_t               length( read32( header, 12 ) );
+            uint64_t               lba;
+            uint64_t               count;
+            uint64_t               size;
+            std::vector< uint8_t > entries;
+            
+            if( std::string( reinterpret_cast< const char * >( header.data() ), 8 ) != "EFI PART" || length < 92 || length > sectorSize )
+            {
+                return false;
+            }
+            
+            {
+                std::vector< uint8_t > data( header.begin(), header.begin() + numeric_cast< ssize_t >( length ) );
+                
+                std::fill( data.begin() + 16, data.begin() + 20, 0 );
+                
+                if( crc32( 0, data.data(), numeric_cast< uInt >( data.size() ) ) != read32( header, 16 ) )
+                {
+                    return false;
+                }
+            }
+            
+            lba   = read64( header, 72 );
+            count = read32( header, 80 );
+            size  = read32( header, 84 );
+            
+            if( size < 128 || count > 1024 || ( lba * sectorSize ) + ( count * size ) > this->_reader->size() )
+            {
+                throw std::runtime_error( "Invalid GPT header: " + this->_path );
+            }
+            
+            entries.resize( numeric_cast< size_t >( count * size ) );
+            this->_reader->read( lba * sectorSize, entries.data(), entries.size() );
+            
+            if( crc32( 0, entries.data(), numeric_cast< uInt >( entries.size() ) ) != read32( header, 88 ) )
+            {
+                throw std::runtime_error( "Invalid GPT partition entries: " + this->_path );
+            }
+            
+            for( uint64_t i = 0; i < count; i++ )
+            {
+                size_t      offset( numeric_cast< size_t >( i * size ) );
+                uint64_t    first( read64( entries, offset + 32 ) );
+                uint64_t    last(  read64( entries, offset + 40 ) );
+                uint64_t    attributes( read64( entries, offset + 48 ) );
+                std::string name;
+                
+                if( std::all_of( entries.begin() + numeric_cast< ssize_t >( offset ), entries.begin() + numeric_cast< ssize_t >( offset + 16 ), []( uint8_t b ) { return b == 0; } ) )
+                {
+                    continue;
+                }
+                
+                if( last < first || ( last + 1 ) * sectorSize > this->_reader->size() )
+                {
+                    continue;
+                }
+                
+                for( size_t j = 0; j < 36; j++ )
+                {
+                    uint16_t c( static_cast< uint16_t >( entries[ offset + 56 + ( j * 2 ) ] | ( entries[ offset + 57 + ( j * 2 ) ] << 8 ) ) );
+                    
+                    if( c == 0 )
+                    {
+                        break;
+                    }
+                    
+                    name += ( c < 0x80 ) ? static_cast< char >( c ) : '_';
+                }
+                
+                this->_partitions.push_back( Partition( Partition::Scheme::GPT, numeric_cast< size_t >( i + 1 ), 0, ( attributes & 0x04 ) != 0, first, ( last - first ) + 1, name ) );
+            }
+            
+            return true;
+        }
+        
+        void Image::IMPL::_probeExtended( uint64_t start, size_t number )
+        {
+            uint64_t sectors( this->_reader->size() / sectorSize );
+            uint64_t ebr( start );
+            
+            for( size_t i = 0; i < 128 && ebr < sectors; i++ )
+            {
+                std::vector< uint8_t > data( this->_sector( ebr ) );
+                uint8_t                type( data[ 446 + 4 ] );
+                uint64_t               first( read32( data, 446 + 8 ) );
+                uint64_t               count( read32( data, 446 + 12 ) );
+                uint64_t               next( read32( data, 462 + 8 ) );
+                
+                if( data[ 510 ] != 0x55 || data[ 511 ] != 0xAA )
+                {
+                    break;
+                }
+                
+                if( type != 0 && first != 0 && count != 0 && ebr + first + count <= sectors )
+                {
+                    this->_partitions.push_back( Partition( Partition::Scheme::MBR, number++, type, data[ 446 ] == 0x80, ebr + first, count ) );
+                }
+                
+                if( data[ 462 + 4 ] == 0 || next == 0 )
+                {
+                    break;
+                }
+                
+                ebr = start + next;
+            }
+        }
+        
+        void Image::IMPL::_computeGeometry( const std::vector< uint8_t > & mbr )
+        {
+            uint64_t sectors( this->_reader->size() / sectorSize );
+            size_t   entry( 446 );
+            
+            while( entry < 446 + ( 4 * 16 ) && mbr[ entry + 4 ] == 0 )
+            {
+                entry += 16;
+            }
+            
+            if( this->_partitions.size() == 0 && this->_mbr.isValid() && this->_mbr.headsPerCylinder() != 0 && this->_mbr.sectorsPerTrack() != 0 )
+            {
+                this->_heads           = this->_mbr.headsPerCylinder();
+                this->_sectorsPerTrack = this->_mbr.sectorsPerTrack();
+                sectors                = this->_reader->size() / this->_mbr.bytesPerSector();
+            }
+            else if( this->_partitions.size() > 0 && this->_partitions.front().scheme() == Partition::Scheme::MBR && entry < 446 + ( 4 * 16 ) && ( mbr[ entry + 6 ] & 0x3F ) != 0 && mbr[ entry + 5 ] != 0 )
+            {
+                this->_heads           = static_cast< uint16_t >( mbr[ entry + 5 ] + 1 );
+                this->_sectorsPerTrack = mbr[ entry + 6 ] & 0x3F;
+            }
+            else
+            {
+                switch( this->_reader->size() )
+                {
+                    case  368640: this->_heads = 2; this->_sectorsPerTrack =  9; break;
+                    case  737280: this->_heads = 2; this->_sectorsPerTrack =  9; break;
+                    case 1228800: this->_heads = 2; this->_sectorsPerTrack = 15; break;
+                    case 1474560: this->_heads = 2; this->_sectorsPerTrack = 18; break;
+                    case 2949120: this->_heads = 2; this->_sectorsPerTrack = 36; break;
+                    
+                    default:
+                        
+                        this->_sectorsPerTrack = 63;
+                        this->_heads           = 255;
+                        
+                        for( uint16_t heads: { 16, 32, 64, 128 } )
+                        {
+                            if( sectors <= 1024ull * heads * 63 )
+                            {
+                                this->_heads = heads;
+                                
+                                break;
+                            }
+                        }
+                        
+                        break;
+                }
+            }
+            
+            this->_cylinders = static_cast< uint16_t >( std::min< uint64_t >( 1024, sectors / ( static_cast< uint64_t >( this->_heads ) * this->_sectorsPerTrack ) ) );
+        }
     }
 }
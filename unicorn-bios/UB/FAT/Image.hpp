@@ -31,6 +31,8 @@
 #include <cstdint>
 #include <vector>
 #include "UB/FAT/MBR.hpp"
+#include "UB/FAT/ImageReader.hpp"
+#include "UB/FAT/Partition.hpp"
 
 namespace UB
 {
@@ -41,17 +43,25 @@ namespace UB
             public:
                 
                 Image( const std::string & path );
+                Image( const std::string & path, const std::shared_ptr< ImageReader > & reader );
                 Image( const Image & o );
                 Image( Image && o ) noexcept;
                 ~Image( void );
                 
                 Image & operator =( Image o );
                 
-                std::string path( void ) const;
-                MBR         mbr( void )  const;
+                std::string path( void )            const;
+                MBR         mbr( void )             const;
+                uint64_t    size( void )            const;
+                uint16_t    cylinders( void )       const;
+                uint16_t    heads( void )           const;
+                uint16_t    sectorsPerTrack( void ) const;
                 
-                std::vector< uint8_t > read( uint8_t cylinder, uint8_t head, uint8_t sector, uint8_t sectors = 1 );
-                std::vector< uint8_t > read( uint64_t offset, uint64_t size );
+                std::vector< Partition > partitions( void )        const;
+                Image                    partition( size_t index ) const;
+                
+                std::vector< uint8_t > read( uint16_t cylinder, uint8_t head, uint8_t sector, uint8_t sectors = 1 ) const;
+                std::vector< uint8_t > read( uint64_t offset, uint64_t size )                                   const;
                 
                 friend void swap( Image & o1, Image & o2 );
                 
@@ -22,18 +22,26 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
-#ifndef UB_CPU_FUNCTIONS_HPP
-#define UB_CPU_FUNCTIONS_HPP
+#ifndef UB_FAT_IMAGE_READER_HPP
+#define UB_FAT_IMAGE_READER_HPP
 
-#include "UB/Engine.hpp"
-#include "UB/Registers.hpp"
+#include <cstdint>
+#include <cstdlib>
 
 namespace UB
 {
-    namespace CPU
+    namespace FAT
     {
-        void cpuid( Engine & engine, const Registers & registers );
+        class ImageReader
+        {
+            public:
+                
+                virtual ~ImageReader( void ) = default;
+                
+                virtual uint64_t size( void )                                      const = 0;
+                virtual void     read( uint64_t offset, uint8_t * buf, size_t size )       = 0;
+        };
     }
 }
 
-#endif /* UB_CPU_FUNCTIONS_HPP */
+#endif /* UB_FAT_IMAGE_READER_HPP */
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/FAT/Partition.hpp"
+#include "UB/String.hpp"
+
+namespace UB
+{
+    namespace FAT
+    {
+        class Partition::IMPL
+        {
+            public:
+                
+                IMPL( Scheme scheme, size_t number, uint8_t type, bool bootable, uint64_t start, uint64_t sectors, const std::string & name );
+                IMPL( const IMPL & o );
+                
+                Scheme      _scheme;
+                size_t      _number;
+                uint8_t     _type;
+                bool        _bootable;
+                uint64_t    _start;
+                uint64_t    _sectors;
+                std::string _name;
+        };
+        
+        Partition::Partition( Scheme scheme, size_t number, uint8_t type, bool bootable, uint64_t start, uint64_t sectors, const std::string & name ):
+            impl( std::make_unique< IMPL >( scheme, number, type, bootable, start, sectors, name ) )
+        {}
+        
+        Partition::Partition( const Partition & o ):
+            impl( std::make_unique< IMPL >( *( o.impl ) ) )
+        {}
+        
+        Partition::Partition( Partition && o ) noexcept:
+            impl( std::move( o.impl ) )
+        {}
+        
+        Partition::~Partition( void )
+        {}
+        
+        Partition & Partition::operator =( Partition o )
+        {
+            swap( *( this ), o );
+            
+            return *( this );
+        }
+        
+        Partition::Scheme Partition::scheme( void ) const
+        {
+            return this->impl->_scheme;
+        }
+        
+        size_t Partition::number( void ) const
+        {
+            return this->impl->_number;
+        }
+        
+        uint8_t Partition::type( void ) const
+        {
+            return this->impl->_type;
+        }
+        
+        bool Partition::bootable( void ) const
+        {
+            return this->impl->_bootable;
+        }
+        
+        uint64_t Partition::start( void ) const
+        {
+            return this->impl->_start;
+        }
+        
+        uint64_t Partition::sectors( void ) const
+        {
+            return this->impl->_sectors;
+        }
+        
+        std::string Partition::name( void ) const
+        {
+            return this->impl->_name;
+        }
+        
+        void swap( Partition & o1, Partition & o2 )
+        {
+            using std::swap;
+            
+            swap( o1.impl, o2.impl );
+        }
+        
+        std::ostream & operator <<( std::ostream & os, const Partition & o )
+        {
+            os << "{"                                                                                   << std::endl
+               << "    Scheme:   " << ( ( o.impl->_scheme == Partition::Scheme::MBR ) ? "MBR" : "GPT" ) << std::endl
+               << "    Number:   " << o.impl->_number                                                   << std::endl
+               << "    Type:     " << String::toHex( o.impl->_type )                                    << std::endl
+               << "    Bootable: " << ( ( o.impl->_bootable ) ? "yes" : "no" )                          << std::endl
+               << "    Start:    " << o.impl->_start                                                    << std::endl
+               << "    Sectors:  " << o.impl->_sectors                                                  << std::endl
+               << "    Name:     " << o.impl->_name                                                     << std::endl
+               << "}";
+            
+            return os;
+        }
+        
+        Partition::IMPL::IMPL( Scheme scheme, size_t number, uint8_t type, bool bootable, uint64_t start, uint64_t sectors, const std::string & name ):
+            _scheme(   scheme ),
+            _number(   number ),
+            _type(     type ),
+            _bootable( bootable ),
+            _start(    start ),
+            _sectors(  sectors ),
+            _name(     name )
+        {}
+        
+        Partition::IMPL::IMPL( const IMPL & o ):
+            _scheme(   o._scheme ),
+            _number(   o._number ),
+            _type(     o._type ),
+            _bootable( o._bootable ),
+            _start(    o._start ),
+            _sectors(  o._sectors ),
+            _name(     o._name )
+        {}
+    }
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_FAT_PARTITION_HPP
+#define UB_FAT_PARTITION_HPP
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class Partition
+        {
+            public:
+                
+                enum class Scheme
+                {
+                    MBR,
+                    GPT
+                };
+                
+                Partition( Scheme scheme, size_t number, uint8_t type, bool bootable, uint64_t start, uint64_t sectors, const std::string & name = "" );
+                Partition( const Partition & o );
+                Partition( Partition && o ) noexcept;
+                ~Partition( void );
+                
+                Partition & operator =( Partition o );
+                
+                Scheme      scheme( void )   const;
+                size_t      number( void )   const;
+                uint8_t     type( void )     const;
+                bool        bootable( void ) const;
+                uint64_t    start( void )    const;
+                uint64_t    sectors( void )  const;
+                std::string name( void )     const;
+                
+                friend void swap( Partition & o1, Partition & o2 );
+                
+                friend std::ostream & operator <<( std::ostream & os, const Partition & o );
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_FAT_PARTITION_HPP */
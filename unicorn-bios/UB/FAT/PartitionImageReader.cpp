@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/FAT/PartitionImageReader.hpp"
+#include <stdexcept>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class PartitionImageReader::IMPL
+        {
+            public:
+                
+                IMPL( const std::shared_ptr< ImageReader > & reader, uint64_t offset, uint64_t size );
+                
+                std::shared_ptr< ImageReader > _reader;
+                uint64_t                       _offset;
+                uint64_t                       _size;
+        };
+        
+        PartitionImageReader::PartitionImageReader( const std::shared_ptr< ImageReader > & reader, uint64_t offset, uint64_t size ):
+            impl( std::make_unique< IMPL >( reader, offset, size ) )
+        {}
+        
+        PartitionImageReader::~PartitionImageReader( void )
+        {}
+        
+        uint64_t PartitionImageReader::size( void ) const
+        {
+            return this->impl->_size;
+        }
+        
+        void PartitionImageReader::read( uint64_t offset, uint8_t * buf, size_t size )
+        {
+            if( offset > this->impl->_size || size > this->impl->_size - offset )
+            {
+                throw std::runtime_error( "Invalid read - Not enough data available" );
+            }
+            
+            this->impl->_reader->read( this->impl->_offset + offset, buf, size );
+        }
+        
+        PartitionImageReader::IMPL::IMPL( const std::shared_ptr< ImageReader > & reader, uint64_t offset, uint64_t size ):
+            _reader( reader ),
+            _offset( offset ),
+            _size(   size )
+        {
+            if( this->_reader == nullptr || offset > this->_reader->size() || size > this->_reader->size() - offset )
+            {
+                throw std::runtime_error( "Invalid partition bounds" );
+            }
+        }
+    }
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/FAT/RawImageReader.hpp"
+#include "UB/Casts.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class RawImageReader::IMPL
+        {
+            public:
+                
+                IMPL( const std::string & path );
+                ~IMPL( void );
+                
+                const uint8_t * _data;
+                size_t          _size;
+        };
+        
+        RawImageReader::RawImageReader( const std::string & path ):
+            impl( std::make_unique< IMPL >( path ) )
+        {}
+        
+        RawImageReader::~RawImageReader( void )
+        {}
+        
+        uint64_t RawImageReader::size( void ) const
+        {
+            return this->impl->_size;
+        }
+        
+        void RawImageReader::read( uint64_t offset, uint8_t * buf, size_t size )
+        {
+            if( offset > this->impl->_size || size > this->impl->_size - offset )
+            {
+                throw std::runtime_error( "Invalid read - Not enough data available" );
+            }
+            
+            if( size > 0 )
+            {
+                memcpy( buf, this->impl->_data + offset, size );
+            }
+        }
+        
+        RawImageReader::IMPL::IMPL( const std::string & path ):
+            _data( nullptr ),
+            _size( 0 )
+        {
+            int         fd( open( path.c_str(), O_RDONLY ) );
+            struct stat st;
+            
+            if( fd < 0 )
+            {
+                throw std::runtime_error( "Cannot open image: " + path );
+            }
+            
+            if( fstat( fd, &st ) != 0 )
+            {
+                close( fd );
+                
+                throw std::runtime_error( "Cannot open image: " + path );
+            }
+            
+            this->_size = numeric_cast< size_t >( st.st_size );
+            
+            if( this->_size > 0 )
+            {
+                void * data( mmap( nullptr, this->_size, PROT_READ, MAP_PRIVATE, fd, 0 ) );
+                
+                if( data == MAP_FAILED )
+                {
+                    close( fd );
+                    
+                    throw std::runtime_error( "Cannot map image: " + path );
+                }
+                
+                this->_data = static_cast< const uint8_t * >( data );
+            }
+            
+            close( fd );
+        }
+        
+        RawImageReader::IMPL::~IMPL( void )
+        {
+            if( this->_data != nullptr )
+            {
+                munmap( const_cast< uint8_t * >( this->_data ), this->_size );
+            }
+        }
+    }
+}
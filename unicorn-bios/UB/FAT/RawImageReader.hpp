@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_FAT_RAW_IMAGE_READER_HPP
+#define UB_FAT_RAW_IMAGE_READER_HPP
+
+#include "UB/FAT/ImageReader.hpp"
+#include <memory>
+#include <algorithm>
+#include <string>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class RawImageReader: public ImageReader
+        {
+            public:
+                
+                RawImageReader( const std::string & path );
+                
+                virtual ~RawImageReader( void );
+                
+                RawImageReader( const RawImageReader & o )              = delete;
+                RawImageReader( RawImageReader && o )                   = delete;
+                RawImageReader & operator =( const RawImageReader & o ) = delete;
+                RawImageReader & operator =( RawImageReader && o )      = delete;
+                
+                uint64_t size( void )                                      const override;
+                void     read( uint64_t offset, uint8_t * buf, size_t size )       override;
+            
+            private:
+                
+                class IMPL;
+                std::unique_ptr< IMPL > impl;
+        };
+    }
+}
+
+#endif /* UB_FAT_RAW_IMAGE_READER_HPP */
@@ -0,0 +1,723 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/FAT/VirtualImageReader.hpp"
+#include "UB/BinaryFileStream.hpp"
+#include "UB/String.hpp"
+#include "UB/Casts.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <ctime>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <set>
+#include <mutex>
+#include <cstring>
+#include <stdexcept>
+#include <limits>
+
+namespace UB
+{
+    namespace FAT
+    {
+        class VirtualImageReader::IMPL
+        {
+            public:
+                
+                struct Node
+                {
+                    std::string               path;
+                    std::array< uint8_t, 11 > name;
+                    bool                      directory;
+                    uint32_t                  size;
+                    time_t                    time;
+                    size_t                    parent;
+                    std::vector< size_t >     children;
+                    uint32_t                  cluster;
+                    uint32_t                  clusters;
+                    std::vector< uint8_t >    entries;
+                };
+                
+                static std::array< uint8_t, 11 > shortName( const std::string & name, const std::vector< std::array< uint8_t, 11 > > & used );
+                static void                      writeEntry( uint8_t * entry, const std::array< uint8_t, 11 > & name, const Node & node, uint32_t cluster );
+                
+                IMPL( const std::string & directory, const std::string & bootSector );
+                
+                void                           _scan( size_t index );
+                void                           _layout( void );
+                void                           _synthesizeBootSector( const std::string & directory, const std::string & bootSector );
+                uint32_t                       _clustersFor( const Node & node, uint32_t clusterSize ) const;
+                uint32_t                       _fatEntry( uint32_t cluster ) const;
+                uint8_t                        _fatByte( uint64_t offset ) const;
+                const Node                   * _nodeForCluster( uint32_t cluster ) const;
+                const std::vector< uint8_t > & _entries( size_t index );
+                void                           _readFile( size_t index, uint64_t offset, uint8_t * buf, size_t size );
+                
+                std::vector< Node >                   _nodes;
+                std::set< std::pair< dev_t, ino_t > > _directories;
+                std::vector< size_t >                 _extents;
+                std::vector< uint8_t >                _bootSector;
+                bool                                  _fat12;
+                uint32_t                              _sectorsPerCluster;
+                uint32_t                              _reservedSectors;
+                uint32_t                              _rootEntries;
+                uint32_t                              _sectorsPerFAT;
+                uint32_t                              _totalSectors;
+                uint64_t                              _fatOffset;
+                uint64_t                              _rootOffset;
+                uint64_t                              _dataOffset;
+                std::ifstream                         _file;
+                size_t                                _fileIndex;
+                std::mutex                            _mtx;
+        };
+        
+        static const uint32_t bytesPerSector = 512;
+        static const uint32_t numberOfFATs   = 2;
+        
+        bool VirtualImageReader::isDirectory( const std::string & path )
+        {
+            struct stat st;
+            
+            if( stat( path.c_str(), &st ) != 0 )
+            {
+                return false;
+            }
+            
+            return S_ISDIR( st.st_mode );
+        }
+        
+        VirtualImageReader::VirtualImageReader( const std::string & directory, const std::string & bootSector ):
+            impl( std::make_unique< IMPL >( directory, bootSector ) )
+        {}
+        
+        VirtualImageReader::~VirtualImageReader( void )
+        {}
+        
+        uint64_t VirtualImageReader::size( void ) const
+        {
+            return static_cast< uint64_t >( this->impl->_totalSectors ) * bytesPerSector;
+        }
+        
+        void VirtualImageReader::read( uint64_t offset, uint8_t * buf, size_t size )
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            
+            uint64_t clusterSize( static_cast< uint64_t >( this->impl->_sectorsPerCluster ) * bytesPerSector );
+            uint64_t fatSize(     static_cast< uint64_t >( this->impl->_sectorsPerFAT )     * bytesPerSector );
+            
+            if( offset > this->size() || size > this->size() - offset )
+            {
+                throw std::runtime_error( "Invalid read - Not enough data available" );
+            }
+            
+            while( size > 0 )
+            {
+                size_t length;
+                
+                if( offset < this->impl->_fatOffset )
+                {
+                    length = numeric_cast< size_t >( std::min< uint64_t >( size, this->impl->_fatOffset - offset ) );
+                    
+                    for( size_t i = 0; i < length; i++ )
+                    {
+                        buf[ i ] = ( offset + i < this->impl->_bootSector.size() ) ? this->impl->_bootSector[ numeric_cast< size_t >( offset + i ) ] : 0;
+                    }
+                }
+                else if( offset < this->impl->_rootOffset )
+                {
+                    uint64_t rel( ( offset - this->impl->_fatOffset ) % fatSize );
+                    
+                    length = numeric_cast< size_t >( std::min< uint64_t >( size, fatSize - rel ) );
+                    
+                    for( size_t i = 0; i < length; i++ )
+                    {
+                        buf[ i ] = this->impl->_fatByte( rel + i );
+                    }
+                }
+                else if( offset < this->impl->_dataOffset )
+                {
+                    const std::vector< uint8_t > & entries( this->impl->_entries( 0 ) );
+                    uint64_t                       rel( offset - this->impl->_rootOffset );
+                    
+                    length = numeric_cast< size_t >( std::min< uint64_t >( size, this->impl->_dataOffset - offset ) );
+                    
+                    for( size_t i = 0; i < length; i++ )
+                    {
+                        buf[ i ] = ( rel + i < entries.size() ) ? entries[ numeric_cast< size_t >( rel + i ) ] : 0;
+                    }
+                }
+                else
+                {
+                    uint64_t           rel( offset - this->impl->_dataOffset );
+                    uint32_t           cluster( numeric_cast< uint32_t >( 2 + ( rel / clusterSize ) ) );
+                    const IMPL::Node * node( this->impl->_nodeForCluster( cluster ) );
+                    
+                    if( node == nullptr )
+                    {
+                        length = numeric_cast< size_t >( std::min< uint64_t >( size, clusterSize - ( rel % clusterSize ) ) );
+                        
+                        memset( buf, 0, length );
+                    }
+                    else
+                    {
+                        uint64_t start( ( ( cluster - node->cluster ) * clusterSize ) + ( rel % clusterSize ) );
+                        size_t   index( numeric_cast< size_t >( node - this->impl->_nodes.data() ) );
+                        
+                        length = numeric_cast< size_t >( std::min< uint64_t >( size, ( node->clusters * clusterSize ) - start ) );
+                        
+                        if( node->directory )
+                        {
+                            const std::vector< uint8_t > & entries( this->impl->_entries( index ) );
+                            
+                            for( size_t i = 0; i < length; i++ )
+                            {
+                                buf[ i ] = ( start + i < entries.size() ) ? entries[ numeric_cast< size_t >( start + i ) ] : 0;
+                            }
+                        }
+                        else
+                        {
+                            this->impl->_readFile( index, start, buf, length );
+                        }
+                    }
+                }
+                
+                buf    += length;
+                offset += length;
+                size   -= length;
+            }
+        }
+        
+        VirtualImageReader::IMPL::IMPL( const std::string & directory, const std::string & bootSector ):
+            _fat12(             true ),
+            _sectorsPerCluster( 0 ),
+            _reservedSectors(   0 ),
+            _rootEntries(       0 ),
+            _sectorsPerFAT(     0 ),
+            _totalSectors(      0 ),
+            _fatOffset(         0 ),
+            _rootOffset(        0 ),
+            _dataOffset(        0 ),
+            _fileIndex(         std::numeric_limits< size_t >::max() )
+        {
+            Node        root;
+            struct stat st;
+            
+            if( stat( directory.c_str(), &st ) != 0 || S_ISDIR( st.st_mode ) == false )
+            {
+                throw std::runtime_error( "Not a directory: " + directory );
+            }
+            
+            this->_directories.insert( { st.st_dev, st.st_ino } );
+            
+            root.path      = directory;
+            root.directory = true;
+            root.size      = 0;
+            root.time      = 0;
+            root.parent    = 0;
+            root.cluster   = 0;
+            root.clusters  = 0;
+            
+            root.name.fill( ' ' );
+            this->_nodes.push_back( root );
+            
+            this->_scan( 0 );
+            this->_layout();
+            this->_synthesizeBootSector( directory, bootSector );
+        }
+        
+        void VirtualImageReader::IMPL::_scan( size_t index )
+        {
+            DIR                                    * dir( opendir( this->_nodes[ index ].path.c_str() ) );
+            std::vector< std::string >               names;
+            std::vector< std::array< uint8_t, 11 > > used;
+            
+            if( dir == nullptr )
+            {
+                throw std::runtime_error( "Cannot read directory: " + this->_nodes[ index ].path );
+            }
+            
+            for( struct dirent * entry = readdir( dir ); entry != nullptr; entry = readdir( dir ) )
+            {
+                if( entry->d_name[ 0 ] != '.' )
+                {
+                    names.push_back( entry->d_name );
+                }
+            }
+            
+            closedir( dir );
+            std::sort( names.begin(), names.end() );
+            
+            for( const auto & name: names )
+            {
+                Node        node;
+                struct stat st;
+                
+                node.path = this->_nodes[ index ].path + "/" + name;
+                
+                if( stat( node.path.c_str(), &st ) != 0 || ( S_ISDIR( st.st_mode ) == false && S_ISREG( st.st_mode ) == false ) )
+                {
+                    continue;
+                }
+                
+                if( S_ISDIR( st.st_mode ) && this->_directories.insert( { st.st_dev, st.st_ino } ).second == false )
+                {
+                    continue;
+                }
+                
+                if( static_cast< uint64_t >( st.st_size ) > std::numeric_limits< uint32_t >::max() )
+                {
+                    throw std::runtime_error( "File too large for a FAT volume: " + node.path );
+                }
+                
+                node.name      = shortName( name, used );
+                node.directory = S_ISDIR( st.st_mode );
+                node.size      = ( node.directory ) ? 0 : static_cast< uint32_t >( st.st_size );
+                node.time      = st.st_mtime;
+                node.parent    = index;
+                node.cluster   = 0;
+                node.clusters  = 0;
+                
+                used.push_back( node.name );
+                this->_nodes.push_back( node );
+                this->_nodes[ index ].children.push_back( this->_nodes.size() - 1 );
+                
+                if( node.directory )
+                {
+                    this->_scan( this->_nodes.size() - 1 );
+                }
+            }
+        }
+        
+        uint32_t VirtualImageReader::IMPL::_clustersFor( const Node & node, uint32_t clusterSize ) const
+        {
+            uint64_t size( ( node.directory ) ? ( node.children.size() + 2 ) * 32 : node.size );
+            
+            return numeric_cast< uint32_t >( ( size + clusterSize - 1 ) / clusterSize );
+        }
+        
+        void VirtualImageReader::IMPL::_layout( void )
+        {
+            uint64_t needed( 0 );
+            uint32_t clusters;
+            uint32_t rootSectors;
+            uint32_t next( 2 );
+            
+            for( size_t i = 1; i < this->_nodes.size(); i++ )
+            {
+                needed += this->_clustersFor( this->_nodes[ i ], bytesPerSector );
+            }
+            
+            if( needed <= 2847 && this->_nodes[ 0 ].children.size() <= 224 )
+            {
+                this->_fat12             = true;
+                this->_sectorsPerCluster = 1;
+                this->_reservedSectors   = 1;
+                this->_rootEntries       = 224;
+                this->_sectorsPerFAT     = 9;
+                this->_totalSectors      = 2880;
+            }
+            else
+            {
+                this->_fat12           = false;
+                this->_reservedSectors = 1;
+                this->_rootEntries     = numeric_cast< uint32_t >( std::max< size_t >( 512, ( ( this->_nodes[ 0 ].children.size() + 15 ) / 16 ) * 16 ) );
+                
+                if( this->_rootEntries > std::numeric_limits< uint16_t >::max() )
+                {
+                    throw std::runtime_error( "Too many entries in root directory: " + this->_nodes[ 0 ].path );
+                }
+                
+                for( this->_sectorsPerCluster = 4; this->_sectorsPerCluster <= 128; this->_sectorsPerCluster *= 2 )
+                {
+                    needed = 0;
+                    
+                    for( size_t i = 1; i < this->_nodes.size(); i++ )
+                    {
+                        needed += this->_clustersFor( this->_nodes[ i ], this->_sectorsPerCluster * bytesPerSector );
+                    }
+                    
+                    if( needed <= 65524 )
+                    {
+                        break;
+                    }
+                }
+                
+                if( this->_sectorsPerCluster > 128 )
+                {
+                    throw std::runtime_error( "Directory too large for a FAT16 volume: " + this->_nodes[ 0 ].path );
+                }
+                
+                clusters             = numeric_cast< uint32_t >( std::max< uint64_t >( needed, 4085 ) );
+                rootSectors          = ( this->_rootEntries * 32 ) / bytesPerSector;
+                this->_sectorsPerFAT = ( ( ( clusters + 2 ) * 2 ) + bytesPerSector - 1 ) / bytesPerSector;
+                this->_totalSectors  = this->_reservedSectors
+                                     + ( numberOfFATs * this->_sectorsPerFAT )
+                                     + rootSectors
+                                     + ( clusters * this->_sectorsPerCluster );
+            }
+            
+            this->_fatOffset  = static_cast< uint64_t >( this->_reservedSectors ) * bytesPerSector;
+            this->_rootOffset = this->_fatOffset  + ( static_cast< uint64_t >( numberOfFATs * this->_sectorsPerFAT ) * bytesPerSector );
+            this->_dataOffset = this->_rootOffset + ( static_cast< uint64_t >( this->_rootEntries ) * 32 );
+            
+            for( size_t i = 1; i < this->_nodes.size(); i++ )
+            {
+                Node & node( this->_nodes[ i ] );
+                
+                node.clusters = this->_clustersFor( node, this->_sectorsPerCluster * bytesPerSector );
+                
+                if( node.clusters == 0 )
+                {
+                    continue;
+                }
+                
+                node.cluster = next;
+                next        += node.clusters;
+                
+                this->_extents.push_back( i );
+            }
+        }
+        
+        void VirtualImageReader::IMPL::_synthesizeBootSector( const std::string & directory, const std::string & bootSector )
+        {
+            uint32_t    heads( ( this->_fat12 ) ? 2  : ( ( this->_totalSectors > 1024 * 16 * 63 ) ? 255 : 16 ) );
+            uint32_t    sectors( ( this->_fat12 ) ? 18 : 63 );
+            uint32_t    serial( static_cast< uint32_t >( std::hash< std::string >()( directory ) ) );
+            std::string oemID( "UNICORN " );
+            std::string label( "NO NAME    " );
+            std::string fileSystem( ( this->_fat12 ) ? "FAT12   " : "FAT16   " );
+            
+            auto write = [ & ]( size_t offset, uint32_t value, size_t bytes )
+            {
+                for( size_t i = 0; i < bytes; i++ )
+                {
+                    this->_bootSector[ offset + i ] = static_cast< uint8_t >( ( value >> ( i * 8 ) ) & 0xFF );
+                }
+            };
+            
+            this->_bootSector = std::vector< uint8_t >( bytesPerSector, 0 );
+            
+            if( bootSector.length() > 0 )
+            {
+                BinaryFileStream       stream( bootSector );
+                std::vector< uint8_t > code( stream.readAll() );
+                
+                if( code.size() < 3 || code.size() > bytesPerSector )
+                {
+                    throw std::runtime_error( "Invalid boot sector: " + bootSector );
+                }
+                
+                memcpy( this->_bootSector.data(), code.data(), 3 );
+                
+                if( code.size() > 62 )
+                {
+                    memcpy( this->_bootSector.data() + 62, code.data() + 62, std::min< size_t >( code.size(), 510 ) - 62 );
+                }
+            }
+            else
+            {
+                const uint8_t jmp[]  = { 0xEB, 0x3C, 0x90 };
+                const uint8_t halt[] = { 0xFA, 0xF4, 0xEB, 0xFD };
+                
+                memcpy( this->_bootSector.data(),      jmp,  sizeof( jmp ) );
+                memcpy( this->_bootSector.data() + 62, halt, sizeof( halt ) );
+            }
+            
+            memcpy( this->_bootSector.data() + 3,  oemID.data(),      oemID.size() );
+            memcpy( this->_bootSector.data() + 43, label.data(),      label.size() );
+            memcpy( this->_bootSector.data() + 54, fileSystem.data(), fileSystem.size() );
+            
+            write( 11,  bytesPerSector,                                             2 );
+            write( 13,  this->_sectorsPerCluster,                                   1 );
+            write( 14,  this->_reservedSectors,                                     2 );
+            write( 16,  numberOfFATs,                                               1 );
+            write( 17,  this->_rootEntries,                                         2 );
+            write( 19,  ( this->_totalSectors > 0xFFFF ) ? 0 : this->_totalSectors, 2 );
+            write( 21,  ( this->_fat12 ) ? 0xF0 : 0xF8,                             1 );
+            write( 22,  this->_sectorsPerFAT,                                       2 );
+            write( 24,  sectors,                                                    2 );
+            write( 26,  heads,                                                      2 );
+            write( 28,  0,                                                          4 );
+            write( 32,  ( this->_totalSectors > 0xFFFF ) ? this->_totalSectors : 0, 4 );
+            write( 36,  ( this->_fat12 ) ? 0x00 : 0x80,                             1 );
+            write( 37,  0,                                                          1 );
+            write( 38,  0x29,                                                       1 );
+            write( 39,  serial,                                                     4 );
+            write( 510, 0xAA55,                                                     2 );
+        }
+        
+        uint32_t VirtualImageReader::IMPL::_fatEntry( uint32_t cluster ) const
+        {
+            uint32_t     eoc( ( this->_fat12 ) ? 0xFFF : 0xFFFF );
+            const Node * node;
+            
+            if( cluster == 0 )
+            {
+                return ( eoc & ~0xFFu ) | ( ( this->_fat12 ) ? 0xF0 : 0xF8 );
+            }
+            
+            if( cluster == 1 )
+            {
+                return eoc;
+            }
+            
+            node = this->_nodeForCluster( cluster );
+            
+            if( node == nullptr )
+            {
+                return 0;
+            }
+            
+            return ( cluster + 1 < node->cluster + node->clusters ) ? cluster + 1 : eoc;
+        }
+        
+        uint8_t VirtualImageReader::IMPL::_fatByte( uint64_t offset ) const
+        {
+            if( this->_fat12 )
+            {
+                uint32_t cluster( numeric_cast< uint32_t >( ( offset / 3 ) * 2 ) );
+                
+                switch( offset % 3 )
+                {
+                    case 0:  return static_cast< uint8_t >( this->_fatEntry( cluster ) & 0xFF );
+                    case 1:  return static_cast< uint8_t >( ( ( this->_fatEntry( cluster ) >> 8 ) & 0x0F ) | ( ( this->_fatEntry( cluster + 1 ) & 0x0F ) << 4 ) );
+                    default: return static_cast< uint8_t >( ( this->_fatEntry( cluster + 1 ) >> 4 ) & 0xFF );
+                }
+            }
+            
+            return static_cast< uint8_t >( ( this->_fatEntry( numeric_cast< uint32_t >( offset / 2 ) ) >> ( ( offset % 2 ) * 8 ) ) & 0xFF );
+        }
+        
+        const VirtualImageReader::IMPL::Node * VirtualImageReader::IMPL::_nodeForCluster( uint32_t cluster ) const
+        {
+            auto it
+            (
+                std::upper_bound
+                (
+                    this->_extents.begin(),
+                    this->_extents.end(),
+                    cluster,
+                    [ & ]( uint32_t c, size_t index ) { return c < this->_nodes[ index ].cluster; }
+                )
+            );
+            
+            if( it == this->_extents.begin() )
+            {
+                return nullptr;
+            }
+            
+            {
+                const Node & node( this->_nodes[ *( --it ) ] );
+                
+                return ( cluster < node.cluster + node.clusters ) ? &node : nullptr;
+            }
+        }
+        
+        const std::vector< uint8_t > & VirtualImageReader::IMPL::_entries( size_t index )
+        {
+            Node & node( this->_nodes[ index ] );
+            
+            if( node.entries.size() > 0 || ( index == 0 && node.children.size() == 0 ) )
+            {
+                return node.entries;
+            }
+            
+            if( index != 0 )
+            {
+                std::array< uint8_t, 11 > dot;
+                std::array< uint8_t, 11 > dotDot;
+                
+                dot.fill( ' ' );
+                dotDot.fill( ' ' );
+                
+                dot[ 0 ]    = '.';
+                dotDot[ 0 ] = '.';
+                dotDot[ 1 ] = '.';
+                
+                node.entries.resize( 64, 0 );
+                
+                writeEntry( node.entries.data(),      dot,    node, node.cluster );
+                writeEntry( node.entries.data() + 32, dotDot, node, ( node.parent == 0 ) ? 0 : this->_nodes[ node.parent ].cluster );
+            }
+            
+            for( size_t child: node.children )
+            {
+                const Node & c( this->_nodes[ child ] );
+                
+                node.entries.resize( node.entries.size() + 32, 0 );
+                writeEntry( node.entries.data() + node.entries.size() - 32, c.name, c, c.cluster );
+            }
+            
+            return node.entries;
+        }
+        
+        void VirtualImageReader::IMPL::_readFile( size_t index, uint64_t offset, uint8_t * buf, size_t size )
+        {
+            const Node & node( this->_nodes[ index ] );
+            size_t       available( 0 );
+            
+            if( this->_fileIndex != index )
+            {
+                if( this->_file.is_open() )
+                {
+                    this->_file.close();
+                }
+                
+                this->_file.open( node.path, std::ios::binary | std::ios::in );
+                
+                this->_fileIndex = index;
+            }
+            
+            if( this->_file.good() == false )
+            {
+                this->_file.close();
+                
+                this->_fileIndex = std::numeric_limits< size_t >::max();
+                
+                throw std::runtime_error( "Cannot read file: " + node.path );
+            }
+            
+            if( offset < node.size )
+            {
+                this->_file.seekg( numeric_cast< std::streamoff >( offset ), std::ios_base::beg );
+                this->_file.read( reinterpret_cast< char * >( buf ), numeric_cast< std::streamsize >( std::min< uint64_t >( size, node.size - offset ) ) );
+                
+                available = numeric_cast< size_t >( this->_file.gcount() );
+                
+                this->_file.clear();
+            }
+            
+            memset( buf + available, 0, size - available );
+        }
+        
+        std::array< uint8_t, 11 > VirtualImageReader::IMPL::shortName( const std::string & name, const std::vector< std::array< uint8_t, 11 > > & used )
+        {
+            std::string               base;
+            std::string               ext;
+            bool                      lossy( false );
+            std::array< uint8_t, 11 > shortName;
+            
+            {
+                size_t pos( name.rfind( '.' ) );
+                
+                base = String::toUpper( ( pos == std::string::npos ) ? name : name.substr( 0, pos ) );
+                ext  = String::toUpper( ( pos == std::string::npos ) ? ""   : name.substr( pos + 1 ) );
+            }
+            
+            for( std::string * s: { &base, &ext } )
+            {
+                std::string sanitized;
+                
+                for( char c: *( s ) )
+                {
+                    if( c == ' ' || c == '.' )
+                    {
+                        lossy = true;
+                    }
+                    else if( isalnum( static_cast< unsigned char >( c ) ) || strchr( "!#$%&'()-@^_`{}~", c ) != nullptr )
+                    {
+                        sanitized += c;
+                    }
+                    else
+                    {
+                        sanitized += '_';
+                        lossy      = true;
+                    }
+                }
+                
+                *( s ) = sanitized;
+            }
+            
+            if( base.length() > 8 || ext.length() > 3 )
+            {
+                lossy = true;
+            }
+            
+            base = base.substr( 0, 8 );
+            ext  = ext.substr( 0, 3 );
+            
+            for( unsigned int i = 0; i < 1000000; i++ )
+            {
+                std::string b( base );
+                
+                if( i > 0 || lossy || base.length() == 0 )
+                {
+                    std::string tail( "~" + std::to_string( std::max( i, 1u ) ) );
+                    
+                    b = base.substr( 0, 8 - tail.length() ) + tail;
+                }
+                
+                shortName.fill( ' ' );
+                memcpy( shortName.data(),     b.data(),   b.length() );
+                memcpy( shortName.data() + 8, ext.data(), ext.length() );
+                
+                if( shortName[ 0 ] == 0xE5 )
+                {
+                    shortName[ 0 ] = 0x05;
+                }
+                
+                if( std::find( used.begin(), used.end(), shortName ) == used.end() )
+                {
+                    return shortName;
+                }
+            }
+            
+            throw std::runtime_error( "Cannot generate a short name for: " + name );
+        }
+        
+        void VirtualImageReader::IMPL::writeEntry( uint8_t * entry, const std::array< uint8_t, 11 > & name, const Node & node, uint32_t cluster )
+        {
+            struct tm t;
+            uint16_t  date( ( 1 << 5 ) | 1 );
+            uint16_t  time( 0 );
+            
+            auto write = [ & ]( size_t offset, uint32_t value, size_t bytes )
+            {
+                for( size_t i = 0; i < bytes; i++ )
+                {
+                    entry[ offset + i ] = static_cast< uint8_t >( ( value >> ( i * 8 ) ) & 0xFF );
+                }
+            };
+            
+            if( localtime_r( &( node.time ), &t ) != nullptr && t.tm_year >= 80 )
+            {
+                date = static_cast< uint16_t >( ( ( t.tm_year - 80 ) << 9 ) | ( ( t.tm_mon + 1 ) << 5 ) | t.tm_mday );
+                time = static_cast< uint16_t >( ( t.tm_hour << 11 ) | ( t.tm_min << 5 ) | ( t.tm_sec / 2 ) );
+            }
+            
+            memcpy( entry, name.data(), name.size() );
+            
+            write( 11, ( node.directory ) ? 0x10 : 0x20, 1 );
+            write( 14, time,                             2 );
+            write( 16, date,                             2 );
+            write( 18, date,                             2 );
+            write( 22, time,                             2 );
+            write( 24, date,                             2 );
+            write( 26, cluster,                          2 );
+            write( 28, node.size,                        4 );
+        }
+    }
+}
@@ -0,0 +1,248 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/InterruptTable.hpp"
+#include "UB/RegisterFrame.hpp"
+#include "UB/String.hpp"
+#include <array>
+#include <mutex>
+#include <stdexcept>
+
+namespace UB
+{
+    class InterruptTable::IMPL
+    {
+        public:
+            
+            struct Function
+            {
+                Handler                                       handler;
+                std::unique_ptr< std::array< Handler, 256 > > subfunctions;
+            };
+            
+            struct Vector
+            {
+                Handler                                        handler;
+                std::unique_ptr< std::array< Function, 256 > > functions;
+            };
+            
+            static std::string name( uint8_t vector );
+            static std::string name( uint8_t vector, uint8_t ah );
+            static std::string name( uint8_t vector, uint8_t ah, uint8_t al );
+            
+            Function & _function( uint8_t vector, uint8_t ah );
+            Handler  & _subfunction( uint8_t vector, uint8_t ah, uint8_t al );
+            
+            std::array< Vector, 256 > _vectors;
+            mutable std::mutex        _mtx;
+    };
+    
+    InterruptTable::InterruptTable( void ):
+        impl( std::make_unique< IMPL >() )
+    {}
+    
+    InterruptTable::~InterruptTable( void )
+    {}
+    
+    void InterruptTable::add( uint8_t vector, const Handler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        
+        if( this->impl->_vectors[ vector ].handler != nullptr )
+        {
+            throw std::runtime_error( "Interrupt handler already registered for " + IMPL::name( vector ) );
+        }
+        
+        this->impl->_vectors[ vector ].handler = handler;
+    }
+    
+    void InterruptTable::add( uint8_t vector, uint8_t ah, const Handler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        IMPL::Function              & function( this->impl->_function( vector, ah ) );
+        
+        if( function.handler != nullptr )
+        {
+            throw std::runtime_error( "Interrupt handler already registered for " + IMPL::name( vector, ah ) );
+        }
+        
+        function.handler = handler;
+    }
+    
+    void InterruptTable::add( uint8_t vector, uint8_t ah, uint8_t al, const Handler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        Handler                     & subfunction( this->impl->_subfunction( vector, ah, al ) );
+        
+        if( subfunction != nullptr )
+        {
+            throw std::runtime_error( "Interrupt handler already registered for " + IMPL::name( vector, ah, al ) );
+        }
+        
+        subfunction = handler;
+    }
+    
+    InterruptTable::Handler InterruptTable::replace( uint8_t vector, const Handler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        Handler                       previous( this->impl->_vectors[ vector ].handler );
+        
+        this->impl->_vectors[ vector ].handler = handler;
+        
+        return previous;
+    }
+    
+    InterruptTable::Handler InterruptTable::replace( uint8_t vector, uint8_t ah, const Handler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        IMPL::Function              & function( this->impl->_function( vector, ah ) );
+        Handler                       previous( function.handler );
+        
+        function.handler = handler;
+        
+        return previous;
+    }
+    
+    InterruptTable::Handler InterruptTable::replace( uint8_t vector, uint8_t ah, uint8_t al, const Handler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        Handler                     & subfunction( this->impl->_subfunction( vector, ah, al ) );
+        Handler                       previous( subfunction );
+        
+        subfunction = handler;
+        
+        return previous;
+    }
+    
+    void InterruptTable::chain( uint8_t vector, const ChainedHandler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        Handler                       previous( this->impl->_vectors[ vector ].handler );
+        
+        this->impl->_vectors[ vector ].handler = [ = ]( const Machine & machine, Engine & engine, RegisterFrame & frame ) -> bool
+        {
+            return handler( machine, engine, frame, previous );
+        };
+    }
+    
+    void InterruptTable::chain( uint8_t vector, uint8_t ah, const ChainedHandler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        IMPL::Function              & function( this->impl->_function( vector, ah ) );
+        Handler                       previous( function.handler );
+        
+        function.handler = [ = ]( const Machine & machine, Engine & engine, RegisterFrame & frame ) -> bool
+        {
+            return handler( machine, engine, frame, previous );
+        };
+    }
+    
+    void InterruptTable::chain( uint8_t vector, uint8_t ah, uint8_t al, const ChainedHandler & handler )
+    {
+        std::lock_guard< std::mutex > l( this->impl->_mtx );
+        Handler                     & subfunction( this->impl->_subfunction( vector, ah, al ) );
+        Handler                       previous( subfunction );
+        
+        subfunction = [ = ]( const Machine & machine, Engine & engine, RegisterFrame & frame ) -> bool
+        {
+            return handler( machine, engine, frame, previous );
+        };
+    }
+    
+    bool InterruptTable::dispatch( uint8_t vector, const Machine & machine, Engine & engine, RegisterFrame & frame ) const
+    {
+        uint16_t ax( frame.ax() );
+        uint8_t  ah( static_cast< uint8_t >( ax >> 8 ) );
+        uint8_t  al( static_cast< uint8_t >( ax & 0xFF ) );
+        Handler  handlers[ 3 ];
+        
+        {
+            std::lock_guard< std::mutex > l( this->impl->_mtx );
+            const IMPL::Vector          & v( this->impl->_vectors[ vector ] );
+            
+            if( v.functions != nullptr )
+            {
+                const IMPL::Function & function( ( *( v.functions ) )[ ah ] );
+                
+                if( function.subfunctions != nullptr )
+                {
+                    handlers[ 0 ] = ( *( function.subfunctions ) )[ al ];
+                }
+                
+                handlers[ 1 ] = function.handler;
+            }
+            
+            handlers[ 2 ] = v.handler;
+        }
+        
+        for( const auto & handler: handlers )
+        {
+            if( handler != nullptr && handler( machine, engine, frame ) )
+            {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+    
+    std::string InterruptTable::IMPL::name( uint8_t vector )
+    {
+        return "INT " + String::toHex( vector );
+    }
+    
+    std::string InterruptTable::IMPL::name( uint8_t vector, uint8_t ah )
+    {
+        return name( vector ) + " AH=" + String::toHex( ah );
+    }
+    
+    std::string InterruptTable::IMPL::name( uint8_t vector, uint8_t ah, uint8_t al )
+    {
+        return name( vector, ah ) + " AL=" + String::toHex( al );
+    }
+    
+    InterruptTable::IMPL::Function & InterruptTable::IMPL::_function( uint8_t vector, uint8_t ah )
+    {
+        Vector & v( this->_vectors[ vector ] );
+        
+        if( v.functions == nullptr )
+        {
+            v.functions = std::make_unique< std::array< Function, 256 > >();
+        }
+        
+        return ( *( v.functions ) )[ ah ];
+    }
+    
+    InterruptTable::Handler & InterruptTable::IMPL::_subfunction( uint8_t vector, uint8_t ah, uint8_t al )
+    {
+        Function & function( this->_function( vector, ah ) );
+        
+        if( function.subfunctions == nullptr )
+        {
+            function.subfunctions = std::make_unique< std::array< Handler, 256 > >();
+        }
+        
+        return ( *( function.subfunctions ) )[ al ];
+    }
+}
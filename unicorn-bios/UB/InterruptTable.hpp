@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_INTERRUPT_TABLE_HPP
+#define UB_INTERRUPT_TABLE_HPP
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace UB
+{
+    class Engine;
+    class Machine;
+    class RegisterFrame;
+    
+    class InterruptTable
+    {
+        public:
+            
+            using Handler        = std::function< bool( const Machine &, Engine &, RegisterFrame & ) >;
+            using ChainedHandler = std::function< bool( const Machine &, Engine &, RegisterFrame &, const Handler & ) >;
+            
+            InterruptTable( void );
+            ~InterruptTable( void );
+            
+            InterruptTable( const InterruptTable & o )              = delete;
+            InterruptTable( InterruptTable && o )                   = delete;
+            InterruptTable & operator =( const InterruptTable & o ) = delete;
+            InterruptTable & operator =( InterruptTable && o )      = delete;
+            
+            void add( uint8_t vector,                         const Handler & handler );
+            void add( uint8_t vector, uint8_t ah,             const Handler & handler );
+            void add( uint8_t vector, uint8_t ah, uint8_t al, const Handler & handler );
+            
+            Handler replace( uint8_t vector,                         const Handler & handler );
+            Handler replace( uint8_t vector, uint8_t ah,             const Handler & handler );
+            Handler replace( uint8_t vector, uint8_t ah, uint8_t al, const Handler & handler );
+            
+            void chain( uint8_t vector,                         const ChainedHandler & handler );
+            void chain( uint8_t vector, uint8_t ah,             const ChainedHandler & handler );
+            void chain( uint8_t vector, uint8_t ah, uint8_t al, const ChainedHandler & handler );
+            
+            bool dispatch( uint8_t vector, const Machine & machine, Engine & engine, RegisterFrame & frame ) const;
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_INTERRUPT_TABLE_HPP */
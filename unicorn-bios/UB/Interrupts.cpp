@@ -23,145 +23,82 @@
  ******************************************************************************/
 
 #include "UB/Interrupts.hpp"
+#include "UB/InterruptTable.hpp"
 #include "UB/Engine.hpp"
 #include "UB/Machine.hpp"
 #include "UB/BIOS/Video.hpp"
 #include "UB/BIOS/Disk.hpp"
 #include "UB/BIOS/Keyboard.hpp"
 #include "UB/BIOS/SystemServices.hpp"
+#include "UB/BIOS/Timer.hpp"
+#include "UB/BIOS/Serial.hpp"
 
 namespace UB
 {
     namespace Interrupts
     {
-        bool int0x05( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
-            ( void )engine;
-            
-            return false;
-        }
+        static bool stop( const Machine & machine, Engine & engine, RegisterFrame & frame );
         
-        bool int0x10( const Machine & machine, Engine & engine )
+        void registerServices( InterruptTable & table )
         {
-            switch( engine.ah() )
-            {
-                case 0x00: return BIOS::Video::setVideoMode( machine, engine );
-                case 0x02: return BIOS::Video::setCursorPosition( machine, engine );
-                case 0x09: return BIOS::Video::writeCharacterAndAttributeAtCursor( machine, engine );
-                case 0x0A: return BIOS::Video::writeCharacterOnlyAtCursor( machine, engine );
-                case 0x0E: return BIOS::Video::ttyOutput( machine, engine );
-                case 0x10: return BIOS::Video::palette( machine, engine );
-                
-                case 0x4F:
-                    
-                    switch( engine.al() )
-                    {
-                        case 0x00: return BIOS::Video::getVBEControllerInfo( machine, engine );
-                        default:   break;
-                    }
-                    
-                default: break;
-            }
+            table.add( 0x08, BIOS::Timer::tick );
             
-            return false;
-        }
-        
-        bool int0x11( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
-            ( void )engine;
+            table.add( 0x10, 0x00,       BIOS::Video::setVideoMode );
+            table.add( 0x10, 0x01,       BIOS::Video::setCursorShape );
+            table.add( 0x10, 0x02,       BIOS::Video::setCursorPosition );
+            table.add( 0x10, 0x03,       BIOS::Video::getCursorPosition );
+            table.add( 0x10, 0x06,       BIOS::Video::scrollUp );
+            table.add( 0x10, 0x07,       BIOS::Video::scrollDown );
+            table.add( 0x10, 0x08,       BIOS::Video::readCharacterAndAttributeAtCursor );
+            table.add( 0x10, 0x09,       BIOS::Video::writeCharacterAndAttributeAtCursor );
+            table.add( 0x10, 0x0A,       BIOS::Video::writeCharacterOnlyAtCursor );
+            table.add( 0x10, 0x0E,       BIOS::Video::ttyOutput );
+            table.add( 0x10, 0x0F,       BIOS::Video::getVideoMode );
+            table.add( 0x10, 0x10,       BIOS::Video::palette );
+            table.add( 0x10, 0x4F, 0x00, BIOS::Video::getVBEControllerInfo );
+            table.add( 0x10, 0x4F, 0x01, BIOS::Video::getVBEModeInfo );
+            table.add( 0x10, 0x4F, 0x02, BIOS::Video::setVBEMode );
+            table.add( 0x10, 0x4F, 0x03, BIOS::Video::getVBEMode );
             
-            return false;
-        }
-        
-        bool int0x12( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
-            ( void )engine;
+            table.add( 0x13, 0x00, BIOS::Disk::reset );
+            table.add( 0x13, 0x02, BIOS::Disk::readSectors );
+            table.add( 0x13, 0x08, BIOS::Disk::getDriveParameters );
+            table.add( 0x13, 0x15, BIOS::Disk::getDiskType );
+            table.add( 0x13, 0x41, BIOS::Disk::checkExtensions );
+            table.add( 0x13, 0x42, BIOS::Disk::extendedReadSectors );
+            table.add( 0x13, 0x48, BIOS::Disk::extendedGetDriveParameters );
             
-            return false;
-        }
-        
-        bool int0x13( const Machine & machine, Engine & engine )
-        {
-            switch( engine.ah() )
-            {
-                case 0x00: return BIOS::Disk::reset( machine, engine );
-                case 0x02: return BIOS::Disk::readSectors( machine, engine );
-                case 0x41: return BIOS::Disk::checkExtensions( machine, engine );
-                case 0x42: return BIOS::Disk::extendedReadSectors( machine, engine );
-                default:   break;
-            }
+            table.add( 0x14, 0x00, BIOS::Serial::initialize );
+            table.add( 0x14, 0x01, BIOS::Serial::send );
+            table.add( 0x14, 0x02, BIOS::Serial::receive );
+            table.add( 0x14, 0x03, BIOS::Serial::status );
             
-            return false;
-        }
-        
-        bool int0x14( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
-            ( void )engine;
+            table.add( 0x15, 0xE8, 0x20, BIOS::SystemServices::getMemoryMap );
+            table.add( 0x15, 0xEC, 0x00, BIOS::SystemServices::enterLongMode );
             
-            return false;
-        }
-        
-        bool int0x15( const Machine & machine, Engine & engine )
-        {
-            switch( engine.ax() )
-            {
-                case 0xE820: return BIOS::SystemServices::getMemoryMap( machine, engine );
-                case 0xEC00: return BIOS::SystemServices::enterLongMode( machine, engine );
-                default:     break;
-            }
+            table.add( 0x16, 0x00, BIOS::Keyboard::readKey );
+            table.add( 0x16, 0x01, BIOS::Keyboard::checkKey );
+            table.add( 0x16, 0x02, BIOS::Keyboard::getShiftFlags );
+            table.add( 0x16, 0x10, BIOS::Keyboard::readExtendedKey );
+            table.add( 0x16, 0x11, BIOS::Keyboard::checkExtendedKey );
             
-            return false;
-        }
-        
-        bool int0x16( const Machine & machine, Engine & engine )
-        {
-            switch( engine.ah() )
-            {
-                case 0x00: return BIOS::Keyboard::readKey( machine, engine );
-                default:   break;
-            }
-            
-            return false;
-        }
-        
-        bool int0x17( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
-            ( void )engine;
-            
-            return false;
-        }
-        
-        bool int0x18( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
+            table.add( 0x18, stop );
+            table.add( 0x19, stop );
             
-            machine.ui().debug() << "Stopping emulation" << std::endl;
-            engine.stop();
-            
-            return true;
+            table.add( 0x1A, 0x00, BIOS::Timer::getSystemTime );
+            table.add( 0x1A, 0x01, BIOS::Timer::setSystemTime );
+            table.add( 0x1A, 0x02, BIOS::Timer::getRTCTime );
+            table.add( 0x1A, 0x04, BIOS::Timer::getRTCDate );
         }
         
-        bool int0x19( const Machine & machine, Engine & engine )
+        static bool stop( const Machine & machine, Engine & engine, RegisterFrame & frame )
         {
-            ( void )machine;
+            ( void )frame;
             
             machine.ui().debug() << "Stopping emulation" << std::endl;
             engine.stop();
             
             return true;
         }
-        
-        bool int0x1A( const Machine & machine, Engine & engine )
-        {
-            ( void )machine;
-            ( void )engine;
-            
-            return false;
-        }
     }
 }
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/KeyboardQueue.hpp"
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+
+namespace UB
+{
+    class KeyboardQueue::IMPL
+    {
+        public:
+            
+            IMPL( size_t capacity );
+            ~IMPL( void );
+            
+            std::vector< uint16_t > _keys;
+            std::atomic< size_t >   _head;
+            std::atomic< size_t >   _tail;
+    };
+    
+    KeyboardQueue::KeyboardQueue( size_t capacity ):
+        impl( std::make_unique< IMPL >( capacity ) )
+    {}
+    
+    KeyboardQueue::~KeyboardQueue( void )
+    {}
+    
+    size_t KeyboardQueue::capacity( void ) const
+    {
+        return this->impl->_keys.size() - 1;
+    }
+    
+    size_t KeyboardQueue::size( void ) const
+    {
+        size_t head( this->impl->_head.load( std::memory_order_acquire ) );
+        size_t tail( this->impl->_tail.load( std::memory_order_acquire ) );
+        
+        return ( tail + this->impl->_keys.size() - head ) % this->impl->_keys.size();
+    }
+    
+    bool KeyboardQueue::empty( void ) const
+    {
+        return this->impl->_head.load( std::memory_order_acquire ) == this->impl->_tail.load( std::memory_order_acquire );
+    }
+    
+    bool KeyboardQueue::push( uint16_t key )
+    {
+        size_t tail( this->impl->_tail.load( std::memory_order_relaxed ) );
+        size_t next( ( tail + 1 ) % this->impl->_keys.size() );
+        
+        if( next == this->impl->_head.load( std::memory_order_acquire ) )
+        {
+            return false;
+        }
+        
+        this->impl->_keys[ tail ] = key;
+        
+        this->impl->_tail.store( next, std::memory_order_release );
+        
+        return true;
+    }
+    
+    bool KeyboardQueue::peek( uint16_t & key ) const
+    {
+        size_t head( this->impl->_head.load( std::memory_order_relaxed ) );
+        
+        if( head == this->impl->_tail.load( std::memory_order_acquire ) )
+        {
+            return false;
+        }
+        
+        key = this->impl->_keys[ head ];
+        
+        return true;
+    }
+    
+    bool KeyboardQueue::pop( uint16_t & key )
+    {
+        size_t head( this->impl->_head.load( std::memory_order_relaxed ) );
+        
+        if( head == this->impl->_tail.load( std::memory_order_acquire ) )
+        {
+            return false;
+        }
+        
+        key = this->impl->_keys[ head ];
+        
+        this->impl->_head.store( ( head + 1 ) % this->impl->_keys.size(), std::memory_order_release );
+        
+        return true;
+    }
+    
+    KeyboardQueue::IMPL::IMPL( size_t capacity ):
+        _keys( capacity + 1, 0 ),
+        _head( 0 ),
+        _tail( 0 )
+    {
+        if( capacity == 0 )
+        {
+            throw std::runtime_error( "Invalid keyboard queue capacity" );
+        }
+    }
+    
+    KeyboardQueue::IMPL::~IMPL( void )
+    {}
+}
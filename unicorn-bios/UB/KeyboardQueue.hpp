@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_KEYBOARD_QUEUE_HPP
+#define UB_KEYBOARD_QUEUE_HPP
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace UB
+{
+    class KeyboardQueue
+    {
+        public:
+            
+            static const size_t defaultCapacity = 256;
+            
+            KeyboardQueue( size_t capacity = defaultCapacity );
+            ~KeyboardQueue( void );
+            
+            KeyboardQueue( const KeyboardQueue & o )              = delete;
+            KeyboardQueue( KeyboardQueue && o )                   = delete;
+            KeyboardQueue & operator =( const KeyboardQueue & o ) = delete;
+            KeyboardQueue & operator =( KeyboardQueue && o )      = delete;
+            
+            size_t capacity( void ) const;
+            size_t size( void )     const;
+            bool   empty( void )    const;
+            
+            bool push( uint16_t key );
+            bool peek( uint16_t & key ) const;
+            bool pop( uint16_t & key );
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_KEYBOARD_QUEUE_HPP */
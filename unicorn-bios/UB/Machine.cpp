@@ -27,13 +27,44 @@
 #include "UB/Screen.hpp"
 #include "UB/Interrupts.hpp"
 #include "UB/FAT/MBR.hpp"
+#include "UB/FAT/FileSystem.hpp"
 #include "UB/String.hpp"
-#include "UB/CPU/Functions.hpp"
+#include "UB/Devices/PIC.hpp"
+#include "UB/Devices/PIT.hpp"
+#include "UB/Devices/CMOS.hpp"
+#include "UB/Devices/SystemControl.hpp"
+#include "UB/Devices/POST.hpp"
+#include "UB/Devices/UART.hpp"
+#include "UB/Devices/APIC.hpp"
+#include "UB/Devices/VGA.hpp"
+#include "UB/Devices/VBE.hpp"
+#include "UB/AsyncWriter.hpp"
+#include "UB/VirtualClock.hpp"
+#include "UB/KeyboardQueue.hpp"
+#include "UB/BIOS/Keyboard.hpp"
+#include "UB/BIOS/Video.hpp"
+#include "UB/Signal.hpp"
+#include "UB/StateFile.hpp"
+#include "UB/BinaryDataStream.hpp"
 #include <sstream>
+#include <map>
 #include <atomic>
 #include <csignal>
 #include <vector>
 #include <iostream>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <cstring>
+#include <iomanip>
+#include <cstdio>
+#include <poll.h>
+#include <unistd.h>
 
 namespace UB
 {
@@ -47,21 +78,104 @@ namespace UB
             
             static size_t memorySizeOrDefault( size_t memory );
             
+            static const uint16_t romSegment = 0xF000;
+            static const uint16_t romStubs   = 0xFD00;
+            
+            static const uint64_t idleQuantum = 10000000;
+            static const uint64_t idleBudget  = 30000000000;
+            static const uint64_t keyQuantum  = 1000000;
+            
+            static const time_t epoch = 946684800;
+            
             void _setup( const Machine & machine );
             void _break( const std::string & message = "" );
+            void _updateBDA( void );
+            void _setupIVT( void );
+            void _setupDevices( void );
+            void _updateTicks( void );
+            bool _isNative( uint8_t i, uint16_t & segment, uint16_t & offset );
+            bool _dispatch( const Machine & machine, uint8_t i, RegisterFrame & frame );
+            void _deliver( RegisterFrame & frame, uint16_t ip, uint16_t segment, uint16_t offset );
+            void _interruptRequest( const Machine & machine, uint64_t address );
+            void _poll( const Machine & machine, uint64_t address );
+            bool _idle( bool halted );
+            void _wake( void );
+            void _stop( const std::string & reason );
+            void _updateTrace( void );
+            bool _pollKeys( void );
+            void _readInput( void );
+            bool _dumpFramebuffer( const std::string & path );
+            void _saveState( const std::string & path, std::map< std::string, std::vector< uint8_t > > sections );
+            void _updateFramebuffer( void );
+            
+            std::map< std::string, std::vector< uint8_t > > _deviceState( void ) const;
+            void                                            _deviceState( const std::map< std::string, std::vector< uint8_t > > & state );
             
             size_t                  _memory;
             FAT::Image              _fat;
             UI::Mode                _mode;
             Engine                  _engine;
             UI                      _ui;
+            InterruptTable          _interrupts;
+            Devices::Bus            _bus;
+            VirtualClock            _clock;
+            CPU::CPUID              _cpuid;
             BIOS::MemoryMap         _memoryMap;
             std::atomic< bool >     _breakOnInterrupt;
             std::atomic< bool >     _breakOnInterruptReturn;
             std::atomic< bool >     _trap;
             std::atomic< bool >     _debugVideo;
             std::atomic< bool >     _singleStep;
+            std::atomic< bool >     _realtime;
+            std::atomic< bool >     _stopping;
+            std::atomic< bool >     _breaking;
             std::vector< uint64_t > _breakpoints;
+            uint16_t                _entrySegment;
+            uint16_t                _entryOffset;
+            uint8_t                 _bootDrive;
+            time_t                  _time;
+            uint64_t                _tscOffset;
+            bool                    _wakeup;
+            uint64_t                _idleStart;
+            uint64_t                _idleInstructions;
+            std::atomic< uint64_t > _nextEvent;
+            std::mutex              _idleMtx;
+            std::condition_variable _idleCV;
+            KeyboardQueue           _keys;
+            size_t                  _scriptIndex;
+            std::thread             _input;
+            std::string             _framebufferPath;
+            uint64_t                _framebufferInterval;
+            uint64_t                _framebufferNext;
+            size_t                  _framebufferIndex;
+            std::atomic< bool >     _framebufferRequested;
+            bool                    _restored;
+            uint64_t                _checkpointInstructions;
+            uint64_t                _checkpointTime;
+            size_t                  _checkpointScriptIndex;
+            std::atomic< bool >     _warmStartPending;
+            uint64_t                _instructionLimit;
+            uint64_t                _instructionStart;
+            std::string             _stopReason;
+            mutable std::mutex      _stopMtx;
+            
+            std::vector< std::pair< uint64_t, uint16_t > > _script;
+            
+            std::map< std::string, std::vector< uint8_t > > _checkpointDevices;
+            
+            std::map< uint8_t, FAT::Image >    _drives;
+            std::unique_ptr< FAT::FileSystem > _fileSystem;
+            
+            std::shared_ptr< Devices::PIC >           _pic;
+            std::shared_ptr< Devices::PIT >           _pit;
+            std::shared_ptr< Devices::CMOS >          _cmos;
+            std::shared_ptr< Devices::SystemControl > _systemControl;
+            std::shared_ptr< Devices::POST >          _post;
+            std::shared_ptr< Devices::UART >          _uart;
+            std::shared_ptr< Devices::APIC >          _localAPIC;
+            std::shared_ptr< Devices::APIC >          _ioAPIC;
+            std::shared_ptr< Devices::VGA >           _vga;
+            std::shared_ptr< Devices::VBE >           _vbe;
     };
 
     Machine::Machine( size_t memory, const FAT::Image & fat, UI::Mode mode ):
@@ -100,321 +214,1701 @@ namespace UB
         return this->impl->_memoryMap;
     }
     
-    UI & Machine::ui( void ) const
+    uint8_t Machine::bootDrive( void ) const
     {
-        return this->impl->_ui;
+        return this->impl->_bootDrive;
     }
     
-    void Machine::run( void )
+    std::vector< uint8_t > Machine::drives( void ) const
     {
-        if( this->impl->_engine.start( 0x7C00 ) == false )
+        std::vector< uint8_t > drives;
+        
+        for( const auto & p: this->impl->_drives )
         {
-            throw std::runtime_error( "Cannot start engine" );
+            drives.push_back( p.first );
         }
         
-        this->impl->_ui.mode( this->impl->_mode );
-        this->impl->_ui.run();
-        this->impl->_engine.stop();
+        return drives;
     }
     
-    bool Machine::breakOnInterrupt( void ) const
+    bool Machine::hasDrive( uint8_t drive ) const
     {
-        return this->impl->_breakOnInterrupt;
+        return this->impl->_drives.find( drive ) != this->impl->_drives.end();
     }
     
-    bool Machine::breakOnInterruptReturn( void ) const
+    const FAT::Image & Machine::drive( uint8_t drive ) const
     {
-        return this->impl->_breakOnInterruptReturn;
+        auto it( this->impl->_drives.find( drive ) );
+        
+        if( it == this->impl->_drives.end() )
+        {
+            throw std::runtime_error( "No such drive: " + String::toHex( drive ) );
+        }
+        
+        return it->second;
     }
     
-    bool Machine::trap( void ) const
+    void Machine::addDrive( uint8_t drive, const FAT::Image & image )
     {
-        return this->impl->_trap;
+        if( drive > 0x01 && drive < 0x80 )
+        {
+            throw std::runtime_error( "Invalid BIOS drive number: " + String::toHex( drive ) );
+        }
+        
+        if( this->hasDrive( drive ) )
+        {
+            throw std::runtime_error( "Drive " + String::toHex( drive ) + " is already in use" );
+        }
+        
+        this->impl->_drives.emplace( drive, image );
+        this->impl->_updateBDA();
     }
     
-    bool Machine::debugVideo( void ) const
+    UI & Machine::ui( void ) const
     {
-        return this->impl->_debugVideo;
+        return this->impl->_ui;
     }
     
-    bool Machine::singleStep( void ) const
+    InterruptTable & Machine::interrupts( void ) const
     {
-        return this->impl->_singleStep;
+        return this->impl->_interrupts;
     }
     
-    void Machine::breakOnInterrupt( bool value )
+    Devices::Bus & Machine::bus( void ) const
     {
-        this->impl->_breakOnInterrupt = value;
+        return this->impl->_bus;
     }
     
-    void Machine::breakOnInterruptReturn( bool value )
+    CPU::CPUID & Machine::cpuid( void ) const
     {
-        this->impl->_breakOnInterruptReturn = value;
+        return this->impl->_cpuid;
     }
     
-    void Machine::trap( bool value )
+    VirtualClock & Machine::clock( void ) const
     {
-        this->impl->_trap = value;
+        return this->impl->_clock;
     }
     
-    void Machine::debugVideo( bool value )
+    Devices::VGA & Machine::vga( void ) const
     {
-        this->impl->_debugVideo = value;
+        return *( this->impl->_vga );
     }
     
-    void Machine::singleStep( bool value )
+    Devices::VBE & Machine::vbe( void ) const
     {
-        this->impl->_singleStep = value;
+        return *( this->impl->_vbe );
     }
-
-    void Machine::breakHere( const std::string & message ) const
+    
+    Devices::CMOS & Machine::cmos( void ) const
     {
-        this->impl->_break( message );
+        return *( this->impl->_cmos );
     }
-
-    void Machine::addBreakpoint( uint64_t address )
+    
+    void Machine::run( void )
     {
-        this->impl->_breakpoints.push_back( address );
+        uint64_t address( this->impl->_engine.pc() );
+        
+        if( this->impl->_restored == false )
+        {
+            this->impl->_engine.cs( this->impl->_entrySegment );
+            this->impl->_engine.dl( this->impl->_bootDrive );
+            
+            address = Engine::getAddress( this->impl->_entrySegment, this->impl->_entryOffset );
+        }
+        
+        this->impl->_restored         = false;
+        this->impl->_stopping         = false;
+        this->impl->_instructionStart = this->impl->_clock.instructions();
+        
+        {
+            std::lock_guard< std::mutex > l( this->impl->_stopMtx );
+            
+            this->impl->_stopReason.clear();
+        }
+        
+        this->impl->_updateTrace();
+        
+        if( this->impl->_engine.start( address ) == false )
+        {
+            throw std::runtime_error( "Cannot start engine" );
+        }
+        
+        if( this->impl->_mode == UI::Mode::Standard && this->impl->_script.empty() )
+        {
+            this->impl->_input = std::thread( [ & ]( void ) { this->impl->_readInput(); } );
+        }
+        
+        this->impl->_ui.mode( this->impl->_mode );
+        this->impl->_ui.run();
+        
+        this->impl->_stopping = true;
+        
+        this->impl->_stop( ( this->impl->_engine.running() ) ? "interrupted" : "stopped" );
+        this->impl->_uart->flush();
+        
+        if( this->impl->_input.joinable() )
+        {
+            this->impl->_input.join();
+        }
     }
     
-    void Machine::removeBreakpoint( uint64_t address )
+    void Machine::stop( const std::string & reason )
     {
-        this->impl->_breakpoints.erase
-        (
-            std::remove
-            (
-                this->impl->_breakpoints.begin(),
-                this->impl->_breakpoints.end(),
-                address
-            ),
-            this->impl->_breakpoints.end()
-        );
+        this->impl->_stop( reason );
     }
     
-    void swap( Machine & o1, Machine & o2 )
+    std::string Machine::stopReason( void ) const
     {
-        using std::swap;
+        std::lock_guard< std::mutex > l( this->impl->_stopMtx );
         
-        swap( o1.impl, o2.impl );
+        return this->impl->_stopReason;
     }
-
-    Machine::IMPL::IMPL( size_t memory, const FAT::Image & fat, UI::Mode mode ):
-        _memory(                 memorySizeOrDefault( memory ) ),
-        _fat(                    fat ),
-        _mode(                   mode ),
-        _engine(                 memorySizeOrDefault( memory ) ),
-        _ui(                     this->_engine ),
-        _memoryMap(              memorySizeOrDefault( memory ) ),
-        _breakOnInterrupt(       false ),
-        _breakOnInterruptReturn( false ),
-        _trap(                   false ),
-        _debugVideo(             false ),
-        _singleStep(             false )
-    {}
-
-    Machine::IMPL::IMPL( const IMPL & o ):
-        _memory(                 o._memory ),
-        _fat(                    o._fat ),
-        _mode(                   o._mode ),
-        _engine(                 o._memory ),
-        _ui(                     this->_engine ),
-        _memoryMap(              o._memoryMap ),
-        _breakOnInterrupt(       o._breakOnInterrupt.load() ),
-        _breakOnInterruptReturn( o._breakOnInterruptReturn.load() ),
-        _trap(                   o._trap.load() ),
-        _debugVideo(             o._debugVideo.load() ),
-        _singleStep(             o._singleStep.load() )
-    {}
-
-    Machine::IMPL::~IMPL( void )
-    {}
     
-    size_t Machine::IMPL::memorySizeOrDefault( size_t memory )
+    void Machine::instructionLimit( uint64_t value )
     {
-        if( memory == 0 )
-        {
-            memory = 64;
-        }
-        else if( memory == 1 )
+        this->impl->_instructionLimit = value;
+    }
+    
+    void Machine::checkpoint( void )
+    {
+        this->impl->_engine.checkpoint();
+        
+        this->impl->_checkpointInstructions = this->impl->_clock.instructions();
+        this->impl->_checkpointTime         = this->impl->_clock.time();
+        this->impl->_checkpointScriptIndex  = this->impl->_scriptIndex;
+        this->impl->_checkpointDevices      = this->impl->_deviceState();
+    }
+    
+    bool Machine::restore( void )
+    {
+        if( this->impl->_engine.restore() == false )
         {
-            memory = 2;
+            return false;
         }
         
-        return memory * 1024 * 1024;
+        this->impl->_clock.reset( this->impl->_checkpointInstructions, this->impl->_checkpointTime );
+        this->impl->_deviceState( this->impl->_checkpointDevices );
+        
+        this->impl->_scriptIndex = this->impl->_checkpointScriptIndex;
+        this->impl->_restored    = true;
+        this->impl->_nextEvent   = 0;
+        
+        this->impl->_vga->invalidate();
+        this->impl->_vbe->invalidate();
+        
+        return true;
     }
     
-    void Machine::IMPL::_setup( const Machine & machine )
+    std::unique_ptr< Machine > Machine::fork( void )
     {
-        FAT::MBR               mbr( this->_fat.mbr() );
-        std::vector< uint8_t > mbrData( mbr.data() );
+        std::unique_ptr< Machine > machine( std::make_unique< Machine >( *( this ) ) );
+        IMPL                     & child( *( machine->impl ) );
         
-        if( mbrData.size() != 512 )
+        this->impl->_engine.fork( child._engine );
+        child._deviceState( this->impl->_deviceState() );
+        
+        child._clock.reset( this->impl->_clock.instructions(), this->impl->_clock.time() );
+        
+        child._breakpoints = this->impl->_breakpoints;
+        child._scriptIndex = this->impl->_scriptIndex;
+        child._restored    = true;
+        
+        return machine;
+    }
+    
+    void Machine::saveState( const std::string & path ) const
+    {
+        this->impl->_saveState( path, {} );
+    }
+    
+    void Machine::loadState( const std::string & path )
+    {
+        StateFile              state( path );
+        std::vector< uint8_t > data( state.section( "drives" ) );
+        BinaryDataStream       drives( data );
+        BinaryDataStream       machine( state.section( "machine" ) );
+        
+        if( state.memory() != this->impl->_memory )
         {
-            throw std::runtime_error( "Invalid MBR size: " + std::to_string( mbrData.size() ) );
+            throw std::runtime_error( "Save state memory size does not match: " + std::to_string( state.memory() / 1024 / 1024 ) + "MB" );
         }
         
-        this->_engine.write( 0x7C00, mbrData );
-        
-        this->_engine.onException
-        (
-            [ & ]( const std::exception & e ) -> bool
+        while( drives.tell() < data.size() )
+        {
+            uint8_t     drive( drives.readUInt8() );
+            uint64_t    size( drives.readLittleEndianUInt64() );
+            std::string name( drives.readString( drives.readLittleEndianUInt16() ) );
+            
+            if( this->hasDrive( drive ) == false || this->drive( drive ).size() != size )
             {
-                this->_ui.debug() << "[ ERROR ]> Exception caught: " << e.what() << std::endl;
-                
-                return true;
+                throw std::runtime_error( "Save state drive " + String::toHex( drive ) + " does not match: " + name );
             }
-        );
+        }
         
-        this->_engine.beforeInstruction
-        (
-            [ & ]( uint64_t address, const std::vector< uint8_t > & instruction )
+        state.load( this->impl->_engine );
+        
+        this->impl->_engine.state( state.section( "cpu" ) );
+        this->impl->_pic->state( state.section( "pic" ) );
+        this->impl->_pit->state( state.section( "pit" ) );
+        this->impl->_cmos->state( state.section( "cmos" ) );
+        this->impl->_systemControl->state( state.section( "sysctl" ) );
+        this->impl->_post->state( state.section( "post" ) );
+        this->impl->_uart->state( state.section( "uart" ) );
+        this->impl->_localAPIC->state( state.section( "lapic" ) );
+        this->impl->_ioAPIC->state( state.section( "ioapic" ) );
+        this->impl->_vga->state( state.section( "vga" ) );
+        
+        {
+            BinaryDataStream vbe( state.section( "vbe" ) );
+            
+            if( state.hasSection( "lfb" ) && this->impl->_vbe->mode( vbe.readLittleEndianUInt16() ) )
             {
-                ( void )address;
-                ( void )instruction;
-                
-                if( this->_singleStep )
-                {
-                    this->_break();
-                }
-                else
-                {
-                    uint64_t ip( this->_engine.eip() );
-                    
-                    if( std::find( this->_breakpoints.begin(), this->_breakpoints.end(), ip ) != this->_breakpoints.end() )
-                    {
-                        this->_break( String::toHex( ip ) );
-                    }
-                }
+                this->impl->_engine.write( Devices::VBE::lfbBase, state.section( "lfb" ) );
             }
-        );
-        
-        this->_engine.afterInstruction
-        (
-            [ & ]( uint64_t address, const Registers & registers, const std::vector< uint8_t > & instruction )
+            else
             {
-                ( void )address;
-                
-                if
-                (
-                       instruction.size() == 2
-                    && instruction[ 0 ]   == 0x0F
-                    && instruction[ 1 ]   == 0xA2
-                )
-                {
-                    CPU::cpuid( this->_engine, registers );
-                }
+                this->impl->_vbe->disable();
             }
-        );
+        }
         
-        this->_engine.onInterrupt
-        (
-            [ & ]( uint32_t i ) -> bool
+        {
+            uint64_t instructions( machine.readLittleEndianUInt64() );
+            uint64_t time( machine.readLittleEndianUInt64() );
+            
+            this->impl->_clock.reset( instructions, time );
+            
+            this->impl->_scriptIndex = static_cast< size_t >( machine.readLittleEndianUInt64() );
+            this->impl->_tscOffset   = machine.readLittleEndianUInt64();
+            this->impl->_nextEvent   = 0;
+        }
+        
+        this->impl->_restored = true;
+        
+        this->impl->_vga->invalidate();
+        this->impl->_vbe->invalidate();
+    }
+    
+    bool Machine::warmStart( uint64_t address, const std::string & path, const std::string & key )
+    {
+        IMPL                 * machine( this->impl.get() );
+        std::vector< uint8_t > data( key.begin(), key.end() );
+        
+        if( StateFile::isStateFile( path ) )
+        {
+            bool match;
+            
             {
-                bool ret( false );
-                
-                if( this->_breakOnInterrupt )
-                {
-                    this->_break( "Interrupt " + String::toHex( i ) );
-                }
-                
-                switch( i )
-                {
-                    case 0x05: ret = Interrupts::int0x05( machine, this->_engine ); break;
-                    case 0x10: ret = Interrupts::int0x10( machine, this->_engine ); break;
-                    case 0x11: ret = Interrupts::int0x11( machine, this->_engine ); break;
-                    case 0x12: ret = Interrupts::int0x12( machine, this->_engine ); break;
-                    case 0x13: ret = Interrupts::int0x13( machine, this->_engine ); break;
-                    case 0x14: ret = Interrupts::int0x14( machine, this->_engine ); break;
-                    case 0x15: ret = Interrupts::int0x15( machine, this->_engine ); break;
-                    case 0x16: ret = Interrupts::int0x16( machine, this->_engine ); break;
-                    case 0x17: ret = Interrupts::int0x17( machine, this->_engine ); break;
-                    case 0x18: ret = Interrupts::int0x18( machine, this->_engine ); break;
-                    case 0x19: ret = Interrupts::int0x19( machine, this->_engine ); break;
-                    case 0x1A: ret = Interrupts::int0x1A( machine, this->_engine ); break;
-                    
-                    default: break;
-                }
+                StateFile state( path );
                 
-                if( this->_breakOnInterruptReturn )
-                {
-                    this->_break( "Return from interrupt" );
-                }
+                match = state.hasSection( "key" ) && state.section( "key" ) == data;
+            }
+            
+            if( match )
+            {
+                this->loadState( path );
                 
-                return ret;
+                return true;
             }
-        );
+        }
         
-        this->_engine.onValidMemoryAccess
+        this->impl->_warmStartPending = true;
+        
+        this->impl->_engine.onExecute
         (
-            [ & ]( uint64_t address, size_t size )
+            address,
+            address,
+            [ machine, path, data ]( uint64_t )
             {
-                if( this->_engine.running() == false )
+                if( machine->_warmStartPending == false )
                 {
                     return;
                 }
                 
-                for( const auto & entry: this->_memoryMap.entries() )
+                machine->_warmStartPending = false;
+                
+                try
                 {
-                    uint64_t end( address + size );
-                    
-                    if( entry.type() == BIOS::MemoryMap::Entry::Type::Usable )
-                    {
-                        continue;
-                    }
-                    
-                    if( ( address >= entry.base() && address <= entry.end() ) || ( end >= entry.base() && end <= entry.end() ) )
-                    {
-                        throw std::runtime_error( "Access to invalid memory at address " + String::toHex( address ) );
-                    }
+                    machine->_saveState( path, { { "key", data } } );
                 }
+                catch( ... )
+                {}
             }
         );
         
-        this->_engine.onInvalidMemoryAccess
-        (
-            [ & ]( uint64_t address, size_t size )
-            {
-                ( void )size;
-                
-                throw std::runtime_error( "Access to invalid memory at address " + String::toHex( address ) );
+        return false;
+    }
+    
+    void Machine::load( const std::string & path, uint16_t segment, uint16_t offset )
+    {
+        uint64_t               address( Engine::getAddress( segment, offset ) );
+        std::vector< uint8_t > data;
+        
+        if( this->impl->_fileSystem == nullptr )
+        {
+            this->impl->_fileSystem = std::make_unique< FAT::FileSystem >( this->impl->_fat );
+        }
+        
+        data = this->impl->_fileSystem->read( path );
+        
+        if( address + data.size() > this->impl->_memory )
+        {
+            throw std::runtime_error( "Cannot load " + path + " at address " + String::toHex( address ) + " - Not enough memory allocated" );
+        }
+        
+        this->impl->_engine.write( address, data );
+    }
+    
+    void Machine::entryPoint( uint16_t segment, uint16_t offset )
+    {
+        this->impl->_entrySegment = segment;
+        this->impl->_entryOffset  = offset;
+        
+        this->impl->_engine.ds( segment );
+        this->impl->_engine.es( segment );
+        this->impl->_engine.ss( 0 );
+        this->impl->_engine.sp( 0x7C00 );
+    }
+    
+    void Machine::serialOutput( const std::string & path )
+    {
+        this->impl->_uart->output( std::make_shared< AsyncWriter >( path ) );
+    }
+    
+    void Machine::serialInput( const std::string & path )
+    {
+        std::ifstream stream( path, std::ios::binary );
+        
+        if( stream.is_open() == false )
+        {
+            throw std::runtime_error( "Cannot open serial input file: " + path );
+        }
+        
+        this->impl->_uart->input( std::vector< uint8_t >( std::istreambuf_iterator< char >( stream ), std::istreambuf_iterator< char >() ) );
+    }
+    
+    void Machine::keyboardInput( const std::string & path )
+    {
+        std::ifstream stream( path );
+        std::string   line;
+        uint64_t      time( 0 );
+        size_t        n( 0 );
+        
+        if( stream.is_open() == false )
+        {
+            throw std::runtime_error( "Cannot open keyboard input file: " + path );
+        }
+        
+        while( std::getline( stream, line ) )
+        {
+            size_t      pos( line.find_first_not_of( " \t" ) );
+            std::string command;
+            std::string argument;
+            
+            n++;
+            
+            if( line.length() > 0 && line.back() == '\r' )
+            {
+                line.pop_back();
+            }
+            
+            if( pos == std::string::npos || pos >= line.length() || line[ pos ] == '#' )
+            {
+                continue;
+            }
+            
+            line    = line.substr( pos );
+            pos     = line.find( ' ' );
+            command = line.substr( 0, pos );
+            
+            if( pos != std::string::npos )
+            {
+                argument = line.substr( pos + 1 );
+            }
+            
+            if( command == "wait" )
+            {
+                char               * end( nullptr );
+                unsigned long long   ms( std::strtoull( argument.c_str(), &end, 10 ) );
+                
+                if( argument.length() == 0 || *( end ) != 0 )
+                {
+                    throw std::runtime_error( "Invalid keyboard input delay at line " + std::to_string( n ) + ": " + line );
+                }
+                
+                time += static_cast< uint64_t >( ms ) * 1000000;
+            }
+            else if( command == "type" )
+            {
+                for( char c: argument )
+                {
+                    uint16_t key( BIOS::Keyboard::keyCode( static_cast< uint8_t >( c ) ) );
+                    
+                    if( key == 0 )
+                    {
+                        throw std::runtime_error( "Invalid keyboard input character at line " + std::to_string( n ) + ": " + line );
+                    }
+                    
+                    this->impl->_script.push_back( { time, key } );
+                }
+            }
+            else if( command == "key" )
+            {
+                uint16_t key( BIOS::Keyboard::keyCode( argument ) );
+                
+                if( key == 0 )
+                {
+                    throw std::runtime_error( "Invalid keyboard input key at line " + std::to_string( n ) + ": " + line );
+                }
+                
+                this->impl->_script.push_back( { time, key } );
+            }
+            else
+            {
+                throw std::runtime_error( "Invalid keyboard input at line " + std::to_string( n ) + ": " + line );
+            }
+        }
+    }
+    
+    void Machine::waitForKey( void ) const
+    {
+        this->impl->_pollKeys();
+        this->impl->_idle( true );
+        this->impl->_pollKeys();
+    }
+    
+    std::string Machine::screen( void ) const
+    {
+        size_t address( Devices::VGA::textBase + static_cast< size_t >( this->impl->_vga->start() ) * 2 );
+        size_t size( this->impl->_vga->columns() * this->impl->_vga->rows() * 2 );
+        
+        return this->impl->_vga->text( this->impl->_engine.read( address, std::min( size, Devices::VGA::textBase + Devices::VGA::textSize - address ) ) );
+    }
+    
+    void Machine::framebufferOutput( const std::string & path, uint64_t interval )
+    {
+        this->impl->_framebufferPath     = path;
+        this->impl->_framebufferInterval = interval * 1000000000;
+        this->impl->_framebufferNext     = this->impl->_clock.time() + this->impl->_framebufferInterval;
+        
+        if( this->impl->_mode == UI::Mode::Headless )
+        {
+            return;
+        }
+        
+        Signal::handle
+        (
+            SIGUSR1,
+            [ & ]( int sig )
+            {
+                ( void )sig;
+                
+                this->impl->_framebufferRequested = true;
+                this->impl->_nextEvent            = 0;
+            }
+        );
+    }
+    
+    bool Machine::dumpFramebuffer( const std::string & path ) const
+    {
+        return this->impl->_dumpFramebuffer( path );
+    }
+    
+    bool Machine::realtime( void ) const
+    {
+        return this->impl->_realtime;
+    }
+    
+    void Machine::realtime( bool value )
+    {
+        this->impl->_realtime = value;
+        
+        if( value )
+        {
+            this->impl->_bus.clock( nullptr );
+        }
+        else
+        {
+            this->impl->_bus.clock( &( this->impl->_clock ) );
+        }
+    }
+    
+    void Machine::time( time_t value )
+    {
+        this->impl->_time = value;
+        
+        this->impl->_cmos->time( value );
+        this->impl->_updateTicks();
+    }
+    
+    bool Machine::breakOnInterrupt( void ) const
+    {
+        return this->impl->_breakOnInterrupt;
+    }
+    
+    bool Machine::breakOnInterruptReturn( void ) const
+    {
+        return this->impl->_breakOnInterruptReturn;
+    }
+    
+    bool Machine::trap( void ) const
+    {
+        return this->impl->_trap;
+    }
+    
+    bool Machine::debugVideo( void ) const
+    {
+        return this->impl->_debugVideo;
+    }
+    
+    bool Machine::singleStep( void ) const
+    {
+        return this->impl->_singleStep;
+    }
+    
+    void Machine::breakOnInterrupt( bool value )
+    {
+        this->impl->_breakOnInterrupt = value;
+    }
+    
+    void Machine::breakOnInterruptReturn( bool value )
+    {
+        this->impl->_breakOnInterruptReturn = value;
+    }
+    
+    void Machine::trap( bool value )
+    {
+        this->impl->_trap = value;
+    }
+    
+    void Machine::debugVideo( bool value )
+    {
+        this->impl->_debugVideo = value;
+    }
+    
+    void Machine::singleStep( bool value )
+    {
+        this->impl->_singleStep = value;
+        
+        this->impl->_updateTrace();
+    }
+
+    void Machine::breakHere( const std::string & message ) const
+    {
+        this->impl->_break( message );
+    }
+
+    void Machine::addBreakpoint( uint64_t address )
+    {
+        this->impl->_breakpoints.push_back( address );
+        this->impl->_updateTrace();
+    }
+    
+    void Machine::removeBreakpoint( uint64_t address )
+    {
+        this->impl->_breakpoints.erase
+        (
+            std::remove
+            (
+                this->impl->_breakpoints.begin(),
+                this->impl->_breakpoints.end(),
+                address
+            ),
+            this->impl->_breakpoints.end()
+        );
+        
+        this->impl->_updateTrace();
+    }
+    
+    void swap( Machine & o1, Machine & o2 )
+    {
+        using std::swap;
+        
+        swap( o1.impl, o2.impl );
+    }
+
+    Machine::IMPL::IMPL( size_t memory, const FAT::Image & fat, UI::Mode mode ):
+        _memory(                 memorySizeOrDefault( memory ) ),
+        _fat(                    fat ),
+        _mode(                   mode ),
+        _engine(                 memorySizeOrDefault( memory ) ),
+        _ui(                     this->_engine ),
+        _memoryMap(              memorySizeOrDefault( memory ) ),
+        _breakOnInterrupt(       false ),
+        _breakOnInterruptReturn( false ),
+        _trap(                   false ),
+        _debugVideo(             false ),
+        _singleStep(             false ),
+        _realtime(               false ),
+        _stopping(               false ),
+        _breaking(               false ),
+        _entrySegment(           0 ),
+        _entryOffset(            0x7C00 ),
+        _bootDrive(              ( fat.partitions().size() > 0 || fat.size() > 2949120 ) ? 0x80 : 0x00 ),
+        _time(                   epoch ),
+        _tscOffset(              0 ),
+        _wakeup(                 false ),
+        _idleStart(              0 ),
+        _idleInstructions(       0 ),
+        _nextEvent(              0 ),
+        _scriptIndex(            0 ),
+        _framebufferInterval(    0 ),
+        _framebufferNext(        0 ),
+        _framebufferIndex(       0 ),
+        _framebufferRequested(   false ),
+        _restored(               false ),
+        _checkpointInstructions( 0 ),
+        _checkpointTime(         0 ),
+        _checkpointScriptIndex(  0 ),
+        _warmStartPending(       false ),
+        _instructionLimit(       0 ),
+        _instructionStart(       0 ),
+        _pic(                    std::make_shared< Devices::PIC >() ),
+        _pit(                    std::make_shared< Devices::PIT >() ),
+        _cmos(                   std::make_shared< Devices::CMOS >( this->_memory, this->_time ) ),
+        _systemControl(          std::make_shared< Devices::SystemControl >() ),
+        _post(                   std::make_shared< Devices::POST >() ),
+        _uart(                   std::make_shared< Devices::UART >( 0x3F8, 4 ) ),
+        _localAPIC(              std::make_shared< Devices::APIC >( Devices::APIC::Type::Local ) ),
+        _ioAPIC(                 std::make_shared< Devices::APIC >( Devices::APIC::Type::IO ) ),
+        _vga(                    std::make_shared< Devices::VGA >() ),
+        _vbe(                    std::make_shared< Devices::VBE >() )
+    {
+        this->_drives.emplace( this->_bootDrive, fat );
+        
+        this->_cpuid.vendor( "UNICORN-BIOS" );
+        this->_cpuid.set( 0x80000000, CPU::CPUID::Register::EAX, 0x80000001 );
+        this->_cpuid.set( 0x80000001, CPU::CPUID::Register::EDX, 0, 0x20000000 );
+    }
+
+    Machine::IMPL::IMPL( const IMPL & o ):
+        _memory(                 o._memory ),
+        _fat(                    o._fat ),
+        _mode(                   o._mode ),
+        _engine(                 o._memory ),
+        _ui(                     this->_engine ),
+        _cpuid(                  o._cpuid ),
+        _memoryMap(              o._memoryMap ),
+        _breakOnInterrupt(       o._breakOnInterrupt.load() ),
+        _breakOnInterruptReturn( o._breakOnInterruptReturn.load() ),
+        _trap(                   o._trap.load() ),
+        _debugVideo(             o._debugVideo.load() ),
+        _singleStep(             o._singleStep.load() ),
+        _realtime(               o._realtime.load() ),
+        _stopping(               false ),
+        _breaking(               false ),
+        _entrySegment(           o._entrySegment ),
+        _entryOffset(            o._entryOffset ),
+        _bootDrive(              o._bootDrive ),
+        _time(                   o._time ),
+        _tscOffset(              o._tscOffset ),
+        _wakeup(                 false ),
+        _idleStart(              0 ),
+        _idleInstructions(       0 ),
+        _nextEvent(              0 ),
+        _scriptIndex(            0 ),
+        _framebufferInterval(    0 ),
+        _framebufferNext(        0 ),
+        _framebufferIndex(       0 ),
+        _framebufferRequested(   false ),
+        _restored(               false ),
+        _checkpointInstructions( 0 ),
+        _checkpointTime(         0 ),
+        _checkpointScriptIndex(  0 ),
+        _warmStartPending(       false ),
+        _instructionLimit(       o._instructionLimit ),
+        _instructionStart(       0 ),
+        _script(                 o._script ),
+        _drives(                 o._drives ),
+        _pic(                    std::make_shared< Devices::PIC >() ),
+        _pit(                    std::make_shared< Devices::PIT >() ),
+        _cmos(                   std::make_shared< Devices::CMOS >( o._memory, o._time ) ),
+        _systemControl(          std::make_shared< Devices::SystemControl >() ),
+        _post(                   std::make_shared< Devices::POST >() ),
+        _uart(                   std::make_shared< Devices::UART >( 0x3F8, 4 ) ),
+        _localAPIC(              std::make_shared< Devices::APIC >( Devices::APIC::Type::Local ) ),
+        _ioAPIC(                 std::make_shared< Devices::APIC >( Devices::APIC::Type::IO ) ),
+        _vga(                    std::make_shared< Devices::VGA >() ),
+        _vbe(                    std::make_shared< Devices::VBE >() )
+    {}
+
+    Machine::IMPL::~IMPL( void )
+    {
+        if( this->_input.joinable() )
+        {
+            this->_stopping = true;
+            
+            this->_input.join();
+        }
+    }
+    
+    size_t Machine::IMPL::memorySizeOrDefault( size_t memory )
+    {
+        if( memory == 0 )
+        {
+            memory = 64;
+        }
+        else if( memory == 1 )
+        {
+            memory = 2;
+        }
+        
+        return memory * 1024 * 1024;
+    }
+    
+    void Machine::IMPL::_saveState( const std::string & path, std::map< std::string, std::vector< uint8_t > > sections )
+    {
+        std::vector< uint8_t > machine;
+        std::vector< uint8_t > drives;
+        
+        auto append = [ & ]( std::vector< uint8_t > & data, uint64_t value, size_t bytes )
+        {
+            for( size_t i = 0; i < bytes; i++ )
+            {
+                data.push_back( static_cast< uint8_t >( ( value >> ( i * 8 ) ) & 0xFF ) );
+            }
+        };
+        
+        append( machine, this->_clock.instructions(), 8 );
+        append( machine, this->_clock.time(),         8 );
+        append( machine, this->_scriptIndex,          8 );
+        append( machine, this->_tscOffset,            8 );
+        
+        for( const auto & p: this->_drives )
+        {
+            std::string name( p.second.path() );
+            
+            append( drives, p.first,         1 );
+            append( drives, p.second.size(), 8 );
+            append( drives, name.length(),   2 );
+            
+            drives.insert( drives.end(), name.begin(), name.end() );
+        }
+        
+        for( const auto & p: this->_deviceState() )
+        {
+            sections[ p.first ] = p.second;
+        }
+        
+        sections[ "cpu" ]     = this->_engine.state();
+        sections[ "machine" ] = machine;
+        sections[ "drives" ]  = drives;
+        
+        if( this->_vbe->enabled() )
+        {
+            sections[ "lfb" ] = this->_engine.read( Devices::VBE::lfbBase, Devices::VBE::lfbSize );
+        }
+        
+        StateFile::write( path, sections, this->_memory, [ & ]( uint64_t address, size_t size ) { return this->_engine.read( address, size ); } );
+    }
+    
+    void Machine::IMPL::_setup( const Machine & machine )
+    {
+        FAT::MBR               mbr( this->_fat.mbr() );
+        std::vector< uint8_t > mbrData( mbr.data() );
+        
+        if( mbrData.size() != 512 )
+        {
+            throw std::runtime_error( "Invalid MBR size: " + std::to_string( mbrData.size() ) );
+        }
+        
+        this->_engine.write( 0x7C00, mbrData );
+        this->_updateBDA();
+        this->_setupIVT();
+        
+        BIOS::Keyboard::initialize( this->_engine );
+        this->_setupDevices();
+        BIOS::Video::initialize( *( this->_vga ), this->_engine );
+        
+        Interrupts::registerServices( this->_interrupts );
+        
+        this->_engine.onException
+        (
+            [ & ]( const std::exception & e ) -> bool
+            {
+                this->_ui.debug() << "[ ERROR ]> Exception caught: " << e.what() << std::endl;
+                
+                this->_stop( "exception" );
+                
+                return true;
+            }
+        );
+        
+        this->_engine.beforeInstruction
+        (
+            [ & ]( uint64_t address, const std::vector< uint8_t > & instruction )
+            {
+                ( void )address;
+                ( void )instruction;
+                
+                if( this->_singleStep )
+                {
+                    this->_break();
+                }
+                else
+                {
+                    uint64_t ip( this->_engine.eip() );
+                    
+                    if( std::find( this->_breakpoints.begin(), this->_breakpoints.end(), ip ) != this->_breakpoints.end() )
+                    {
+                        this->_break( String::toHex( ip ) );
+                    }
+                }
+            }
+        );
+        
+        this->_engine.onCPUID
+        (
+            [ & ]( uint32_t leaf, uint32_t subleaf, RegisterFrame & frame )
+            {
+                uint32_t eax( frame.eax() );
+                uint32_t ebx( frame.ebx() );
+                uint32_t ecx( frame.ecx() );
+                uint32_t edx( frame.edx() );
+                
+                ( void )subleaf;
+                
+                if( this->_cpuid.apply( leaf, eax, ebx, ecx, edx ) )
+                {
+                    frame.eax( eax );
+                    frame.ebx( ebx );
+                    frame.ecx( ecx );
+                    frame.edx( edx );
+                }
+            }
+        );
+        
+        this->_engine.onRDTSC
+        (
+            [ & ]( uint64_t & value ) -> bool
+            {
+                value = this->_bus.time() + this->_tscOffset;
+                
+                return true;
+            }
+        );
+        
+        this->_engine.onRDMSR
+        (
+            [ & ]( uint32_t msr, uint64_t & value ) -> bool
+            {
+                if( msr != 0x10 )
+                {
+                    return false;
+                }
+                
+                value = this->_bus.time() + this->_tscOffset;
+                
+                return true;
+            }
+        );
+        
+        this->_engine.onWRMSR
+        (
+            [ & ]( uint32_t msr, uint64_t value )
+            {
+                if( msr == 0x10 )
+                {
+                    this->_tscOffset = value - this->_bus.time();
+                }
+            }
+        );
+        
+        this->_engine.onInterrupt
+        (
+            [ & ]( uint32_t i ) -> bool
+            {
+                uint8_t vector( static_cast< uint8_t >( i ) );
+                
+                uint16_t      segment( 0 );
+                uint16_t      offset( 0 );
+                RegisterFrame frame( this->_engine.frame() );
+                
+                if( this->_engine.mode() == Engine::Mode::Real && this->_isNative( vector, segment, offset ) == false )
+                {
+                    std::vector< uint8_t > instruction( this->_engine.read( Engine::getAddress( frame.cs(), frame.ip() ), 2 ) );
+                    uint16_t               ip( frame.ip() );
+                    
+                    if( instruction[ 0 ] == 0xCD && instruction[ 1 ] == vector )
+                    {
+                        ip = static_cast< uint16_t >( ip + 2 );
+                    }
+                    else if( ( instruction[ 0 ] == 0xCC && vector == 3 ) || ( instruction[ 0 ] == 0xCE && vector == 4 ) )
+                    {
+                        ip = static_cast< uint16_t >( ip + 1 );
+                    }
+                    
+                    this->_deliver( frame, ip, segment, offset );
+                    
+                    return true;
+                }
+                
+                return this->_dispatch( machine, vector, frame );
+            }
+        );
+        
+        this->_engine.onExecute
+        (
+            Engine::getAddress( romSegment, romStubs ),
+            Engine::getAddress( romSegment, romStubs + 0xFF ),
+            [ & ]( uint64_t address )
+            {
+                uint8_t       vector( static_cast< uint8_t >( address - Engine::getAddress( romSegment, romStubs ) ) );
+                RegisterFrame frame( this->_engine.frame() );
+                
+                if( this->_dispatch( machine, vector, frame ) == false )
+                {
+                    throw std::runtime_error( "Unhandled interrupt: " + String::toHex( vector ) );
+                }
+                
+                {
+                    uint64_t               stack( Engine::getAddress( frame.ss(), static_cast< uint16_t >( frame.sp() + 4 ) ) );
+                    std::vector< uint8_t > data( this->_engine.read( stack, 2 ) );
+                    uint16_t               flags( static_cast< uint16_t >( data[ 0 ] | ( data[ 1 ] << 8 ) ) );
+                    
+                    flags = static_cast< uint16_t >( ( flags & ~0x08D5 ) | ( frame.eflags() & 0x08D5 ) );
+                    
+                    this->_engine.write( stack, { static_cast< uint8_t >( flags & 0xFF ), static_cast< uint8_t >( flags >> 8 ) } );
+                }
+            }
+        );
+        
+        this->_engine.onBlock
+        (
+            [ & ]( uint64_t address, size_t size, size_t instructions )
+            {
+                uint64_t executed( this->_clock.instructions() - this->_instructionStart );
+                
+                ( void )size;
+                
+                if( this->_instructionLimit != 0 && executed + instructions > this->_instructionLimit )
+                {
+                    this->_ui.debug() << "Instruction budget exhausted, stopping emulation" << std::endl;
+                    
+                    this->_stop( "budget" );
+                    
+                    return;
+                }
+                
+                this->_clock.tick( instructions );
+                this->_poll( machine, address );
+            }
+        );
+        
+        this->_engine.onIdle
+        (
+            [ & ]( void )
+            {
+                this->_idle( false );
+            }
+        );
+        
+        this->_engine.onHalt
+        (
+            [ & ]( void ) -> bool
+            {
+                if( ( this->_engine.eflags() & 0x0200 ) == 0 )
+                {
+                    this->_ui.debug() << "CPU halted with interrupts disabled, stopping emulation" << std::endl;
+                    
+                    this->_stop( "halted" );
+                    
+                    return false;
+                }
+                
+                return this->_idle( true );
+            }
+        );
+        
+        this->_engine.onPortRead
+        (
+            [ & ]( uint16_t port, size_t size, uint32_t & value ) -> bool
+            {
+                return this->_bus.read( port, size, value );
+            }
+        );
+        
+        this->_engine.onPortWrite
+        (
+            [ & ]( uint16_t port, size_t size, uint32_t value ) -> bool
+            {
+                return this->_bus.write( port, size, value );
+            }
+        );
+        
+        this->_engine.onValidMemoryAccess
+        (
+            [ & ]( uint64_t address, size_t size )
+            {
+                if( this->_engine.running() == false )
+                {
+                    return;
+                }
+                
+                if( address >= Engine::getAddress( romSegment, romStubs ) && address + size <= Engine::getAddress( romSegment, romStubs + 0x100 ) )
+                {
+                    return;
+                }
+                
+                for( const auto & entry: this->_memoryMap.entries() )
+                {
+                    uint64_t end( address + size );
+                    
+                    if( entry.type() == BIOS::MemoryMap::Entry::Type::Usable )
+                    {
+                        continue;
+                    }
+                    
+                    if( ( address >= entry.base() && address <= entry.end() ) || ( end >= entry.base() && end <= entry.end() ) )
+                    {
+                        throw std::runtime_error( "Access to invalid memory at address " + String::toHex( address ) );
+                    }
+                }
+            }
+        );
+        
+        this->_engine.onInvalidMemoryAccess
+        (
+            [ & ]( uint64_t address, size_t size )
+            {
+                ( void )size;
+                
+                throw std::runtime_error( "Access to invalid memory at address " + String::toHex( address ) );
+            }
+        );
+        
+        if( this->_mode == UI::Mode::Interactive )
+        {
+            Screen::shared().onKeyPress
+            (
+                [ & ]( int key )
+                {
+                    if( key == 0x20 )
+                    {
+                        this->_singleStep = true;
+                        
+                        this->_updateTrace();
+                        this->_wake();
+                    }
+                }
+            );
+        }
+    }
+    
+    void Machine::IMPL::_break( const std::string & message )
+    {
+        if( message.length() > 0 )
+        {
+            this->_ui.debug() << "[ BREAK ]> " << message << std::endl;
+        }
+        
+        if( this->_mode == UI::Mode::Headless )
+        {
+            return;
+        }
+        
+        if( this->_trap )
+        {
+            raise( SIGTRAP );
+        }
+        else
+        {
+            this->_breaking = true;
+            
+            if( this->_ui.waitForUserResume() == 0x20 )
+            {
+                this->_singleStep = true;
+            }
+            else
+            {
+                this->_singleStep = false;
+            }
+            
+            this->_breaking = false;
+            
+            this->_updateTrace();
+        }
+    }
+    
+    void Machine::IMPL::_updateBDA( void )
+    {
+        uint16_t floppies( 0 );
+        uint8_t  disks( 0 );
+        
+        for( const auto & p: this->_drives )
+        {
+            if( p.first < 0x80 )
+            {
+                floppies++;
+            }
+            else
+            {
+                disks++;
+            }
+        }
+        
+        {
+            uint16_t equipment( 0 );
+            
+            if( floppies > 0 )
+            {
+                equipment |= 0x0001;
+                equipment |= static_cast< uint16_t >( ( std::min< uint16_t >( floppies, 4 ) - 1 ) << 6 );
+            }
+            
+            equipment |= 0x0200;
+            
+            this->_engine.write( 0x400, { static_cast< uint8_t >( this->_uart->base() & 0xFF ), static_cast< uint8_t >( this->_uart->base() >> 8 ) } );
+            this->_engine.write( 0x410, { static_cast< uint8_t >( equipment & 0xFF ), static_cast< uint8_t >( equipment >> 8 ) } );
+            this->_engine.write( 0x475, { disks } );
+        }
+    }
+    
+    void Machine::IMPL::_setupIVT( void )
+    {
+        std::vector< uint8_t > ivt;
+        std::vector< uint8_t > stubs( 0x100, 0xCF );
+        
+        for( unsigned int i = 0; i < 0x100; i++ )
+        {
+            uint16_t offset( static_cast< uint16_t >( romStubs + i ) );
+            
+            ivt.push_back( static_cast< uint8_t >( offset & 0xFF ) );
+            ivt.push_back( static_cast< uint8_t >( offset >> 8 ) );
+            ivt.push_back( static_cast< uint8_t >( romSegment & 0xFF ) );
+            ivt.push_back( static_cast< uint8_t >( romSegment >> 8 ) );
+        }
+        
+        this->_engine.write( 0, ivt );
+        this->_engine.write( Engine::getAddress( romSegment, romStubs ), stubs );
+    }
+    
+    bool Machine::IMPL::_dispatch( const Machine & machine, uint8_t i, RegisterFrame & frame )
+    {
+        bool ret;
+        
+        if( this->_breakOnInterrupt )
+        {
+            this->_break( "Interrupt " + String::toHex( i ) );
+        }
+        
+        ret = this->_interrupts.dispatch( i, machine, this->_engine, frame );
+        
+        this->_engine.frame( frame );
+        
+        if( this->_breakOnInterruptReturn )
+        {
+            this->_break( "Return from interrupt" );
+        }
+        
+        return ret;
+    }
+    
+    void Machine::IMPL::_setupDevices( void )
+    {
+        this->_bus.attach( this->_pic,           0x20, 0x21 );
+        this->_bus.attach( this->_pic,           0xA0, 0xA1 );
+        this->_bus.attach( this->_pit,           0x40, 0x43 );
+        this->_bus.attach( this->_pit,           0x61, 0x61 );
+        this->_bus.attach( this->_cmos,          0x70, 0x71 );
+        this->_bus.attach( this->_post,          0x80, 0x80 );
+        this->_bus.attach( this->_systemControl, 0x92, 0x92 );
+        this->_bus.attach( this->_uart,          this->_uart->base(), static_cast< uint16_t >( this->_uart->base() + 7 ) );
+        this->_bus.attach( this->_vga,           0x3D4, 0x3D5 );
+        this->_bus.attach( this->_vga,           0x3DA, 0x3DA );
+        
+        this->_engine.mapDevice
+        (
+            Devices::VGA::textBase,
+            Devices::VGA::textSize,
+            nullptr,
+            [ & ]( uint64_t offset, size_t size, uint64_t value )
+            {
+                ( void )value;
+                
+                this->_vga->invalidate( offset, size );
             }
         );
         
-        if( this->_mode == UI::Mode::Interactive )
+        this->_ui.vga( this->_vga );
+        
+        this->_engine.mapDevice
+        (
+            Devices::VBE::lfbBase,
+            Devices::VBE::lfbSize,
+            nullptr,
+            [ & ]( uint64_t offset, size_t size, uint64_t value )
+            {
+                ( void )value;
+                
+                this->_vbe->invalidate( offset, size );
+            }
+        );
+        
+        for( const auto & apic: { this->_localAPIC, this->_ioAPIC } )
         {
-            Screen::shared().onKeyPress
+            this->_engine.mapDevice
             (
-                [ & ]( int key )
+                apic->base(),
+                Devices::APIC::size,
+                [ = ]( uint64_t offset, size_t size ) -> uint64_t
                 {
-                    if( key == 0x20 )
-                    {
-                        this->_singleStep = true;
-                    }
+                    return apic->read( offset, size );
+                },
+                [ = ]( uint64_t offset, size_t size, uint64_t value )
+                {
+                    apic->write( offset, size, value );
                 }
             );
         }
+        
+        this->_bus.onRaise
+        (
+            [ & ]( uint8_t irq )
+            {
+                this->_pic->raise( irq );
+            }
+        );
+        
+        this->_bus.onStop
+        (
+            [ & ]( void )
+            {
+                this->_ui.debug() << "System reset requested, stopping emulation" << std::endl;
+                this->_stop( "reset" );
+            }
+        );
+        
+        this->_post->onCode
+        (
+            [ & ]( uint8_t code )
+            {
+                this->_ui.debug() << "POST code: " << String::toHex( code ) << std::endl;
+            }
+        );
+        
+        if( this->_realtime == false )
+        {
+            this->_bus.clock( &( this->_clock ) );
+        }
+        
+        this->_updateTicks();
     }
     
-    void Machine::IMPL::_break( const std::string & message )
+    void Machine::IMPL::_updateTicks( void )
     {
-        if( message.length() > 0 )
+        struct tm tm;
+        uint64_t  seconds;
+        uint32_t  ticks;
+        
+        gmtime_r( &( this->_time ), &tm );
+        
+        seconds = static_cast< uint64_t >( tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec );
+        ticks   = static_cast< uint32_t >( ( seconds * Devices::PIT::frequency ) / 0x10000 );
+        
+        this->_engine.write
+        (
+            0x46C,
+            {
+                static_cast< uint8_t >( ticks & 0xFF ),
+                static_cast< uint8_t >( ( ticks >> 8 ) & 0xFF ),
+                static_cast< uint8_t >( ( ticks >> 16 ) & 0xFF ),
+                static_cast< uint8_t >( ( ticks >> 24 ) & 0xFF )
+            }
+        );
+    }
+    
+    bool Machine::IMPL::_isNative( uint8_t i, uint16_t & segment, uint16_t & offset )
+    {
+        std::vector< uint8_t > entry( this->_engine.read( static_cast< size_t >( i ) * 4, 4 ) );
+        
+        offset  = static_cast< uint16_t >( entry[ 0 ] | ( entry[ 1 ] << 8 ) );
+        segment = static_cast< uint16_t >( entry[ 2 ] | ( entry[ 3 ] << 8 ) );
+        
+        return segment == romSegment && offset == romStubs + i;
+    }
+    
+    void Machine::IMPL::_deliver( RegisterFrame & frame, uint16_t ip, uint16_t segment, uint16_t offset )
+    {
+        uint16_t               sp( static_cast< uint16_t >( frame.sp() - 6 ) );
+        std::vector< uint8_t > stack;
+        
+        stack.push_back( static_cast< uint8_t >( ip & 0xFF ) );
+        stack.push_back( static_cast< uint8_t >( ip >> 8 ) );
+        stack.push_back( static_cast< uint8_t >( frame.cs() & 0xFF ) );
+        stack.push_back( static_cast< uint8_t >( frame.cs() >> 8 ) );
+        stack.push_back( static_cast< uint8_t >( frame.eflags() & 0xFF ) );
+        stack.push_back( static_cast< uint8_t >( ( frame.eflags() >> 8 ) & 0xFF ) );
+        
+        this->_engine.write( Engine::getAddress( frame.ss(), sp ), stack );
+        
+        frame.sp( sp );
+        frame.cs( segment );
+        frame.ip( offset );
+        frame.eflags( frame.eflags() & ~static_cast< uint32_t >( 0x0300 ) );
+        
+        this->_engine.frame( frame );
+        this->_engine.jump( Engine::getAddress( segment, offset ) );
+    }
+    
+    void Machine::IMPL::_interruptRequest( const Machine & machine, uint64_t address )
+    {
+        uint16_t segment( 0 );
+        uint16_t offset( 0 );
+        uint8_t  irq;
+        uint8_t  vector;
+        
+        if( this->_engine.mode() != Engine::Mode::Real )
         {
-            this->_ui.debug() << "[ BREAK ]> " << message << std::endl;
+            return;
         }
         
-        if( this->_trap )
         {
-            raise( SIGTRAP );
+            RegisterFrame frame( this->_engine.frame() );
+            
+            if( ( frame.eflags() & 0x0200 ) == 0 )
+            {
+                return;
+            }
+            
+            irq    = this->_pic->acknowledge();
+            vector = this->_pic->vector( irq );
+            
+            if( this->_isNative( vector, segment, offset ) )
+            {
+                if( this->_interrupts.dispatch( vector, machine, this->_engine, frame ) == false )
+                {
+                    this->_pic->endOfInterrupt( irq );
+                }
+                
+                this->_engine.frame( frame );
+            }
+            else
+            {
+                this->_deliver( frame, static_cast< uint16_t >( address - Engine::getAddress( frame.cs(), 0 ) ), segment, offset );
+            }
+        }
+    }
+    
+    void Machine::IMPL::_poll( const Machine & machine, uint64_t address )
+    {
+        uint64_t now( this->_bus.time() );
+        uint64_t next;
+        
+        if( now < this->_nextEvent && now < this->_bus.next() )
+        {
+            return;
+        }
+        
+        this->_nextEvent = std::numeric_limits< uint64_t >::max();
+        
+        this->_bus.update();
+        this->_pollKeys();
+        this->_updateFramebuffer();
+        
+        next = std::numeric_limits< uint64_t >::max();
+        
+        if( this->_scriptIndex < this->_script.size() )
+        {
+            next = std::min( next, this->_script[ this->_scriptIndex ].first );
+        }
+        
+        if( this->_keys.empty() == false )
+        {
+            next = std::min( next, now + keyQuantum );
+        }
+        
+        if( this->_framebufferPath.length() > 0 && this->_framebufferInterval > 0 )
+        {
+            next = std::min( next, this->_framebufferNext );
+        }
+        
+        if( this->_pic->pending() )
+        {
+            this->_interruptRequest( machine, address );
+            
+            if( this->_pic->pending() )
+            {
+                next = 0;
+            }
+        }
+        
+        {
+            uint64_t current( this->_nextEvent );
+            
+            while( next < current && this->_nextEvent.compare_exchange_weak( current, next ) == false )
+            {}
+        }
+    }
+    
+    bool Machine::IMPL::_idle( bool halted )
+    {
+        std::unique_lock< std::mutex > l( this->_idleMtx );
+        
+        if( this->_clock.instructions() - this->_idleInstructions > 1000000 )
+        {
+            this->_idleStart = this->_bus.time();
+        }
+        
+        while( this->_stopping == false )
+        {
+            uint64_t now;
+            uint64_t deadline;
+            
+            this->_bus.update();
+            
+            if( this->_pollKeys() || this->_pic->pending() || this->_wakeup || ( halted == false && this->_singleStep ) )
+            {
+                break;
+            }
+            
+            now      = this->_bus.time();
+            deadline = std::min< uint64_t >( this->_bus.next(), now + idleQuantum );
+            
+            if( this->_scriptIndex < this->_script.size() )
+            {
+                deadline = std::min< uint64_t >( deadline, this->_script[ this->_scriptIndex ].first );
+            }
+            
+            if( this->_realtime || now - this->_idleStart >= idleBudget )
+            {
+                this->_idleCV.wait_for( l, std::chrono::nanoseconds( ( deadline > now ) ? deadline - now : 0 ) );
+            }
+            
+            if( this->_realtime == false && this->_wakeup == false )
+            {
+                this->_clock.advanceTo( deadline );
+            }
+            
+            if( halted == false )
+            {
+                break;
+            }
+        }
+        
+        if( this->_wakeup )
+        {
+            this->_wakeup    = false;
+            this->_idleStart = this->_bus.time();
+        }
+        
+        this->_idleInstructions = this->_clock.instructions();
+        this->_nextEvent        = 0;
+        
+        return this->_stopping == false;
+    }
+    
+    void Machine::IMPL::_wake( void )
+    {
+        {
+            std::lock_guard< std::mutex > l( this->_idleMtx );
+            
+            this->_wakeup    = true;
+            this->_nextEvent = 0;
+        }
+        
+        this->_idleCV.notify_all();
+    }
+    
+    void Machine::IMPL::_stop( const std::string & reason )
+    {
+        {
+            std::lock_guard< std::mutex > l( this->_stopMtx );
+            
+            if( this->_stopReason.length() == 0 )
+            {
+                this->_stopReason = reason;
+            }
+        }
+        
+        this->_engine.stop();
+        this->_wake();
+    }
+    
+    void Machine::IMPL::_updateTrace( void )
+    {
+        this->_engine.trace( this->_singleStep || this->_breakpoints.empty() == false || this->_mode == UI::Mode::Interactive );
+    }
+    
+    bool Machine::IMPL::_pollKeys( void )
+    {
+        uint16_t key( 0 );
+        bool     delivered( false );
+        
+        while( this->_scriptIndex < this->_script.size() && this->_script[ this->_scriptIndex ].first <= this->_bus.time() )
+        {
+            if( this->_keys.push( this->_script[ this->_scriptIndex ].second ) == false )
+            {
+                break;
+            }
+            
+            this->_scriptIndex++;
+        }
+        
+        while( this->_keys.peek( key ) && BIOS::Keyboard::push( this->_engine, key ) )
+        {
+            this->_keys.pop( key );
+            
+            delivered = true;
+        }
+        
+        return delivered;
+    }
+    
+    void Machine::IMPL::_readInput( void )
+    {
+        while( this->_stopping == false )
+        {
+            struct pollfd p;
+            uint8_t       c( 0 );
+            uint16_t      key( 0 );
+            
+            if( this->_breaking )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+                
+                continue;
+            }
+            
+            memset( &p, 0, sizeof( p ) );
+            
+            p.fd     = STDIN_FILENO;
+            p.events = POLLIN;
+            
+            if( ::poll( &p, 1, 100 ) <= 0 )
+            {
+                continue;
+            }
+            
+            if( ::read( STDIN_FILENO, &c, 1 ) != 1 )
+            {
+                break;
+            }
+            
+            if( ( key = BIOS::Keyboard::keyCode( c ) ) == 0 )
+            {
+                continue;
+            }
+            
+            while( this->_keys.push( key ) == false && this->_stopping == false )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            }
+            
+            this->_wake();
+        }
+    }
+    
+    bool Machine::IMPL::_dumpFramebuffer( const std::string & path )
+    {
+        std::vector< uint8_t > data;
+        
+        if( this->_vbe->enabled() == false )
+        {
+            return false;
+        }
+        
+        this->_vbe->update
+        (
+            [ & ]( uint64_t offset, size_t size ) -> std::vector< uint8_t >
+            {
+                return this->_engine.read( Devices::VBE::lfbBase + offset, size );
+            }
+        );
+        
+        if( path.length() > 4 && String::toLower( path.substr( path.length() - 4 ) ) == ".png" )
+        {
+            data = this->_vbe->png();
         }
         else
         {
-            if( this->_ui.waitForUserResume() == 0x20 )
+            data = this->_vbe->ppm();
+        }
+        
+        {
+            std::ofstream stream( path, std::ios::binary );
+            
+            if( stream.is_open() == false )
             {
-                this->_singleStep = true;
+                throw std::runtime_error( "Cannot write framebuffer dump: " + path );
             }
-            else
+            
+            stream.write( reinterpret_cast< const char * >( data.data() ), static_cast< std::streamsize >( data.size() ) );
+        }
+        
+        return true;
+    }
+    
+    std::map< std::string, std::vector< uint8_t > > Machine::IMPL::_deviceState( void ) const
+    {
+        std::map< std::string, std::vector< uint8_t > > state;
+        
+        state[ "pic" ]    = this->_pic->state();
+        state[ "pit" ]    = this->_pit->state();
+        state[ "cmos" ]   = this->_cmos->state();
+        state[ "sysctl" ] = this->_systemControl->state();
+        state[ "post" ]   = this->_post->state();
+        state[ "uart" ]   = this->_uart->state();
+        state[ "lapic" ]  = this->_localAPIC->state();
+        state[ "ioapic" ] = this->_ioAPIC->state();
+        state[ "vga" ]    = this->_vga->state();
+        state[ "vbe" ]    = {};
+        
+        if( this->_vbe->enabled() )
+        {
+            uint16_t mode( this->_vbe->mode().number );
+            
+            state[ "vbe" ] = { static_cast< uint8_t >( mode & 0xFF ), static_cast< uint8_t >( mode >> 8 ) };
+        }
+        
+        return state;
+    }
+    
+    void Machine::IMPL::_deviceState( const std::map< std::string, std::vector< uint8_t > > & state )
+    {
+        const std::vector< uint8_t > & vbe( state.at( "vbe" ) );
+        
+        this->_pic->state( state.at( "pic" ) );
+        this->_pit->state( state.at( "pit" ) );
+        this->_cmos->state( state.at( "cmos" ) );
+        this->_systemControl->state( state.at( "sysctl" ) );
+        this->_post->state( state.at( "post" ) );
+        this->_uart->state( state.at( "uart" ) );
+        this->_localAPIC->state( state.at( "lapic" ) );
+        this->_ioAPIC->state( state.at( "ioapic" ) );
+        this->_vga->state( state.at( "vga" ) );
+        
+        if( vbe.size() < 2 || this->_vbe->mode( static_cast< uint16_t >( vbe[ 0 ] | ( vbe[ 1 ] << 8 ) ) ) == false )
+        {
+            this->_vbe->disable();
+        }
+    }
+    
+    void Machine::IMPL::_updateFramebuffer( void )
+    {
+        if( this->_framebufferPath.length() == 0 )
+        {
+            return;
+        }
+        
+        if( this->_framebufferRequested || ( this->_framebufferInterval > 0 && this->_clock.time() >= this->_framebufferNext ) )
+        {
+            std::string        path( this->_framebufferPath );
+            size_t             pos( path.rfind( '.' ) );
+            std::ostringstream index;
+            
+            this->_framebufferRequested = false;
+            this->_framebufferNext      = this->_clock.time() + this->_framebufferInterval;
+            
+            index << "-" << std::setfill( '0' ) << std::setw( 4 ) << this->_framebufferIndex;
+            
+            if( pos == std::string::npos || path.find( '/', pos ) != std::string::npos )
             {
-                this->_singleStep = false;
+                pos = path.length();
+            }
+            
+            if( this->_dumpFramebuffer( path.insert( pos, index.str() ) ) )
+            {
+                this->_framebufferIndex++;
             }
         }
     }
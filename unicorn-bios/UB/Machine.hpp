@@ -27,9 +27,18 @@
 
 #include <memory>
 #include <algorithm>
+#include <vector>
+#include <ctime>
 #include "UB/FAT/Image.hpp"
 #include "UB/BIOS/MemoryMap.hpp"
 #include "UB/UI.hpp"
+#include "UB/InterruptTable.hpp"
+#include "UB/Devices/Bus.hpp"
+#include "UB/CPU/CPUID.hpp"
+#include "UB/VirtualClock.hpp"
+#include "UB/Devices/VGA.hpp"
+#include "UB/Devices/VBE.hpp"
+#include "UB/Devices/CMOS.hpp"
 
 namespace UB
 {
@@ -47,9 +56,49 @@ namespace UB
             const FAT::Image      & bootImage( void ) const;
             const BIOS::MemoryMap & memoryMap( void ) const;
             
-            UI & ui( void ) const;
+            uint8_t                bootDrive( void )                const;
+            std::vector< uint8_t > drives( void )                   const;
+            bool                   hasDrive( uint8_t drive )        const;
+            const FAT::Image     & drive( uint8_t drive )           const;
+            void                   addDrive( uint8_t drive, const FAT::Image & image );
             
-            void run( void );
+            UI             & ui( void )         const;
+            InterruptTable & interrupts( void ) const;
+            Devices::Bus   & bus( void )        const;
+            CPU::CPUID     & cpuid( void )      const;
+            VirtualClock   & clock( void )      const;
+            Devices::VGA   & vga( void )        const;
+            Devices::VBE   & vbe( void )        const;
+            Devices::CMOS  & cmos( void )       const;
+            
+            void        run( void );
+            void        stop( const std::string & reason );
+            std::string stopReason( void ) const;
+            void        instructionLimit( uint64_t value );
+            void        checkpoint( void );
+            bool        restore( void );
+            
+            std::unique_ptr< Machine > fork( void );
+            
+            void saveState( const std::string & path ) const;
+            void loadState( const std::string & path );
+            bool warmStart( uint64_t address, const std::string & path, const std::string & key );
+            
+            void load( const std::string & path, uint16_t segment, uint16_t offset );
+            void entryPoint( uint16_t segment, uint16_t offset );
+            
+            void serialOutput( const std::string & path );
+            void serialInput( const std::string & path );
+            void keyboardInput( const std::string & path );
+            void waitForKey( void ) const;
+            
+            std::string screen( void ) const;
+            void        framebufferOutput( const std::string & path, uint64_t interval );
+            bool        dumpFramebuffer( const std::string & path ) const;
+            
+            bool realtime( void ) const;
+            void realtime( bool value );
+            void time( time_t value );
             
             bool breakOnInterrupt( void )       const;
             bool breakOnInterruptReturn( void ) const;
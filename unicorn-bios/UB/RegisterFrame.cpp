@@ -0,0 +1,604 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/RegisterFrame.hpp"
+#include <array>
+
+namespace UB
+{
+    class RegisterFrame::IMPL
+    {
+        public:
+            
+            IMPL( void );
+            IMPL( const IMPL & o );
+            ~IMPL( void );
+            
+            uint64_t _get( Register reg ) const;
+            void     _set( Register reg, uint64_t value, uint64_t mask, unsigned int shift );
+            
+            std::array< uint64_t, RegisterFrame::count > _values;
+            uint32_t                                      _dirty;
+    };
+    
+    RegisterFrame::RegisterFrame( void ):
+        impl( std::make_unique< IMPL >() )
+    {}
+    
+    RegisterFrame::RegisterFrame( const RegisterFrame & o ):
+        impl( std::make_unique< IMPL >( *( o.impl ) ) )
+    {}
+    
+    RegisterFrame::RegisterFrame( RegisterFrame && o ) noexcept:
+        impl( std::move( o.impl ) )
+    {}
+    
+    RegisterFrame::~RegisterFrame( void )
+    {}
+    
+    RegisterFrame & RegisterFrame::operator =( RegisterFrame o )
+    {
+        swap( *( this ), o );
+        
+        return *( this );
+    }
+    
+    uint64_t RegisterFrame::value( Register reg ) const
+    {
+        return this->impl->_get( reg );
+    }
+    
+    void RegisterFrame::value( Register reg, uint64_t value )
+    {
+        this->impl->_set( reg, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    bool RegisterFrame::isDirty( Register reg ) const
+    {
+        return ( this->impl->_dirty & ( 1U << static_cast< unsigned int >( reg ) ) ) != 0;
+    }
+    
+    bool RegisterFrame::isDirty( void ) const
+    {
+        return this->impl->_dirty != 0;
+    }
+    
+    void RegisterFrame::clean( void )
+    {
+        this->impl->_dirty = 0;
+    }
+    
+    bool RegisterFrame::cf( void ) const
+    {
+        return ( this->impl->_get( Register::EFLAGS ) & 0x01 ) != 0;
+    }
+    
+    bool RegisterFrame::zf( void ) const
+    {
+        return ( this->impl->_get( Register::EFLAGS ) & 0x40 ) != 0;
+    }
+    
+    uint8_t RegisterFrame::ah( void ) const
+    {
+        return static_cast< uint8_t >( ( this->impl->_get( Register::RAX ) >> 8 ) & 0xFF );
+    }
+    
+    uint8_t RegisterFrame::al( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RAX ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::ax( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RAX ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::eax( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RAX ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rax( void ) const
+    {
+        return this->impl->_get( Register::RAX );
+    }
+    
+    uint8_t RegisterFrame::bh( void ) const
+    {
+        return static_cast< uint8_t >( ( this->impl->_get( Register::RBX ) >> 8 ) & 0xFF );
+    }
+    
+    uint8_t RegisterFrame::bl( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RBX ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::bx( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RBX ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::ebx( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RBX ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rbx( void ) const
+    {
+        return this->impl->_get( Register::RBX );
+    }
+    
+    uint8_t RegisterFrame::ch( void ) const
+    {
+        return static_cast< uint8_t >( ( this->impl->_get( Register::RCX ) >> 8 ) & 0xFF );
+    }
+    
+    uint8_t RegisterFrame::cl( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RCX ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::cx( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RCX ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::ecx( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RCX ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rcx( void ) const
+    {
+        return this->impl->_get( Register::RCX );
+    }
+    
+    uint8_t RegisterFrame::dh( void ) const
+    {
+        return static_cast< uint8_t >( ( this->impl->_get( Register::RDX ) >> 8 ) & 0xFF );
+    }
+    
+    uint8_t RegisterFrame::dl( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RDX ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::dx( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RDX ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::edx( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RDX ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rdx( void ) const
+    {
+        return this->impl->_get( Register::RDX );
+    }
+    
+    uint8_t RegisterFrame::sil( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RSI ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::si( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RSI ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::esi( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RSI ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rsi( void ) const
+    {
+        return this->impl->_get( Register::RSI );
+    }
+    
+    uint8_t RegisterFrame::dil( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RDI ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::di( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RDI ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::edi( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RDI ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rdi( void ) const
+    {
+        return this->impl->_get( Register::RDI );
+    }
+    
+    uint8_t RegisterFrame::bpl( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RBP ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::bp( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RBP ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::ebp( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RBP ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rbp( void ) const
+    {
+        return this->impl->_get( Register::RBP );
+    }
+    
+    uint8_t RegisterFrame::spl( void ) const
+    {
+        return static_cast< uint8_t >( this->impl->_get( Register::RSP ) & 0xFF );
+    }
+    
+    uint16_t RegisterFrame::sp( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RSP ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::esp( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RSP ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rsp( void ) const
+    {
+        return this->impl->_get( Register::RSP );
+    }
+    
+    uint16_t RegisterFrame::ip( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::RIP ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::eip( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::RIP ) & 0xFFFFFFFF );
+    }
+    
+    uint64_t RegisterFrame::rip( void ) const
+    {
+        return this->impl->_get( Register::RIP );
+    }
+    
+    uint16_t RegisterFrame::cs( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::CS ) & 0xFFFF );
+    }
+    
+    uint16_t RegisterFrame::ds( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::DS ) & 0xFFFF );
+    }
+    
+    uint16_t RegisterFrame::es( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::ES ) & 0xFFFF );
+    }
+    
+    uint16_t RegisterFrame::fs( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::FS ) & 0xFFFF );
+    }
+    
+    uint16_t RegisterFrame::gs( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::GS ) & 0xFFFF );
+    }
+    
+    uint16_t RegisterFrame::ss( void ) const
+    {
+        return static_cast< uint16_t >( this->impl->_get( Register::SS ) & 0xFFFF );
+    }
+    
+    uint32_t RegisterFrame::eflags( void ) const
+    {
+        return static_cast< uint32_t >( this->impl->_get( Register::EFLAGS ) & 0xFFFFFFFF );
+    }
+    
+    void RegisterFrame::cf( bool value )
+    {
+        this->impl->_set( Register::EFLAGS, ( value ) ? 1 : 0, 0x01, 0 );
+    }
+    
+    void RegisterFrame::zf( bool value )
+    {
+        this->impl->_set( Register::EFLAGS, ( value ) ? 1 : 0, 0x01, 6 );
+    }
+    
+    void RegisterFrame::ah( uint8_t value )
+    {
+        this->impl->_set( Register::RAX, value, 0xFF, 8 );
+    }
+    
+    void RegisterFrame::al( uint8_t value )
+    {
+        this->impl->_set( Register::RAX, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::ax( uint16_t value )
+    {
+        this->impl->_set( Register::RAX, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::eax( uint32_t value )
+    {
+        this->impl->_set( Register::RAX, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rax( uint64_t value )
+    {
+        this->impl->_set( Register::RAX, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::bh( uint8_t value )
+    {
+        this->impl->_set( Register::RBX, value, 0xFF, 8 );
+    }
+    
+    void RegisterFrame::bl( uint8_t value )
+    {
+        this->impl->_set( Register::RBX, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::bx( uint16_t value )
+    {
+        this->impl->_set( Register::RBX, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::ebx( uint32_t value )
+    {
+        this->impl->_set( Register::RBX, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rbx( uint64_t value )
+    {
+        this->impl->_set( Register::RBX, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::ch( uint8_t value )
+    {
+        this->impl->_set( Register::RCX, value, 0xFF, 8 );
+    }
+    
+    void RegisterFrame::cl( uint8_t value )
+    {
+        this->impl->_set( Register::RCX, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::cx( uint16_t value )
+    {
+        this->impl->_set( Register::RCX, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::ecx( uint32_t value )
+    {
+        this->impl->_set( Register::RCX, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rcx( uint64_t value )
+    {
+        this->impl->_set( Register::RCX, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::dh( uint8_t value )
+    {
+        this->impl->_set( Register::RDX, value, 0xFF, 8 );
+    }
+    
+    void RegisterFrame::dl( uint8_t value )
+    {
+        this->impl->_set( Register::RDX, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::dx( uint16_t value )
+    {
+        this->impl->_set( Register::RDX, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::edx( uint32_t value )
+    {
+        this->impl->_set( Register::RDX, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rdx( uint64_t value )
+    {
+        this->impl->_set( Register::RDX, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::sil( uint8_t value )
+    {
+        this->impl->_set( Register::RSI, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::si( uint16_t value )
+    {
+        this->impl->_set( Register::RSI, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::esi( uint32_t value )
+    {
+        this->impl->_set( Register::RSI, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rsi( uint64_t value )
+    {
+        this->impl->_set( Register::RSI, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::dil( uint8_t value )
+    {
+        this->impl->_set( Register::RDI, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::di( uint16_t value )
+    {
+        this->impl->_set( Register::RDI, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::edi( uint32_t value )
+    {
+        this->impl->_set( Register::RDI, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rdi( uint64_t value )
+    {
+        this->impl->_set( Register::RDI, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::bpl( uint8_t value )
+    {
+        this->impl->_set( Register::RBP, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::bp( uint16_t value )
+    {
+        this->impl->_set( Register::RBP, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::ebp( uint32_t value )
+    {
+        this->impl->_set( Register::RBP, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rbp( uint64_t value )
+    {
+        this->impl->_set( Register::RBP, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::spl( uint8_t value )
+    {
+        this->impl->_set( Register::RSP, value, 0xFF, 0 );
+    }
+    
+    void RegisterFrame::sp( uint16_t value )
+    {
+        this->impl->_set( Register::RSP, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::esp( uint32_t value )
+    {
+        this->impl->_set( Register::RSP, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rsp( uint64_t value )
+    {
+        this->impl->_set( Register::RSP, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::ip( uint16_t value )
+    {
+        this->impl->_set( Register::RIP, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::eip( uint32_t value )
+    {
+        this->impl->_set( Register::RIP, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::rip( uint64_t value )
+    {
+        this->impl->_set( Register::RIP, value, 0xFFFFFFFFFFFFFFFF, 0 );
+    }
+    
+    void RegisterFrame::cs( uint16_t value )
+    {
+        this->impl->_set( Register::CS, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::ds( uint16_t value )
+    {
+        this->impl->_set( Register::DS, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::es( uint16_t value )
+    {
+        this->impl->_set( Register::ES, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::fs( uint16_t value )
+    {
+        this->impl->_set( Register::FS, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::gs( uint16_t value )
+    {
+        this->impl->_set( Register::GS, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::ss( uint16_t value )
+    {
+        this->impl->_set( Register::SS, value, 0xFFFF, 0 );
+    }
+    
+    void RegisterFrame::eflags( uint32_t value )
+    {
+        this->impl->_set( Register::EFLAGS, value, 0xFFFFFFFF, 0 );
+    }
+    
+    void swap( RegisterFrame & o1, RegisterFrame & o2 )
+    {
+        using std::swap;
+        
+        swap( o1.impl, o2.impl );
+    }
+    
+    RegisterFrame::IMPL::IMPL( void ):
+        _values{},
+        _dirty( 0 )
+    {}
+    
+    RegisterFrame::IMPL::IMPL( const IMPL & o ):
+        _values( o._values ),
+        _dirty(  o._dirty )
+    {}
+    
+    RegisterFrame::IMPL::~IMPL( void )
+    {}
+    
+    uint64_t RegisterFrame::IMPL::_get( Register reg ) const
+    {
+        return this->_values[ static_cast< size_t >( reg ) ];
+    }
+    
+    void RegisterFrame::IMPL::_set( Register reg, uint64_t value, uint64_t mask, unsigned int shift )
+    {
+        uint64_t & v( this->_values[ static_cast< size_t >( reg ) ] );
+        
+        v             = ( v & ~( mask << shift ) ) | ( ( value & mask ) << shift );
+        this->_dirty |= 1U << static_cast< unsigned int >( reg );
+    }
+}
@@ -55,7 +55,7 @@ namespace UB
                 
                 handlers->operator[]( sig ).push_back( handler );
                 
-                signal( SIGINT, ::handle ); 
+                signal( sig, ::handle );
             }
         }
     }
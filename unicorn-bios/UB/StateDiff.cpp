@@ -0,0 +1,459 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/StateDiff.hpp"
+#include "UB/Engine.hpp"
+#include "UB/Capstone.hpp"
+#include "UB/String.hpp"
+#include "UB/Casts.hpp"
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <stdexcept>
+
+namespace UB
+{
+    class StateDiff::IMPL
+    {
+        public:
+            
+            static const size_t blockSize    = 64;
+            static const size_t mergeGap     = 16;
+            static const size_t maxRanges    = 64;
+            static const size_t contextBytes = 64;
+            
+            static void _add( std::vector< std::pair< uint64_t, size_t > > & ranges, uint64_t address, size_t size );
+            static void _compare( const uint8_t * data1, const uint8_t * data2, size_t size, uint64_t address, std::vector< std::pair< uint64_t, size_t > > & ranges );
+            
+            IMPL( const StateFile & state1, const StateFile & state2 );
+            
+            void _compareRegisters( void );
+            void _compareSections( void );
+            void _compareMemory( void );
+            void _dump( std::ostream & os, const std::string & prefix, const std::vector< uint8_t > & data, uint64_t address ) const;
+            
+            const StateFile                                   & _state1;
+            const StateFile                                   & _state2;
+            std::vector< std::string >                          _registers;
+            std::vector< std::pair< uint64_t, uint64_t > >      _registerValues;
+            std::vector< std::string >                          _sections;
+            std::vector< std::string >                          _sectionInfo;
+            std::vector< std::pair< uint64_t, size_t > >        _ranges;
+            size_t                                              _pages;
+    };
+    
+    StateDiff::StateDiff( const StateFile & state1, const StateFile & state2 ):
+        impl( std::make_unique< IMPL >( state1, state2 ) )
+    {}
+    
+    StateDiff::~StateDiff( void )
+    {}
+    
+    bool StateDiff::identical( void ) const
+    {
+        return this->impl->_registers.size() == 0
+            && this->impl->_sections.size()  == 0
+            && this->impl->_ranges.size()    == 0
+            && this->impl->_state1.memory()  == this->impl->_state2.memory();
+    }
+    
+    size_t StateDiff::pages( void ) const
+    {
+        return this->impl->_pages;
+    }
+    
+    std::vector< std::string > StateDiff::registers( void ) const
+    {
+        return this->impl->_registers;
+    }
+    
+    std::vector< std::string > StateDiff::sections( void ) const
+    {
+        return this->impl->_sections;
+    }
+    
+    std::vector< std::pair< uint64_t, size_t > > StateDiff::ranges( void ) const
+    {
+        return this->impl->_ranges;
+    }
+    
+    std::string StateDiff::report( void ) const
+    {
+        std::stringstream ss;
+        size_t            bytes( 0 );
+        
+        if( this->identical() )
+        {
+            return "States are identical\n";
+        }
+        
+        if( this->impl->_registers.size() > 0 )
+        {
+            ss << "Registers:" << std::endl;
+            
+            for( size_t i = 0; i < this->impl->_registers.size(); i++ )
+            {
+                ss << "    "
+                   << std::left
+                   << std::setw( 16 )
+                   << this->impl->_registers[ i ] + ":"
+                   << std::right
+                   << String::toHex( this->impl->_registerValues[ i ].first )
+                   << " -> "
+                   << String::toHex( this->impl->_registerValues[ i ].second )
+                   << std::endl;
+            }
+        }
+        
+        if( this->impl->_sections.size() > 0 )
+        {
+            ss << "Devices:" << std::endl;
+            
+            for( size_t i = 0; i < this->impl->_sections.size(); i++ )
+            {
+                ss << "    "
+                   << std::left
+                   << std::setw( 16 )
+                   << this->impl->_sections[ i ] + ":"
+                   << std::right
+                   << this->impl->_sectionInfo[ i ]
+                   << std::endl;
+            }
+        }
+        
+        if( this->impl->_state1.memory() != this->impl->_state2.memory() )
+        {
+            ss << "Memory size: "
+               << this->impl->_state1.memory() / 1024 / 1024
+               << "MB -> "
+               << this->impl->_state2.memory() / 1024 / 1024
+               << "MB"
+               << std::endl;
+        }
+        
+        if( this->impl->_ranges.size() == 0 )
+        {
+            return ss.str();
+        }
+        
+        for( const auto & range: this->impl->_ranges )
+        {
+            bytes += range.second;
+        }
+        
+        ss << "Memory: "
+           << bytes
+           << " bytes in "
+           << this->impl->_ranges.size()
+           << " ranges ("
+           << this->impl->_pages
+           << " of "
+           << std::min( this->impl->_state1.pages(), this->impl->_state2.pages() )
+           << " pages differ)"
+           << std::endl;
+        
+        for( size_t i = 0; i < this->impl->_ranges.size() && i < IMPL::maxRanges; i++ )
+        {
+            uint64_t               address( this->impl->_ranges[ i ].first );
+            size_t                 size( this->impl->_ranges[ i ].second );
+            uint64_t               begin( address & ~static_cast< uint64_t >( 15 ) );
+            uint64_t               end( std::min< uint64_t >( begin + IMPL::contextBytes, ( address + size + 15 ) & ~static_cast< uint64_t >( 15 ) ) );
+            size_t                 code( numeric_cast< size_t >( std::min< uint64_t >( 16, std::min( this->impl->_state1.memory(), this->impl->_state2.memory() ) - address ) ) );
+            std::vector< uint8_t > data1( this->impl->_state1.read( begin, numeric_cast< size_t >( end - begin ) ) );
+            std::vector< uint8_t > data2( this->impl->_state2.read( begin, numeric_cast< size_t >( end - begin ) ) );
+            auto                   code1( Capstone::disassemble( this->impl->_state1.read( address, code ), address ) );
+            auto                   code2( Capstone::disassemble( this->impl->_state2.read( address, code ), address ) );
+            
+            ss << std::endl
+               << "    "
+               << String::toHex( address )
+               << " - "
+               << String::toHex( address + size - 1 )
+               << " ("
+               << size
+               << " bytes)"
+               << std::endl;
+            
+            this->impl->_dump( ss, "        - ", data1, begin );
+            this->impl->_dump( ss, "        + ", data2, begin );
+            
+            if( end < address + size )
+            {
+                ss << "        ..." << std::endl;
+            }
+            
+            for( size_t j = 0; j < code1.size() && j < 3; j++ )
+            {
+                ss << "        - " << code1[ j ].first << ": " << code1[ j ].second << std::endl;
+            }
+            
+            for( size_t j = 0; j < code2.size() && j < 3; j++ )
+            {
+                ss << "        + " << code2[ j ].first << ": " << code2[ j ].second << std::endl;
+            }
+        }
+        
+        if( this->impl->_ranges.size() > IMPL::maxRanges )
+        {
+            ss << std::endl
+               << "    ... "
+               << this->impl->_ranges.size() - IMPL::maxRanges
+               << " more ranges"
+               << std::endl;
+        }
+        
+        return ss.str();
+    }
+    
+    StateDiff::IMPL::IMPL( const StateFile & state1, const StateFile & state2 ):
+        _state1( state1 ),
+        _state2( state2 ),
+        _pages( 0 )
+    {
+        this->_compareRegisters();
+        this->_compareSections();
+        this->_compareMemory();
+    }
+    
+    void StateDiff::IMPL::_add( std::vector< std::pair< uint64_t, size_t > > & ranges, uint64_t address, size_t size )
+    {
+        if( ranges.size() > 0 && ranges.back().first + ranges.back().second + mergeGap >= address )
+        {
+            ranges.back().second = numeric_cast< size_t >( std::max( ranges.back().first + ranges.back().second, address + size ) - ranges.back().first );
+        }
+        else
+        {
+            ranges.push_back( { address, size } );
+        }
+    }
+    
+    void StateDiff::IMPL::_compare( const uint8_t * data1, const uint8_t * data2, size_t size, uint64_t address, std::vector< std::pair< uint64_t, size_t > > & ranges )
+    {
+        for( size_t i = 0; i < size; i += blockSize )
+        {
+            size_t n( std::min( blockSize, size - i ) );
+            
+            if( memcmp( data1 + i, data2 + i, n ) == 0 )
+            {
+                continue;
+            }
+            
+            for( size_t j = i; j < i + n; j++ )
+            {
+                if( data1[ j ] != data2[ j ] )
+                {
+                    _add( ranges, address + j, 1 );
+                }
+            }
+        }
+    }
+    
+    void StateDiff::IMPL::_compareRegisters( void )
+    {
+        std::vector< std::pair< std::string, uint64_t > > registers1;
+        std::vector< std::pair< std::string, uint64_t > > registers2;
+        std::map< std::string, uint64_t >                 values;
+        
+        if( this->_state1.hasSection( "cpu" ) )
+        {
+            registers1 = Engine::stateRegisters( this->_state1.section( "cpu" ) );
+        }
+        
+        if( this->_state2.hasSection( "cpu" ) )
+        {
+            registers2 = Engine::stateRegisters( this->_state2.section( "cpu" ) );
+        }
+        
+        for( const auto & reg: registers1 )
+        {
+            values[ reg.first ] = reg.second;
+        }
+        
+        for( const auto & reg: registers2 )
+        {
+            auto it( values.find( reg.first ) );
+            
+            if( it == values.end() || it->second != reg.second )
+            {
+                this->_registers.push_back( reg.first );
+                this->_registerValues.push_back( { ( it == values.end() ) ? 0 : it->second, reg.second } );
+            }
+        }
+    }
+    
+    void StateDiff::IMPL::_compareSections( void )
+    {
+        std::set< std::string > names;
+        
+        for( const std::string & name: this->_state1.sections() )
+        {
+            names.insert( name );
+        }
+        
+        for( const std::string & name: this->_state2.sections() )
+        {
+            names.insert( name );
+        }
+        
+        names.erase( "cpu" );
+        
+        for( const std::string & name: names )
+        {
+            std::vector< uint8_t > data1;
+            std::vector< uint8_t > data2;
+            size_t                 count( 0 );
+            
+            if( this->_state1.hasSection( name ) )
+            {
+                data1 = this->_state1.section( name );
+            }
+            
+            if( this->_state2.hasSection( name ) )
+            {
+                data2 = this->_state2.section( name );
+            }
+            
+            if( data1 == data2 )
+            {
+                continue;
+            }
+            
+            this->_sections.push_back( name );
+            
+            if( data1.size() != data2.size() )
+            {
+                this->_sectionInfo.push_back( std::to_string( data1.size() ) + " -> " + std::to_string( data2.size() ) + " bytes" );
+                
+                continue;
+            }
+            
+            for( size_t i = 0; i < data1.size(); i++ )
+            {
+                count += ( data1[ i ] != data2[ i ] ) ? 1 : 0;
+            }
+            
+            this->_sectionInfo.push_back( std::to_string( count ) + " of " + std::to_string( data1.size() ) + " bytes differ" );
+        }
+    }
+    
+    void StateDiff::IMPL::_compareMemory( void )
+    {
+        size_t                                                      page( Engine::pageSize );
+        size_t                                                      pages( std::min( this->_state1.pages(), this->_state2.pages() ) );
+        size_t                                                      count( std::max< unsigned int >( 1, std::thread::hardware_concurrency() ) );
+        std::vector< std::vector< std::pair< uint64_t, size_t > > > ranges( count );
+        std::vector< size_t >                                       differing( count, 0 );
+        std::vector< std::thread >                                  threads;
+        std::atomic< bool >                                         failed( false );
+        
+        for( size_t t = 0; t < count; t++ )
+        {
+            threads.emplace_back
+            (
+                [ &, t ]
+                {
+                    size_t begin( ( pages * t ) / count );
+                    size_t end( ( pages * ( t + 1 ) ) / count );
+                    
+                    try
+                    {
+                        for( size_t i = begin; i < end; i++ )
+                        {
+                            if( this->_state1.isZero( i ) && this->_state2.isZero( i ) )
+                            {
+                                continue;
+                            }
+                            
+                            if( this->_state1.hash( i ) == this->_state2.hash( i ) )
+                            {
+                                continue;
+                            }
+                            
+                            {
+                                uint64_t               address( static_cast< uint64_t >( i ) * page );
+                                size_t                 size( numeric_cast< size_t >( std::min< uint64_t >( page, std::min( this->_state1.memory(), this->_state2.memory() ) - address ) ) );
+                                std::vector< uint8_t > data1( this->_state1.read( address, size ) );
+                                std::vector< uint8_t > data2( this->_state2.read( address, size ) );
+                                
+                                differing[ t ]++;
+                                
+                                _compare( data1.data(), data2.data(), size, address, ranges[ t ] );
+                            }
+                        }
+                    }
+                    catch( ... )
+                    {
+                        failed = true;
+                    }
+                }
+            );
+        }
+        
+        for( auto & thread: threads )
+        {
+            thread.join();
+        }
+        
+        if( failed )
+        {
+            throw std::runtime_error( "Cannot compare save states: invalid page data" );
+        }
+        
+        for( size_t t = 0; t < count; t++ )
+        {
+            this->_pages += differing[ t ];
+            
+            for( const auto & range: ranges[ t ] )
+            {
+                _add( this->_ranges, range.first, range.second );
+            }
+        }
+    }
+    
+    void StateDiff::IMPL::_dump( std::ostream & os, const std::string & prefix, const std::vector< uint8_t > & data, uint64_t address ) const
+    {
+        for( size_t i = 0; i < data.size(); i += 16 )
+        {
+            os << prefix << String::toHex( address + i ) << ":";
+            
+            for( size_t j = i; j < i + 16 && j < data.size(); j++ )
+            {
+                os << " "
+                   << std::hex
+                   << std::uppercase
+                   << std::setfill( '0' )
+                   << std::setw( 2 )
+                   << static_cast< unsigned int >( data[ j ] )
+                   << std::dec
+                   << std::setfill( ' ' );
+            }
+            
+            os << std::endl;
+        }
+    }
+}
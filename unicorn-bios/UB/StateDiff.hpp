@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_STATE_DIFF_HPP
+#define UB_STATE_DIFF_HPP
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "UB/StateFile.hpp"
+
+namespace UB
+{
+    class StateDiff
+    {
+        public:
+            
+            StateDiff( const StateFile & state1, const StateFile & state2 );
+            ~StateDiff( void );
+            
+            StateDiff( const StateDiff & o )              = delete;
+            StateDiff( StateDiff && o )                   = delete;
+            StateDiff & operator =( const StateDiff & o ) = delete;
+            StateDiff & operator =( StateDiff && o )      = delete;
+            
+            bool                                         identical( void ) const;
+            size_t                                       pages( void )     const;
+            std::vector< std::string >                   registers( void ) const;
+            std::vector< std::string >                   sections( void )  const;
+            std::vector< std::pair< uint64_t, size_t > > ranges( void )    const;
+            std::string                                  report( void )    const;
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_STATE_DIFF_HPP */
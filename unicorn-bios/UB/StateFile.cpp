@@ -0,0 +1,695 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/StateFile.hpp"
+#include "UB/Casts.hpp"
+#include <zlib.h>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <stdexcept>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace UB
+{
+    class StateFile::IMPL
+    {
+        public:
+            
+            enum class Storage: uint32_t
+            {
+                Zero     = 0,
+                Deflated = 1,
+                Stored   = 2
+            };
+            
+            struct Entry
+            {
+                uint64_t offset;
+                uint32_t size;
+                uint32_t length;
+                Storage  storage;
+                uint64_t hash;
+            };
+            
+            static const std::string magic;
+            static const uint16_t    version;
+            static const size_t      headerSize  = 32;
+            static const size_t      sectionSize = 40;
+            static const size_t      entrySize   = 24;
+            static const size_t      nameSize    = 16;
+            
+            static uint64_t _hash( const uint8_t * data, size_t size );
+            static void     _write( const std::string & path, const std::map< std::string, std::vector< uint8_t > > & sections, size_t memory, const std::function< std::vector< uint8_t >( uint64_t, size_t ) > & read );
+            
+            IMPL( const std::string & path );
+            ~IMPL( void );
+            
+            void                   _open( void );
+            void                   _close( void );
+            uint64_t               _read( uint64_t offset, size_t bytes ) const;
+            const uint8_t        * _data( const Entry & entry )           const;
+            std::vector< uint8_t > _inflate( const Entry & entry )        const;
+            
+            std::string                     _path;
+            int                             _fd;
+            uint8_t                       * _file;
+            size_t                          _size;
+            size_t                          _memory;
+            std::map< std::string, Entry >  _sections;
+            std::vector< Entry >            _pages;
+    };
+    
+    const std::string StateFile::IMPL::magic   = "UBSS";
+    const uint16_t    StateFile::IMPL::version = 3;
+    
+    bool StateFile::isStateFile( const std::string & path )
+    {
+        std::ifstream stream( path, std::ios::binary | std::ios::in );
+        char          buf[ 4 ];
+        
+        if( stream.good() == false )
+        {
+            return false;
+        }
+        
+        if( stream.read( buf, sizeof( buf ) ).gcount() != sizeof( buf ) )
+        {
+            return false;
+        }
+        
+        return std::string( buf, sizeof( buf ) ) == IMPL::magic;
+    }
+    
+    void StateFile::write( const std::string & path, const std::map< std::string, std::vector< uint8_t > > & sections, size_t memory, const std::function< std::vector< uint8_t >( uint64_t, size_t ) > & read )
+    {
+        std::vector< char > temp( path.begin(), path.end() );
+        int                 fd;
+        
+        temp.insert( temp.end(), { '.', 'X', 'X', 'X', 'X', 'X', 'X', 0 } );
+        
+        if( ( fd = mkstemp( temp.data() ) ) < 0 )
+        {
+            throw std::runtime_error( "Cannot create save state: " + path + " - " + strerror( errno ) );
+        }
+        
+        fchmod( fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+        close( fd );
+        
+        try
+        {
+            IMPL::_write( temp.data(), sections, memory, read );
+            
+            if( rename( temp.data(), path.c_str() ) != 0 )
+            {
+                throw std::runtime_error( "Cannot write save state: " + path + " - " + strerror( errno ) );
+            }
+        }
+        catch( ... )
+        {
+            unlink( temp.data() );
+            
+            throw;
+        }
+    }
+    
+    void StateFile::IMPL::_write( const std::string & path, const std::map< std::string, std::vector< uint8_t > > & sections, size_t memory, const std::function< std::vector< uint8_t >( uint64_t, size_t ) > & read )
+    {
+        std::ofstream                                        out( path, std::ios::binary | std::ios::out | std::ios::trunc );
+        std::vector< std::pair< std::string, IMPL::Entry > > entries;
+        std::vector< IMPL::Entry >                           pages;
+        size_t                                               page( Engine::pageSize );
+        uint64_t                                             count( ( memory + page - 1 ) / page );
+        uint64_t                                             offset;
+        
+        auto write = [ & ]( uint64_t value, size_t bytes )
+        {
+            for( size_t i = 0; i < bytes; i++ )
+            {
+                out.put( static_cast< char >( ( value >> ( i * 8 ) ) & 0xFF ) );
+            }
+        };
+        
+        auto store = [ & ]( const uint8_t * data, size_t length, bool align ) -> IMPL::Entry
+        {
+            std::vector< uint8_t > deflated( compressBound( numeric_cast< uLong >( length ) ), 0 );
+            uLongf                 deflatedLength( numeric_cast< uLongf >( deflated.size() ) );
+            uint64_t               hash( IMPL::_hash( data, length ) );
+            
+            if( std::all_of( data, data + length, []( uint8_t b ) { return b == 0; } ) )
+            {
+                return { 0, 0, numeric_cast< uint32_t >( length ), IMPL::Storage::Zero, hash };
+            }
+            
+            if( compress2( deflated.data(), &deflatedLength, data, numeric_cast< uLong >( length ), Z_BEST_SPEED ) == Z_OK && deflatedLength < length )
+            {
+                IMPL::Entry entry { offset, numeric_cast< uint32_t >( deflatedLength ), numeric_cast< uint32_t >( length ), IMPL::Storage::Deflated, hash };
+                
+                out.write( reinterpret_cast< const char * >( deflated.data() ), numeric_cast< std::streamsize >( deflatedLength ) );
+                
+                offset += deflatedLength;
+                
+                return entry;
+            }
+            
+            if( align && offset % page != 0 )
+            {
+                offset += page - ( offset % page );
+                
+                out.seekp( numeric_cast< std::streamoff >( offset ), std::ios_base::beg );
+            }
+            
+            {
+                IMPL::Entry entry { offset, numeric_cast< uint32_t >( length ), numeric_cast< uint32_t >( length ), IMPL::Storage::Stored, hash };
+                
+                out.write( reinterpret_cast< const char * >( data ), numeric_cast< std::streamsize >( length ) );
+                
+                offset += length;
+                
+                return entry;
+            }
+        };
+        
+        if( out.good() == false )
+        {
+            throw std::runtime_error( "Cannot create save state: " + path );
+        }
+        
+        offset = IMPL::headerSize + ( sections.size() * IMPL::sectionSize ) + ( count * IMPL::entrySize );
+        
+        out.seekp( numeric_cast< std::streamoff >( offset ), std::ios_base::beg );
+        
+        for( const auto & p: sections )
+        {
+            if( p.first.length() == 0 || p.first.length() > IMPL::nameSize )
+            {
+                throw std::runtime_error( "Invalid save state section name: " + p.first );
+            }
+            
+            entries.push_back( { p.first, store( p.second.data(), p.second.size(), false ) } );
+        }
+        
+        for( uint64_t address = 0; address < memory; address += 256 * page )
+        {
+            std::vector< uint8_t > data( read( address, numeric_cast< size_t >( std::min< uint64_t >( 256 * page, memory - address ) ) ) );
+            
+            for( size_t i = 0; i < data.size(); i += page )
+            {
+                pages.push_back( store( data.data() + i, std::min( page, data.size() - i ), true ) );
+            }
+        }
+        
+        out.seekp( 0, std::ios_base::beg );
+        out.write( IMPL::magic.data(), numeric_cast< std::streamsize >( IMPL::magic.size() ) );
+        write( IMPL::version,                                          2 );
+        write( 0,                                                      2 );
+        write( page,                                                   4 );
+        write( sections.size(),                                        4 );
+        write( memory,                                                 8 );
+        write( IMPL::headerSize + sections.size() * IMPL::sectionSize, 8 );
+        
+        for( const auto & p: entries )
+        {
+            out.write( p.first.data(), numeric_cast< std::streamsize >( p.first.length() ) );
+            
+            for( size_t i = p.first.length(); i < IMPL::nameSize; i++ )
+            {
+                out.put( 0 );
+            }
+            
+            write( p.second.offset,                             8 );
+            write( p.second.size,                               4 );
+            write( p.second.length,                             4 );
+            write( static_cast< uint32_t >( p.second.storage ), 4 );
+            write( 0,                                           4 );
+        }
+        
+        for( const auto & entry: pages )
+        {
+            write( entry.offset,                             8 );
+            write( entry.size,                               4 );
+            write( static_cast< uint32_t >( entry.storage ), 4 );
+            write( entry.hash,                               8 );
+        }
+        
+        out.close();
+        
+        if( out.good() == false )
+        {
+            throw std::runtime_error( "Cannot write save state: " + path );
+        }
+    }
+    
+    StateFile::StateFile( const std::string & path ):
+        impl( std::make_unique< IMPL >( path ) )
+    {}
+    
+    StateFile::~StateFile( void )
+    {}
+    
+    size_t StateFile::memory( void ) const
+    {
+        return this->impl->_memory;
+    }
+    
+    bool StateFile::hasSection( const std::string & name ) const
+    {
+        return this->impl->_sections.find( name ) != this->impl->_sections.end();
+    }
+    
+    std::vector< std::string > StateFile::sections( void ) const
+    {
+        std::vector< std::string > names;
+        
+        for( const auto & p: this->impl->_sections )
+        {
+            names.push_back( p.first );
+        }
+        
+        return names;
+    }
+    
+    std::vector< uint8_t > StateFile::section( const std::string & name ) const
+    {
+        auto it( this->impl->_sections.find( name ) );
+        
+        if( it == this->impl->_sections.end() )
+        {
+            throw std::runtime_error( "Missing save state section: " + name );
+        }
+        
+        return this->impl->_inflate( it->second );
+    }
+    
+    size_t StateFile::pages( void ) const
+    {
+        return this->impl->_pages.size();
+    }
+    
+    uint64_t StateFile::hash( size_t page ) const
+    {
+        if( page >= this->impl->_pages.size() )
+        {
+            throw std::runtime_error( "Invalid save state page: " + std::to_string( page ) );
+        }
+        
+        return this->impl->_pages[ page ].hash;
+    }
+    
+    bool StateFile::isZero( size_t page ) const
+    {
+        if( page >= this->impl->_pages.size() )
+        {
+            throw std::runtime_error( "Invalid save state page: " + std::to_string( page ) );
+        }
+        
+        return this->impl->_pages[ page ].storage == IMPL::Storage::Zero;
+    }
+    
+    std::vector< uint8_t > StateFile::read( uint64_t address, size_t size ) const
+    {
+        size_t                 page( Engine::pageSize );
+        std::vector< uint8_t > data;
+        
+        if( address > this->impl->_memory || size > this->impl->_memory - address )
+        {
+            throw std::runtime_error( "Invalid save state memory range: " + std::to_string( address ) );
+        }
+        
+        data.reserve( size );
+        
+        while( data.size() < size )
+        {
+            uint64_t               i( address / page );
+            size_t                 offset( numeric_cast< size_t >( address % page ) );
+            std::vector< uint8_t > bytes( this->impl->_inflate( this->impl->_pages[ numeric_cast< size_t >( i ) ] ) );
+            size_t                 n( std::min( bytes.size() - offset, size - data.size() ) );
+            
+            data.insert( data.end(), bytes.begin() + numeric_cast< std::ptrdiff_t >( offset ), bytes.begin() + numeric_cast< std::ptrdiff_t >( offset + n ) );
+            
+            address += n;
+        }
+        
+        return data;
+    }
+    
+    void StateFile::load( Engine & engine ) const
+    {
+        size_t                  host( static_cast< size_t >( sysconf( _SC_PAGESIZE ) ) );
+        size_t                  page( Engine::pageSize );
+        std::vector< uint64_t > deflated;
+        
+        if( engine.memory() != this->impl->_memory )
+        {
+            throw std::runtime_error( "Save state memory size does not match: " + std::to_string( this->impl->_memory / 1024 / 1024 ) + "MB" );
+        }
+        
+        engine.clearMemory();
+        
+        for( uint64_t i = 0; i < this->impl->_pages.size(); )
+        {
+            uint64_t n( 1 );
+            
+            if( this->impl->_pages[ i ].storage == IMPL::Storage::Deflated )
+            {
+                deflated.push_back( i++ );
+                
+                continue;
+            }
+            
+            if( this->impl->_pages[ i ].storage != IMPL::Storage::Stored )
+            {
+                i++;
+                
+                continue;
+            }
+            
+            while
+            (
+                   i + n < this->impl->_pages.size()
+                && this->impl->_pages[ i + n ].storage == IMPL::Storage::Stored
+                && this->impl->_pages[ i + n ].offset  == this->impl->_pages[ i ].offset + n * page
+            )
+            {
+                n++;
+            }
+            
+            {
+                uint64_t address( i * page );
+                size_t   size( numeric_cast< size_t >( std::min< uint64_t >( n * page, this->impl->_memory - address ) ) );
+                
+                if( address % host == 0 && size % host == 0 && this->impl->_pages[ i ].offset % host == 0 )
+                {
+                    engine.map( address, size, this->impl->_fd, this->impl->_pages[ i ].offset );
+                }
+                else
+                {
+                    engine.write( address, this->impl->_data( this->impl->_pages[ i ] ), size );
+                }
+            }
+            
+            i += n;
+        }
+        
+        if( deflated.size() > 0 )
+        {
+            std::vector< std::thread > threads;
+            size_t                     count( std::max< unsigned int >( 1, std::thread::hardware_concurrency() ) );
+            size_t                     chunk( 256 );
+            std::atomic< size_t >      next( 0 );
+            std::atomic< bool >        failed( false );
+            
+            for( size_t t = 0; t < count; t++ )
+            {
+                threads.emplace_back
+                (
+                    [ & ]
+                    {
+                        std::vector< uint8_t > data( chunk * page, 0 );
+                        
+                        try
+                        {
+                            for( size_t first = next.fetch_add( chunk ); first < deflated.size() && failed == false; first = next.fetch_add( chunk ) )
+                            {
+                                size_t last( std::min( first + chunk, deflated.size() ) );
+                                
+                                for( size_t i = first; i < last; i++ )
+                                {
+                                    const IMPL::Entry & entry( this->impl->_pages[ deflated[ i ] ] );
+                                    uLongf              length( numeric_cast< uLongf >( entry.length ) );
+                                    
+                                    if( uncompress( data.data() + ( i - first ) * page, &length, this->impl->_data( entry ), numeric_cast< uLong >( entry.size ) ) != Z_OK || length != entry.length )
+                                    {
+                                        failed = true;
+                                        
+                                        return;
+                                    }
+                                }
+                                
+                                for( size_t i = first; i < last; )
+                                {
+                                    size_t   n( 1 );
+                                    uint64_t address( deflated[ i ] * page );
+                                    
+                                    while( i + n < last && deflated[ i + n ] == deflated[ i ] + n )
+                                    {
+                                        n++;
+                                    }
+                                    
+                                    engine.write( address, data.data() + ( i - first ) * page, numeric_cast< size_t >( std::min< uint64_t >( n * page, this->impl->_memory - address ) ) );
+                                    
+                                    i += n;
+                                }
+                            }
+                        }
+                        catch( ... )
+                        {
+                            failed = true;
+                        }
+                    }
+                );
+            }
+            
+            for( auto & thread: threads )
+            {
+                thread.join();
+            }
+            
+            if( failed )
+            {
+                throw std::runtime_error( "Invalid save state page data: " + this->impl->_path );
+            }
+        }
+    }
+    
+    StateFile::IMPL::IMPL( const std::string & path ):
+        _path( path ),
+        _fd( -1 ),
+        _file( nullptr ),
+        _size( 0 ),
+        _memory( 0 )
+    {
+        try
+        {
+            this->_open();
+        }
+        catch( ... )
+        {
+            this->_close();
+            
+            throw;
+        }
+    }
+    
+    StateFile::IMPL::~IMPL( void )
+    {
+        this->_close();
+    }
+    
+    void StateFile::IMPL::_open( void )
+    {
+        struct stat st;
+        size_t      page( Engine::pageSize );
+        uint64_t    sections;
+        uint64_t    index;
+        uint64_t    count;
+        
+        if( ( this->_fd = open( this->_path.c_str(), O_RDONLY | O_CLOEXEC ) ) < 0 || fstat( this->_fd, &st ) != 0 )
+        {
+            throw std::runtime_error( "Cannot open save state: " + this->_path );
+        }
+        
+        this->_size = static_cast< size_t >( st.st_size );
+        
+        if( this->_size < headerSize )
+        {
+            throw std::runtime_error( "Invalid save state: " + this->_path );
+        }
+        
+        {
+            void * file( mmap( nullptr, this->_size, PROT_READ, MAP_PRIVATE, this->_fd, 0 ) );
+            
+            if( file == MAP_FAILED )
+            {
+                throw std::runtime_error( "Cannot map save state: " + this->_path + " - " + strerror( errno ) );
+            }
+            
+            this->_file = static_cast< uint8_t * >( file );
+        }
+        
+        if( std::string( reinterpret_cast< const char * >( this->_file ), magic.size() ) != magic )
+        {
+            throw std::runtime_error( "Invalid save state: " + this->_path );
+        }
+        
+        if( this->_read( 4, 2 ) != version )
+        {
+            throw std::runtime_error( "Unsupported save state version: " + this->_path );
+        }
+        
+        if( this->_read( 8, 4 ) != page )
+        {
+            throw std::runtime_error( "Unsupported save state page size: " + this->_path );
+        }
+        
+        sections      = this->_read( 12, 4 );
+        this->_memory = numeric_cast< size_t >( this->_read( 16, 8 ) );
+        index         = this->_read( 24, 8 );
+        count         = ( this->_memory + page - 1 ) / page;
+        
+        if( index != headerSize + sections * sectionSize || index + count * entrySize > this->_size )
+        {
+            throw std::runtime_error( "Invalid save state: " + this->_path );
+        }
+        
+        for( uint64_t i = 0; i < sections; i++ )
+        {
+            uint64_t     offset( headerSize + i * sectionSize );
+            const char * name( reinterpret_cast< const char * >( this->_file + offset ) );
+            Entry        entry;
+            
+            entry.offset  = this->_read( offset + nameSize,      8 );
+            entry.size    = static_cast< uint32_t >( this->_read( offset + nameSize + 8,  4 ) );
+            entry.length  = static_cast< uint32_t >( this->_read( offset + nameSize + 12, 4 ) );
+            entry.storage = static_cast< Storage >( this->_read( offset + nameSize + 16, 4 ) );
+            
+            this->_sections[ std::string( name, strnlen( name, nameSize ) ) ] = entry;
+        }
+        
+        for( uint64_t i = 0; i < count; i++ )
+        {
+            uint64_t offset( index + i * entrySize );
+            Entry    entry;
+            
+            entry.offset  = this->_read( offset,     8 );
+            entry.size    = static_cast< uint32_t >( this->_read( offset + 8,  4 ) );
+            entry.length  = static_cast< uint32_t >( std::min< uint64_t >( page, this->_memory - i * page ) );
+            entry.storage = static_cast< Storage >( this->_read( offset + 12, 4 ) );
+            entry.hash    = this->_read( offset + 16, 8 );
+            
+            if( entry.storage == Storage::Stored && entry.size != entry.length )
+            {
+                throw std::runtime_error( "Invalid save state page: " + std::to_string( i ) );
+            }
+            
+            this->_pages.push_back( entry );
+        }
+    }
+    
+    void StateFile::IMPL::_close( void )
+    {
+        if( this->_file != nullptr )
+        {
+            munmap( this->_file, this->_size );
+        }
+        
+        if( this->_fd >= 0 )
+        {
+            close( this->_fd );
+        }
+        
+        this->_file = nullptr;
+        this->_fd   = -1;
+    }
+    
+    uint64_t StateFile::IMPL::_hash( const uint8_t * data, size_t size )
+    {
+        uint64_t hash( 0xCBF29CE484222325 );
+        size_t   i;
+        
+        for( i = 0; i + 8 <= size; i += 8 )
+        {
+            uint64_t word;
+            
+            memcpy( &word, data + i, 8 );
+            
+            hash ^= word;
+            hash *= 0x100000001B3;
+            hash ^= hash >> 29;
+        }
+        
+        for( ; i < size; i++ )
+        {
+            hash ^= data[ i ];
+            hash *= 0x100000001B3;
+        }
+        
+        return hash;
+    }
+    
+    uint64_t StateFile::IMPL::_read( uint64_t offset, size_t bytes ) const
+    {
+        uint64_t value( 0 );
+        
+        for( size_t i = 0; i < bytes; i++ )
+        {
+            value |= static_cast< uint64_t >( this->_file[ offset + i ] ) << ( i * 8 );
+        }
+        
+        return value;
+    }
+    
+    const uint8_t * StateFile::IMPL::_data( const Entry & entry ) const
+    {
+        if( entry.offset > this->_size || entry.size > this->_size - entry.offset )
+        {
+            throw std::runtime_error( "Invalid save state: " + this->_path + " - Not enough data available" );
+        }
+        
+        return this->_file + entry.offset;
+    }
+    
+    std::vector< uint8_t > StateFile::IMPL::_inflate( const Entry & entry ) const
+    {
+        std::vector< uint8_t > data( entry.length, 0 );
+        
+        if( entry.storage == Storage::Stored && entry.size == entry.length )
+        {
+            memcpy( data.data(), this->_data( entry ), data.size() );
+        }
+        else if( entry.storage == Storage::Deflated )
+        {
+            uLongf length( numeric_cast< uLongf >( data.size() ) );
+            
+            if( uncompress( data.data(), &length, this->_data( entry ), numeric_cast< uLong >( entry.size ) ) != Z_OK || length != data.size() )
+            {
+                throw std::runtime_error( "Invalid save state: " + this->_path );
+            }
+        }
+        else if( entry.storage != Storage::Zero )
+        {
+            throw std::runtime_error( "Invalid save state: " + this->_path );
+        }
+        
+        return data;
+    }
+}
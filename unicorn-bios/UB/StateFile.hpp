@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_STATE_FILE_HPP
+#define UB_STATE_FILE_HPP
+
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <cstdint>
+#include "UB/Engine.hpp"
+
+namespace UB
+{
+    /*
+     * Reads and writes machine save-states.
+     *
+     * The file starts with a 32 bytes header ("UBSS" magic, version, page
+     * size, section count, memory size and index offset), followed by one
+     * 40 bytes entry per named section (CPU context, devices...) and one
+     * 24 bytes index entry per guest RAM page (file offset, stored size,
+     * storage type and a 64 bits hash of the page contents, so states can be
+     * compared without inflating identical pages). All values are
+     * little-endian.
+     * Pages only containing zeroes are not stored, other pages are either
+     * deflated or stored raw at a page-aligned offset, so they can be mapped
+     * copy-on-write into guest RAM instead of being read.
+     */
+    class StateFile
+    {
+        public:
+            
+            static bool isStateFile( const std::string & path );
+            static void write( const std::string & path, const std::map< std::string, std::vector< uint8_t > > & sections, size_t memory, const std::function< std::vector< uint8_t >( uint64_t, size_t ) > & read );
+            
+            StateFile( const std::string & path );
+            ~StateFile( void );
+            
+            StateFile( const StateFile & o )              = delete;
+            StateFile( StateFile && o )                   = delete;
+            StateFile & operator =( const StateFile & o ) = delete;
+            StateFile & operator =( StateFile && o )      = delete;
+            
+            size_t                     memory( void )                         const;
+            bool                       hasSection( const std::string & name ) const;
+            std::vector< std::string > sections( void )                       const;
+            std::vector< uint8_t >     section( const std::string & name )    const;
+            size_t                     pages( void )                          const;
+            uint64_t                   hash( size_t page )                    const;
+            bool                       isZero( size_t page )                  const;
+            std::vector< uint8_t >     read( uint64_t address, size_t size )  const;
+            void                       load( Engine & engine )                const;
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_STATE_FILE_HPP */
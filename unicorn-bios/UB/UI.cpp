@@ -31,6 +31,7 @@
 #include "UB/Capstone.hpp"
 #include "UB/Window.hpp"
 #include "UB/Signal.hpp"
+#include "UB/Devices/VGA.hpp"
 #include <mutex>
 #include <optional>
 #include <thread>
@@ -38,6 +39,7 @@
 #include <optional>
 #include <iostream>
 #include <condition_variable>
+#include <chrono>
 #include <csignal>
 
 namespace UB
@@ -62,11 +64,14 @@ namespace UB
             void _displayInstructions( void );
             void _displayDisassembly( void );
             void _displayMemory( void );
+            void _displayScreen( void );
             void _memoryScrollUp( size_t n = 1 );
             void _memoryScrollDown( size_t n = 1 );
             void _memoryPageUp( void );
             void _memoryPageDown( void );
             
+            static Color _color( uint8_t attribute );
+            
             bool                          _running;
             Mode                          _mode;
             Engine                      & _engine;
@@ -80,6 +85,11 @@ namespace UB
             std::optional< std::string >  _memoryAddressPrompt;
             std::function< void( int ) >  _waitEnterOrSpaceKeyPress;
             mutable std::recursive_mutex  _rmtx;
+            
+            std::shared_ptr< Devices::VGA > _vga;
+            bool                            _showScreen;
+            std::unique_ptr< Window >       _screenWindow;
+            std::vector< size_t >           _screenLayout;
     };
     
     UI::UI( Engine & engine ):
@@ -148,13 +158,26 @@ namespace UB
             {
                 this->impl->_setupScreen();
             }
-            else
+            else if( mode == Mode::Standard )
             {
                 this->impl->_output.redirect( std::cout );
                 this->impl->_debug.redirect(  std::cerr );
             }
         }
         
+        if( mode == Mode::Headless )
+        {
+            this->impl->_engine.waitUntilFinished();
+            
+            {
+                std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+                
+                this->impl->_running = false;
+            }
+            
+            return;
+        }
+        
         {
             std::condition_variable_any cv;
             
@@ -189,7 +212,7 @@ namespace UB
                     {
                         while( exit == false )
                         {
-                            std::this_thread::yield();
+                            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
                         }
                     }
                     
@@ -224,6 +247,11 @@ namespace UB
         bool                        keyPressed( false );
         std::condition_variable_any cv;
         
+        if( this->mode() == Mode::Headless )
+        {
+            return '\n';
+        }
+        
         if( this->mode() == Mode::Standard )
         {
             std::cout << "Emulation paused - Press [ENTER] to continue..." << std::endl;
@@ -294,6 +322,13 @@ namespace UB
         return this->impl->_debug;
     }
     
+    void UI::vga( const std::shared_ptr< Devices::VGA > & vga )
+    {
+        std::lock_guard< std::recursive_mutex > l( this->impl->_rmtx );
+        
+        this->impl->_vga = vga;
+    }
+    
     void swap( UI & o1, UI & o2 )
     {
         std::lock( o1.impl->_rmtx, o2.impl->_rmtx );
@@ -316,7 +351,8 @@ namespace UB
         _statusColor(        Color::red() ),
         _memoryOffset(       0x7C00 ),
         _memoryBytesPerLine( 0 ),
-        _memoryLines(        0 )
+        _memoryLines(        0 ),
+        _showScreen(         false )
     {
         this->_setupEngine();
     }
@@ -335,7 +371,8 @@ namespace UB
         _statusColor(        Color::red() ),
         _memoryOffset(       o._memoryOffset ),
         _memoryBytesPerLine( o._memoryBytesPerLine ),
-        _memoryLines(        o._memoryLines )
+        _memoryLines(        o._memoryLines ),
+        _showScreen(         o._showScreen )
     {
         ( void )l;
         
@@ -386,9 +423,18 @@ namespace UB
                 this->_displayStack();
                 this->_displayInstructions();
                 this->_displayDisassembly();
-                this->_displayMemory();
-                this->_displayOutput();
-                this->_displayDebug();
+                
+                if( this->_showScreen && this->_vga != nullptr )
+                {
+                    this->_displayScreen();
+                }
+                else
+                {
+                    this->_displayMemory();
+                    this->_displayOutput();
+                    this->_displayDebug();
+                }
+                
                 this->_displayStatus();
             }
         );
@@ -469,6 +515,11 @@ namespace UB
                     {
                         this->_memoryOffset = 0;
                     }
+                    else if( key == 'v' )
+                    {
+                        this->_showScreen   = this->_showScreen == false;
+                        this->_screenWindow = nullptr;
+                    }
                 }
             }
         );
@@ -1048,6 +1099,72 @@ namespace UB
         win.refresh();
     }
     
+    void UI::IMPL::_displayScreen( void )
+    {
+        size_t                x(      0 );
+        size_t                y(      21 );
+        size_t                width(  Screen::shared().width() );
+        size_t                height( Screen::shared().height() - y - 3 );
+        size_t                columns( this->_vga->columns() );
+        size_t                rows( this->_vga->rows() );
+        std::vector< size_t > layout( { width, height, columns, rows } );
+        
+        if( this->_screenWindow == nullptr || this->_screenLayout != layout )
+        {
+            this->_screenWindow = std::make_unique< Window >( x, y, width, height );
+            this->_screenLayout = layout;
+            
+            this->_screenWindow->box();
+            this->_screenWindow->move( 2, 1 );
+            this->_screenWindow->print( Color::blue(), "Screen (%zux%zu):", columns, rows );
+            this->_screenWindow->move( 1, 2 );
+            this->_screenWindow->addHorizontalLine( width - 2 );
+            this->_vga->invalidate();
+        }
+        
+        {
+            std::vector< size_t > cells( this->_vga->dirty() );
+            
+            if( cells.size() > 0 )
+            {
+                std::vector< uint8_t > memory( this->_engine.read( Devices::VGA::textBase + static_cast< size_t >( this->_vga->start() ) * 2, columns * rows * 2 ) );
+                
+                for( size_t cell: cells )
+                {
+                    char c( Devices::VGA::character( memory[ cell * 2 ] ) );
+                    
+                    if( 2 + ( cell % columns ) >= width - 1 || 3 + ( cell / columns ) >= height - 1 )
+                    {
+                        continue;
+                    }
+                    
+                    this->_screenWindow->move( 2 + ( cell % columns ), 3 + ( cell / columns ) );
+                    this->_screenWindow->print( _color( memory[ cell * 2 + 1 ] ), ( c == '%' ) ? "%%" : std::string( 1, c ) );
+                }
+            }
+        }
+        
+        Screen::shared().refresh();
+        this->_screenWindow->move( 0, 0 );
+        this->_screenWindow->refresh();
+    }
+    
+    Color UI::IMPL::_color( uint8_t attribute )
+    {
+        switch( attribute & 0x0F )
+        {
+            case 0x00: return Color::black();
+            case 0x01: case 0x09: return Color::blue();
+            case 0x02: case 0x0A: return Color::green();
+            case 0x03: case 0x0B: return Color::cyan();
+            case 0x04: case 0x0C: return Color::red();
+            case 0x05: case 0x0D: return Color::magenta();
+            case 0x06: case 0x0E: return Color::yellow();
+            case 0x0F: return Color::white();
+            default:   return Color::clear();
+        }
+    }
+    
     void UI::IMPL::_memoryScrollUp( size_t n )
     {
         if( this->_memoryOffset > ( this->_memoryBytesPerLine * n ) )
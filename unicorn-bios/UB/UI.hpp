@@ -34,6 +34,11 @@ namespace UB
 {
     class Engine;
     
+    namespace Devices
+    {
+        class VGA;
+    }
+    
     class UI
     {
         public:
@@ -41,7 +46,8 @@ namespace UB
             enum class Mode
             {
                 Standard,
-                Interactive
+                Interactive,
+                Headless
             };
             
             UI( Engine & engine );
@@ -56,6 +62,7 @@ namespace UB
             
             void run( void );
             int  waitForUserResume( void );
+            void vga( const std::shared_ptr< Devices::VGA > & vga );
             
             StringStream & output( void );
             StringStream & debug( void );
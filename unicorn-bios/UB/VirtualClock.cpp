@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "UB/VirtualClock.hpp"
+#include <atomic>
+#include <stdexcept>
+
+namespace UB
+{
+    class VirtualClock::IMPL
+    {
+        public:
+            
+            IMPL( uint64_t frequency );
+            ~IMPL( void );
+            
+            uint64_t _nanoseconds( uint64_t instructions ) const;
+            
+            uint64_t                _frequency;
+            std::atomic< uint64_t > _instructions;
+            std::atomic< uint64_t > _offset;
+    };
+    
+    VirtualClock::VirtualClock( uint64_t frequency ):
+        impl( std::make_unique< IMPL >( frequency ) )
+    {}
+    
+    VirtualClock::~VirtualClock( void )
+    {}
+    
+    uint64_t VirtualClock::frequency( void ) const
+    {
+        return this->impl->_frequency;
+    }
+    
+    uint64_t VirtualClock::instructions( void ) const
+    {
+        return this->impl->_instructions.load( std::memory_order_relaxed );
+    }
+    
+    uint64_t VirtualClock::time( void ) const
+    {
+        return this->impl->_nanoseconds( this->impl->_instructions.load( std::memory_order_relaxed ) ) + this->impl->_offset;
+    }
+    
+    void VirtualClock::tick( uint64_t instructions )
+    {
+        this->impl->_instructions.fetch_add( instructions, std::memory_order_relaxed );
+    }
+    
+    void VirtualClock::advance( uint64_t nanoseconds )
+    {
+        this->impl->_offset += nanoseconds;
+    }
+    
+    void VirtualClock::advanceTo( uint64_t nanoseconds )
+    {
+        uint64_t now( this->time() );
+        
+        if( nanoseconds > now )
+        {
+            this->advance( nanoseconds - now );
+        }
+    }
+    
+    void VirtualClock::reset( uint64_t instructions, uint64_t nanoseconds )
+    {
+        uint64_t elapsed( this->impl->_nanoseconds( instructions ) );
+        
+        this->impl->_instructions = instructions;
+        this->impl->_offset       = ( nanoseconds > elapsed ) ? nanoseconds - elapsed : 0;
+    }
+    
+    VirtualClock::IMPL::IMPL( uint64_t frequency ):
+        _frequency(    frequency ),
+        _instructions( 0 ),
+        _offset(       0 )
+    {
+        if( frequency == 0 )
+        {
+            throw std::runtime_error( "Invalid virtual clock frequency" );
+        }
+    }
+    
+    VirtualClock::IMPL::~IMPL( void )
+    {}
+    
+    uint64_t VirtualClock::IMPL::_nanoseconds( uint64_t instructions ) const
+    {
+        return ( instructions / this->_frequency ) * 1000000000 + ( ( instructions % this->_frequency ) * 1000000000 ) / this->_frequency;
+    }
+}
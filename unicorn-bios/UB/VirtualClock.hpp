@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2019 Jean-David Gadina - www.xs-labs.com
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#ifndef UB_VIRTUAL_CLOCK_HPP
+#define UB_VIRTUAL_CLOCK_HPP
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace UB
+{
+    class VirtualClock
+    {
+        public:
+            
+            static const uint64_t defaultFrequency = 100000000;
+            
+            VirtualClock( uint64_t frequency = defaultFrequency );
+            ~VirtualClock( void );
+            
+            VirtualClock( const VirtualClock & o )              = delete;
+            VirtualClock( VirtualClock && o )                   = delete;
+            VirtualClock & operator =( const VirtualClock & o ) = delete;
+            VirtualClock & operator =( VirtualClock && o )      = delete;
+            
+            uint64_t frequency( void )    const;
+            uint64_t instructions( void ) const;
+            uint64_t time( void )         const;
+            
+            void tick( uint64_t instructions = 1 );
+            void advance( uint64_t nanoseconds );
+            void advanceTo( uint64_t nanoseconds );
+            void reset( uint64_t instructions, uint64_t nanoseconds );
+        
+        private:
+            
+            class IMPL;
+            std::unique_ptr< IMPL > impl;
+    };
+}
+
+#endif /* UB_VIRTUAL_CLOCK_HPP */
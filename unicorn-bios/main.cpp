@@ -23,47 +23,81 @@
  ******************************************************************************/
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <functional>
+#include <cstdlib>
+#include <cerrno>
+#include <zlib.h>
+#include <cstdio>
+#include <ctime>
+#include <csignal>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "UB/Arguments.hpp"
 #include "UB/Machine.hpp"
+#include "UB/Engine.hpp"
+#include "UB/String.hpp"
 #include "UB/Screen.hpp"
+#include "UB/StateFile.hpp"
+#include "UB/StateDiff.hpp"
+#include "UB/Batch.hpp"
+#include "UB/FAT/CompressedImageReader.hpp"
+#include "UB/FAT/VirtualImageReader.hpp"
+#include "UB/FAT/FileSystem.hpp"
 
-static void showHelp( void );
+static void                           showHelp( void );
+static UB::FAT::Image                 openImage( const std::string & path, const std::string & bootSector );
+static std::unique_ptr< UB::Machine > createMachine( const UB::Arguments & args, UB::UI::Mode mode, const std::function< UB::FAT::Image( const std::string &, const std::string & ) > & image );
+static void                           finishMachine( const UB::Arguments & args, UB::Machine & machine );
+static int                            runBatch( const UB::Arguments & args );
+static void                           parseAddress( const std::string & s, uint16_t & segment, uint16_t & offset );
+static std::string                    digest( const UB::FAT::Image & image );
+static std::string                    digest( const std::string & path );
+static std::string                    digest( const std::vector< uint8_t > & data );
+static std::string                    warmStartConfiguration( const UB::Arguments & args );
+static std::string                    warmStartKey( const UB::Arguments & args, const UB::Machine & machine );
+static std::string                    warmStartPath( const UB::Arguments & args );
+static bool                           diffState( const std::string & path1, const std::string & path2 );
 
 int main( int argc, const char * argv[] )
 {
+    signal( SIGPIPE, SIG_IGN );
+    
     try
     {
         UB::Arguments args( argc, argv );
         
-        if( args.showHelp() || args.bootImage().length() == 0 )
+        if( args.showHelp() == false && args.diffState().size() == 2 )
+        {
+            return ( diffState( args.diffState()[ 0 ], args.diffState()[ 1 ] ) ) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        
+        if( args.showHelp() == false && args.batch().length() > 0 )
+        {
+            return runBatch( args );
+        }
+        
+        if( args.showHelp() || args.bootImage().length() == 0 || args.diffState().size() > 2 )
         {
             showHelp();
             
             return EXIT_SUCCESS;
         }
         
+        if( args.compressImage().length() > 0 )
         {
-            UB::Machine * machine;
-            
-            if( args.noUI() )
-            {
-                machine = new UB::Machine( args.memory() * 1024 * 1024, args.bootImage(), UB::UI::Mode::Standard );
-            }
-            else
-            {
-                machine = new UB::Machine( args.memory() * 1024 * 1024, args.bootImage(), UB::UI::Mode::Interactive );
-            }
+            UB::FAT::CompressedImageReader::compress( args.bootImage(), args.compressImage() );
             
-            machine->breakOnInterrupt( args.breakOnInterrupt() );
-            machine->breakOnInterruptReturn( args.breakOnInterruptReturn() );
-            machine->trap( args.trap() );
-            machine->debugVideo( args.debugVideo() );
-            machine->singleStep( args.singleStep() );
-            
-            for( auto bp: args.breakpoints() )
-            {
-                machine->addBreakpoint( bp );
-            }
+            return EXIT_SUCCESS;
+        }
+        
+        {
+            UB::Machine * machine( createMachine( args, ( args.noUI() ) ? UB::UI::Mode::Standard : UB::UI::Mode::Interactive, openImage ).release() );
             
             if( args.noUI() == false && args.noColors() )
             {
@@ -72,6 +106,32 @@ int main( int argc, const char * argv[] )
             
             
             machine->run();
+            
+            finishMachine( args, *( machine ) );
+            
+            if( args.diffState().size() == 1 )
+            {
+                const char * tmp( std::getenv( "TMPDIR" ) );
+                std::string  path( std::string( ( tmp != nullptr && *( tmp ) != 0 ) ? tmp : "/tmp" ) + "/unicorn-bios-" + std::to_string( getpid() ) + ".state" );
+                bool         identical;
+                
+                machine->saveState( path );
+                
+                try
+                {
+                    identical = diffState( args.diffState()[ 0 ], path );
+                }
+                catch( ... )
+                {
+                    std::remove( path.c_str() );
+                    
+                    throw;
+                }
+                
+                std::remove( path.c_str() );
+                
+                return ( identical ) ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
         }
         
         return EXIT_SUCCESS;
@@ -90,9 +150,428 @@ int main( int argc, const char * argv[] )
     }
 }
 
+static UB::FAT::Image openImage( const std::string & path, const std::string & bootSector )
+{
+    if( bootSector.length() > 0 )
+    {
+        if( UB::FAT::VirtualImageReader::isDirectory( path ) == false )
+        {
+            throw std::runtime_error( "--boot-sector requires BOOT_IMG to be a directory" );
+        }
+        
+        return UB::FAT::Image( path, std::make_shared< UB::FAT::VirtualImageReader >( path, bootSector ) );
+    }
+    
+    return UB::FAT::Image( path );
+}
+
+static std::unique_ptr< UB::Machine > createMachine( const UB::Arguments & args, UB::UI::Mode mode, const std::function< UB::FAT::Image( const std::string &, const std::string & ) > & image )
+{
+    std::unique_ptr< UB::Machine > machine( std::make_unique< UB::Machine >( args.memory() * 1024 * 1024, image( args.bootImage(), args.bootSector() ), mode ) );
+    
+    machine->breakOnInterrupt( args.breakOnInterrupt() );
+    machine->breakOnInterruptReturn( args.breakOnInterruptReturn() );
+    machine->trap( args.trap() );
+    machine->debugVideo( args.debugVideo() );
+    machine->singleStep( args.singleStep() );
+    machine->realtime( args.realtime() );
+    
+    if( args.time() == "now" )
+    {
+        machine->time( std::time( nullptr ) );
+    }
+    else if( args.time().length() > 0 )
+    {
+        char      * end( nullptr );
+        long long   time( std::strtoll( args.time().c_str(), &end, 10 ) );
+        
+        if( *( end ) != 0 || time < 0 )
+        {
+            throw std::runtime_error( "Invalid --time argument: " + args.time() );
+        }
+        
+        machine->time( static_cast< time_t >( time ) );
+    }
+    
+    for( const auto & drive: args.drives() )
+    {
+        size_t        pos( drive.find( '=' ) );
+        char        * end( nullptr );
+        unsigned long number( std::strtoul( drive.substr( 0, ( pos == std::string::npos ) ? 0 : pos ).c_str(), &end, 16 ) );
+        
+        if( pos == std::string::npos || pos == 0 || *( end ) != 0 || number > 0xFF || ( number > 0x01 && number < 0x80 ) )
+        {
+            throw std::runtime_error( "Invalid --drive argument: " + drive );
+        }
+        
+        machine->addDrive( static_cast< uint8_t >( number ), image( drive.substr( pos + 1 ), "" ) );
+    }
+    
+    if( args.serial().length() > 0 )
+    {
+        machine->serialOutput( args.serial() );
+    }
+    
+    if( args.serialInput().length() > 0 )
+    {
+        machine->serialInput( args.serialInput() );
+    }
+    
+    if( args.keys().length() > 0 )
+    {
+        machine->keyboardInput( args.keys() );
+    }
+    
+    if( args.budget().length() > 0 )
+    {
+        char               * end( nullptr );
+        unsigned long long   budget( std::strtoull( args.budget().c_str(), &end, 10 ) );
+        
+        if( *( end ) != 0 || budget == 0 )
+        {
+            throw std::runtime_error( "Invalid --budget argument: " + args.budget() );
+        }
+        
+        machine->instructionLimit( static_cast< uint64_t >( budget ) );
+    }
+    
+    if( args.dumpFramebuffer().length() > 0 )
+    {
+        char      * end( nullptr );
+        long long   interval( std::strtoll( args.dumpInterval().c_str(), &end, 10 ) );
+        
+        if( *( end ) != 0 || interval < 0 )
+        {
+            throw std::runtime_error( "Invalid --dump-interval argument: " + args.dumpInterval() );
+        }
+        
+        machine->framebufferOutput( args.dumpFramebuffer(), static_cast< uint64_t >( interval ) );
+    }
+    
+    for( auto bp: args.breakpoints() )
+    {
+        machine->addBreakpoint( bp );
+    }
+    
+    for( const auto & load: args.load() )
+    {
+        size_t   pos( load.rfind( '@' ) );
+        uint16_t segment;
+        uint16_t offset;
+        
+        if( pos == std::string::npos )
+        {
+            throw std::runtime_error( "Invalid --load argument: " + load );
+        }
+        
+        parseAddress( load.substr( pos + 1 ), segment, offset );
+        machine->load( load.substr( 0, pos ), segment, offset );
+        
+        if( args.entry().length() == 0 && load == args.load().front() )
+        {
+            machine->entryPoint( segment, offset );
+        }
+    }
+    
+    if( args.entry().length() > 0 )
+    {
+        uint16_t segment;
+        uint16_t offset;
+        
+        parseAddress( args.entry(), segment, offset );
+        machine->entryPoint( segment, offset );
+    }
+    
+    if( args.loadState().length() > 0 )
+    {
+        machine->loadState( args.loadState() );
+    }
+    
+    if( args.warmStart().length() > 0 )
+    {
+        uint16_t segment;
+        uint16_t offset;
+        
+        parseAddress( args.warmStart(), segment, offset );
+        machine->warmStart( UB::Engine::getAddress( segment, offset ), warmStartPath( args ), warmStartKey( args, *( machine ) ) );
+    }
+    
+    return machine;
+}
+
+static void finishMachine( const UB::Arguments & args, UB::Machine & machine )
+{
+    if( args.dumpScreen() == "-" )
+    {
+        std::cout << machine.screen();
+    }
+    else if( args.dumpScreen().length() > 0 )
+    {
+        std::ofstream stream( args.dumpScreen() );
+        
+        if( stream.is_open() == false )
+        {
+            throw std::runtime_error( "Cannot write screen dump: " + args.dumpScreen() );
+        }
+        
+        stream << machine.screen();
+    }
+    
+    if( args.dumpFramebuffer().length() > 0 )
+    {
+        machine.dumpFramebuffer( args.dumpFramebuffer() );
+    }
+    
+    if( args.saveState().length() > 0 )
+    {
+        machine.saveState( args.saveState() );
+    }
+}
+
+static int runBatch( const UB::Arguments & args )
+{
+    UB::Batch                               batch( args.batch() );
+    std::map< std::string, UB::FAT::Image > images;
+    std::mutex                              mtx;
+    
+    auto image = [ & ]( const std::string & path, const std::string & bootSector ) -> UB::FAT::Image
+    {
+        std::lock_guard< std::mutex > l( mtx );
+        std::string                   key( path + "\n" + bootSector );
+        auto                          it( images.find( key ) );
+        
+        if( it == images.end() )
+        {
+            it = images.emplace( key, openImage( path, bootSector ) ).first;
+        }
+        
+        return it->second;
+    };
+    
+    batch.run
+    (
+        args.jobs(),
+        [ & ]( const UB::Arguments & job ) -> std::unique_ptr< UB::Machine >
+        {
+            return createMachine( job, UB::UI::Mode::Headless, image );
+        },
+        finishMachine
+    );
+    
+    std::cout << batch.report();
+    
+    return ( batch.succeeded() ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void parseAddress( const std::string & s, uint16_t & segment, uint16_t & offset )
+{
+    size_t   pos( s.find( ':' ) );
+    char   * end( nullptr );
+    
+    if( pos != std::string::npos )
+    {
+        unsigned long seg( std::strtoul( s.substr( 0, pos ).c_str(), &end, 16 ) );
+        unsigned long off( 0 );
+        
+        if( *( end ) == 0 )
+        {
+            off = std::strtoul( s.substr( pos + 1 ).c_str(), &end, 16 );
+        }
+        
+        if( *( end ) != 0 || pos == 0 || pos == s.length() - 1 || seg > 0xFFFF || off > 0xFFFF )
+        {
+            throw std::runtime_error( "Invalid address: " + s );
+        }
+        
+        segment = static_cast< uint16_t >( seg );
+        offset  = static_cast< uint16_t >( off );
+    }
+    else
+    {
+        unsigned long address( std::strtoul( s.c_str(), &end, 16 ) );
+        
+        if( *( end ) != 0 || s.length() == 0 || address > 0xFFFFF )
+        {
+            throw std::runtime_error( "Invalid address: " + s );
+        }
+        
+        segment = static_cast< uint16_t >( ( address >> 16 ) << 12 );
+        offset  = static_cast< uint16_t >( address & 0xFFFF );
+    }
+}
+
+static std::string digest( const UB::FAT::Image & image )
+{
+    uint64_t           size( image.size() );
+    uLong              crc( crc32( 0, Z_NULL, 0 ) );
+    uLong              adler( adler32( 0, Z_NULL, 0 ) );
+    std::ostringstream ss;
+    
+    for( uint64_t offset = 0; offset < size; offset += 1024 * 1024 )
+    {
+        std::vector< uint8_t > data( image.read( offset, std::min< uint64_t >( 1024 * 1024, size - offset ) ) );
+        
+        crc   = crc32(   crc,   data.data(), static_cast< uInt >( data.size() ) );
+        adler = adler32( adler, data.data(), static_cast< uInt >( data.size() ) );
+    }
+    
+    ss << size << ":" << std::hex << std::setfill( '0' ) << std::setw( 8 ) << crc << std::setw( 8 ) << adler;
+    
+    return ss.str();
+}
+
+static std::string digest( const std::string & path )
+{
+    std::ifstream stream( path, std::ios::binary );
+    
+    if( stream.is_open() == false )
+    {
+        throw std::runtime_error( "Cannot open file: " + path );
+    }
+    
+    return digest( std::vector< uint8_t >( std::istreambuf_iterator< char >( stream ), std::istreambuf_iterator< char >() ) );
+}
+
+static std::string digest( const std::vector< uint8_t > & data )
+{
+    std::ostringstream ss;
+    
+    ss << data.size() << ":" << std::hex << std::setfill( '0' )
+       << std::setw( 8 ) << crc32(   crc32(   0, Z_NULL, 0 ), data.data(), static_cast< uInt >( data.size() ) )
+       << std::setw( 8 ) << adler32( adler32( 0, Z_NULL, 0 ), data.data(), static_cast< uInt >( data.size() ) );
+    
+    return ss.str();
+}
+
+static std::string warmStartConfiguration( const UB::Arguments & args )
+{
+    std::ostringstream ss;
+    
+    ss << "memory="       << args.memory()      << std::endl
+       << "warm-start="   << args.warmStart()   << std::endl
+       << "boot-image="   << args.bootImage()   << std::endl
+       << "boot-sector="  << args.bootSector()  << std::endl
+       << "entry="        << args.entry()       << std::endl
+       << "time="         << args.time()        << std::endl
+       << "realtime="     << args.realtime()    << std::endl
+       << "keys="         << args.keys()        << std::endl
+       << "serial-input=" << args.serialInput() << std::endl;
+    
+    for( const auto & load: args.load() )
+    {
+        ss << "load=" << load << std::endl;
+    }
+    
+    for( const auto & drive: args.drives() )
+    {
+        ss << "drive=" << drive << std::endl;
+    }
+    
+    return ss.str();
+}
+
+static std::string warmStartKey( const UB::Arguments & args, const UB::Machine & machine )
+{
+    std::ostringstream ss;
+    
+    ss << warmStartConfiguration( args );
+    
+    for( uint8_t drive: machine.drives() )
+    {
+        ss << "image-" << UB::String::toHex( drive ) << "=" << digest( machine.drive( drive ) ) << std::endl;
+    }
+    
+    if( args.load().size() > 0 )
+    {
+        UB::FAT::FileSystem fs( machine.drive( machine.bootDrive() ) );
+        
+        for( const auto & load: args.load() )
+        {
+            std::string name( load.substr( 0, load.rfind( '@' ) ) );
+            
+            ss << "load-data=" << name << ":" << digest( fs.read( name ) ) << std::endl;
+        }
+    }
+    
+    if( args.keys().length() > 0 )
+    {
+        ss << "keys-data=" << digest( args.keys() ) << std::endl;
+    }
+    
+    if( args.serialInput().length() > 0 )
+    {
+        ss << "serial-input-data=" << digest( args.serialInput() ) << std::endl;
+    }
+    
+    return ss.str();
+}
+
+static std::string warmStartPath( const UB::Arguments & args )
+{
+    std::string        configuration( warmStartConfiguration( args ) );
+    std::string        directory( args.warmStartCache() );
+    std::ostringstream ss;
+    
+    if( directory.length() == 0 )
+    {
+        const char * cache( getenv( "XDG_CACHE_HOME" ) );
+        const char * home( getenv( "HOME" ) );
+        
+        if( cache != nullptr && *( cache ) != 0 )
+        {
+            directory = std::string( cache ) + "/unicorn-bios";
+        }
+        else if( home != nullptr && *( home ) != 0 )
+        {
+            directory = std::string( home ) + "/.cache/unicorn-bios";
+        }
+        else
+        {
+            throw std::runtime_error( "No cache directory available for --warm-start" );
+        }
+    }
+    
+    for( size_t pos = directory.find( '/', 1 ); ; pos = directory.find( '/', pos + 1 ) )
+    {
+        std::string path( directory.substr( 0, pos ) );
+        
+        if( mkdir( path.c_str(), 0755 ) != 0 && errno != EEXIST )
+        {
+            throw std::runtime_error( "Cannot create cache directory: " + path );
+        }
+        
+        if( pos == std::string::npos )
+        {
+            break;
+        }
+    }
+    
+    ss << directory << "/"
+       << std::hex << std::setfill( '0' )
+       << std::setw( 8 ) << crc32(   crc32(   0, Z_NULL, 0 ), reinterpret_cast< const Bytef * >( configuration.data() ), static_cast< uInt >( configuration.size() ) )
+       << std::setw( 8 ) << adler32( adler32( 0, Z_NULL, 0 ), reinterpret_cast< const Bytef * >( configuration.data() ), static_cast< uInt >( configuration.size() ) )
+       << ".state";
+    
+    return ss.str();
+}
+
+static bool diffState( const std::string & path1, const std::string & path2 )
+{
+    UB::StateFile state1( path1 );
+    UB::StateFile state2( path2 );
+    UB::StateDiff diff( state1, state2 );
+    
+    std::cout << diff.report();
+    
+    return diff.identical();
+}
+
 static void showHelp( void )
 {
     std::cout << "Usage: unicorn-bios [OPTIONS] BOOT_IMG"
+              << std::endl
+              << std::endl
+              << "BOOT_IMG may be a disk image or a directory, which is exposed as a FAT12/16 volume."
               << std::endl
               << std::endl
               << "Options:"
@@ -119,5 +598,61 @@ static void showHelp( void )
               << "    --no-ui:        Don't start the user interface (output will be displayed to stdout, debug info to stderr)."
               << std::endl
               << "    --no-colors:    Don't use colors."
+              << std::endl
+              << "    --realtime:     Use the host clock instead of the deterministic instruction-count clock."
+              << std::endl
+              << "    --compress-image FILE:  Converts BOOT_IMG to the compressed image format and exits."
+              << std::endl
+              << "    --boot-sector FILE:     Boot code to use when BOOT_IMG is a directory."
+              << std::endl
+              << "    --load FILE@SEG:OFF:    Loads FILE from the BOOT_IMG FAT volume at SEG:OFF, skipping the boot sector."
+              << std::endl
+              << "    --entry ADDR:           Entry point (SEG:OFF or linear) when using --load. Defaults to the first load address."
+              << std::endl
+              << "    --drive NUM=FILE:       Attaches an additional disk image or directory as BIOS drive NUM (hex: 00-01 or 80-FF, e.g. 81=data.img)."
+              << std::endl
+              << "                            BOOT_IMG is drive 00, or 80 if it is a partitioned or hard disk sized image."
+              << std::endl
+              << "    --serial FILE:          Writes COM1 output to FILE, which may be a FIFO, or - for stdout."
+              << std::endl
+              << "    --serial-input FILE:    Feeds the contents of FILE to COM1 as received data."
+              << std::endl
+              << "    --time SECONDS:         Initial RTC time (UTC), as a Unix timestamp or 'now'. Defaults to 2000-01-01 00:00:00."
+              << std::endl
+              << "    --keys FILE:            Keystroke script for the keyboard, instead of the terminal (stdin with --no-ui)."
+              << std::endl
+              << "                            One command per line: 'wait MS', 'type TEXT' or 'key NAME' (Enter, Esc, Up, F1, Ctrl-C...)."
+              << std::endl
+              << "    --dump-screen FILE:     Writes the final VGA text screen to FILE, or - for stdout."
+              << std::endl
+              << "    --dump-framebuffer FILE: Writes the VBE framebuffer to FILE (PNG if it ends with .png, PPM otherwise) at exit."
+              << std::endl
+              << "                            SIGUSR1 writes a numbered dump (FILE-0000.png...) on demand."
+              << std::endl
+              << "    --dump-interval SECONDS: Also writes a numbered dump every SECONDS of emulated time."
+              << std::endl
+              << "    --save-state FILE:      Saves the machine state (CPU, devices and RAM) to FILE at exit."
+              << std::endl
+              << "    --load-state FILE:      Resumes from a state saved with --save-state. The memory size and drives must match."
+              << std::endl
+              << "    --warm-start ADDR:      Snapshots the machine the first time it reaches ADDR (SEG:OFF or linear), and resumes"
+              << std::endl
+              << "                            from that snapshot on later runs with the same images and options."
+              << std::endl
+              << "    --warm-start-cache DIR: Directory for --warm-start snapshots. Defaults to ~/.cache/unicorn-bios."
+              << std::endl
+              << "    --diff-state FILE:      Compares the machine state at exit with FILE. When given twice, compares both"
+              << std::endl
+              << "                            saved states and exits, without BOOT_IMG. Exits with 1 if the states differ."
+              << std::endl
+              << "    --budget COUNT:         Stops the emulation after COUNT instructions."
+              << std::endl
+              << "    --batch MANIFEST:       Runs the jobs listed in MANIFEST on concurrent headless machines, and prints"
+              << std::endl
+              << "                            a report. One job per line: BOOT_IMG followed by options for that job."
+              << std::endl
+              << "    --jobs / -j COUNT:      Number of --batch threads. Defaults to the number of CPUs."
+              << std::endl
+              << "    --timeout SECONDS:      Stops a --batch job after SECONDS of wall time."
               << std::endl;
 }